@@ -1,91 +1,343 @@
-#ifndef NVM_ALLOCATOR_H
-#define NVM_ALLOCATOR_H
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-#include <stdint.h>
-#include <stddef.h>
-
-#include "NvmSpaceManager.h"
-#include "SlabHashTable.h"
-#include "NvmSlab.h"
-#include "NvmDefs.h"
-
-// ============================================================================
-//                          NVM Allocator Public API
-// ============================================================================
-
-/**
- * @brief 初始化 NVM 分配器
- * 
- * 这是一个单例模式的初始化函数。它接管指定的一块 NVM 物理内存区域，
- * 并初始化内部的中心堆、Per-CPU 缓存和元数据索引。
- * 
- * @param nvm_base_addr NVM 物理内存映射到进程空间的起始地址
- * @param nvm_size_bytes NVM 区域的总大小 (字节)
- * @return 0 成功, -1 失败 (如已初始化、内存不足等)
- */
-int nvm_allocator_create(void* nvm_base_addr, uint64_t nvm_size_bytes);
-
-/**
- * @brief 销毁 NVM 分配器
- * 
- * 释放所有 DRAM 元数据 (Slab 描述符、哈希表、空间管理链表)。
- * 注意：不会修改 NVM 物理内存中的数据。
- */
-void nvm_allocator_destroy(void);
-
-/**
- * @brief 分配 NVM 内存
- * 
- * 优先从当前 CPU 的本地缓存 (L1) 分配，无锁操作。
- * 若缓存未命中，则从中心堆 (L2) 分配并回填缓存。
- * 
- * @param size 请求大小 (字节)
- * @return 指向 NVM 内存的指针，若分配失败返回 NULL
- */
-void* nvm_malloc(size_t size);
-
-/**
- * @brief 释放 NVM 内存
- * 
- * 支持本地释放 (Local Free) 和跨线程释放 (Remote Free)。
- * 
- * @param nvm_ptr nvm_malloc 返回的指针
- */
-void nvm_free(void* nvm_ptr);
-
-// ============================================================================
-//                          故障恢复 API
-// ============================================================================
-
-/**
- * @brief 恢复已分配内存块的元数据
- * 
- * 在系统崩溃重启后，用于根据持久化日志或扫描结果，重建分配器的内存视图。
- * 它会在内部 Slab 中将对应的块标记为“已占用”。
- * 
- * @param nvm_ptr 指向已分配块的指针
- * @param size 原分配大小
- * @return 0 成功, -1 失败
- */
-int nvm_allocator_restore_allocation(void* nvm_ptr, size_t size);
-
-/**
- * @brief [调试] 打印分配器内部布局信息
- * 
- * 输出内容包括：
- * 1. NVM 物理内存的基地址 (Base Address)
- * 2. 所有活跃 Slab (2MB 页) 的偏移量分布情况 (调用哈希表打印)
- * 
- * @note 此函数主要用于开发调试，检查内存映射是否符合预期。
- */
-void nvm_allocator_debug_print(void);
-
-#ifdef __cplusplus
-}
-#endif
-
+#ifndef NVM_ALLOCATOR_H
+#define NVM_ALLOCATOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "NvmSpaceManager.h"
+#include "SlabHashTable.h"
+#include "SlabPageMap.h"
+#include "NvmSlab.h"
+#include "NvmExtent.h"
+#include "NvmLayout.h"
+#include "NvmDefs.h"
+
+// ============================================================================
+//                          NVM Allocator Public API
+// ============================================================================
+
+/**
+ * @brief 一个 NUMA 节点上的 NVM 区域
+ */
+typedef struct NvmNodeRegion {
+    int      node;          // 该区域物理所在的 NUMA 节点
+    void*    base_addr;     // 映射到进程空间的起始地址
+    uint64_t size_bytes;    // 区域大小 (字节)
+} NvmNodeRegion;
+
+// 一次 nvm_publish 最多发布的预留数 (每个预留占两条日志项：置位与写入目标)
+#define NVM_PUBLISH_MAX_ACTIONS (NVM_LOG_CAPACITY / 2)
+
+// 一个事务内最多的分配数与释放数 (各自计数；日志项另受 NVM_LOG_CAPACITY 限制)
+#define NVM_TX_MAX_OPS          NVM_LOG_CAPACITY
+
+/**
+ * @brief 一个尚未发布的预留 (DRAM)，由 nvm_reserve 填写
+ */
+typedef struct NvmAction {
+    void*    ptr;           // 预留块的地址，发布前即可写入内容
+    uint64_t offset;        // 块在所属区域内的偏移 (发布时写入目标位置的值)
+    uint64_t slab_offset;   // 所属 Slab 的起始偏移
+    uint32_t block_idx;     // 块在 Slab 中的索引
+    uint16_t region_id;     // 所属区域 (nvm_allocator_create_numa 中的下标)
+} NvmAction;
+
+/**
+ * @brief nvm_allocator_restore_batch 的一个条目
+ */
+typedef struct NvmRestoreEntry {
+    void*  nvm_ptr;         // 已分配块的指针
+    size_t size;            // 原分配大小 (只支持 Slab 尺寸)
+} NvmRestoreEntry;
+
+/**
+ * @brief 初始化 NVM 分配器
+ * 
+ * 这是一个单例模式的初始化函数。它接管指定的一块 NVM 物理内存区域，
+ * 并初始化内部的中心堆、Per-CPU 缓存和元数据索引。
+ * 整个区域视为位于节点 0，等价于只注册一个区域的 nvm_allocator_create_numa。
+ * 
+ * 区域开头 (NVM_START_OFFSET) 是持久元数据区 (超级块、跨度头部、持久位图与
+ * 重做日志槽，约占区域的 1/64 另加 256KB)。挂载时先重做已提交未清空的日志。区域已格式化时直接挂载：按跨度头部重建 Slab 与大对象区块，
+ * 开销与跨度数成正比，与对象数无关；否则就地格式化。区域大小须与格式化时一致。
+ * 
+ * @param nvm_base_addr NVM 物理内存映射到进程空间的起始地址
+ * @param nvm_size_bytes NVM 区域的总大小 (字节)
+ * @return 0 成功, -1 失败 (如已初始化、内存不足等)
+ */
+int nvm_allocator_create(void* nvm_base_addr, uint64_t nvm_size_bytes);
+
+/**
+ * @brief 按 NUMA 节点初始化 NVM 分配器
+ * 
+ * 每个区域拥有独立的中心堆 (空间管理器与元数据索引)，不同节点的
+ * 慢路径切分互不竞争。CPU 堆优先从本节点的区域切分 Slab，本地耗尽时
+ * 按节点距离由近及远回退到其他区域。
+ * 
+ * @param regions 区域数组 (调用方保证互不重叠)，同一节点可有多个区域
+ * @param region_count 区域个数
+ * @return 0 成功, -1 失败
+ */
+int nvm_allocator_create_numa(const NvmNodeRegion* regions, uint32_t region_count);
+
+/**
+ * @brief 销毁 NVM 分配器
+ * 
+ * 释放所有 DRAM 元数据 (Slab 描述符、哈希表、空间管理链表)。
+ * 注意：不会修改 NVM 物理内存中的数据，之后在同一区域上创建即挂载原有对象
+ * (线程缓存等各级缓存中的块视为空闲)。当前线程的分配与释放在返回前持久；
+ * 其他线程须在此之前调用 nvm_drain 或 nvm_thread_cache_flush，否则其最近的
+ * 分配与释放可能未持久。
+ */
+void nvm_allocator_destroy(void);
+
+/**
+ * @brief 分配 NVM 内存
+ * 
+ * 优先从当前线程的线程缓存 (tcache) 弹出块及其所属 Slab，无锁；随后对持久
+ * 位图字做一次原子置位并写回 (不加栅栏)。
+ * 若缓存未命中，则从当前 CPU 堆 (必要时从中心堆) 批量回填缓存。
+ * 8B ~ 4KB 与 5KB ~ 512KB (中型类别) 的对象由 Slab 分配；超过 512KB 的对象
+ * 按 4KB 页粒度从区块分配，超过 2MB 的对象独占按 64KB 取整的连续空间。
+ * 空间不足时先回写当前线程缓存与 CPU 缓存、归还空 Slab，再重试一次。
+ * 
+ * 持久位图只写回不加栅栏：分配在本线程下一次 nvm_drain / nvm_persist
+ * (通常即应用持久化指向该块的指针时) 一并持久，连续分配只付一次栅栏。
+ * 
+ * @param size 请求大小 (字节)
+ * @return 指向 NVM 内存的指针，若分配失败返回 NULL
+ */
+void* nvm_malloc(size_t size);
+
+/**
+ * @brief 释放 NVM 内存
+ * 
+ * 块先压入当前线程的线程缓存，缓存满时批量归还给所属 Slab。
+ * 支持本地释放 (Local Free) 和跨线程释放 (Remote Free)。
+ * 释放同样在本线程下一次 nvm_drain / nvm_persist 时持久。
+ * 
+ * @param nvm_ptr nvm_malloc 返回的指针
+ */
+void nvm_free(void* nvm_ptr);
+
+/**
+ * @brief 在指定 NUMA 节点的 NVM 上分配内存
+ * 
+ * 绕过线程缓存与 CPU 缓存，由该节点的节点堆分配：优先使用该节点的
+ * 区域，耗尽时按距离回退。返回的指针照常用 nvm_free 释放。
+ * 
+ * @param size 请求大小 (字节)
+ * @param node 目标 NUMA 节点
+ * @return 指向 NVM 内存的指针，失败返回 NULL
+ */
+void* nvm_malloc_node(size_t size, int node);
+
+// ============================================================================
+//                          两阶段分配 API
+// ============================================================================
+
+/**
+ * @brief 预留一个块 (不改写持久状态)
+ * 
+ * 与 nvm_malloc 走同一条缓存路径，但不置位持久位图：崩溃时预留的块自动
+ * 视为空闲，不会泄漏。应用可先初始化块内容，再用 nvm_publish 发布。
+ * 只支持由 Slab 分配的尺寸 (不超过 512KB)。
+ * 
+ * @param size 请求大小 (字节)
+ * @param action 输出：预留记录，交给 nvm_publish 或 nvm_cancel
+ * @return 预留块的地址 (即 action->ptr)，失败返回 NULL
+ */
+void* nvm_reserve(size_t size, NvmAction* action);
+
+/**
+ * @brief 原子发布一批预留：置位持久位图，并把块偏移写入应用的 NVM 位置
+ * 
+ * 全部置位与写入先记入一个重做日志槽，一次持久化后再应用，崩溃后挂载时
+ * 要么全部生效、要么全部未生效。固定三次栅栏 (日志提交、应用、清空日志)，
+ * 与批次大小无关；同一位图字上的置位合并为一条日志项。
+ * 
+ * @param actions 预留记录数组
+ * @param count 个数 (不超过 NVM_PUBLISH_MAX_ACTIONS)
+ * @param dest_ptrs 目标位置数组 (须位于分配器管理的区域内且 8 字节对齐)，
+ *                  写入块在所属区域内的偏移；整个数组或单项为 NULL 表示不写入
+ * @return 0 成功, -1 参数非法 (含与页映射不符、已发布、已取消或批内重复的预留)
+ *         或日志槽长时间全部被占用 (此时没有任何预留被发布)，或日志应用失败
+ *         (预留仍归调用方，可重试或取消)
+ */
+int nvm_publish(const NvmAction* actions, uint32_t count, uint64_t* const* dest_ptrs);
+
+/**
+ * @brief 放弃一批预留，块照常回到缓存 (持久状态本就未改写)
+ *
+ * 与页映射不符、已发布或已取消的预留记录被跳过，不归还任何块。
+ */
+void nvm_cancel(const NvmAction* actions, uint32_t count);
+
+// ============================================================================
+//                          事务 API
+// ============================================================================
+
+/**
+ * @brief 在当前线程开始一个分配事务 (每个线程同时至多一个)
+ * 
+ * 事务占用一个 NVM 重做日志槽，事务内的分配、释放与指针写入都只记入日志，
+ * 由 nvm_tx_commit 一次原子生效；提交前崩溃时全部丢弃，提交途中崩溃时
+ * 挂载时重做。线程在提交或中止前退出时事务自动中止。
+ * 
+ * @return 0 成功, -1 本线程已有进行中的事务，或日志槽长时间全部被占用
+ */
+int nvm_tx_begin(void);
+
+/**
+ * @brief 事务内分配 (同 nvm_reserve，只支持 Slab 尺寸)
+ * 
+ * 块立即可用，提交后才在持久位图中置位。
+ * 
+ * @return 块地址，失败返回 NULL (事务仍进行中，可继续、提交或中止)
+ */
+void* nvm_tx_alloc(size_t size);
+
+/**
+ * @brief 事务内释放 (只支持 Slab 块)：推迟到提交之后块才可被再次分配
+ * @return 0 成功, -1 不是 Slab 块、重复释放或日志已满
+ */
+int nvm_tx_free(void* nvm_ptr);
+
+/**
+ * @brief 事务内写入一个持久指针：提交时与分配、释放一同原子生效
+ * 
+ * 提交前 dest 保持原值。块内其余数据由应用自行持久化 (须在提交前完成)。
+ * 
+ * @param dest 目标位置 (须位于分配器管理的区域内且 8 字节对齐)
+ * @param value 写入的值 (如块在所属区域内的偏移)
+ * @return 0 成功, -1 参数非法或日志已满
+ */
+int nvm_tx_set(uint64_t* dest, uint64_t value);
+
+/**
+ * @brief 提交事务
+ * 
+ * 固定三次栅栏 (日志提交、应用、清空日志)，与事务内的对象数无关。
+ * 提交后推迟的释放生效，日志槽归还。
+ * 
+ * @return 0 成功, -1 没有进行中的事务或日志应用失败 (推迟的释放不生效，事务结束)
+ */
+int nvm_tx_commit(void);
+
+/**
+ * @brief 中止事务：分配的块回到缓存，释放与写入作废 (不改写持久状态)
+ */
+void nvm_tx_abort(void);
+
+// ============================================================================
+//                          空间回收 API
+// ============================================================================
+
+/**
+ * @brief 立即归还所有空 Slab
+ * 
+ * 将各 CPU 堆中所有全空的 Slab 摘链、注销索引，并将其 NVM 空间
+ * 归还给空间管理器，使其可被其他尺寸类别或其他 CPU 复用。
+ * 各 CPU 堆预留但尚未切分的 Slab 空间也一并归还。
+ * 
+ * @return 归还的 NVM 字节数
+ */
+size_t nvm_malloc_trim(void);
+
+/**
+ * @brief 设置空 Slab 的衰减时间
+ * 
+ * 空 Slab 在全空链表中停留超过该时长后，于下一次有 Slab 变空时被归还。
+ * 默认值为 NVM_SLAB_DECAY_MS。
+ * 
+ * @param decay_ms 衰减时间 (毫秒)；0 表示变空即归还，负数表示从不自动归还
+ */
+void nvm_allocator_set_decay_ms(int64_t decay_ms);
+
+/**
+ * @brief 设置冷类别晋升阈值
+ * 
+ * CPU 首次使用某个尺寸类别时，块来自所在 NUMA 节点的共享 Slab (由锁保护)，
+ * 触碰一个类别的固定开销与 CPU 数无关。CPU 在 NVM_SHARED_WINDOW_MS 窗口内
+ * 从共享 Slab 分配的块数达到阈值后，该类别晋升为 CPU 独占 Slab；
+ * 独占 Slab 全部归还后回到共享模式。默认值为 NVM_SHARED_PROMOTE_BLOCKS。
+ * 
+ * @param blocks 窗口内的块数阈值；0 表示始终使用 CPU 独占 Slab
+ */
+void nvm_allocator_set_promote_threshold(uint32_t blocks);
+
+// ============================================================================
+//                          线程缓存 API
+// ============================================================================
+
+/**
+ * @brief 将当前线程缓存的空闲块全部归还给 Slab
+ * 
+ * 线程退出时会自动回写；该接口用于在长期空闲前主动归还，或在检查
+ * 分配器内部状态前使 Slab 计数与实际占用一致。同时持久化本线程此前
+ * 的分配与释放 (nvm_drain)。
+ */
+void nvm_thread_cache_flush(void);
+
+/**
+ * @brief 启用/禁用当前线程的线程缓存 (默认启用)
+ * 
+ * 禁用时先回写已缓存的块，之后该线程的分配与释放直接走 CPU 堆。
+ * 
+ * @param enabled true 启用, false 禁用
+ */
+void nvm_thread_cache_set_enabled(bool enabled);
+
+// ============================================================================
+//                          故障恢复 API
+// ============================================================================
+
+/**
+ * @brief 恢复已分配内存块的元数据
+ * 
+ * 在系统崩溃重启后，用于根据持久化日志或扫描结果，重建分配器的内存视图。
+ * 它会在内部 Slab 中将对应的块标记为“已占用”，并同步写入持久位图。
+ * 挂载已格式化的区域时分配器已自动重建，只有需要补录的对象才须调用。
+ * 
+ * @param nvm_ptr 指向已分配块的指针
+ * @param size 原分配大小
+ * @return 0 成功, -1 失败
+ */
+int nvm_allocator_restore_allocation(void* nvm_ptr, size_t size);
+
+/**
+ * @brief 批量恢复已分配内存块的元数据 (大批量补录时代替逐个调用 nvm_allocator_restore_allocation)
+ * 
+ * 条目先按区域与地址分桶、各桶并行排序后按 Slab 分组；所需的新 Slab 空间
+ * 每个区域一次性向空间管理器占位 (单次加锁，按地址单遍处理)；新建 Slab 的
+ * 持久位图按字写好后整字载入 DRAM 位图。排序与置位在条目数达到
+ * NVM_RESTORE_PARALLEL_MIN 时分给至多 NVM_RESTORE_MAX_THREADS 个线程。
+ * 条目顺序任意，重复条目无害。
+ * 
+ * @param entries 条目数组
+ * @param count 条目数
+ * @return 0 成功；-1 失败：条目非法、尺寸类别冲突或空间已被占用时没有任何条目
+ *         被恢复，内存不足时已建立的 Slab 上的条目仍被恢复
+ */
+int nvm_allocator_restore_batch(const NvmRestoreEntry* entries, size_t count);
+
+/**
+ * @brief [调试] 打印分配器内部布局信息
+ * 
+ * 输出内容包括：
+ * 1. NVM 物理内存的基地址 (Base Address)
+ * 2. 所有活跃 Slab (2MB 页) 的偏移量分布情况 (调用哈希表打印)
+ * 
+ * @note 此函数主要用于开发调试，检查内存映射是否符合预期。
+ */
+void nvm_allocator_debug_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // NVM_ALLOCATOR_H
\ No newline at end of file
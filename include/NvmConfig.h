@@ -13,20 +13,23 @@ extern "C" {
 #include <sched.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <time.h>
+
+#include "NvmRseq.h"
+#include "NvmNuma.h"
+#include "NvmPersist.h"
 
 // ============================================================================
 //                          硬件与性能配置
 // ============================================================================
 
-// 最大支持的 CPU 核心数
-// Linux: 通常设为系统逻辑核心数
-// RTEMS: 根据 BSP 配置设定
-#define MAX_CPUS 64
-
 // 缓存行大小 (用于填充对齐，消除 False Sharing)
 // x86_64 通常为 64，部分 ARM/PowerPC 为 128
 #define CACHE_LINE_SIZE 64
 
+// 线程局部存储 (GCC/Clang 扩展，Linux 与 RTEMS 均支持)
+#define NVM_THREAD_LOCAL __thread
+
 // 分支预测优化宏
 #if defined(__GNUC__) || defined(__clang__)
     #define NVM_LIKELY(x)   __builtin_expect(!!(x), 1)
@@ -42,14 +45,14 @@ extern "C" {
 
 /**
  * @brief 获取当前线程运行的 CPU ID
- * @return 范围 [0, MAX_CPUS - 1]
+ * @return 范围 [0, nvm_numa_possible_cpus() - 1]，与 CPU 一一对应
  */
 static inline int nvm_get_current_cpu_id(void) {
 #ifdef __linux__
-    int cpu = sched_getcpu();
+    // 优先读取 rseq 区域 (普通内存读)，未注册时退回 sched_getcpu
+    int cpu = nvm_rseq_cpu_id();
+    if (NVM_UNLIKELY(cpu < 0)) cpu = sched_getcpu();
     if (NVM_UNLIKELY(cpu < 0)) return 0;
-    // 简单的取模映射，防止系统核数超过 MAX_CPUS 导致越界
-    if (NVM_UNLIKELY(cpu >= MAX_CPUS)) return cpu % MAX_CPUS;
     return cpu;
 #elif defined(__rtems__)
     // RTEMS 适配接口 (需根据实际 RTEMS 版本启用)
@@ -64,6 +67,25 @@ static inline int nvm_get_current_cpu_id(void) {
 // 兼容旧代码的宏定义 (如果不想修改所有调用处)
 #define NVM_GET_CURRENT_CPU_ID() nvm_get_current_cpu_id()
 
+// ============================================================================
+//                          OS 适配层 (单调时钟)
+// ============================================================================
+
+/**
+ * @brief 获取单调时钟时间 (纳秒)
+ * @note 仅用于空 Slab 衰减等慢路径计时，不在分配快速路径上调用
+ */
+static inline uint64_t nvm_get_time_ns(void) {
+#if defined(__linux__) || defined(__rtems__)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#else
+    // 无可用时钟：衰减退化为 "立即满足"，仅影响归还时机
+    return 0;
+#endif
+}
+
 // ============================================================================
 //                          OS 适配层 (锁原语)
 // ============================================================================
@@ -76,6 +98,7 @@ typedef pthread_spinlock_t nvm_spinlock_t;
 #define NVM_SPINLOCK_DESTROY(l)  pthread_spin_destroy(l)
 #define NVM_SPINLOCK_ACQUIRE(l)  pthread_spin_lock(l)
 #define NVM_SPINLOCK_RELEASE(l)  pthread_spin_unlock(l)
+#define NVM_SPINLOCK_TRY_ACQUIRE(l) pthread_spin_trylock(l)   // 成功返回 0
 
 // --- 2. 互斥锁 (Mutex) ---
 // 场景: 持有时间较长、涉及系统调用 (如 SpaceManager 扩容)
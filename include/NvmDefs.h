@@ -1,66 +1,192 @@
-#ifndef NVM_DEFS_H
-#define NVM_DEFS_H
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-#include <stdint.h>
-#include <stddef.h>
-#include <stdbool.h>
-
-#include "NvmConfig.h"
-
-// ============================================================================
-//                          全局常量定义
-// ============================================================================
-
-// NVM 起始偏移量 (模拟环境下通常为 0)
-#define NVM_START_OFFSET  0
-
-// 标准 Slab 大小: 2MB (Huge Page Friendly)
-#define NVM_SLAB_SIZE     (2 * 1024 * 1024)
-
-// Slab 本地缓存 (FreeList) 配置
-#define SLAB_CACHE_SIZE        64
-#define SLAB_CACHE_BATCH_SIZE  (SLAB_CACHE_SIZE / 2)
-
-// 哈希表初始容量 (建议为素数以减少冲突)
-#define INITIAL_HASHTABLE_CAPACITY 101
-
-// ============================================================================
-//                          通用宏工具
-// ============================================================================
-
-// 向上对齐到 align (align 必须是 2 的幂)
-#define NVM_ALIGN_UP(x, align) (((x) + ((align) - 1)) & ~((align) - 1))
-
-// 向下对齐到 align
-#define NVM_ALIGN_DOWN(x, align) ((x) & ~((align) - 1))
-
-// 错误日志输出
-#define LOG_ERR(fmt, ...) fprintf(stderr, "[NvmAllocator] Error: " fmt "\n", ##__VA_ARGS__)
-
-// ============================================================================
-//                          尺寸类别 (Size Classes)
-// ============================================================================
-
-typedef enum {
-    SC_8B = 0,
-    SC_16B,
-    SC_32B,
-    SC_64B,
-    SC_128B,
-    SC_256B,
-    SC_512B,
-    SC_1K,
-    SC_2K,
-    SC_4K,
-    SC_COUNT    // 哨兵值：总类别数
-} SizeClassID;
-
-#ifdef __cplusplus
-}
-#endif
-
+#ifndef NVM_DEFS_H
+#define NVM_DEFS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "NvmConfig.h"
+
+// ============================================================================
+//                          全局常量定义
+// ============================================================================
+
+// NVM 起始偏移量 (模拟环境下通常为 0)
+#define NVM_START_OFFSET  0
+
+// 默认 Slab 大小: 2MB (Huge Page Friendly)
+// 也是分配器可管理的最小 NVM 容量，以及大对象页粒度区块的大小
+#define NVM_SLAB_SIZE     (2 * 1024 * 1024)
+
+// Slab 跨度 (span) 的单位: 各尺寸类别的 Slab 跨度为其 2 的幂倍 (见尺寸类别表)，
+// 并按自身跨度对齐；空间管理器与页映射表均以此为粒度
+#define NVM_SPAN_UNIT     (64 * 1024)
+#define NVM_MAX_SLAB_SPAN (4 * 1024 * 1024)
+
+// Slab 本地缓存 (FreeList) 配置
+#define SLAB_CACHE_SIZE        64
+#define SLAB_CACHE_BATCH_SIZE  (SLAB_CACHE_SIZE / 2)
+
+// 线程缓存 (tcache) 配置: 每个尺寸类别缓存的块数上限，及批量填充/回写的块数
+#define NVM_TCACHE_CAPACITY    64
+#define NVM_TCACHE_BATCH       (NVM_TCACHE_CAPACITY / 2)
+
+// CPU 缓存配置: 每个 CPU、每个尺寸类别暂存的块数上限 (线程缓存溢出/回填的中转层)
+#define NVM_CPU_CACHE_SIZE     64
+
+// 中型类别的块很大，线程缓存与 CPU 缓存按字节数收紧每类别的块数上限
+// (上限 = NVM_CACHE_MAX_BYTES / 块大小，取值范围 [2, 上述块数上限])
+#define NVM_CACHE_MAX_BYTES    (256 * 1024)
+
+// 弹匣仓库 (depot) 配置: CPU 缓存放不下的块整批装进弹匣 (magazine) 交给每类别的仓库，
+// 另一线程回填时整批取走，不经过 Slab 位图。每类别最多囤积 NVM_DEPOT_MAX_MAGAZINES 个满弹匣；
+// 弹匣大小从类别块数上限的一半起步，每 NVM_DEPOT_ADAPT_INTERVAL 次加锁中若超过
+// 1/NVM_DEPOT_CONTENTION_RATIO 发生争用则翻倍 (不超过类别块数上限)
+#define NVM_MAGAZINE_CAPACITY        NVM_TCACHE_CAPACITY
+#define NVM_DEPOT_MAX_MAGAZINES      8
+#define NVM_DEPOT_ADAPT_INTERVAL     64
+#define NVM_DEPOT_CONTENTION_RATIO   8
+
+// Slab 尺寸类别的最大块大小 (SC_512K)，更大的对象走大对象区块
+#define NVM_MAX_SLAB_BLOCK_SIZE (512 * 1024)
+
+// 大对象区块配置: 超过最大尺寸类别的对象按 4KB 页从 2MB 区块中切分，
+// 超过 NVM_SLAB_SIZE 的对象独占按 NVM_SPAN_UNIT 取整的连续空间
+#define NVM_EXTENT_PAGE_SIZE   4096
+#define NVM_EXTENT_PAGES       (NVM_SLAB_SIZE / NVM_EXTENT_PAGE_SIZE)
+#define NVM_EXTENT_CHUNK_UNITS (NVM_SLAB_SIZE / NVM_SPAN_UNIT)   // 页粒度区块的跨度单元数
+
+// 哈希表初始容量 (建议为素数以减少冲突)
+#define INITIAL_HASHTABLE_CAPACITY 101
+
+// 页映射表叶子位数: 每个叶子覆盖 2^N 个跨度单元 (10 -> 1024 x 64KB = 64MB NVM)
+#define SLAB_PAGEMAP_LEAF_BITS 10
+
+// 空 Slab 衰减时间 (毫秒): 空闲超过该时长的空 Slab 归还给空间管理器
+// 0 表示变空即归还，负数表示从不自动归还 (仅由 nvm_malloc_trim 归还)
+#define NVM_SLAB_DECAY_MS 1000
+
+// 冷类别晋升阈值 (块数): CPU 在一个统计窗口内从所在节点的共享 Slab 分配的块数
+// 达到该值后，该类别改由 CPU 独占 Slab 服务；0 表示始终使用独占 Slab
+#define NVM_SHARED_PROMOTE_BLOCKS 256
+
+// 冷类别晋升统计窗口 (毫秒)
+#define NVM_SHARED_WINDOW_MS 100
+
+// Slab 空间预留批次: CPU 堆一次从空间管理器预留一段连续空间，此后在堆锁内私有地切分
+// Slab 跨度，不再为每个 Slab 争抢空间管理器的互斥锁。相邻两次预留的间隔短于
+// NVM_RESERVE_WINDOW_MS 时批次翻倍，否则减半 (初始只预留所需跨度)；批次不超过
+// NVM_RESERVE_MAX_BYTES 与区域大小的 1/NVM_RESERVE_REGION_SHARE。未用完的预留在
+// nvm_malloc_trim 时归还
+#define NVM_RESERVE_MAX_BYTES     (32 * NVM_SLAB_SIZE)
+#define NVM_RESERVE_WINDOW_MS     100
+#define NVM_RESERVE_REGION_SHARE  64
+
+// 重做日志槽全部被占用时最多让出 CPU 的次数，超过后发布或开始事务失败
+#define NVM_LOG_CLAIM_YIELDS      100000
+
+// 批量恢复配置: 条目数达到 NVM_RESTORE_PARALLEL_MIN 时，排序与置位分给至多
+// NVM_RESTORE_MAX_THREADS 个线程 (含调用线程)。每个区域按地址切成
+// 线程数 x NVM_RESTORE_BUCKETS_PER_THREAD 个分桶 (桶界按 NVM_MAX_SLAB_SPAN 对齐，
+// Slab 不跨桶)，各桶独立排序
+#define NVM_RESTORE_PARALLEL_MIN        (64 * 1024)
+#define NVM_RESTORE_MAX_THREADS         16
+#define NVM_RESTORE_BUCKETS_PER_THREAD  4
+
+// 恢复时遇到正被所属堆退役的 Slab，等待其空间归还空间管理器最多让出 CPU 的次数
+#define NVM_RESTORE_RETIRE_YIELDS       100000
+
+// ============================================================================
+//                          通用宏工具
+// ============================================================================
+
+// 向上对齐到 align (align 必须是 2 的幂)
+#define NVM_ALIGN_UP(x, align) (((x) + ((align) - 1)) & ~((align) - 1))
+
+// 向下对齐到 align
+#define NVM_ALIGN_DOWN(x, align) ((x) & ~((align) - 1))
+
+// 错误日志输出
+#define LOG_ERR(fmt, ...) fprintf(stderr, "[NvmAllocator] Error: " fmt "\n", ##__VA_ARGS__)
+
+// ============================================================================
+//                          尺寸类别 (Size Classes)
+// ============================================================================
+
+// 尺寸类别表 (jemalloc 风格)：X(类别名, 块大小, Slab 跨度)
+// - 小类别 8B ~ 4KB：8B 粒度起步，此后每次翻倍分 4 档 (间距为组下界的 1/4)，
+//   32B 以上的请求内部碎片低于 20%
+// - 中型类别 5KB ~ 512KB：同样每次翻倍分 4 档，块大小为 1KB 的整数倍 (中型尺寸查找表
+//   的粒度)，请求的内部碎片低于 20%。128KB 以上 1/4 间距的块在 4MB 跨度中尾部浪费
+//   过大，档位取尾部浪费不超过 1/64 的近邻 (156K、312K、372K)，相邻档位之比仍不超过 1.25
+// - Slab 跨度：容纳至少 256 个块的最小 2 的幂 (不小于 64KB)，小类别的 Slab 小 (位图小、
+//   冷类别占用少)。跨度上限为 4MB：16KB 以上的类别放不下 256 个块，块数随块大小
+//   递减 (20KB 为 204 块，512KB 仅 8 块)，此时只要求尾部浪费不超过跨度的 1/64
+// 枚举、块大小表、跨度表与尺寸查找表均由此生成，保持一致
+#define NVM_SIZE_CLASS_TABLE(X)                                                   \
+    X(SC_8B,    8,    64 << 10)    X(SC_16B,   16,   64 << 10)                   \
+    X(SC_24B,   24,   64 << 10)    X(SC_32B,   32,   64 << 10)                   \
+    X(SC_40B,   40,   64 << 10)    X(SC_48B,   48,   64 << 10)                   \
+    X(SC_56B,   56,   64 << 10)    X(SC_64B,   64,   64 << 10)                   \
+    X(SC_80B,   80,   64 << 10)    X(SC_96B,   96,   64 << 10)                   \
+    X(SC_112B,  112,  64 << 10)    X(SC_128B,  128,  64 << 10)                   \
+    X(SC_160B,  160,  64 << 10)    X(SC_192B,  192,  64 << 10)                   \
+    X(SC_224B,  224,  64 << 10)    X(SC_256B,  256,  64 << 10)                   \
+    X(SC_320B,  320,  128 << 10)   X(SC_384B,  384,  128 << 10)                  \
+    X(SC_448B,  448,  128 << 10)   X(SC_512B,  512,  128 << 10)                  \
+    X(SC_640B,  640,  256 << 10)   X(SC_768B,  768,  256 << 10)                  \
+    X(SC_896B,  896,  256 << 10)   X(SC_1K,    1024, 256 << 10)                  \
+    X(SC_1280B, 1280, 512 << 10)   X(SC_1536B, 1536, 512 << 10)                  \
+    X(SC_1792B, 1792, 512 << 10)   X(SC_2K,    2048, 512 << 10)                  \
+    X(SC_2560B, 2560, 1 << 20)     X(SC_3K,    3072, 1 << 20)                    \
+    X(SC_3584B, 3584, 1 << 20)     X(SC_4K,    4096, 1 << 20)                    \
+    X(SC_5K,    5 << 10,   2 << 20)     /* 409 块 */                             \
+    X(SC_6K,    6 << 10,   2 << 20)     /* 341 块 */                             \
+    X(SC_7K,    7 << 10,   2 << 20)     /* 292 块 */                             \
+    X(SC_8K,    8 << 10,   2 << 20)     /* 256 块 */                             \
+    X(SC_10K,   10 << 10,  4 << 20)     /* 409 块 */                             \
+    X(SC_12K,   12 << 10,  4 << 20)     /* 341 块 */                             \
+    X(SC_14K,   14 << 10,  4 << 20)     /* 292 块 */                             \
+    X(SC_16K,   16 << 10,  4 << 20)     /* 256 块 */                             \
+    X(SC_20K,   20 << 10,  4 << 20)     /* 204 块 */                             \
+    X(SC_24K,   24 << 10,  4 << 20)     /* 170 块 */                             \
+    X(SC_28K,   28 << 10,  4 << 20)     /* 146 块 */                             \
+    X(SC_32K,   32 << 10,  4 << 20)     /* 128 块 */                             \
+    X(SC_40K,   40 << 10,  4 << 20)     /* 102 块 */                             \
+    X(SC_48K,   48 << 10,  4 << 20)     /* 85 块 */                              \
+    X(SC_56K,   56 << 10,  4 << 20)     /* 73 块 */                              \
+    X(SC_64K,   64 << 10,  4 << 20)     /* 64 块 */                              \
+    X(SC_80K,   80 << 10,  4 << 20)     /* 51 块 */                              \
+    X(SC_96K,   96 << 10,  4 << 20)     /* 42 块 */                              \
+    X(SC_112K,  112 << 10, 4 << 20)     /* 36 块 */                              \
+    X(SC_128K,  128 << 10, 4 << 20)     /* 32 块 */                              \
+    X(SC_156K,  156 << 10, 4 << 20)     /* 26 块 */                              \
+    X(SC_192K,  192 << 10, 4 << 20)     /* 21 块 */                              \
+    X(SC_224K,  224 << 10, 4 << 20)     /* 18 块 */                              \
+    X(SC_256K,  256 << 10, 4 << 20)     /* 16 块 */                              \
+    X(SC_312K,  312 << 10, 4 << 20)     /* 13 块 */                              \
+    X(SC_372K,  372 << 10, 4 << 20)     /* 11 块 */                              \
+    X(SC_448K,  448 << 10, 4 << 20)     /* 9 块 */                               \
+    X(SC_512K,  512 << 10, 4 << 20)     /* 8 块 */
+
+#define NVM_SC_ENUM_ENTRY(name, size, span) name,
+
+typedef enum {
+    NVM_SIZE_CLASS_TABLE(NVM_SC_ENUM_ENTRY)
+    SC_COUNT    // 哨兵值：总类别数
+} SizeClassID;
+
+// 最大的小类别，及尺寸查找表的粒度 (小类别按 8B，中型类别按 1KB)
+#define NVM_SMALL_MAX_SIZE     4096
+#define NVM_SMALL_QUANTUM      8
+#define NVM_MEDIUM_QUANTUM     1024
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // NVM_DEFS_H
\ No newline at end of file
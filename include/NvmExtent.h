@@ -0,0 +1,114 @@
+#ifndef NVM_EXTENT_H
+#define NVM_EXTENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "NvmDefs.h"
+#include <stdbool.h>
+
+// ============================================================================
+//                          核心数据结构
+// ============================================================================
+
+/**
+ * @brief NVM 大对象区块元数据
+ * 
+ * 两种形态共用同一结构：
+ * 1. 页粒度区块 (span_units == NVM_EXTENT_CHUNK_UNITS)：一个 2MB 区域按 4KB 页切分，
+ *    容纳多个任意大小 (按页取整) 的对象，页位图记录占用，释放后相邻空闲页自然合并。
+ * 2. 巨型对象 (span_units > NVM_EXTENT_CHUNK_UNITS)：单个对象独占按 NVM_SPAN_UNIT
+ *    取整的连续空间。
+ * 
+ * @note 本结构不含锁，由调用方 (所属区域的区块锁) 串行化访问。
+ */
+typedef struct NvmExtent {
+
+    // --- 1. 链表链接 ---
+    // 所属区域的区块链表 (双向链表，O(1) 摘除)；页粒度区块挂在按最长空闲段分的箱中
+    struct NvmExtent* next_in_chain;
+    struct NvmExtent* prev_in_chain;
+
+    // --- 2. 核心元数据 ---
+    uint64_t nvm_base_offset;         // 区块在 NVM 物理空间中的起始偏移量
+    uint32_t span_units;              // 覆盖的 NVM_SPAN_UNIT 个数 (NVM_EXTENT_CHUNK_UNITS 为页粒度区块)
+    uint32_t free_pages;              // 空闲页数 (巨型对象恒为 0)
+    uint32_t max_free_run;            // 最长连续空闲页段 (巨型对象恒为 0)，不小于它的请求必能满足
+    uint16_t region_id;               // 所属 NVM 区域编号
+    uint16_t _padding;
+
+    // --- 3. 页位图与对象长度表 (仅页粒度区块使用) ---
+    uint64_t page_bitmap[NVM_EXTENT_PAGES / 64];   // 1 = 占用
+    uint16_t run_pages[NVM_EXTENT_PAGES];          // 以该页起始的对象页数，0 表示不是对象起点
+
+} NvmExtent;
+
+// ============================================================================
+//                          生命周期管理
+// ============================================================================
+
+/**
+ * @brief 创建区块元数据 (DRAM)
+ * @param nvm_base_offset NVM 上的物理起始偏移 (须按 NVM_SPAN_UNIT 对齐)
+ * @param span_units 覆盖的 NVM_SPAN_UNIT 个数，不小于 NVM_EXTENT_CHUNK_UNITS；
+ *                   大于它时整个区块即一个对象
+ * @return 成功返回指针，失败返回 NULL
+ */
+NvmExtent* nvm_extent_create(uint64_t nvm_base_offset, uint32_t span_units);
+
+/**
+ * @brief 重置区块元数据以便复用 (参数要求同 nvm_extent_create)
+ * 清空页位图与对象长度表，并绑定到新的 NVM 偏移。
+ * @note 调用方需保证此时没有其他线程在使用该区块
+ */
+void nvm_extent_reset(NvmExtent* self, uint64_t nvm_base_offset, uint32_t span_units);
+
+/**
+ * @brief 销毁区块元数据
+ * 注意：不负责释放 NVM 物理空间，仅释放 DRAM 元数据
+ */
+void nvm_extent_destroy(NvmExtent* self);
+
+// ============================================================================
+//                          核心操作 API
+// ============================================================================
+
+/**
+ * @brief 在页粒度区块中分配连续 pages 个页 (First-Fit)
+ * @param pages 页数 (1 ~ NVM_EXTENT_PAGES)
+ * @param out_page [输出] 起始页号
+ * @return 0 成功, -1 失败 (没有足够长的连续空闲页)
+ */
+int nvm_extent_alloc(NvmExtent* self, uint32_t pages, uint32_t* out_page);
+
+/**
+ * @brief 释放以 page 起始的对象
+ * @return 释放的页数；page 不是对象起点时返回 0
+ */
+uint32_t nvm_extent_free(NvmExtent* self, uint32_t page);
+
+/**
+ * @brief 以 page 起始的对象的页数
+ * @return page 不是对象起点时返回 0
+ */
+uint32_t nvm_extent_object_pages(const NvmExtent* self, uint32_t page);
+
+/**
+ * @brief 在页粒度区块中重新标记一个已知位置的对象 (用于从持久记录重建)
+ * @param page 起始页号
+ * @param pages 页数
+ * @return 0 成功, -1 失败 (越界或与已有对象重叠)
+ */
+int nvm_extent_restore(NvmExtent* self, uint32_t page, uint32_t pages);
+
+/**
+ * @brief 检查页粒度区块是否完全为空
+ */
+bool nvm_extent_is_empty(const NvmExtent* self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NVM_EXTENT_H
@@ -0,0 +1,193 @@
+#ifndef NVM_LAYOUT_H
+#define NVM_LAYOUT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "NvmDefs.h"
+#include "NvmLog.h"
+#include <stdbool.h>
+
+// ============================================================================
+//                          持久布局常量
+// ============================================================================
+
+// 超级块魔数 ("NVMALLOC") 与布局版本号，布局不兼容的修改须递增版本号
+#define NVM_LAYOUT_MAGIC    0x434F4C4C414D564EULL
+#define NVM_LAYOUT_VERSION  2
+
+// 每个跨度单元的持久位图槽字节数：最小的块 (8B) 填满一个单元时每块一位
+// 只有跨度起始单元的槽被使用，所有类别的 Slab 块数都不超过这个位数
+#define NVM_LAYOUT_BITMAP_BYTES (NVM_SPAN_UNIT / NVM_SMALL_QUANTUM / 8)
+
+// 页粒度区块的持久位图：前 NVM_EXTENT_PAGES 位为页占用，其后同样多位标记对象起始页
+#define NVM_LAYOUT_CHUNK_STARTS NVM_EXTENT_PAGES
+
+// 每个区域的重做日志槽数 (同时进行的发布/事务数上限，超出时等待空闲槽)
+#define NVM_LAYOUT_LOG_SLOTS 64
+
+// ============================================================================
+//                          核心数据结构
+// ============================================================================
+
+/**
+ * @brief 跨度状态 (记录在跨度起始单元的头部中)
+ */
+typedef enum {
+    NVM_SPAN_FREE = 0,                  // 未使用，或属于某个跨度的后续单元
+    NVM_SPAN_SLAB,                      // Slab：持久位图按块索引记录应用持有的块
+    NVM_SPAN_CHUNK,                     // 页粒度区块：持久位图记录占用页与对象起始页
+    NVM_SPAN_HUGE,                      // 巨型对象：整个跨度即一个对象，不使用位图
+    NVM_SPAN_STATE_COUNT
+} NvmSpanState;
+
+/**
+ * @brief 跨度头部 (NVM 中每个 64KB 单元一项，8 字节整体原子写入)
+ */
+typedef struct NvmSpanHeader {
+    uint8_t  state;                     // NvmSpanState
+    uint8_t  size_class;                // Slab 的 SizeClassID (其他状态为 0)
+    uint16_t _reserved;
+    uint32_t span_units;                // 跨度覆盖的单元数
+} NvmSpanHeader;
+
+/**
+ * @brief 超级块 (位于区域的 NVM_START_OFFSET 处)
+ *
+ * 区域开头的元数据区依次为：超级块、跨度头部表 (每单元一项)、持久位图槽
+ * (每单元 NVM_LAYOUT_BITMAP_BYTES)、重做日志槽 (NVM_LAYOUT_LOG_SLOTS 个)，
+ * 整体按 NVM_SPAN_UNIT 对齐，数据从其后开始。
+ * 魔数最后写入，格式化中途崩溃的区域下次仍会被重新格式化。
+ */
+typedef struct NvmSuperblock {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t unit_size;                 // 创建时的 NVM_SPAN_UNIT
+    uint64_t region_size;               // 区域大小 (字节)
+    uint64_t unit_count;                // 跨度单元数 (头部表项数)
+    uint64_t header_offset;             // 头部表相对超级块的偏移
+    uint64_t bitmap_offset;             // 位图槽相对超级块的偏移
+    uint64_t log_offset;                // 日志槽相对超级块的偏移
+    uint64_t log_count;                 // 日志槽数
+    uint64_t meta_size;                 // 元数据区大小 (字节，NVM_SPAN_UNIT 的整数倍)
+} NvmSuperblock;
+
+/**
+ * @brief 持久布局句柄 (DRAM)
+ *
+ * 缓存超级块中的偏移，热路径改写位图时不必再读 NVM 中的超级块。
+ * 单元号与偏移量均相对于 NVM_START_OFFSET。
+ */
+typedef struct NvmLayout {
+    NvmSuperblock* superblock;
+    NvmSpanHeader* headers;
+    uint64_t*      bitmaps;
+    NvmRedoLog*    logs;
+    uint64_t       unit_count;
+    uint64_t       meta_size;
+} NvmLayout;
+
+// ============================================================================
+//                          生命周期管理
+// ============================================================================
+
+/**
+ * @brief 计算区域的元数据区大小
+ * @param region_size 区域大小 (字节)
+ * @return 元数据区字节数 (NVM_SPAN_UNIT 的整数倍)
+ */
+uint64_t nvm_layout_meta_size(uint64_t region_size);
+
+/**
+ * @brief 打开区域的持久布局：已格式化时直接挂载，否则格式化
+ *
+ * 格式化只清零头部表与日志头并写入超级块；位图槽在跨度启用时按需清零，
+ * 因此格式化的开销不随区域大小中的数据部分增长。
+ *
+ * @param base 区域映射到进程空间的起始地址
+ * @param region_size 区域大小 (字节)
+ * @return 1 挂载了已有布局, 0 新格式化, -1 失败 (布局与区域不符或区域过小)
+ */
+int nvm_layout_open(NvmLayout* self, void* base, uint64_t region_size);
+
+// ============================================================================
+//                          跨度头部 API
+// ============================================================================
+
+/**
+ * @brief 记录一个跨度的状态 (写入起始单元的头部)
+ *
+ * Slab 与页粒度区块会先清零起始单元的位图槽并持久化，再写入头部，
+ * 崩溃后不会出现带着上一任残留位图的跨度。返回时头部已持久。
+ *
+ * @param offset 跨度起始偏移 (NVM_SPAN_UNIT 对齐)
+ * @param state 跨度状态 (非 NVM_SPAN_FREE)
+ * @param size_class Slab 的尺寸类别，其他状态传 0
+ * @param span_bytes 跨度字节数
+ */
+void nvm_layout_set_span(NvmLayout* self, uint64_t offset, NvmSpanState state, uint8_t size_class, uint64_t span_bytes);
+
+/**
+ * @brief 清除跨度头部 (跨度归还给空间管理器前调用，返回时已持久)
+ */
+void nvm_layout_clear_span(NvmLayout* self, uint64_t offset);
+
+/**
+ * @brief 读取第 unit 个单元的头部
+ */
+NvmSpanHeader nvm_layout_span_at(const NvmLayout* self, uint64_t unit);
+
+/**
+ * @brief 批量置位/清除持久位图中的连续位 (页粒度区块，只写回不加栅栏)
+ * @param offset 跨度起始偏移
+ * @param first 起始位
+ * @param count 位数
+ * @param used true 置位, false 清除
+ */
+void nvm_layout_mark_range(const NvmLayout* self, uint64_t offset, uint32_t first, uint32_t count, bool used);
+
+// ============================================================================
+//                          持久位图 API
+// ============================================================================
+
+/**
+ * @brief 跨度起始偏移对应的持久位图槽
+ */
+static inline uint64_t* nvm_layout_bitmap(const NvmLayout* self, uint64_t offset) {
+    uint64_t unit = (offset - NVM_START_OFFSET) / NVM_SPAN_UNIT;
+    return self->bitmaps + unit * (NVM_LAYOUT_BITMAP_BYTES / sizeof(uint64_t));
+}
+
+/**
+ * @brief 原子置位 (块交给应用时)
+ * @note 同一字可能被不同线程同时改写 (本地分配与远程释放)，须用原子操作。
+ *       只写回不加栅栏，由本线程下一次 nvm_drain 完成持久化
+ */
+static inline void nvm_layout_mark(const NvmLayout* self, uint64_t offset, uint32_t bit) {
+    uint64_t* word = &nvm_layout_bitmap(self, offset)[bit / 64];
+    __atomic_fetch_or(word, 1ULL << (bit % 64), __ATOMIC_RELAXED);
+    nvm_flush(word, sizeof(*word));
+}
+
+/**
+ * @brief 原子清除 (应用归还块时)
+ */
+static inline void nvm_layout_unmark(const NvmLayout* self, uint64_t offset, uint32_t bit) {
+    uint64_t* word = &nvm_layout_bitmap(self, offset)[bit / 64];
+    __atomic_fetch_and(word, ~(1ULL << (bit % 64)), __ATOMIC_RELAXED);
+    nvm_flush(word, sizeof(*word));
+}
+
+/**
+ * @brief 第 slot 个重做日志槽
+ */
+static inline NvmRedoLog* nvm_layout_log(const NvmLayout* self, uint32_t slot) {
+    return &self->logs[slot];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NVM_LAYOUT_H
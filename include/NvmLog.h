@@ -0,0 +1,106 @@
+#ifndef NVM_LOG_H
+#define NVM_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "NvmDefs.h"
+#include <stdbool.h>
+
+// ============================================================================
+//                          重做日志常量
+// ============================================================================
+
+// 每个日志槽的字节数 (含一个缓存行的日志头)
+#define NVM_LOG_SLOT_SIZE   4096
+
+// 每个日志槽可容纳的日志项数
+#define NVM_LOG_CAPACITY    ((NVM_LOG_SLOT_SIZE - CACHE_LINE_SIZE) / 16)
+
+// 日志项目标的编码：高 2 位为操作，其后 16 位为区域号，低 46 位为区域内偏移
+#define NVM_LOG_OP_SHIFT      62
+#define NVM_LOG_REGION_SHIFT  46
+#define NVM_LOG_OFFSET_MASK   ((1ULL << NVM_LOG_REGION_SHIFT) - 1)
+
+// ============================================================================
+//                          核心数据结构
+// ============================================================================
+
+/**
+ * @brief 日志项操作 (均作用于一个 8 字节对齐的 NVM 字，重复应用结果不变)
+ */
+typedef enum {
+    NVM_LOG_OP_SET = 1,                 // 字 |= value (置位持久位图)
+    NVM_LOG_OP_CLEAR,                   // 字 &= ~value (清除持久位图)
+    NVM_LOG_OP_STORE,                   // 字 = value (写入应用的持久指针)
+} NvmLogOp;
+
+/**
+ * @brief 日志项 (16 字节)
+ */
+typedef struct NvmLogEntry {
+    uint64_t target;                    // 操作 | 区域号 | 区域内偏移 (见 nvm_log_target)
+    uint64_t value;
+} NvmLogEntry;
+
+/**
+ * @brief 重做日志槽 (位于 NVM，大小 NVM_LOG_SLOT_SIZE)
+ *
+ * 调用方先把日志项写入 entries，再由 nvm_log_commit 一次持久化日志头与全部日志项。
+ * 日志头的校验和覆盖项数与所有日志项：部分日志项未落盘的日志校验失败，视为从未提交。
+ */
+typedef struct NvmRedoLog {
+    uint64_t    checksum;
+    uint32_t    count;                  // 已提交的日志项数，0 表示空闲
+    uint32_t    _reserved;
+    uint8_t     _pad[CACHE_LINE_SIZE - 16];
+    NvmLogEntry entries[NVM_LOG_CAPACITY];
+} NvmRedoLog;
+
+// ============================================================================
+//                          日志 API
+// ============================================================================
+
+/**
+ * @brief 编码日志项目标
+ */
+static inline uint64_t nvm_log_target(NvmLogOp op, uint16_t region_id, uint64_t offset) {
+    return ((uint64_t)op << NVM_LOG_OP_SHIFT) | ((uint64_t)region_id << NVM_LOG_REGION_SHIFT) |
+           (offset & NVM_LOG_OFFSET_MASK);
+}
+
+/**
+ * @brief 提交日志：写入项数与校验和，持久化日志头与前 count 项 (一次栅栏)
+ * @param count 调用方已写入 entries 的项数 (1 ~ NVM_LOG_CAPACITY)
+ * @return 0 成功, -1 项数非法
+ */
+int nvm_log_commit(NvmRedoLog* self, uint32_t count);
+
+/**
+ * @brief 日志是否已完整提交 (项数合法且校验和一致)
+ */
+bool nvm_log_valid(const NvmRedoLog* self);
+
+/**
+ * @brief 重做日志：按顺序应用全部日志项，并写回被修改的字 (不加栅栏)
+ *
+ * 先校验所有日志项的区域号与偏移，任何一项越界则一项都不应用。
+ *
+ * @param bases 各区域映射到进程空间的起始地址，按区域号索引
+ * @param sizes 各区域大小 (字节)
+ * @param region_count 区域个数
+ * @return 0 成功, -1 日志无效或日志项越界
+ */
+int nvm_log_apply(const NvmRedoLog* self, void* const* bases, const uint64_t* sizes, uint32_t region_count);
+
+/**
+ * @brief 清空日志并持久化 (日志应用完毕且已持久之后调用)
+ */
+void nvm_log_clear(NvmRedoLog* self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NVM_LOG_H
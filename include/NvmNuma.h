@@ -0,0 +1,198 @@
+#ifndef NVM_NUMA_H
+#define NVM_NUMA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+//                          系统头文件依赖
+// ============================================================================
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+// 支持的最大 NUMA 节点数 (mbind 节点掩码位数)
+#define NVM_NUMA_MAX_NODES 1024
+
+// 无 sysfs 距离信息时的默认节点距离 (与 ACPI SLIT 约定一致)
+#define NVM_NUMA_LOCAL_DISTANCE   10
+#define NVM_NUMA_REMOTE_DISTANCE  20
+
+// ============================================================================
+//                          OS 适配层 (CPU 拓扑)
+// ============================================================================
+
+#ifdef __linux__
+// 解析 sysfs 中形如 "0-127" 或 "0-3,8-11" 的 ID 列表，返回最大 ID + 1；失败返回 0
+static inline uint32_t nvm_numa_read_id_list(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return 0;
+
+    char buf[256];
+    unsigned long max_id = 0;
+    bool found = false;
+    if (fgets(buf, sizeof(buf), f)) {
+        char* p = buf;
+        while (*p) {
+            if (!isdigit((unsigned char)*p)) { p++; continue; }
+            unsigned long id = strtoul(p, &p, 10);
+            if (id > max_id) max_id = id;
+            found = true;
+        }
+    }
+    fclose(f);
+    return found ? (uint32_t)max_id + 1 : 0;
+}
+#endif
+
+/**
+ * @brief 获取可能存在的 CPU 数量 (含离线与可热插拔的 CPU)
+ * @return 最大 CPU ID + 1，至少为 1
+ * @note 读取 sysfs，仅在初始化等慢路径上调用
+ */
+static inline uint32_t nvm_numa_possible_cpus(void) {
+#ifdef __linux__
+    uint32_t count = nvm_numa_read_id_list("/sys/devices/system/cpu/possible");
+    if (count > 0) return count;
+    long n = sysconf(_SC_NPROCESSORS_CONF);
+    return (n > 0) ? (uint32_t)n : 1;
+#elif defined(__rtems__)
+    // RTEMS 适配接口 (需根据实际 RTEMS 版本启用)
+    // return rtems_scheduler_get_processor_maximum();
+    return 1;
+#else
+    return 1;
+#endif
+}
+
+/**
+ * @brief 获取指定 CPU 所属的 NUMA 节点
+ * @return 节点号；无 NUMA 信息时返回 0
+ */
+static inline int nvm_numa_node_of_cpu(uint32_t cpu) {
+#ifdef __linux__
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", cpu);
+
+    DIR* dir = opendir(path);
+    if (!dir) return 0;
+
+    int node = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && isdigit((unsigned char)entry->d_name[4])) {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+#else
+    (void)cpu;
+    return 0;
+#endif
+}
+
+/**
+ * @brief 获取可能存在的 NUMA 节点数量
+ * @return 最大节点号 + 1，无 NUMA 信息时为 1
+ */
+static inline uint32_t nvm_numa_possible_nodes(void) {
+#ifdef __linux__
+    uint32_t count = nvm_numa_read_id_list("/sys/devices/system/node/possible");
+    if (count > NVM_NUMA_MAX_NODES) count = NVM_NUMA_MAX_NODES;
+    return (count > 0) ? count : 1;
+#else
+    return 1;
+#endif
+}
+
+/**
+ * @brief 获取两个 NUMA 节点之间的相对距离
+ *
+ * 读取 nodeN/distance (按节点号排列的距离表)。节点不存在或表中缺少
+ * 对应项时，同节点返回 NVM_NUMA_LOCAL_DISTANCE，否则返回 NVM_NUMA_REMOTE_DISTANCE。
+ */
+static inline int nvm_numa_distance(int from, int to) {
+    int distance = (from == to) ? NVM_NUMA_LOCAL_DISTANCE : NVM_NUMA_REMOTE_DISTANCE;
+#ifdef __linux__
+    if (from < 0 || to < 0) return distance;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/distance", from);
+    FILE* f = fopen(path, "r");
+    if (!f) return distance;
+
+    int value;
+    for (int i = 0; i <= to && fscanf(f, "%d", &value) == 1; ++i) {
+        if (i == to) distance = value;
+    }
+    fclose(f);
+#endif
+    return distance;
+}
+
+// ============================================================================
+//                          OS 适配层 (节点本地内存)
+// ============================================================================
+
+/**
+ * @brief 在指定 NUMA 节点上分配清零的 DRAM 内存 (页对齐)
+ *
+ * 尽力而为：首选该节点，节点内存不足时由内核回退到其他节点。
+ * 物理页在首次访问时才分配，因此调用方应在设置策略后再初始化内容。
+ *
+ * @param size 字节数
+ * @param node 目标节点，负数表示不指定
+ * @return 失败返回 NULL，须用 nvm_numa_free 释放
+ */
+static inline void* nvm_numa_alloc_onnode(size_t size, int node) {
+#ifdef __linux__
+    void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) return NULL;
+
+    if (node >= 0 && node < NVM_NUMA_MAX_NODES) {
+        unsigned long mask[NVM_NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+        mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+        // 失败 (如内核未启用 NUMA) 不影响正确性，忽略
+        syscall(SYS_mbind, ptr, size, MPOL_PREFERRED, mask, (unsigned long)NVM_NUMA_MAX_NODES, 0);
+    }
+    return ptr;
+#else
+    (void)node;
+    return calloc(1, size);
+#endif
+}
+
+/**
+ * @brief 释放 nvm_numa_alloc_onnode 分配的内存
+ */
+static inline void nvm_numa_free(void* ptr, size_t size) {
+    if (!ptr) return;
+#ifdef __linux__
+    munmap(ptr, size);
+#else
+    (void)size;
+    free(ptr);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NVM_NUMA_H
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef NVM_PERSIST_H
+#define NVM_PERSIST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+//                          系统头文件依赖
+// ============================================================================
+
+#include <stddef.h>
+
+// ============================================================================
+//                          OS 适配层 (持久化原语)
+// ============================================================================
+
+/**
+ * @brief 缓存行写回方式 (按强度递增排列)
+ *
+ * 首次使用时按 CPUID 选择 CPU 支持的最强指令：CLWB 写回后行仍留在缓存中，
+ * CLFLUSHOPT 写回并失效，二者都须以 sfence 排序；CLFLUSH 自身有序，无需栅栏。
+ * eADR 平台的 CPU 缓存位于掉电保护域内，写回与栅栏都可省去，此时应由
+ * nvm_persist_set_mode 设为 NVM_FLUSH_NONE (CPUID 无法探测 eADR)。
+ */
+typedef enum {
+    NVM_FLUSH_NONE = 0,                 // eADR / 非 x86：不写回，不加栅栏
+    NVM_FLUSH_CLFLUSH,
+    NVM_FLUSH_CLFLUSHOPT,
+    NVM_FLUSH_CLWB,
+} NvmFlushMode;
+
+/**
+ * @brief 当前的写回方式
+ */
+NvmFlushMode nvm_persist_mode(void);
+
+/**
+ * @brief 指定写回方式 (如 eADR 平台设为 NVM_FLUSH_NONE)
+ *
+ * 超出 CPU 能力的方式降级为 CPU 支持的最强方式。须在创建分配器之前调用：
+ * 切换时其他线程尚未写回的缓存行不会被补刷。
+ *
+ * @return 实际生效的写回方式
+ */
+NvmFlushMode nvm_persist_set_mode(NvmFlushMode mode);
+
+/**
+ * @brief 将 [addr, addr + len) 所在的缓存行写回 NVM (不加栅栏)
+ *
+ * 写回先记在线程本地的待刷区间中：与待刷区间重叠或相邻的范围直接合并，
+ * 同一缓存行的多次改写只写回一次；不相邻时才对旧区间发出写回指令。
+ * 返回时数据尚不保证持久，须由同一线程随后的 nvm_drain 完成。
+ */
+void nvm_flush(const void* addr, size_t len);
+
+/**
+ * @brief 持久化屏障：本线程此前 nvm_flush 的数据全部到达持久域后返回
+ *
+ * 发出待刷区间的写回，再以一条 sfence 等待完成。自上次屏障以来没有写回，
+ * 或写回方式无需栅栏 (CLFLUSH / NONE) 时不发出 sfence，因此批量改写后只需
+ * 在批次边界调用一次。
+ */
+void nvm_drain(void);
+
+/**
+ * @brief nvm_flush 后立即 nvm_drain
+ */
+void nvm_persist(const void* addr, size_t len);
+
+/**
+ * @brief 丢弃所有线程尚未发出的写回 (NVM 映射即将解除时调用)
+ *
+ * 其他线程的待刷区间在其下一次 nvm_flush / nvm_drain 时被识别为过期并丢弃，
+ * 不会对已解除映射的地址发出写回指令。需要持久的数据应在此之前 nvm_drain。
+ */
+void nvm_persist_invalidate(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NVM_PERSIST_H
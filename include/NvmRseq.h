@@ -0,0 +1,297 @@
+#ifndef NVM_RSEQ_H
+#define NVM_RSEQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+//                          系统头文件依赖
+// ============================================================================
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// rseq (Restartable Sequences) 仅在 Linux x86_64 + glibc (>= 2.35) 下启用：
+// rseq 区域由 glibc 为每个线程注册，这里只读取、不重复注册
+#if defined(__linux__) && defined(__x86_64__) && defined(__has_include)
+    #if __has_include(<sys/rseq.h>) && __has_include(<linux/membarrier.h>)
+        #define NVM_HAVE_RSEQ 1
+    #endif
+#endif
+
+#ifdef NVM_HAVE_RSEQ
+#include <sys/rseq.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/membarrier.h>
+#endif
+
+// ============================================================================
+//                          返回值定义
+// ============================================================================
+
+#define NVM_RSEQ_OK       0     // 序列已提交
+#define NVM_RSEQ_ABORT   -1     // 被抢占/迁移/信号打断，调用方重试
+#define NVM_RSEQ_MISS     1     // 栈空 (pop) / 栈满 (push) / 已被停用 (stopped) / 闸门关闭 (link)
+
+#ifdef NVM_HAVE_RSEQ
+
+// ============================================================================
+//                          rseq 区域访问
+// ============================================================================
+
+/**
+ * @brief 获取当前线程的 rseq 区域
+ * @return glibc 未注册 rseq 时返回 NULL
+ */
+static inline struct rseq* nvm_rseq_area(void) {
+    if (__rseq_size == 0) return NULL;
+    return (struct rseq*)((char*)__builtin_thread_pointer() + __rseq_offset);
+}
+
+/**
+ * @brief 从 rseq 区域读取当前 CPU ID (一次普通内存读，无系统调用)
+ * @return 未注册时返回 -1
+ */
+static inline int nvm_rseq_cpu_id(void) {
+    struct rseq* rs = nvm_rseq_area();
+    if (!rs) return -1;
+    return (int)__atomic_load_n(&rs->cpu_id, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 注册 rseq 栅栏 (进程级，可重复调用)
+ * @return true 表示可以使用 nvm_rseq_fence
+ */
+static inline bool nvm_rseq_fence_init(void) {
+    return syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_RSEQ, 0, 0) == 0;
+}
+
+/**
+ * @brief rseq 栅栏：返回时，所有 CPU 上正在执行的可重启序列均已提交或被中止
+ */
+static inline void nvm_rseq_fence(void) {
+    syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED_RSEQ, 0, 0);
+}
+
+// ============================================================================
+//                          可重启序列 (x86_64)
+// ============================================================================
+
+#define NVM_RSEQ_STR_(x) #x
+#define NVM_RSEQ_STR(x)  NVM_RSEQ_STR_(x)
+
+// 序列描述符：start_ip = 1, post_commit_ip = 2, abort_ip = 4
+#define NVM_RSEQ_ASM_DEFINE_TABLE                                   \
+    ".pushsection __rseq_cs, \"aw\"\n\t"                            \
+    ".balign 32\n\t"                                                \
+    "3:\n\t"                                                        \
+    ".long 0x0, 0x0\n\t"                                            \
+    ".quad 1f, (2f - 1f), 4f\n\t"                                   \
+    ".popsection\n\t"
+
+// 进入临界区：登记描述符，并确认仍在 cpu_id 上
+#define NVM_RSEQ_ASM_ENTER                                          \
+    "leaq 3b(%%rip), %%rax\n\t"                                     \
+    "movq %%rax, %[rseq_cs]\n\t"                                    \
+    "1:\n\t"                                                        \
+    "cmpl %[cpu_id], %[current_cpu_id]\n\t"                         \
+    "jnz 4f\n\t"
+
+// 中止入口：前 4 字节必须是注册时使用的签名 (ud1 指令编码，便于反汇编)
+#define NVM_RSEQ_ASM_DEFINE_ABORT                                   \
+    ".pushsection __rseq_failure, \"ax\"\n\t"                       \
+    ".byte 0x0f, 0xb9, 0x3d\n\t"                                    \
+    ".long " NVM_RSEQ_STR(RSEQ_SIG) "\n\t"                          \
+    "4:\n\t"                                                        \
+    "jmp %l[abort]\n\t"                                             \
+    ".popsection\n\t"
+
+/**
+ * @brief 在 CPU cpu 的私有栈上弹出一个元素
+ *
+ * 读取栈顶元素与提交新的栈深度位于同一序列内，序列被打断时整体重来，
+ * 因此无需任何原子指令。
+ *
+ * @param cpu 期望所在的 CPU (取自 nvm_rseq_cpu_id)
+ * @param stopped 非 0 时直接返回 MISS (栈正被其他线程排空)
+ * @param count 栈深度
+ * @param slots 栈数组
+ * @param out [输出] 弹出的元素
+ */
+static inline int nvm_rseq_percpu_pop(int cpu, const uint32_t* stopped, uint32_t* count,
+                                      void* const* slots, void** out) {
+    struct rseq* rs = nvm_rseq_area();
+    __asm__ __volatile__ goto (
+        NVM_RSEQ_ASM_DEFINE_TABLE
+        NVM_RSEQ_ASM_ENTER
+        "cmpl $0, (%[stopped])\n\t"
+        "jnz %l[miss]\n\t"
+        "movl (%[count]), %%ebx\n\t"
+        "testl %%ebx, %%ebx\n\t"
+        "jz %l[miss]\n\t"
+        "subl $1, %%ebx\n\t"
+        "movq (%[slots], %%rbx, 8), %%rcx\n\t"
+        "movq %%rcx, (%[out])\n\t"
+        // 提交
+        "movl %%ebx, (%[count])\n\t"
+        "2:\n\t"
+        NVM_RSEQ_ASM_DEFINE_ABORT
+        :
+        : [cpu_id] "r" (cpu), [current_cpu_id] "m" (rs->cpu_id), [rseq_cs] "m" (rs->rseq_cs),
+          [stopped] "r" (stopped), [count] "r" (count), [slots] "r" (slots), [out] "r" (out)
+        : "memory", "cc", "rax", "rbx", "rcx"
+        : abort, miss);
+    return NVM_RSEQ_OK;
+abort:
+    return NVM_RSEQ_ABORT;
+miss:
+    return NVM_RSEQ_MISS;
+}
+
+/**
+ * @brief 在 CPU cpu 的私有栈上压入一个元素
+ * @param capacity 栈容量
+ * @param item 待压入的元素
+ */
+static inline int nvm_rseq_percpu_push(int cpu, const uint32_t* stopped, uint32_t* count,
+                                       void** slots, uint32_t capacity, void* item) {
+    struct rseq* rs = nvm_rseq_area();
+    __asm__ __volatile__ goto (
+        NVM_RSEQ_ASM_DEFINE_TABLE
+        NVM_RSEQ_ASM_ENTER
+        "cmpl $0, (%[stopped])\n\t"
+        "jnz %l[miss]\n\t"
+        "movl (%[count]), %%ebx\n\t"
+        "cmpl %[capacity], %%ebx\n\t"
+        "jae %l[miss]\n\t"
+        "movq %[item], (%[slots], %%rbx, 8)\n\t"
+        "addl $1, %%ebx\n\t"
+        // 提交
+        "movl %%ebx, (%[count])\n\t"
+        "2:\n\t"
+        NVM_RSEQ_ASM_DEFINE_ABORT
+        :
+        : [cpu_id] "r" (cpu), [current_cpu_id] "m" (rs->cpu_id), [rseq_cs] "m" (rs->rseq_cs),
+          [stopped] "r" (stopped), [count] "r" (count), [slots] "r" (slots),
+          [capacity] "r" (capacity), [item] "r" (item)
+        : "memory", "cc", "rax", "rbx", "rcx"
+        : abort, miss);
+    return NVM_RSEQ_OK;
+abort:
+    return NVM_RSEQ_ABORT;
+miss:
+    return NVM_RSEQ_MISS;
+}
+
+/**
+ * @brief 在 CPU cpu 上把元素 item 头插到索引链表
+ *
+ * 表头高 32 位为链表长度，低 32 位为表头索引；原表头索引写入 *link 后，
+ * 以一次普通存储提交新表头。同一 CPU 上的压入与摘下 (nvm_rseq_percpu_take)
+ * 互不交错，无需原子指令。*gate 不等于 open 时直接返回 MISS (仅在序列开始时检查)。
+ *
+ * @param gate 闸门字节
+ * @param open 允许压入时闸门的取值
+ * @param head 链表表头
+ * @param link 元素的后继字段 (链表为空时写入的值无意义)
+ * @param item 元素索引
+ */
+static inline int nvm_rseq_percpu_link(int cpu, const uint8_t* gate, uint8_t open, uint64_t* head,
+                                       uint32_t* link, uint32_t item) {
+    struct rseq* rs = nvm_rseq_area();
+    __asm__ __volatile__ goto (
+        NVM_RSEQ_ASM_DEFINE_TABLE
+        NVM_RSEQ_ASM_ENTER
+        "movzbl (%[gate]), %%ebx\n\t"
+        "cmpl %[open], %%ebx\n\t"
+        "jnz %l[miss]\n\t"
+        "movq (%[head]), %%rbx\n\t"
+        "movl %%ebx, (%[link])\n\t"
+        "shrq $32, %%rbx\n\t"
+        "addq $1, %%rbx\n\t"
+        "shlq $32, %%rbx\n\t"
+        "movl %[item], %%ecx\n\t"
+        "orq %%rcx, %%rbx\n\t"
+        // 提交
+        "movq %%rbx, (%[head])\n\t"
+        "2:\n\t"
+        NVM_RSEQ_ASM_DEFINE_ABORT
+        :
+        : [cpu_id] "r" (cpu), [current_cpu_id] "m" (rs->cpu_id), [rseq_cs] "m" (rs->rseq_cs),
+          [gate] "r" (gate), [open] "r" ((uint32_t)open), [head] "r" (head), [link] "r" (link),
+          [item] "r" (item)
+        : "memory", "cc", "rax", "rbx", "rcx"
+        : abort, miss);
+    return NVM_RSEQ_OK;
+abort:
+    return NVM_RSEQ_ABORT;
+miss:
+    return NVM_RSEQ_MISS;
+}
+
+/**
+ * @brief 在 CPU cpu 上摘下整条链表 (读出表头并提交为 0)
+ * @param head 链表表头 (编码同 nvm_rseq_percpu_link)
+ * @param out [输出] 摘下的表头，仅在返回 OK 时有效
+ */
+static inline int nvm_rseq_percpu_take(int cpu, uint64_t* head, uint64_t* out) {
+    struct rseq* rs = nvm_rseq_area();
+    __asm__ __volatile__ goto (
+        NVM_RSEQ_ASM_DEFINE_TABLE
+        NVM_RSEQ_ASM_ENTER
+        "movq (%[head]), %%rbx\n\t"
+        "movq %%rbx, (%[out])\n\t"
+        // 提交
+        "movq $0, (%[head])\n\t"
+        "2:\n\t"
+        NVM_RSEQ_ASM_DEFINE_ABORT
+        :
+        : [cpu_id] "r" (cpu), [current_cpu_id] "m" (rs->cpu_id), [rseq_cs] "m" (rs->rseq_cs),
+          [head] "r" (head), [out] "r" (out)
+        : "memory", "cc", "rax", "rbx"
+        : abort);
+    return NVM_RSEQ_OK;
+abort:
+    return NVM_RSEQ_ABORT;
+}
+
+#else // !NVM_HAVE_RSEQ
+
+// 不支持 rseq 的平台：调用方退回到每 CPU 锁
+static inline int  nvm_rseq_cpu_id(void)      { return -1; }
+static inline bool nvm_rseq_fence_init(void)  { return false; }
+static inline void nvm_rseq_fence(void)       { }
+
+static inline int nvm_rseq_percpu_pop(int cpu, const uint32_t* stopped, uint32_t* count,
+                                      void* const* slots, void** out) {
+    (void)cpu; (void)stopped; (void)count; (void)slots; (void)out;
+    return NVM_RSEQ_MISS;
+}
+
+static inline int nvm_rseq_percpu_push(int cpu, const uint32_t* stopped, uint32_t* count,
+                                       void** slots, uint32_t capacity, void* item) {
+    (void)cpu; (void)stopped; (void)count; (void)slots; (void)capacity; (void)item;
+    return NVM_RSEQ_MISS;
+}
+
+static inline int nvm_rseq_percpu_link(int cpu, const uint8_t* gate, uint8_t open, uint64_t* head,
+                                       uint32_t* link, uint32_t item) {
+    (void)cpu; (void)gate; (void)open; (void)head; (void)link; (void)item;
+    return NVM_RSEQ_MISS;
+}
+
+static inline int nvm_rseq_percpu_take(int cpu, uint64_t* head, uint64_t* out) {
+    (void)cpu; (void)head; (void)out;
+    return NVM_RSEQ_ABORT;
+}
+
+#endif // NVM_HAVE_RSEQ
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NVM_RSEQ_H
\ No newline at end of file
@@ -1,122 +1,311 @@
-#ifndef NVM_SLAB_H
-#define NVM_SLAB_H
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-#include "NvmDefs.h"
-#include <stdbool.h> 
-
-// ============================================================================
-//                          核心数据结构
-// ============================================================================
-
-/**
- * @brief NVM Slab 元数据结构
- * 
- * 管理 NVM 中的一个固定大小的内存页 (2MB)，将其切分为固定大小的小块。
- * 包含 DRAM 中的元数据、自旋锁、本地缓存 (FreeList) 和位图。
- */
-typedef struct NvmSlab {
-    
-    // --- 1. 链表链接 ---
-    // 指向同尺寸类别 (Size Class) 链表中的下一个 Slab
-    // 仅被拥有该 Slab 的 CPU 在本地堆中访问，或在创建/销毁时访问
-    struct NvmSlab* next_in_chain;
-
-    // --- 2. 并发控制 ---
-    // 保护位图 (bitmap) 和 本地缓存 (free_block_buffer) 的并发访问
-    // 处理 Remote Free (跨线程释放) 时的竞争
-    nvm_spinlock_t lock;
-
-    // --- 3. 核心元数据 ---
-    uint64_t nvm_base_offset;         // Slab 在 NVM 物理空间中的起始偏移量
-    uint8_t  size_type_id;            // 对应的 SizeClassID
-    uint8_t  _padding[3];             // 内存对齐填充 (保证后续 uint32 对齐)
-    uint32_t block_size;              // 每个块的大小 (字节)
-    uint32_t total_block_count;       // 该 Slab 能容纳的总块数
-    uint32_t allocated_block_count;   // 当前已分配的块数 (用于判断是否满/空)
-
-    // --- 4. 本地缓存 (Software Cache / FreeList) ---
-    // 使用环形缓冲区作为一个固定大小的 LIFO/FIFO 缓存
-    // 用于加速分配和释放，减少位图扫描的开销
-    uint32_t cache_head;
-    uint32_t cache_tail;
-    uint32_t cache_count;
-    uint32_t free_block_buffer[SLAB_CACHE_SIZE];
-
-    // --- 5. 位图区域 (Flexible Array Member) ---
-    // 必须位于结构体末尾。用于记录所有块的分配状态 (0=空闲, 1=占用)
-    // 实际大小在创建时根据 block_size 动态计算分配
-    unsigned char bitmap[];
-
-} NvmSlab;
-
-
-#define IS_BIT_SET(bitmap, n)   ((bitmap[(n) / 8] >> ((n) % 8)) & 1)
-#define SET_BIT(bitmap, n)      (bitmap[(n) / 8] |= (1 << ((n) % 8)))
-#define CLEAR_BIT(bitmap, n)    (bitmap[(n) / 8] &= ~(1 << ((n) % 8)))
-
-// ============================================================================
-//                          生命周期管理
-// ============================================================================
-
-/**
- * @brief 创建并初始化 Slab 元数据 (DRAM)
- * @param sc_id 尺寸类别 ID
- * @param nvm_base_offset NVM 上的物理起始偏移
- * @return 成功返回指针，失败返回 NULL
- */
-NvmSlab* nvm_slab_create(SizeClassID sc_id, uint64_t nvm_base_offset);
-
-/**
- * @brief 销毁 Slab 元数据
- * 注意：不负责释放 NVM 物理空间，仅释放 DRAM 元数据
- */
-void nvm_slab_destroy(NvmSlab* self);
-
-// ============================================================================
-//                          核心操作 API
-// ============================================================================
-
-/**
- * @brief 从 Slab 中分配一个块
- * @param out_block_idx [输出] 分配到的块索引
- * @return 0 成功, -1 失败 (Slab 已满)
- */
-int nvm_slab_alloc(NvmSlab* self, uint32_t* out_block_idx);
-
-/**
- * @brief 归还一个块到 Slab
- * @param block_idx 块索引
- */
-void nvm_slab_free(NvmSlab* self, uint32_t block_idx);
-
-// ============================================================================
-//                          状态查询与恢复 API
-// ============================================================================
-
-/**
- * @brief 手动设置位图状态 (用于故障恢复)
- * 将指定索引的块标记为已占用
- */
-int nvm_slab_set_bitmap_at_idx(NvmSlab* self, uint32_t block_idx);
-
-/**
- * @brief 检查 Slab 是否已满
- * @note 这是一个乐观检查 (Relaxed Read)，通常不加锁
- */
-bool nvm_slab_is_full(const NvmSlab* self);
-
-/**
- * @brief 检查 Slab 是否完全为空
- * @note 这是一个乐观检查
- */
-bool nvm_slab_is_empty(const NvmSlab* self);
-
-#ifdef __cplusplus
-}
-#endif
-
+#ifndef NVM_SLAB_H
+#define NVM_SLAB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "NvmDefs.h"
+#include <stdbool.h> 
+
+struct NvmCpuHeap;                      // 所属堆 (分配器私有类型)
+
+// ============================================================================
+//                          核心数据结构
+// ============================================================================
+
+/**
+ * @brief Slab 在 CPU 堆中所属的链表
+ * 
+ * 每个 CPU 堆按尺寸类别维护 部分占用 / 已满 / 全空 三条链表，
+ * Slab 在满/非满、空/非空转换时于链表间迁移，使选取可用 Slab 为 O(1)。
+ */
+typedef enum {
+    SLAB_LIST_PARTIAL = 0,              // 部分占用：分配优先从这里取
+    SLAB_LIST_FULL,                     // 已满：分配路径不再访问
+    SLAB_LIST_EMPTY,                    // 全空：待复用
+    SLAB_LIST_COUNT,
+    SLAB_LIST_NONE = SLAB_LIST_COUNT    // 未挂载到任何链表
+} NvmSlabListID;
+
+/**
+ * @brief NVM Slab 元数据结构
+ * 
+ * 管理 NVM 中的一段连续空间 (跨度由尺寸类别决定，64KB ~ 4MB)，将其切分为固定大小的小块。
+ * 包含 DRAM 中的元数据、自旋锁、本地缓存 (FreeList) 和位图。
+ */
+typedef struct NvmSlab {
+    
+    // --- 1. 链表链接 ---
+    // 同尺寸类别 (Size Class) 链表中的前后 Slab (双向链表，O(1) 摘除)
+    // 由所属 CPU 堆的锁保护
+    struct NvmSlab* next_in_chain;
+    struct NvmSlab* prev_in_chain;
+    struct NvmCpuHeap* owner_heap;    // 所属堆 (CPU 堆或节点堆)
+    uint64_t        empty_since_ns;   // 进入全空链表的时间 (用于衰减归还)
+
+    // --- 2. 并发控制 ---
+    // 位图与本地缓存的分配、回收由所属堆锁串行化，远程释放与本地释放链表都不获取此锁。
+    // 此锁只在批量分配、回收远程链表与恢复置位的内部使用，使不经过堆的直接调用者
+    // (尚未挂载的 Slab、单元测试) 仍然安全；持有堆锁时它从不竞争
+    nvm_spinlock_t lock;
+
+    // --- 3. 核心元数据 ---
+    uint64_t nvm_base_offset;         // Slab 在 NVM 物理空间中的起始偏移量
+    uint64_t block_recip;             // ceil(2^NVM_SLAB_RECIP_SHIFT / block_size)，见 nvm_slab_block_index
+    uint8_t  size_type_id;            // 对应的 SizeClassID
+    uint8_t  list_id;                 // 当前所在链表 (NvmSlabListID)，原子访问
+    uint16_t region_id;               // 所属 NVM 区域 (即中心堆) 编号
+    uint32_t block_size;              // 每个块的大小 (字节)
+    uint32_t span_size;               // Slab 跨度 (字节)，按自身大小对齐
+    uint32_t total_block_count;       // 该 Slab 能容纳的总块数
+    uint32_t allocated_block_count;   // 当前已分配的块数 (用于判断是否满/空)
+
+    // --- 4. 本地缓存 (Software Cache / FreeList) ---
+    // 使用环形缓冲区作为一个固定大小的 LIFO/FIFO 缓存
+    // 用于加速分配和释放，减少位图扫描的开销
+    uint32_t cache_head;
+    uint32_t cache_tail;
+    uint32_t cache_count;
+    uint32_t free_block_buffer[SLAB_CACHE_SIZE];
+
+    // --- 本地释放链表 ---
+    // 所属 CPU 上的释放在可重启序列内压入此链表，不获取任何锁、不做原子读改写；
+    // 所属堆在持锁回填时于同一 CPU 上一次性摘下，其他 CPU 上 (trim、窃取、远程释放
+    // 触发的全空转换) 关闭闸门并执行 rseq 栅栏后摘下。编码与远程释放链表相同，
+    // 只在 Slab 位于部分占用链表时接受压入 (闸门为 list_id)
+    uint64_t local_free;
+
+    // --- 远程释放链表 (MPSC) ---
+    // 非所属 CPU 的释放无锁压入此链表，不触碰锁、缓存与位图；所属堆在下次
+    // 回填时一次性摘下整条链表。高 32 位为链表长度，低 32 位为表头块索引，
+    // 后继索引写在被释放块的前 4 字节中。与上方所属方频繁写入的字段相隔
+    // 整个环形缓冲区，避免远程释放与本地分配争抢同一缓存行
+    uint64_t remote_free;
+
+    // --- 5. 两级位图索引 ---
+    // summary 的第 i 位为 1 表示 bitmap[i] 中仍有空闲位，refill 时用 ctz 直接定位
+    // scan_cursor 为上次找到空闲块的 summary 字下标，下次从这里继续 (轮转扫描)
+    uint32_t  bitmap_words;           // bitmap 的 64 位字数
+    uint32_t  summary_words;          // summary 的 64 位字数
+    uint32_t  scan_cursor;
+    uint64_t* summary;                // 指向 bitmap 之后的摘要区
+
+    // 预留标记：第 i 位为 1 表示块 i 已由 nvm_reserve 交出、尚未发布或取消。
+    // 与位图字数相同，紧随摘要区；只做原子读改写，不受任何锁保护
+    uint64_t* reserved;
+
+    // --- 6. 位图区域 (Flexible Array Member) ---
+    // 必须位于结构体末尾。按 64 位字记录所有块的分配状态 (0=空闲, 1=占用)
+    // 末字中超出 total_block_count 的位恒为 1；摘要区与预留标记紧随其后，同一次分配
+    // 实际大小在创建时根据 block_size 动态计算分配
+    uint64_t bitmap[];
+
+} NvmSlab;
+
+
+// 块索引的乘法-移位除法：off * recip 与 off / block_size 的误差为 off * e / 2^42
+// (e = recip * block_size - 2^42 < block_size)，off < 2^22 (NVM_MAX_SLAB_SPAN) 且
+// block_size <= 2^19 时误差小于 1 / block_size，取整结果精确
+#define NVM_SLAB_RECIP_SHIFT 42
+
+#define IS_BIT_SET(bitmap, n)   (((bitmap)[(n) / 64] >> ((n) % 64)) & 1)
+#define SET_BIT(bitmap, n)      ((bitmap)[(n) / 64] |= (1ULL << ((n) % 64)))
+#define CLEAR_BIT(bitmap, n)    ((bitmap)[(n) / 64] &= ~(1ULL << ((n) % 64)))
+
+// ============================================================================
+//                          生命周期管理
+// ============================================================================
+
+/**
+ * @brief 创建并初始化 Slab 元数据 (DRAM)
+ * @param sc_id 尺寸类别 ID
+ * @param nvm_base_offset NVM 上的物理起始偏移
+ * @return 成功返回指针，失败返回 NULL
+ */
+NvmSlab* nvm_slab_create(SizeClassID sc_id, uint64_t nvm_base_offset);
+
+/**
+ * @brief 销毁 Slab 元数据
+ * 注意：不负责释放 NVM 物理空间，仅释放 DRAM 元数据
+ */
+void nvm_slab_destroy(NvmSlab* self);
+
+/**
+ * @brief 重置 Slab 元数据以便复用 (尺寸类别保持不变)
+ * 清空位图、缓存与计数，并绑定到新的 NVM 偏移。
+ * @note 调用方需保证此时没有其他线程在使用该 Slab
+ */
+void nvm_slab_reset(NvmSlab* self, uint64_t nvm_base_offset);
+
+// ============================================================================
+//                          核心操作 API
+// ============================================================================
+
+/**
+ * @brief 从 Slab 中批量分配块 (一次加锁)
+ * @param out_block_idx [输出] 块索引数组，容量至少为 count
+ * @param count 期望分配的块数
+ * @return 实际分配的块数 (Slab 耗尽时小于 count)
+ */
+uint32_t nvm_slab_alloc_batch(NvmSlab* self, uint32_t* out_block_idx, uint32_t count);
+
+/**
+ * @brief 本地释放：归还一个块到 Slab，不获取 Slab 锁，不做原子读改写
+ * 
+ * 调用方须持有串行化该 Slab 全部分配、回收与置位的锁 (所属堆锁)。
+ * 计数以普通存储更新，供无锁路径上的原子读取。
+ * 
+ * @param block_idx 块索引
+ */
+void nvm_slab_free_local(NvmSlab* self, uint32_t block_idx);
+
+/**
+ * @brief 本地释放链表：在 CPU cpu 的可重启序列内压入一个块，不加锁、无原子读改写
+ * 
+ * 只有全部压入都发生在同一 CPU 上时链表才是安全的，调用方须保证 cpu 为所属堆的 CPU。
+ * 块在被回收前仍计入已分配块数。
+ * 
+ * @param slab_addr Slab 映射到进程空间的起始地址 (链表指针写在块内)
+ * @param block_idx 块索引
+ * @param cpu 所属堆对应的 CPU (取自 nvm_rseq_cpu_id)
+ * @return 0 已压入; -1 序列被打断、已不在 cpu 上或 Slab 不在部分占用链表，调用方改走加锁释放
+ */
+int nvm_slab_local_push(NvmSlab* self, void* slab_addr, uint32_t block_idx, int cpu);
+
+/**
+ * @brief 回收本地释放链表 (由所属堆在持有堆锁时调用)
+ * 
+ * 在 CPU cpu 的可重启序列内摘下整条链表后逐块归还，不在 cpu 上时不做任何事。
+ * 
+ * @param slab_addr Slab 映射到进程空间的起始地址
+ * @param cpu 所属堆对应的 CPU
+ * @return 回收的块数
+ */
+uint32_t nvm_slab_collect_local(NvmSlab* self, const void* slab_addr, int cpu);
+
+/**
+ * @brief 在任意 CPU 上回收本地释放链表 (由所属堆在持有堆锁时调用)
+ * 
+ * 暂时关闭闸门 (list_id) 并执行 rseq 栅栏，此后不会再有压入序列提交，
+ * 再以原子交换摘下整条链表逐块归还。栅栏会打断所有 CPU，只用于慢路径。
+ * 
+ * @param slab_addr Slab 映射到进程空间的起始地址
+ * @return 回收的块数
+ */
+uint32_t nvm_slab_drain_local(NvmSlab* self, const void* slab_addr);
+
+/**
+ * @brief 标记块已被预留 (交给应用、尚未发布或取消)
+ * 
+ * 原子读改写，不获取 Slab 锁。
+ * 
+ * @param block_idx 块索引
+ * @return 0 成功, -1 索引越界或块已处于预留状态
+ */
+int nvm_slab_reserve_block(NvmSlab* self, uint32_t block_idx);
+
+/**
+ * @brief 清除块的预留标记 (发布或取消时)
+ * 
+ * 原子读改写，并发清除同一块时只有一方成功，块因此不会被两次交出。
+ * 
+ * @param block_idx 块索引
+ * @return 0 成功, -1 索引越界或块未被预留
+ */
+int nvm_slab_unreserve_block(NvmSlab* self, uint32_t block_idx);
+
+/**
+ * @brief 远程释放：将块无锁压入远程释放链表 (多生产者)
+ * 
+ * 只做一次 CAS，不获取 Slab 锁。块在被回收前仍计入已分配块数。
+ * 
+ * @param slab_addr Slab 映射到进程空间的起始地址 (链表指针写在块内)
+ * @param block_idx 块索引
+ * @return 压入后链表中待回收的块数
+ */
+uint32_t nvm_slab_remote_free(NvmSlab* self, void* slab_addr, uint32_t block_idx);
+
+/**
+ * @brief 回收远程释放链表 (由所属堆在持有堆锁时调用)
+ * 
+ * 一次原子交换摘下整条链表，并在一次加锁内全部归还。
+ * 
+ * @param slab_addr Slab 映射到进程空间的起始地址
+ * @return 回收的块数
+ */
+uint32_t nvm_slab_collect_remote(NvmSlab* self, const void* slab_addr);
+
+// ============================================================================
+//                          状态查询与恢复 API
+// ============================================================================
+
+/**
+ * @brief 手动设置位图状态 (用于故障恢复)
+ * 将指定索引的块标记为已占用
+ */
+int nvm_slab_set_bitmap_at_idx(NvmSlab* self, uint32_t block_idx);
+
+/**
+ * @brief 以整字拷贝的方式载入位图 (用于从持久位图重建 Slab)
+ * 
+ * 覆盖原有位图、清空缓存与远程释放链表，开销只与位图字数有关，与已分配块数无关。
+ * 
+ * @param words 位图 (至少 bitmap_words 个字，超出 total_block_count 的位被忽略)
+ * @return 载入后的已分配块数
+ */
+uint32_t nvm_slab_load_bitmap(NvmSlab* self, const uint64_t* words);
+
+/**
+ * @brief 检查 Slab 是否已满
+ * @note 这是一个乐观检查 (Relaxed Read)，通常不加锁
+ */
+bool nvm_slab_is_full(const NvmSlab* self);
+
+/**
+ * @brief 检查 Slab 是否完全为空
+ * @note 这是一个乐观检查
+ */
+bool nvm_slab_is_empty(const NvmSlab* self);
+
+/**
+ * @brief 远程释放链表中待回收的块数
+ * @note 这是一个乐观检查
+ */
+uint32_t nvm_slab_remote_pending(const NvmSlab* self);
+
+/**
+ * @brief 本地释放链表中待回收的块数
+ * @note 这是一个乐观检查
+ */
+uint32_t nvm_slab_local_pending(const NvmSlab* self);
+
+/**
+ * @brief 获取尺寸类别的块大小
+ * @return 块大小 (字节)，sc_id 无效时返回 0
+ */
+uint32_t nvm_slab_class_block_size(SizeClassID sc_id);
+
+/**
+ * @brief 获取尺寸类别的 Slab 跨度
+ * @return 跨度 (字节，NVM_SPAN_UNIT 的 2 的幂倍)，sc_id 无效时返回 0
+ */
+uint32_t nvm_slab_class_span_size(SizeClassID sc_id);
+
+/**
+ * @brief 计算 Slab 内偏移对应的块索引
+ * 
+ * 以预先计算的倒数做一次乘法和移位，代替释放路径上的除法指令
+ * (非 2 的幂的尺寸类别编译器无法优化为移位)。
+ * 
+ * @param offset_in_slab 相对 Slab 起始的偏移 (须小于 span_size)
+ */
+static inline uint32_t nvm_slab_block_index(const NvmSlab* self, uint64_t offset_in_slab) {
+    return (uint32_t)((offset_in_slab * self->block_recip) >> NVM_SLAB_RECIP_SHIFT);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // NVM_SLAB_H
\ No newline at end of file
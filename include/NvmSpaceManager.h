@@ -16,7 +16,11 @@ extern "C" {
  * @brief NVM 空闲空间管理器 (不透明句柄)
  * 
  * 负责管理大块连续的 NVM 物理空间。
- * 内部维护一个按地址排序的双向链表，支持合并与分割。
+ * 内部以 NVM_SPAN_UNIT 为单元维护伙伴系统 (每阶一张带摘要的空闲块位图)，
+ * 对齐的 2 的幂跨度分配/释放为 O(log n)，释放时与伙伴块立即合并。
+ * 极大连续空闲段另按地址与按大小各建一棵平衡树，非 2 的幂大小的分配 Best-Fit，O(log n)。
+ * 以上结构只登记回收过的空间；从未分配过的高端空间 (荒野) 以原子 CAS 推进的指针无锁切分，
+ * 紧邻荒野的释放直接退回荒野。
  * 
  * @note 线程安全：内部操作由互斥锁 (Mutex) 保护。
  */
@@ -36,7 +40,7 @@ FreeSpaceManager* space_manager_create(uint64_t total_nvm_size, uint64_t nvm_sta
 
 /**
  * @brief 销毁空间管理器
- * 释放链表节点内存和锁资源。
+ * 释放位图内存和锁资源。
  */
 void space_manager_destroy(FreeSpaceManager* manager);
 
@@ -45,8 +49,8 @@ void space_manager_destroy(FreeSpaceManager* manager);
 // ============================================================================
 
 /**
- * @brief 分配一个标准 Slab 大小的 NVM 块
- * 采用 First-Fit 策略。
+ * @brief 分配一个 NVM_SLAB_SIZE 大小且按其对齐的 NVM 块
+ * 取地址最低的足够大的空闲伙伴块。
  * @return 成功返回 NVM 偏移量，失败返回 (uint64_t)-1
  */
 uint64_t space_manager_alloc_slab(FreeSpaceManager* manager);
@@ -58,12 +62,73 @@ uint64_t space_manager_alloc_slab(FreeSpaceManager* manager);
  */
 void space_manager_free_slab(FreeSpaceManager* manager, uint64_t offset_to_free);
 
+/**
+ * @brief 分配一段连续的 NVM 空间 (用于大对象)
+ * 起始偏移至少按 NVM_SPAN_UNIT 对齐。回收空间优先：2 的幂大小取地址最低的伙伴块，
+ * 其他大小 (或没有单个伙伴块放得下时) 在按大小索引的空闲段中 Best-Fit；
+ * 回收空间放不下时无锁从荒野切分。
+ * @param size 字节数，须为 NVM_SPAN_UNIT 的整数倍
+ * @return 成功返回 NVM 偏移量，失败返回 (uint64_t)-1
+ */
+uint64_t space_manager_alloc(FreeSpaceManager* manager, uint64_t size);
+
+/**
+ * @brief 分配一段按 align 对齐的连续 NVM 空间 (用于 Slab 跨度)
+ * 对齐相对于创建时的起始偏移，拆分剩余的部分保留为空闲块。
+ * @param size 字节数，须为 NVM_SPAN_UNIT 的整数倍
+ * @param align 对齐 (2 的幂，且不小于 NVM_SPAN_UNIT)
+ * @return 成功返回 NVM 偏移量，失败返回 (uint64_t)-1
+ */
+uint64_t space_manager_alloc_aligned(FreeSpaceManager* manager, uint64_t size, uint64_t align);
+
+/**
+ * @brief 归还 space_manager_alloc 分配的空间
+ * 自动尝试与相邻的空闲块合并。
+ * @param offset_to_free 要释放的 NVM 偏移量
+ * @param size 分配时的字节数
+ */
+void space_manager_free(FreeSpaceManager* manager, uint64_t offset_to_free, uint64_t size);
+
 /**
  * @brief [故障恢复] 在指定偏移处强制占位
  * 用于在系统重启后，根据持久化数据恢复已分配的块状态。
+ * @param size 占位的字节数 (Slab 跨度)
  * @return 0 成功, -1 失败 (已被占用或无效)
  */
-int space_manager_alloc_at_offset(FreeSpaceManager* manager, uint64_t offset);
+int space_manager_alloc_at_offset(FreeSpaceManager* manager, uint64_t offset, uint64_t size);
+
+/**
+ * @brief [故障恢复] 在一批偏移处强制占位 (只加锁一次，按地址顺序单遍处理)
+ * 首尾相接的区间合并为一段占位。任何一段无法占位时，已占的部分全部归还。
+ * @param offsets 各区间起始偏移 (须按升序排列且互不重叠)
+ * @param sizes 各区间字节数
+ * @return 0 成功, -1 失败 (区间无效或已被占用，此时没有任何区间被占位)
+ */
+int space_manager_alloc_at_offsets(FreeSpaceManager* manager, const uint64_t* offsets,
+                                   const uint64_t* sizes, size_t count);
+
+// ============================================================================
+//                          查询 API
+// ============================================================================
+
+/**
+ * @brief 获取当前空闲的总字节数
+ */
+uint64_t space_manager_free_bytes(FreeSpaceManager* manager);
+
+/**
+ * @brief 获取当前最大连续空闲段的字节数 (O(1) 且无锁，调用方可据此提前判定分配失败)
+ */
+uint64_t space_manager_largest_free(FreeSpaceManager* manager);
+
+/**
+ * @brief 查找 from 所在单元及之后的第一个最大连续空闲段 (按地址遍历空闲空间)
+ * @param out_offset 空闲段起始偏移
+ * @param out_size 空闲段字节数
+ * @return 0 找到, -1 之后没有空闲空间
+ */
+int space_manager_next_free_range(FreeSpaceManager* manager, uint64_t from,
+                                  uint64_t* out_offset, uint64_t* out_size);
 
 #ifdef __cplusplus
 }
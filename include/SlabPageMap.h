@@ -0,0 +1,102 @@
+#ifndef SLAB_PAGE_MAP_H
+#define SLAB_PAGE_MAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "NvmDefs.h"
+#include "NvmSlab.h"
+#include "NvmExtent.h"
+
+// ============================================================================
+//                          类型定义
+// ============================================================================
+
+/**
+ * @brief Slab 页映射表 (不透明句柄)
+ * 
+ * 映射关系: (NVM Offset - 起始偏移) / NVM_SPAN_UNIT (页号) -> Slab Metadata Pointer
+ * 跨度为多个单元的 Slab 在其覆盖的每个页上都有表项，内部指针一次查找即可定位。
+ * 页也可以映射到大对象区块 (NvmExtent)，表项以指针最低位区分两种元数据。
+ * 两级基数树：根数组在创建时按 NVM 总大小一次分配，叶子数组按需分配。
+ * 
+ * @note 线程安全：查找为无锁 (wait-free) 的两次原子读；
+ *       插入/移除通过原子指针发布，叶子数组以 CAS 安装，均不加锁。
+ */
+typedef struct SlabPageMap SlabPageMap;
+
+// ============================================================================
+//                          生命周期管理
+// ============================================================================
+
+/**
+ * @brief 创建页映射表
+ * @param total_nvm_size NVM 总大小 (字节)，决定可映射的页数
+ * @param nvm_start_offset NVM 起始偏移量
+ * @return 成功返回句柄，失败返回 NULL
+ */
+SlabPageMap* slab_pagemap_create(uint64_t total_nvm_size, uint64_t nvm_start_offset);
+
+/**
+ * @brief 销毁页映射表
+ * 注意：只释放映射表结构本身，不释放其中存储的 Slab 指针。
+ */
+void slab_pagemap_destroy(SlabPageMap* map);
+
+// ============================================================================
+//                          核心操作 API
+// ============================================================================
+
+/**
+ * @brief 发布映射 (Release 语义，Slab 元数据须已初始化完毕)
+ * @param nvm_offset Slab 起始偏移 (须按 NVM_SPAN_UNIT 对齐)
+ * @param size Slab 跨度 (NVM_SPAN_UNIT 的整数倍)，覆盖的每个页都指向该 Slab
+ * @return 0 成功, -1 失败 (越界、任一页已存在或内存不足，失败时不留下部分映射)
+ */
+int slab_pagemap_insert(SlabPageMap* map, uint64_t nvm_offset, uint64_t size, NvmSlab* slab_ptr);
+
+/**
+ * @brief 查找映射 (wait-free)
+ * @param nvm_offset 任意 NVM 偏移，自动归属到所在页
+ * @return 成功返回 Slab 指针，未映射、越界或映射到区块时返回 NULL
+ */
+NvmSlab* slab_pagemap_lookup(const SlabPageMap* map, uint64_t nvm_offset);
+
+/**
+ * @brief 撤销映射
+ * @param size 插入时的跨度
+ * @return 被移除的 Slab 指针，未映射 (或映射到区块) 返回 NULL
+ */
+NvmSlab* slab_pagemap_remove(SlabPageMap* map, uint64_t nvm_offset, uint64_t size);
+
+/**
+ * @brief 发布大对象区块映射 (语义同 slab_pagemap_insert)
+ * @param nvm_offset 区块起始偏移 (须按 NVM_SPAN_UNIT 对齐)
+ * @param size 需要映射的字节数
+ */
+int slab_pagemap_insert_extent(SlabPageMap* map, uint64_t nvm_offset, uint64_t size, NvmExtent* extent_ptr);
+
+/**
+ * @brief 查找大对象区块映射 (wait-free)
+ * @return 页映射到区块时返回区块指针，否则 (未映射、越界或映射到 Slab) 返回 NULL
+ */
+NvmExtent* slab_pagemap_lookup_extent(const SlabPageMap* map, uint64_t nvm_offset);
+
+/**
+ * @brief 撤销大对象区块映射
+ * @param size 插入时映射的字节数
+ * @return 被移除的区块指针，页未映射到区块时返回 NULL
+ */
+NvmExtent* slab_pagemap_remove_extent(SlabPageMap* map, uint64_t nvm_offset, uint64_t size);
+
+/**
+ * @brief 获取当前已映射的页数 (Slab 与区块合计，统计用，非严格一致)
+ */
+uint32_t slab_pagemap_count(const SlabPageMap* map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SLAB_PAGE_MAP_H
\ No newline at end of file
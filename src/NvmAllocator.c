@@ -8,50 +8,338 @@
 //                          核心数据结构
 // ============================================================================
 
-// 中心堆：全局共享，组件内部自带锁保护
+// 中心堆：每个 NVM 区域一个 (通常每个 NUMA 节点一个)，组件内部自带锁保护
+// 各区域的偏移量均相对于本区域基址，互不相干
 typedef struct NvmCentralHeap {
     void*             nvm_base_addr;
+    uint64_t          nvm_size;
+    int               node;                // 区域物理所在的 NUMA 节点
+    uint16_t          region_id;           // 在 central_heaps 中的下标
+    uint32_t          attach_cursor;       // 重建/恢复的 Slab 下一次从哪个 CPU 开始轮转 (原子访问)
     FreeSpaceManager* space_manager;
-    SlabHashTable*    slab_lookup_table;
+    SlabHashTable*    slab_lookup_table;   // Slab 注册表 (慢路径与调试遍历)
+    SlabPageMap*      slab_page_map;       // 页号 -> Slab 的无锁查找表 (释放/恢复路径)
+    NvmLayout         layout;              // 区域开头的持久元数据 (超级块、跨度头部、持久位图、日志槽)
+    uint64_t          log_busy;            // 重做日志槽占用位图 (每槽一位，CAS 占用)
+
+    // 已退役 Slab 描述符缓存 (按尺寸类别)
+    // 描述符在分配器生命周期内不归还给系统 (类型稳定)，并发释放路径上的
+    // 过期指针最多读到被复用的描述符，会在所属堆锁内复查后放弃
+    nvm_spinlock_t    slab_cache_lock;
+    NvmSlab*          slab_cache[SC_COUNT];
+
+    // 大对象区块 (超过最大尺寸类别)，由 extent_lock 保护
+    // 页粒度区块 (多个对象共享一个 2MB 区块) 按最长连续空闲页数分箱，非空箱记在位图中：
+    // 分配时取不小于请求页数的首个非空箱，箱内任一区块必能放下，查找与区块数无关
+    nvm_mutex_t       extent_lock;
+    NvmExtent*        extent_chunk_bins[NVM_EXTENT_PAGES + 1];
+    uint64_t          extent_chunk_nonempty[NVM_EXTENT_PAGES / 64 + 1];
+    uint32_t          extent_chunk_count;
+    NvmExtent*        extent_spans;        // 巨型对象 (独占按跨度单元取整的连续空间)
+    // 已归还的区块描述符，与 Slab 描述符一样类型稳定：释放路径无锁查到的过期指针
+    // 最多读到被复用的描述符，会在 extent_lock 内复查页映射后放弃
+    NvmExtent*        extent_cache;
 } NvmCentralHeap;
 
-// CPU 堆：每个 CPU 独享，无锁访问，填充以避免伪共享
+// CPU 缓存：线程缓存与 Slab 链表之间的每 CPU 块栈 (对 Slab 而言均为已分配)
+// rseq 模式下只通过可重启序列访问，无锁无原子操作；否则由所在堆的 lock 保护
+// stopped 非 0 时 rseq 序列直接放弃：加锁路径 (排空、未注册 rseq 的线程) 把它从 OPEN
+// 改为 STOPPING 的一方在锁外执行一次 rseq 栅栏后置为 STOPPED，其余加锁者等待完成即可；
+// 加锁路径结束后保持 STOPPED，直到本 CPU 上的 rseq 线程在堆锁内重新开放，
+// 因此只有状态切换时才有栅栏，连续的加锁操作不再逐次打断所有 CPU
+enum { CPU_CACHE_OPEN = 0, CPU_CACHE_STOPPING = 1, CPU_CACHE_STOPPED = 2 };
+
+typedef struct NvmCpuCache {
+    uint32_t stopped;                       // CPU_CACHE_OPEN / STOPPING / STOPPED
+    uint32_t counts[SC_COUNT];
+    void*    slots[SC_COUNT][NVM_CPU_CACHE_SIZE];
+} NvmCpuCache;
+
+// CPU 堆：每个 CPU 独享，按尺寸类别维护 部分占用/已满/全空 三条链表
+// 链表迁移涉及多处写入，无法放进单次提交的可重启序列，仍由堆锁保护
+// (同核多线程、线程迁移时仍然安全)，填充以避免伪共享
+// 节点堆 (nvm_malloc_node) 复用同一结构，只是不使用 cpu_cache 与冷类别统计；
+// 节点堆同时是本节点各 CPU 冷类别的共享堆
 typedef struct NvmCpuHeap {
-    NvmSlab* slab_lists[SC_COUNT];
-    char     _padding[CACHE_LINE_SIZE - ((sizeof(NvmSlab*) * SC_COUNT) % CACHE_LINE_SIZE)];
+    nvm_spinlock_t     lock;
+    int                node;           // 所在 NUMA 节点 (节点堆为其节点号)
+    const uint16_t*    region_order;   // 切分新 Slab 时依次尝试的区域 (本节点优先，按距离递增)
+    struct NvmCpuHeap* shared_heap;    // 冷类别的共享堆 (所在节点的节点堆)，节点堆自身为 NULL
+    NvmSlab*           slab_lists[SC_COUNT][SLAB_LIST_COUNT];
+
+    // 冷类别统计，由 lock 保护：未晋升的类别从 shared_heap 分配
+    uint8_t            dedicated[SC_COUNT];         // 非 0 表示已晋升为独占 Slab
+    uint32_t           shared_blocks[SC_COUNT];     // 当前窗口内从共享 Slab 分配的块数
+    uint64_t           shared_window_ns[SC_COUNT];  // 当前窗口起点
+
+    // Slab 空间预留批次，由 lock 保护：[resv_next, resv_end) 是从区域 resv_region
+    // 预留的尚未切分的空间，两者相等表示没有预留
+    uint16_t           resv_region;
+    uint64_t           resv_next;
+    uint64_t           resv_end;
+    uint64_t           resv_batch;                  // 下一次预留的字节数 (2 的幂，0 表示只取所需跨度)
+    uint64_t           resv_refill_ns;              // 上一次预留的时间
+
+    NvmCpuCache        cpu_cache;
 } __attribute__((aligned(CACHE_LINE_SIZE))) NvmCpuHeap;
 
+// 弹匣：一组同类别的块 (对 Slab 而言均为已分配)，在线程缓存与仓库之间整体交换
+typedef struct NvmMagazine {
+    struct NvmMagazine* next;
+    uint32_t            count;
+    void*               blocks[NVM_MAGAZINE_CAPACITY];
+} NvmMagazine;
+
+// 弹匣仓库：每类别一个，满弹匣与空弹匣各成一条链表，锁内只做 O(1) 的链表摘挂
+// 生产者/消费者线程经由仓库整批交接空闲块，双方都不触碰 Slab 位图
+typedef struct NvmDepot {
+    nvm_spinlock_t lock;
+    NvmMagazine*   full;
+    NvmMagazine*   empty;
+    uint32_t       full_count;     // 锁内写入，锁外可原子读取作预检
+    uint32_t       empty_count;
+    uint32_t       mag_size;       // 当前弹匣大小，随观察到的争用增长 (锁外可原子读取)
+    uint32_t       lock_count;     // 本统计周期内的加锁次数
+    uint32_t       contended;      // 其中 trylock 失败的次数
+} __attribute__((aligned(CACHE_LINE_SIZE))) NvmDepot;
+
 // 顶层分配器结构
 typedef struct NvmAllocator {
-    NvmCentralHeap central_heap;
-    NvmCpuHeap     cpu_heaps[MAX_CPUS];
+    uint32_t        region_count;
+    NvmCentralHeap* central_heaps;  // 每个 NVM 区域一个中心堆
+    void**          region_bases;   // 各区域基址与大小 (按区域号索引，供重做日志解析目标)
+    uint64_t*       region_sizes;
+    uint32_t        node_count;     // 节点号上界，即 node_heaps 的长度与 region_order 的行数
+    uint16_t*       region_order;   // node_count 行 x region_count 列，第 n 行为节点 n 的区域回退顺序
+    uint64_t        generation;     // 实例代号 (>= 1)，线程缓存据此判断内容是否属于本实例
+    int64_t         decay_ms;       // 空 Slab 衰减时间 (见 NVM_SLAB_DECAY_MS)
+    uint32_t        promote_blocks; // 冷类别晋升阈值 (见 NVM_SHARED_PROMOTE_BLOCKS)
+    bool            rseq_enabled;   // CPU 缓存是否走 rseq 无锁路径
+    uint32_t        cache_limit[SC_COUNT];  // 每类别线程缓存/CPU 缓存的块数上限 (中型类别按字节数收紧)
+    uint32_t        cpu_count;      // 可能存在的 CPU 数，即 cpu_heaps 的长度
+    NvmCpuHeap**    cpu_heaps;      // 按 CPU ID 一一对应，各自分配在所属 CPU 的 NUMA 节点上
+    NvmCpuHeap**    node_heaps;     // 按节点号一一对应，供 nvm_malloc_node 使用
+    NvmDepot*       depots;         // 每类别一个弹匣仓库 (SC_COUNT 项)
+    nvm_mutex_t     restore_lock;   // 串行化恢复路径上 "查不到 Slab -> 占位 -> 注册" 的整个过程
 } NvmAllocator;
 
+// 日志槽占用位图每槽一位
+_Static_assert(NVM_LAYOUT_LOG_SLOTS == 64, "log_busy must cover exactly NVM_LAYOUT_LOG_SLOTS slots");
+
 static struct NvmAllocator* global_nvm_allocator = NULL;
+static uint64_t             global_allocator_generation = 0;
+
+// 线程缓存：每个线程按尺寸类别缓存一组已分配 (对 Slab 而言) 的块指针及其所属 Slab
+// 仅由所属线程访问；分配时直接用缓存的 Slab 置位持久位图，不再按指针查找
+typedef struct NvmThreadCacheBin {
+    uint32_t count;
+    void*    blocks[NVM_TCACHE_CAPACITY];   // 栈：blocks[count - 1] 为最近释放的块
+    NvmSlab* slabs[NVM_TCACHE_CAPACITY];    // 与 blocks 一一对应 (块在缓存中时 Slab 不会退役)
+} NvmThreadCacheBin;
+
+typedef struct NvmThreadCache {
+    uint64_t          generation;   // 绑定的分配器代号，0 表示未绑定
+    bool              disabled;
+    bool              registered;   // 已登记线程退出析构
+    NvmMagazine*      spare;        // 备用空弹匣 (与分配器实例无关)，与仓库交换时换出/换入
+    NvmThreadCacheBin bins[SC_COUNT];
+} NvmThreadCache;
+
+static NVM_THREAD_LOCAL NvmThreadCache thread_cache;
+static pthread_key_t                   thread_cache_key;
+static pthread_once_t                  thread_cache_key_once = PTHREAD_ONCE_INIT;
+
+// 事务：每个线程至多一个进行中的事务。日志项随操作直接写入所占的 NVM 日志槽，
+// 提交前项数保持为 0 (崩溃即丢弃)；DRAM 侧只记住块指针，供中止与提交后归还
+typedef struct NvmTx {
+    uint64_t generation;                    // 所属分配器代号，0 表示没有进行中的事务
+    bool     registered;                    // 已登记线程退出析构
+    uint16_t region_id;                     // 日志槽所在区域
+    uint32_t slot;
+    uint32_t entry_count;                   // 已写入日志槽的项数
+    uint32_t alloc_count;
+    uint32_t free_count;
+    void*    allocs[NVM_TX_MAX_OPS];        // 事务内预留的块，中止时归还
+    void*    frees[NVM_TX_MAX_OPS];         // 推迟到提交之后才归还的块
+} NvmTx;
+
+static NVM_THREAD_LOCAL NvmTx thread_tx;
+static pthread_key_t          thread_tx_key;
+static pthread_once_t         thread_tx_key_once = PTHREAD_ONCE_INIT;
+
+// 批量恢复：条目换算后的记录，按区域与偏移排序
+typedef struct NvmRestoreRecord {
+    uint64_t offset;                        // 块在区域内的偏移
+    uint16_t region_id;
+    uint8_t  sc_id;
+} NvmRestoreRecord;
+
+// 批量恢复：同一 Slab 上的记录 [begin, end)
+typedef struct NvmRestoreGroup {
+    NvmSlab* slab;                          // NULL 表示建立失败，跳过
+    uint64_t slab_base;
+    size_t   begin;
+    size_t   end;
+    uint16_t region_id;
+    uint8_t  sc_id;
+    bool     created;                       // 本批新建 (位图整字载入)，否则在已有 Slab 上逐块置位
+} NvmRestoreGroup;
+
+// 批量恢复的并行任务：各线程以原子递增的 next 领取分桶或分组
+typedef struct NvmRestoreJob {
+    NvmAllocator*     allocator;
+    NvmRestoreRecord* records;
+    size_t*           bucket_starts;        // bucket_count + 1 项，第 b 桶为 [bucket_starts[b], bucket_starts[b + 1])
+    uint32_t          bucket_count;
+    NvmRestoreGroup*  groups;
+    size_t            group_count;
+    size_t            next;
+    bool              failed;               // 某组置位失败 (原子写入)
+} NvmRestoreJob;
+
+// 尺寸 -> 类别查找表：小类别按 8B 粒度、中型类别按 1KB 粒度索引，
+// 由尺寸类别表生成一次 (首次创建分配器时)，此后只读
+static uint8_t        sc_small_lookup[NVM_SMALL_MAX_SIZE / NVM_SMALL_QUANTUM + 1];
+static uint8_t        sc_medium_lookup[NVM_MAX_SLAB_BLOCK_SIZE / NVM_MEDIUM_QUANTUM + 1];
+static pthread_once_t sc_lookup_once = PTHREAD_ONCE_INIT;
 
 // ============================================================================
 //                          内部函数前向声明
 // ============================================================================
 
 static SizeClassID   map_size_to_sc_id(size_t size);
-static void          remove_slab_from_list(NvmSlab** list_head, NvmSlab* slab_to_remove);
-static NvmAllocator* nvm_allocator_create_impl(void* nvm_base_addr, uint64_t nvm_size_bytes);
+static void          sc_lookup_build(void);
+static NvmCpuHeap*   cpu_heap_create(int node, const uint16_t* region_order);
+static void          cpu_heap_destroy(NvmCpuHeap* heap);
+static int           current_cpu_index(const NvmAllocator* allocator);
+static int           heap_local_cpu(const NvmAllocator* allocator, const NvmCpuHeap* heap);
+static int           build_region_order(NvmAllocator* allocator);
+static const uint16_t* region_order_of_node(const NvmAllocator* allocator, int node);
+static NvmCentralHeap* central_of_ptr(NvmAllocator* allocator, const void* nvm_ptr, uint64_t* out_offset);
+static char*         slab_addr_of(const NvmAllocator* allocator, const NvmSlab* slab);
+static void          heap_link_slab(NvmCpuHeap* heap, NvmSlab* slab, NvmSlabListID list_id);
+static void          heap_unlink_slab(NvmCpuHeap* heap, NvmSlab* slab);
+static void          heap_move_slab(NvmCpuHeap* heap, NvmSlab* slab, NvmSlabListID list_id);
+static NvmSlabListID heap_classify_slab(const NvmSlab* slab);
+static void          heap_collect_local(NvmAllocator* allocator, NvmCpuHeap* heap, NvmSlab* slab, const char* slab_addr);
+static NvmSlabListID heap_settle_slab(NvmAllocator* allocator, NvmCpuHeap* heap, NvmSlab* slab);
+static size_t        heap_decay_empty_slabs(NvmAllocator* allocator, NvmCpuHeap* heap, SizeClassID sc_id, bool force, NvmSlab** retired);
+static void          heap_retire_slabs(NvmAllocator* allocator, NvmSlab* retired);
+static size_t        heap_trim(NvmAllocator* allocator, NvmCpuHeap* heap);
+static uint64_t      heap_reserve_span(NvmAllocator* allocator, NvmCpuHeap* heap, uint16_t region_id, uint64_t span);
+static size_t        heap_release_reservation(NvmAllocator* allocator, NvmCpuHeap* heap);
+static void          heap_return_space(NvmAllocator* allocator, NvmCpuHeap* heap, uint16_t region_id, uint64_t offset, uint64_t size);
+static void          heaps_release_reservations(NvmAllocator* allocator);
+static NvmSlab*      heap_get_alloc_slab(NvmAllocator* allocator, NvmCpuHeap* heap, SizeClassID sc_id);
+static uint32_t      heap_alloc_blocks(NvmAllocator* allocator, NvmCpuHeap* heap, SizeClassID sc_id, void** out_blocks, uint32_t count);
+static uint32_t      cpu_heap_alloc_blocks(NvmAllocator* allocator, NvmCpuHeap* heap, SizeClassID sc_id, void** out_blocks, uint32_t count);
+static uint32_t      heap_take_partial(NvmAllocator* allocator, NvmCpuHeap* heap, SizeClassID sc_id, void** out_blocks, uint32_t count);
+static uint32_t      heap_steal_blocks(NvmAllocator* allocator, SizeClassID sc_id, void** out_blocks, uint32_t count);
+static void          heap_free_block(NvmAllocator* allocator, NvmSlab* slab, uint64_t nvm_offset);
+static NvmCpuHeap*   heap_lock_slab_owner(NvmCentralHeap* central, NvmSlab* slab, uint64_t slab_base);
+static void          heap_free_ptr(NvmAllocator* allocator, void* nvm_ptr);
+static void          heap_release_block(NvmAllocator* allocator, NvmSlab* slab, void* block, uint64_t nvm_offset);
+static void          heap_persist_block(NvmAllocator* allocator, NvmSlab* slab, const void* block);
+static NvmSlab*      heap_slab_of(NvmAllocator* allocator, const void* block);
+static uint32_t      cpu_cache_pop_batch(NvmAllocator* allocator, SizeClassID sc_id, void** out_blocks, uint32_t count);
+static uint32_t      cpu_cache_push_batch(NvmAllocator* allocator, SizeClassID sc_id, void** blocks, uint32_t count);
+static void          cpu_cache_stop(NvmCpuCache* cache);
+static void          cpu_cache_reopen(NvmCpuHeap* heap);
+static void          cpu_cache_lock(NvmAllocator* allocator, NvmCpuHeap* heap);
+static void          cpu_cache_unlock(NvmAllocator* allocator, NvmCpuHeap* heap);
+static uint32_t      cpu_cache_pop_locked(NvmAllocator* allocator, SizeClassID sc_id, void** out_blocks, uint32_t count);
+static uint32_t      cpu_cache_push_locked(NvmAllocator* allocator, SizeClassID sc_id, void** blocks, uint32_t count);
+static void          cpu_cache_drain_all(NvmAllocator* allocator);
+static void          depot_acquire(NvmDepot* depot, uint32_t max_size);
+static uint32_t      depot_push(NvmAllocator* allocator, NvmThreadCache* tc, SizeClassID sc_id, void** blocks, uint32_t count);
+static uint32_t      depot_pop(NvmAllocator* allocator, NvmThreadCache* tc, SizeClassID sc_id, void** out_blocks);
+static void          depot_drain_all(NvmAllocator* allocator);
+static NvmSlab*      central_acquire_slab(NvmCentralHeap* central, SizeClassID sc_id, uint64_t offset);
+static NvmSlab*      central_carve_slab(NvmCentralHeap* central, SizeClassID sc_id, uint64_t offset);
+static void          central_recycle_slab(NvmCentralHeap* central, NvmSlab* slab);
+static void          central_retire_slab(NvmCentralHeap* central, NvmSlab* slab);
+static int           central_attach(NvmAllocator* allocator, NvmCentralHeap* central);
+static NvmCpuHeap*   central_attach_heap(NvmAllocator* allocator, NvmCentralHeap* central);
+static int           central_attach_slab(NvmAllocator* allocator, NvmCentralHeap* central, uint64_t offset, NvmSpanHeader header);
+static int           central_attach_chunk(NvmCentralHeap* central, uint64_t offset, uint64_t span);
+static int           central_attach_huge(NvmCentralHeap* central, uint64_t offset, uint64_t span);
+static int           central_claim_log(NvmCentralHeap* central, uint32_t* out_slot);
+static void          central_release_log(NvmCentralHeap* central, uint32_t slot);
+static uint64_t      central_bitmap_target(NvmCentralHeap* central, NvmLogOp op, uint64_t slab_offset, uint32_t block_idx);
+static NvmSlab*      central_action_slab(NvmAllocator* allocator, const NvmAction* action);
+static int           allocator_replay_logs(NvmAllocator* allocator);
+static void          extent_link(NvmExtent** head, NvmExtent* extent);
+static void          extent_unlink(NvmExtent** head, NvmExtent* extent);
+static void          chunk_index_insert(NvmCentralHeap* central, NvmExtent* chunk);
+static void          chunk_index_remove(NvmCentralHeap* central, NvmExtent* chunk);
+static NvmExtent*    chunk_index_find(const NvmCentralHeap* central, uint32_t pages);
+static void*         extent_alloc(NvmAllocator* allocator, const NvmCpuHeap* heap, size_t size);
+static void*         central_alloc_extent(NvmCentralHeap* central, size_t size);
+static void          central_free_extent(NvmCentralHeap* central, NvmExtent* extent, uint64_t nvm_offset);
+static void          central_release_chunk(NvmCentralHeap* central, NvmExtent* extent);
+static NvmExtent*    central_acquire_extent(NvmCentralHeap* central, uint64_t offset, uint32_t span_units);
+static void          central_recycle_extent(NvmCentralHeap* central, NvmExtent* extent);
+static size_t        central_trim_extents(NvmCentralHeap* central);
+static NvmAllocator* nvm_allocator_create_impl(const NvmNodeRegion* regions, uint32_t region_count);
 static void          nvm_allocator_destroy_impl(NvmAllocator* allocator);
 static void*         nvm_malloc_impl(NvmAllocator* allocator, size_t size);
+static void*         nvm_malloc_slab(NvmAllocator* allocator, SizeClassID sc_id, NvmSlab** out_slab);
+static void*         nvm_malloc_class(NvmAllocator* allocator, SizeClassID sc_id, NvmSlab** out_slab);
+static void*         nvm_malloc_steal(NvmAllocator* allocator, SizeClassID sc_id, NvmSlab** out_slab);
+static size_t        nvm_malloc_reclaim(NvmAllocator* allocator);
+static void*         nvm_malloc_node_impl(NvmAllocator* allocator, size_t size, int node);
 static void          nvm_free_impl(NvmAllocator* allocator, void* nvm_ptr);
+static void*         nvm_reserve_impl(NvmAllocator* allocator, size_t size, NvmAction* action);
+static int           nvm_publish_impl(NvmAllocator* allocator, const NvmAction* actions, uint32_t count, uint64_t* const* dest_ptrs);
+static void          nvm_cancel_impl(NvmAllocator* allocator, const NvmAction* actions, uint32_t count);
+static NvmTx*        tx_current(NvmAllocator* allocator);
+static int           tx_record(NvmTx* tx, NvmRedoLog* log, uint64_t target, uint64_t value);
+static int           nvm_tx_begin_impl(NvmAllocator* allocator);
+static void*         nvm_tx_alloc_impl(NvmAllocator* allocator, size_t size);
+static int           nvm_tx_free_impl(NvmAllocator* allocator, void* nvm_ptr);
+static int           nvm_tx_set_impl(NvmAllocator* allocator, uint64_t* dest, uint64_t value);
+static int           nvm_tx_commit_impl(NvmAllocator* allocator);
+static void          nvm_tx_abort_impl(NvmAllocator* allocator);
+static void          tx_create_key(void);
+static void          tx_thread_exit(void* arg);
 static int           nvm_allocator_restore_allocation_impl(NvmAllocator* allocator, void* nvm_ptr, size_t size);
+static int           restore_convert(NvmAllocator* allocator, const NvmRestoreEntry* entry, NvmRestoreRecord* out);
+static uint32_t      restore_bucket_of(const NvmRestoreRecord* record, const uint64_t* bucket_span, uint32_t per_region);
+static int           restore_record_cmp(const void* a, const void* b);
+static void          restore_run(NvmRestoreJob* job, uint32_t threads, void* (*worker)(void*));
+static void*         restore_sort_worker(void* arg);
+static void*         restore_mark_worker(void* arg);
+static int           restore_mark_group(NvmAllocator* allocator, const NvmRestoreRecord* records, const NvmRestoreGroup* group);
+static int           restore_group_records(NvmRestoreJob* job, size_t count);
+static int           restore_reserve(NvmAllocator* allocator, const NvmRestoreJob* job, uint64_t* offsets, uint64_t* sizes);
+static void          restore_rollback(NvmAllocator* allocator, NvmRestoreJob* job, size_t failed);
+static int           nvm_allocator_restore_batch_impl(NvmAllocator* allocator, const NvmRestoreEntry* entries, size_t count);
+static size_t        nvm_malloc_trim_impl(NvmAllocator* allocator);
+static bool          tcache_bind(NvmAllocator* allocator, NvmThreadCache* tc);
+static void*         tcache_refill(NvmAllocator* allocator, NvmThreadCache* tc, NvmThreadCacheBin* bin, SizeClassID sc_id, NvmSlab** out_slab);
+static void          tcache_resolve_slabs(NvmAllocator* allocator, NvmThreadCacheBin* bin);
+static void          tcache_flush_bin(NvmAllocator* allocator, NvmThreadCacheBin* bin, uint32_t count);
+static void          tcache_spill_bin(NvmAllocator* allocator, NvmThreadCache* tc, NvmThreadCacheBin* bin, SizeClassID sc_id, uint32_t count);
+static void          tcache_flush_all(NvmAllocator* allocator, NvmThreadCache* tc);
+static void          tcache_create_key(void);
+static void          tcache_thread_exit(void* arg);
 
 // ============================================================================
 //                          公共 API 实现
 // ============================================================================
 
 int nvm_allocator_create(void* nvm_base_addr, uint64_t nvm_size_bytes) {
+    NvmNodeRegion region = { 0, nvm_base_addr, nvm_size_bytes };
+    return nvm_allocator_create_numa(&region, 1);
+}
+
+int nvm_allocator_create_numa(const NvmNodeRegion* regions, uint32_t region_count) {
     if (global_nvm_allocator != NULL) {
         LOG_ERR("Allocator already initialized.");
         return -1;
     }
     
-    global_nvm_allocator = nvm_allocator_create_impl(nvm_base_addr, nvm_size_bytes);
+    global_nvm_allocator = nvm_allocator_create_impl(regions, region_count);
     return (global_nvm_allocator == NULL) ? -1 : 0;
 }
 
@@ -60,6 +348,12 @@ void nvm_allocator_destroy(void) {
         nvm_allocator_destroy_impl(global_nvm_allocator);
         global_nvm_allocator = NULL;
     }
+    // 调用方此后可能解除 NVM 映射：本线程的写回就地完成，其他线程的待刷区间作废
+    nvm_drain();
+    nvm_persist_invalidate();
+    // 其他线程的备用弹匣在线程退出时释放
+    free(thread_cache.spare);
+    thread_cache.spare = NULL;
 }
 
 void* nvm_malloc(size_t size) {
@@ -78,6 +372,86 @@ void nvm_free(void* nvm_ptr) {
     nvm_free_impl(global_nvm_allocator, nvm_ptr);
 }
 
+void* nvm_malloc_node(size_t size, int node) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return NULL;
+    }
+    return nvm_malloc_node_impl(global_nvm_allocator, size, node);
+}
+
+void* nvm_reserve(size_t size, NvmAction* action) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return NULL;
+    }
+    return nvm_reserve_impl(global_nvm_allocator, size, action);
+}
+
+int nvm_publish(const NvmAction* actions, uint32_t count, uint64_t* const* dest_ptrs) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return -1;
+    }
+    return nvm_publish_impl(global_nvm_allocator, actions, count, dest_ptrs);
+}
+
+void nvm_cancel(const NvmAction* actions, uint32_t count) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return;
+    }
+    nvm_cancel_impl(global_nvm_allocator, actions, count);
+}
+
+int nvm_tx_begin(void) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return -1;
+    }
+    return nvm_tx_begin_impl(global_nvm_allocator);
+}
+
+void* nvm_tx_alloc(size_t size) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return NULL;
+    }
+    return nvm_tx_alloc_impl(global_nvm_allocator, size);
+}
+
+int nvm_tx_free(void* nvm_ptr) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return -1;
+    }
+    return nvm_tx_free_impl(global_nvm_allocator, nvm_ptr);
+}
+
+int nvm_tx_set(uint64_t* dest, uint64_t value) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return -1;
+    }
+    return nvm_tx_set_impl(global_nvm_allocator, dest, value);
+}
+
+int nvm_tx_commit(void) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return -1;
+    }
+    return nvm_tx_commit_impl(global_nvm_allocator);
+}
+
+void nvm_tx_abort(void) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return;
+    }
+    nvm_tx_abort_impl(global_nvm_allocator);
+}
+
 int nvm_allocator_restore_allocation(void* nvm_ptr, size_t size) {
     if (global_nvm_allocator == NULL) {
         LOG_ERR("Allocator not initialized.");
@@ -86,230 +460,2862 @@ int nvm_allocator_restore_allocation(void* nvm_ptr, size_t size) {
     return nvm_allocator_restore_allocation_impl(global_nvm_allocator, nvm_ptr, size);
 }
 
+int nvm_allocator_restore_batch(const NvmRestoreEntry* entries, size_t count) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return -1;
+    }
+    return nvm_allocator_restore_batch_impl(global_nvm_allocator, entries, count);
+}
+
+size_t nvm_malloc_trim(void) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return 0;
+    }
+    return nvm_malloc_reclaim(global_nvm_allocator);
+}
+
+void nvm_allocator_set_decay_ms(int64_t decay_ms) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return;
+    }
+    __atomic_store_n(&global_nvm_allocator->decay_ms, decay_ms, __ATOMIC_RELAXED);
+}
+
+void nvm_allocator_set_promote_threshold(uint32_t blocks) {
+    if (global_nvm_allocator == NULL) {
+        LOG_ERR("Allocator not initialized.");
+        return;
+    }
+    __atomic_store_n(&global_nvm_allocator->promote_blocks, blocks, __ATOMIC_RELAXED);
+}
+
+void nvm_thread_cache_flush(void) {
+    nvm_drain();
+    if (global_nvm_allocator == NULL) return;
+    tcache_flush_all(global_nvm_allocator, &thread_cache);
+}
+
+void nvm_thread_cache_set_enabled(bool enabled) {
+    NvmThreadCache* tc = &thread_cache;
+    if (!enabled && global_nvm_allocator != NULL) {
+        tcache_flush_all(global_nvm_allocator, tc);
+    }
+    tc->disabled   = !enabled;
+    tc->generation = 0;
+}
+
 // ============================================================================
 //                          内部函数实现
 // ============================================================================
 
+// 一次查表，返回 SC_COUNT 表示超出 Slab 尺寸类别
 static SizeClassID map_size_to_sc_id(size_t size) {
-    if (size <= 8)    return SC_8B;
-    if (size <= 16)   return SC_16B;
-    if (size <= 32)   return SC_32B;
-    if (size <= 64)   return SC_64B;
-    if (size <= 128)  return SC_128B;
-    if (size <= 256)  return SC_256B;
-    if (size <= 512)  return SC_512B;
-    if (size <= 1024) return SC_1K;
-    if (size <= 2048) return SC_2K;
-    if (size <= 4096) return SC_4K;
+    if (NVM_LIKELY(size <= NVM_SMALL_MAX_SIZE)) {
+        return (SizeClassID)sc_small_lookup[(size + NVM_SMALL_QUANTUM - 1) / NVM_SMALL_QUANTUM];
+    }
+    if (size <= NVM_MAX_SLAB_BLOCK_SIZE) {
+        return (SizeClassID)sc_medium_lookup[(size + NVM_MEDIUM_QUANTUM - 1) / NVM_MEDIUM_QUANTUM];
+    }
     return SC_COUNT;
 }
 
-static void remove_slab_from_list(NvmSlab** list_head, NvmSlab* slab_to_remove) {
-    if (!list_head || !*list_head || !slab_to_remove) return;
+// 第 i 项为能容纳 i 个粒度的最小类别 (各类别块大小都是所在区间粒度的整数倍)
+static void sc_lookup_build(void) {
+    int sc = 0;
+    for (uint32_t i = 0; i < sizeof(sc_small_lookup); ++i) {
+        while (nvm_slab_class_block_size((SizeClassID)sc) < i * NVM_SMALL_QUANTUM) sc++;
+        sc_small_lookup[i] = (uint8_t)sc;
+    }
+    for (uint32_t i = 0; i < sizeof(sc_medium_lookup); ++i) {
+        while (nvm_slab_class_block_size((SizeClassID)sc) < i * NVM_MEDIUM_QUANTUM) sc++;
+        sc_medium_lookup[i] = (uint8_t)sc;
+    }
+}
+
+// 在指定 NUMA 节点上创建堆，切分 Slab 时按 region_order 依次尝试各区域
+static NvmCpuHeap* cpu_heap_create(int node, const uint16_t* region_order) {
+    NvmCpuHeap* heap = (NvmCpuHeap*)nvm_numa_alloc_onnode(sizeof(NvmCpuHeap), node);
+    if (!heap) {
+        LOG_ERR("Failed to allocate heap on node %d.", node);
+        return NULL;
+    }
+    // 内存已清零，所有链表头均为 NULL
+    NVM_SPINLOCK_INIT(&heap->lock);
+    heap->node         = node;
+    heap->region_order = region_order;
+    return heap;
+}
 
-    if (*list_head == slab_to_remove) {
-        *list_head = slab_to_remove->next_in_chain;
-        return;
+// 销毁堆及其链表上的全部 Slab 描述符
+static void cpu_heap_destroy(NvmCpuHeap* heap) {
+    if (!heap) return;
+    for (int j = 0; j < SC_COUNT; ++j) {
+        for (int k = 0; k < SLAB_LIST_COUNT; ++k) {
+            NvmSlab* curr = heap->slab_lists[j][k];
+            while (curr) {
+                NvmSlab* next = curr->next_in_chain;
+                nvm_slab_destroy(curr);
+                curr = next;
+            }
+        }
+    }
+    NVM_SPINLOCK_DESTROY(&heap->lock);
+    nvm_numa_free(heap, sizeof(NvmCpuHeap));
+}
+
+// 当前 CPU 对应的堆下标
+static int current_cpu_index(const NvmAllocator* allocator) {
+    int cpu = NVM_GET_CURRENT_CPU_ID();
+    // CPU ID 总在 possible 范围内；仅防御异常的热插拔配置
+    if (NVM_UNLIKELY((uint32_t)cpu >= allocator->cpu_count)) return 0;
+    return cpu;
+}
+
+// 当前线程 (经 rseq 读取) 正运行在 CPU 堆 heap 所属的 CPU 上时返回该 CPU，否则返回 -1
+// 节点堆不对应任何 CPU，恒返回 -1
+static int heap_local_cpu(const NvmAllocator* allocator, const NvmCpuHeap* heap) {
+    int cpu = nvm_rseq_cpu_id();
+    if (cpu < 0 || (uint32_t)cpu >= allocator->cpu_count || allocator->cpu_heaps[cpu] != heap) return -1;
+    return cpu;
+}
+
+// 为每个节点生成区域回退顺序：按节点距离升序，距离相同时按区域下标
+static int build_region_order(NvmAllocator* allocator) {
+    uint32_t regions = allocator->region_count;
+    allocator->region_order = (uint16_t*)calloc((size_t)allocator->node_count * regions, sizeof(uint16_t));
+    int* distance = (int*)calloc(regions, sizeof(int));
+    if (!allocator->region_order || !distance) {
+        free(distance);
+        LOG_ERR("Failed to allocate region order table.");
+        return -1;
     }
 
-    NvmSlab* current = *list_head;
-    while (current->next_in_chain && current->next_in_chain != slab_to_remove) {
-        current = current->next_in_chain;
+    for (uint32_t n = 0; n < allocator->node_count; ++n) {
+        uint16_t* row = &allocator->region_order[(size_t)n * regions];
+        for (uint32_t i = 0; i < regions; ++i) {
+            distance[i] = nvm_numa_distance((int)n, allocator->central_heaps[i].node);
+        }
+        // 插入排序 (稳定)：区域数很少，且只在初始化时执行
+        for (uint32_t i = 0; i < regions; ++i) {
+            uint32_t j = i;
+            while (j > 0 && distance[row[j - 1]] > distance[i]) {
+                row[j] = row[j - 1];
+                j--;
+            }
+            row[j] = (uint16_t)i;
+        }
     }
 
-    if (current->next_in_chain == slab_to_remove) {
-        current->next_in_chain = slab_to_remove->next_in_chain;
+    free(distance);
+    return 0;
+}
+
+static const uint16_t* region_order_of_node(const NvmAllocator* allocator, int node) {
+    // 拓扑中不存在的节点退回节点 0 的顺序
+    if (node < 0 || (uint32_t)node >= allocator->node_count) node = 0;
+    return &allocator->region_order[(size_t)node * allocator->region_count];
+}
+
+// 按指针定位所属区域，并给出区域内偏移；不属于任何区域时返回 NULL
+// 区域数很少 (通常等于节点数)，线性查找即可
+static NvmCentralHeap* central_of_ptr(NvmAllocator* allocator, const void* nvm_ptr, uint64_t* out_offset) {
+    uintptr_t addr = (uintptr_t)nvm_ptr;
+    for (uint32_t i = 0; i < allocator->region_count; ++i) {
+        NvmCentralHeap* central = &allocator->central_heaps[i];
+        uintptr_t base = (uintptr_t)central->nvm_base_addr;
+        if (addr >= base && addr - base < central->nvm_size) {
+            *out_offset = (uint64_t)(addr - base);
+            return central;
+        }
     }
+    return NULL;
 }
 
-static NvmAllocator* nvm_allocator_create_impl(void* nvm_base_addr, uint64_t nvm_size_bytes) {
-    if (!nvm_base_addr) return NULL;
+// Slab 映射到进程空间的起始地址
+static char* slab_addr_of(const NvmAllocator* allocator, const NvmSlab* slab) {
+    return (char*)allocator->central_heaps[slab->region_id].nvm_base_addr + slab->nvm_base_offset;
+}
 
-    // 使用 calloc 自动初始化为 0，省去手动循环初始化 CPU Heaps
-    NvmAllocator* allocator = (NvmAllocator*)calloc(1, sizeof(NvmAllocator));
-    if (!allocator) {
-        LOG_ERR("Failed to allocate allocator struct.");
-        return NULL;
+// 以下链表操作均假设已持有 heap->lock
+static void heap_link_slab(NvmCpuHeap* heap, NvmSlab* slab, NvmSlabListID list_id) {
+    NvmSlab** head = &heap->slab_lists[slab->size_type_id][list_id];
+
+    // 头插法
+    slab->prev_in_chain = NULL;
+    slab->next_in_chain = *head;
+    if (*head) (*head)->prev_in_chain = slab;
+    *head = slab;
+
+    if (list_id == SLAB_LIST_EMPTY) slab->empty_since_ns = nvm_get_time_ns();
+    __atomic_store_n(&slab->list_id, (uint8_t)list_id, __ATOMIC_SEQ_CST);
+}
+
+static void heap_unlink_slab(NvmCpuHeap* heap, NvmSlab* slab) {
+    if (slab->list_id == SLAB_LIST_NONE) return;
+
+    if (slab->prev_in_chain) slab->prev_in_chain->next_in_chain = slab->next_in_chain;
+    else                     heap->slab_lists[slab->size_type_id][slab->list_id] = slab->next_in_chain;
+
+    if (slab->next_in_chain) slab->next_in_chain->prev_in_chain = slab->prev_in_chain;
+
+    slab->prev_in_chain = NULL;
+    slab->next_in_chain = NULL;
+    __atomic_store_n(&slab->list_id, (uint8_t)SLAB_LIST_NONE, __ATOMIC_SEQ_CST);
+}
+
+static void heap_move_slab(NvmCpuHeap* heap, NvmSlab* slab, NvmSlabListID list_id) {
+    if (slab->list_id == list_id) return;
+    heap_unlink_slab(heap, slab);
+    heap_link_slab(heap, slab, list_id);
+}
+
+static NvmSlabListID heap_classify_slab(const NvmSlab* slab) {
+    if (nvm_slab_is_full(slab))  return SLAB_LIST_FULL;
+    if (nvm_slab_is_empty(slab)) return SLAB_LIST_EMPTY;
+    return SLAB_LIST_PARTIAL;
+}
+
+// 假设已持有 heap->lock
+// 回收本地释放链表：在所属 CPU 上经可重启序列摘下；在别的 CPU 上 (trim、窃取、
+// 远程释放触发的全空转换) 或序列被打断时关闭闸门并执行 rseq 栅栏后摘下
+static void heap_collect_local(NvmAllocator* allocator, NvmCpuHeap* heap, NvmSlab* slab, const char* slab_addr) {
+    if (nvm_slab_local_pending(slab) == 0) return;
+    int cpu = heap_local_cpu(allocator, heap);
+    if (cpu < 0 || nvm_slab_collect_local(slab, slab_addr, cpu) == 0) {
+        nvm_slab_drain_local(slab, slab_addr);
     }
+}
 
-    // 初始化中心堆组件
-    allocator->central_heap.nvm_base_addr = nvm_base_addr;
-    allocator->central_heap.space_manager = space_manager_create(nvm_size_bytes, NVM_START_OFFSET);
-    allocator->central_heap.slab_lookup_table = slab_hashtable_create(INITIAL_HASHTABLE_CAPACITY);
+// 假设已持有 heap->lock
+// 回收远程与本地释放链表，并按占用状态把 Slab 迁移到对应链表，返回新链表
+// 移入已满链表时先发布 list_id 再复查远程链表，与 heap_free_block 中远程释放
+// "先压入远程链表再读 list_id" 配对，避免 Slab 滞留在已满链表。
+// 本地释放的压入只在部分占用时接受：已满发布之后只可能有此前越过闸门的序列提交，
+// 复查时再回收一次即可 (跨 CPU 回收的栅栏保证不会有更晚的提交)
+static NvmSlabListID heap_settle_slab(NvmAllocator* allocator, NvmCpuHeap* heap, NvmSlab* slab) {
+    const char* slab_addr = slab_addr_of(allocator, slab);
+    NvmSlabListID list_id;
+    for (;;) {
+        nvm_slab_collect_remote(slab, slab_addr);
+        heap_collect_local(allocator, heap, slab, slab_addr);
+        list_id = heap_classify_slab(slab);
+        heap_move_slab(heap, slab, list_id);
+        if (list_id != SLAB_LIST_FULL) break;
 
-    if (!allocator->central_heap.space_manager || !allocator->central_heap.slab_lookup_table) {
-        LOG_ERR("Failed to create central heap components.");
-        nvm_allocator_destroy_impl(allocator);
-        return NULL;
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (nvm_slab_is_full(slab) && nvm_slab_remote_pending(slab) == 0 &&
+            nvm_slab_local_pending(slab) == 0) break;
     }
+    return list_id;
+}
 
-    return allocator;
+// 假设已持有 heap->lock
+// 将空闲时间超过衰减阈值 (force 时为全部) 的空 Slab 摘链并挂到 *retired 上，返回其字节数
+// 退役要获取哈希表读写锁、空间管理器互斥锁并写回持久头部，由调用方放开堆锁后
+// 交给 heap_retire_slabs 完成
+static size_t heap_decay_empty_slabs(NvmAllocator* allocator, NvmCpuHeap* heap, SizeClassID sc_id, bool force, NvmSlab** retired) {
+    int64_t decay_ms = __atomic_load_n(&allocator->decay_ms, __ATOMIC_RELAXED);
+    if (!force && decay_ms < 0) return 0;
+
+    uint64_t now = nvm_get_time_ns();
+    uint64_t decay_ns = force ? 0 : (uint64_t)decay_ms * 1000000ULL;
+    size_t released = 0;
+
+    NvmSlab* curr = heap->slab_lists[sc_id][SLAB_LIST_EMPTY];
+    while (curr) {
+        NvmSlab* next = curr->next_in_chain;
+        if (now - curr->empty_since_ns >= decay_ns) {
+            // 先摘链 (list_id 置为 NONE)，使并发释放路径的复查放弃该 Slab
+            heap_unlink_slab(heap, curr);
+            released += curr->span_size;
+            curr->next_in_chain = *retired;
+            *retired = curr;
+        }
+        curr = next;
+    }
+
+    // 独占 Slab 全部归还后，该类别回到共享模式，重新统计分配速率
+    if (released > 0 && !heap->slab_lists[sc_id][SLAB_LIST_PARTIAL] &&
+        !heap->slab_lists[sc_id][SLAB_LIST_FULL] && !heap->slab_lists[sc_id][SLAB_LIST_EMPTY]) {
+        heap->dedicated[sc_id]     = 0;
+        heap->shared_blocks[sc_id] = 0;
+    }
+    return released;
 }
 
-static void nvm_allocator_destroy_impl(NvmAllocator* allocator) {
-    if (!allocator) return;
+// 调用方不得持有任何堆锁
+// 退役 heap_decay_empty_slabs 摘下的 Slab (已不在任何链表上，分配路径不会再取到)
+static void heap_retire_slabs(NvmAllocator* allocator, NvmSlab* retired) {
+    while (retired) {
+        NvmSlab* next = retired->next_in_chain;
+        central_retire_slab(&allocator->central_heaps[retired->region_id], retired);
+        retired = next;
+    }
+}
 
-    // 销毁所有 CPU 堆中的 Slab
-    for (int i = 0; i < MAX_CPUS; ++i) {
-        for (int j = 0; j < SC_COUNT; ++j) {
-            NvmSlab* curr = allocator->cpu_heaps[i].slab_lists[j];
+// 回收堆中所有 Slab 的远程与本地释放，并立即归还所有空 Slab，返回归还的字节数
+static size_t heap_trim(NvmAllocator* allocator, NvmCpuHeap* heap) {
+    NvmSlab* retired = NULL;
+    size_t released = 0;
+
+    NVM_SPINLOCK_ACQUIRE(&heap->lock);
+    for (int j = 0; j < SC_COUNT; ++j) {
+        // 先处理部分占用链表：已满 Slab 回收后头插到部分占用链表，不会被重复访问
+        static const NvmSlabListID lists[] = { SLAB_LIST_PARTIAL, SLAB_LIST_FULL };
+        for (int k = 0; k < 2; ++k) {
+            NvmSlab* curr = heap->slab_lists[j][lists[k]];
             while (curr) {
                 NvmSlab* next = curr->next_in_chain;
-                nvm_slab_destroy(curr);
+                if (nvm_slab_remote_pending(curr) > 0 || nvm_slab_local_pending(curr) > 0) {
+                    heap_settle_slab(allocator, heap, curr);
+                }
                 curr = next;
             }
         }
+        if (heap->slab_lists[j][SLAB_LIST_EMPTY]) {
+            released += heap_decay_empty_slabs(allocator, heap, (SizeClassID)j, true, &retired);
+        }
     }
+    // 归还未切分的预留 (最后一步，期间会暂时放开堆锁)，批次回到初始大小
+    heap->resv_batch = 0;
+    released += heap_release_reservation(allocator, heap);
+    NVM_SPINLOCK_RELEASE(&heap->lock);
 
-    // 销毁中心堆组件
-    if (allocator->central_heap.space_manager) 
-        space_manager_destroy(allocator->central_heap.space_manager);
-    if (allocator->central_heap.slab_lookup_table) 
-        slab_hashtable_destroy(allocator->central_heap.slab_lookup_table);
-
-    free(allocator);
+    heap_retire_slabs(allocator, retired);
+    return released;
 }
 
-static void* nvm_malloc_impl(NvmAllocator* allocator, size_t size) {
-    if (!allocator || size == 0) return NULL;
+// 假设已持有 heap->lock，期间可能暂时放开
+// 为一个 Slab 跨度取得 NVM 空间：优先从本堆在该区域的预留批次中切分 (不获取空间管理器的锁)，
+// 批次用完时按切分速率调整批次大小并重新预留。空间管理器持有互斥锁且可能分配内存，
+// 只在放开堆锁后调用。返回偏移量，区域耗尽时返回 (uint64_t)-1
+static uint64_t heap_reserve_span(NvmAllocator* allocator, NvmCpuHeap* heap, uint16_t region_id, uint64_t span) {
+    NvmCentralHeap* central = &allocator->central_heaps[region_id];
 
-    SizeClassID sc_id = map_size_to_sc_id(size);
-    if (sc_id == SC_COUNT) {
-        LOG_ERR("Size too large for slab allocation: %zu", size);
-        return NULL;
+    // [Fast Path] 批次内切分：跨度自然对齐，对齐产生的空隙 (仅在类别交替时出现) 先摘下再归还
+    if (heap->resv_next < heap->resv_end && heap->resv_region == region_id) {
+        uint64_t offset = NVM_ALIGN_UP(heap->resv_next - NVM_START_OFFSET, span) + NVM_START_OFFSET;
+        if (offset + span <= heap->resv_end) {
+            uint64_t gap = heap->resv_next;
+            heap->resv_next = offset + span;
+            if (offset > gap) heap_return_space(allocator, heap, region_id, gap, offset - gap);
+            return offset;
+        }
     }
 
-    // 获取当前 CPU 堆
-    int cpu_id = NVM_GET_CURRENT_CPU_ID();
-    NvmCpuHeap* current_cpu_heap = &allocator->cpu_heaps[cpu_id];
-    NvmSlab* target_slab = current_cpu_heap->slab_lists[sc_id];
+    // [Slow Path] 摘下剩余部分后重新预留：两次预留间隔很短说明该 CPU 正在快速消耗 Slab
+    uint16_t old_region = heap->resv_region;
+    uint64_t old_next   = heap->resv_next;
+    uint64_t old_end    = heap->resv_end;
+    heap->resv_next = heap->resv_end = 0;
 
-    // [Fast Path] 查找本地缓存的可用 Slab
-    while (target_slab && nvm_slab_is_full(target_slab)) {
-        target_slab = target_slab->next_in_chain;
+    uint64_t limit = central->nvm_size / NVM_RESERVE_REGION_SHARE;
+    if (limit > NVM_RESERVE_MAX_BYTES) limit = NVM_RESERVE_MAX_BYTES;
+    uint64_t now = nvm_get_time_ns();
+    if (heap->resv_refill_ns != 0 && now - heap->resv_refill_ns < (uint64_t)NVM_RESERVE_WINDOW_MS * 1000000ULL) {
+        uint64_t grown = ((heap->resv_batch > span) ? heap->resv_batch : span) * 2;
+        if (grown <= limit) heap->resv_batch = grown;
+    } else {
+        heap->resv_batch /= 2;
     }
+    heap->resv_refill_ns = now;
 
-    // [Slow Path] 需要从中心堆分配
-    if (!target_slab) {
-        // 1. 申请 NVM 空间
-        uint64_t offset = space_manager_alloc_slab(allocator->central_heap.space_manager);
-        if (offset == (uint64_t)-1) return NULL;
+    // 批次为 2 的幂且不小于跨度，按 min(批次, 最大跨度) 对齐，批次起点可直接放下任何跨度
+    uint64_t size = (heap->resv_batch > span) ? heap->resv_batch : span;
+    uint64_t align = (size < NVM_MAX_SLAB_SPAN) ? size : NVM_MAX_SLAB_SPAN;
 
-        // 2. 创建 DRAM 元数据
-        target_slab = nvm_slab_create(sc_id, offset);
-        if (!target_slab) {
-            space_manager_free_slab(allocator->central_heap.space_manager, offset);
-            LOG_ERR("Failed to create slab metadata.");
-            return NULL;
-        }
+    // 放开堆锁后归还旧批次、预留新批次
+    NVM_SPINLOCK_RELEASE(&heap->lock);
+    if (old_next < old_end) {
+        space_manager_free(allocator->central_heaps[old_region].space_manager, old_next, old_end - old_next);
+    }
+    uint64_t offset = space_manager_alloc_aligned(central->space_manager, size, align);
+    if (offset == (uint64_t)-1 && size > span) {
+        // 区域所剩不多：只取所需跨度，不再囤积
+        size   = span;
+        offset = space_manager_alloc_aligned(central->space_manager, span, span);
+    }
+    NVM_SPINLOCK_ACQUIRE(&heap->lock);
+    if (offset == (uint64_t)-1) return (uint64_t)-1;
 
-        // 3. 注册到全局哈希表
-        if (slab_hashtable_insert(allocator->central_heap.slab_lookup_table, offset, target_slab) != 0) {
-            nvm_slab_destroy(target_slab);
-            space_manager_free_slab(allocator->central_heap.space_manager, offset);
-            LOG_ERR("Failed to insert slab into hashtable.");
-            return NULL;
-        }
+    // 复查：放锁期间同一堆上的其他线程可能已装入批次，保留它，新批次只取本跨度
+    if (heap->resv_next < heap->resv_end) {
+        if (size > span) heap_return_space(allocator, heap, region_id, offset + span, size - span);
+        return offset;
+    }
+    heap->resv_region = region_id;
+    heap->resv_next   = offset + span;
+    heap->resv_end    = offset + size;
+    return offset;
+}
+
+// 假设已持有 heap->lock，期间可能暂时放开
+// 摘下未切分的预留并归还给空间管理器，返回归还的字节数
+static size_t heap_release_reservation(NvmAllocator* allocator, NvmCpuHeap* heap) {
+    if (heap->resv_next >= heap->resv_end) return 0;
+
+    uint64_t offset  = heap->resv_next;
+    size_t released = heap->resv_end - heap->resv_next;
+    heap->resv_next = heap->resv_end = 0;
+    heap_return_space(allocator, heap, heap->resv_region, offset, released);
+    return released;
+}
 
-        // 4. 挂载到本地堆 (头插法)
-        target_slab->next_in_chain = current_cpu_heap->slab_lists[sc_id];
-        current_cpu_heap->slab_lists[sc_id] = target_slab;
+// 假设已持有 heap->lock
+// 暂时放开堆锁，把一段已从预留中摘下的空间归还给空间管理器 (其互斥锁不得在自旋锁内获取)
+static void heap_return_space(NvmAllocator* allocator, NvmCpuHeap* heap, uint16_t region_id, uint64_t offset, uint64_t size) {
+    NVM_SPINLOCK_RELEASE(&heap->lock);
+    space_manager_free(allocator->central_heaps[region_id].space_manager, offset, size);
+    NVM_SPINLOCK_ACQUIRE(&heap->lock);
+}
+
+// 归还所有 CPU 堆与节点堆的预留 (逐个获取堆锁，调用方不得持有任何堆锁)
+static void heaps_release_reservations(NvmAllocator* allocator) {
+    for (uint32_t i = 0; i < allocator->cpu_count + allocator->node_count; ++i) {
+        NvmCpuHeap* heap = (i < allocator->cpu_count) ? allocator->cpu_heaps[i]
+                                                      : allocator->node_heaps[i - allocator->cpu_count];
+        NVM_SPINLOCK_ACQUIRE(&heap->lock);
+        heap_release_reservation(allocator, heap);
+        NVM_SPINLOCK_RELEASE(&heap->lock);
     }
+}
+
+// 假设已持有 heap->lock (切分新 Slab 时可能暂时放开)
+// 返回可分配的 Slab (部分占用链表表头)，依次尝试 部分占用 -> 全空 -> 中心堆
+static NvmSlab* heap_get_alloc_slab(NvmAllocator* allocator, NvmCpuHeap* heap, SizeClassID sc_id) {
+    // [Fast Path] 部分占用链表的表头即为可用 Slab，O(1)
+    NvmSlab* slab = heap->slab_lists[sc_id][SLAB_LIST_PARTIAL];
+    if (slab) return slab;
 
-    // 执行分配 (Slab 内部自旋锁保护)
-    uint32_t block_idx;
-    if (nvm_slab_alloc(target_slab, &block_idx) == 0) {
-        uint64_t final_offset = target_slab->nvm_base_offset + (block_idx * target_slab->block_size);
-        return (char*)allocator->central_heap.nvm_base_addr + final_offset;
+    // 其次复用全空 Slab
+    slab = heap->slab_lists[sc_id][SLAB_LIST_EMPTY];
+    if (slab) {
+        heap_move_slab(heap, slab, SLAB_LIST_PARTIAL);
+        return slab;
     }
 
-    LOG_ERR("Unexpected allocation failure in slab.");
+    // [Slow Path] 从预留批次切分新 Slab：本节点的区域优先，耗尽时按节点距离回退
+    uint64_t span = nvm_slab_class_span_size(sc_id);
+    for (uint32_t i = 0; i < allocator->region_count; ++i) {
+        uint16_t region_id = heap->region_order[i];
+        uint64_t offset = heap_reserve_span(allocator, heap, region_id, span);
+        if (offset == (uint64_t)-1) continue;
+
+        // 建立描述符与索引要分配内存、获取哈希表读写锁并写回持久头部，放开堆锁进行；
+        // 挂载之前新 Slab 不在任何链表上，只有本线程会使用
+        NVM_SPINLOCK_RELEASE(&heap->lock);
+        slab = central_carve_slab(&allocator->central_heaps[region_id], sc_id, offset);
+        NVM_SPINLOCK_ACQUIRE(&heap->lock);
+        if (slab) {
+            // 挂载到本地堆的部分占用链表
+            slab->owner_heap = heap;
+            heap_link_slab(heap, slab, SLAB_LIST_PARTIAL);
+            return slab;
+        }
+    }
     return NULL;
 }
 
-static void nvm_free_impl(NvmAllocator* allocator, void* nvm_ptr) {
-    if (!allocator || !nvm_ptr) return;
+// 从指定堆批量分配最多 count 个块，整批只获取一次堆锁
+// 返回实际分配的块数 (NVM 空间耗尽时可能小于 count)
+static uint32_t heap_alloc_blocks(NvmAllocator* allocator, NvmCpuHeap* heap, SizeClassID sc_id, void** out_blocks, uint32_t count) {
+    uint32_t block_idx[NVM_TCACHE_CAPACITY];
+    uint32_t got = 0;
 
-    // 计算相对偏移并对齐到 Slab 边界
-    uint64_t nvm_offset = (uint64_t)((char*)nvm_ptr - (char*)allocator->central_heap.nvm_base_addr);
-    uint64_t slab_base = (nvm_offset / NVM_SLAB_SIZE) * NVM_SLAB_SIZE;
+    NVM_SPINLOCK_ACQUIRE(&heap->lock);
 
-    // 全局查表获取元数据
-    NvmSlab* target_slab = slab_hashtable_lookup(allocator->central_heap.slab_lookup_table, slab_base);
-    if (!target_slab) return;
+    while (got < count) {
+        NvmSlab* slab = heap_get_alloc_slab(allocator, heap, sc_id);
+        if (!slab) break;
+        char* slab_addr = slab_addr_of(allocator, slab);
 
-    // 计算块索引并释放
-    uint32_t block_idx = (nvm_offset - target_slab->nvm_base_offset) / target_slab->block_size;
-    nvm_slab_free(target_slab, block_idx);
+        // 分配只在持有堆锁时发生，部分占用链表中的 Slab 必有空闲块
+        uint32_t want = count - got;
+        if (want > NVM_TCACHE_CAPACITY) want = NVM_TCACHE_CAPACITY;
+        uint32_t n = nvm_slab_alloc_batch(slab, block_idx, want);
+        if (n == 0) {
+            LOG_ERR("Unexpected allocation failure in slab.");
+            break;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            out_blocks[got++] = slab_addr + (uint64_t)block_idx[i] * slab->block_size;
+        }
+
+        // 满转换：先批量回收远程释放，仍满才移入已满链表
+        if (nvm_slab_is_full(slab)) {
+            heap_settle_slab(allocator, heap, slab);
+        }
+    }
+
+    NVM_SPINLOCK_RELEASE(&heap->lock);
+    return got;
 }
 
-static int nvm_allocator_restore_allocation_impl(NvmAllocator* allocator, void* nvm_ptr, size_t size) {
-    if (!allocator || !nvm_ptr || size == 0) return -1;
+// 从 CPU 堆分配一批块：冷类别由所在节点的共享堆服务，每个类别在节点上只占
+// 共享 Slab，不随 CPU 数增长；窗口内分配量达到阈值后晋升为 CPU 独占 Slab
+static uint32_t cpu_heap_alloc_blocks(NvmAllocator* allocator, NvmCpuHeap* heap, SizeClassID sc_id, void** out_blocks, uint32_t count) {
+    uint32_t threshold = __atomic_load_n(&allocator->promote_blocks, __ATOMIC_RELAXED);
+    if (threshold == 0 || __atomic_load_n(&heap->dedicated[sc_id], __ATOMIC_RELAXED)) {
+        return heap_alloc_blocks(allocator, heap, sc_id, out_blocks, count);
+    }
 
-    SizeClassID sc_id = map_size_to_sc_id(size);
-    if (sc_id == SC_COUNT) return -1;
+    // 先在共享堆锁内分配，再单独获取本堆锁更新统计，两把锁不嵌套
+    uint32_t got = heap_alloc_blocks(allocator, heap->shared_heap, sc_id, out_blocks, count);
 
-    uint64_t nvm_offset = (uint64_t)((char*)nvm_ptr - (char*)allocator->central_heap.nvm_base_addr);
-    uint64_t slab_base = (nvm_offset / NVM_SLAB_SIZE) * NVM_SLAB_SIZE;
+    uint64_t now = nvm_get_time_ns();
+    NVM_SPINLOCK_ACQUIRE(&heap->lock);
+    if (now - heap->shared_window_ns[sc_id] >= (uint64_t)NVM_SHARED_WINDOW_MS * 1000000ULL) {
+        heap->shared_window_ns[sc_id] = now;
+        heap->shared_blocks[sc_id]    = 0;
+    }
+    heap->shared_blocks[sc_id] += got;
+    if (heap->shared_blocks[sc_id] >= threshold) {
+        __atomic_store_n(&heap->dedicated[sc_id], 1, __ATOMIC_RELAXED);
+    }
+    NVM_SPINLOCK_RELEASE(&heap->lock);
+    return got;
+}
 
-    NvmCentralHeap* central = &allocator->central_heap;
-    NvmSlab* slab = slab_hashtable_lookup(central->slab_lookup_table, slab_base);
+// 假设已持有 heap->lock
+// 只从堆中已有的部分占用 Slab 分配，不复用全空 Slab、不切分新 Slab，返回实际块数
+static uint32_t heap_take_partial(NvmAllocator* allocator, NvmCpuHeap* heap, SizeClassID sc_id, void** out_blocks, uint32_t count) {
+    uint32_t block_idx[NVM_TCACHE_CAPACITY];
+    uint32_t got = 0;
 
-    if (!slab) {
-        // Slab 不存在：重建并占位
-        if (space_manager_alloc_at_offset(central->space_manager, slab_base) != 0) {
-            LOG_ERR("Restore failed: Space occupied.");
-            return -1;
+    NvmSlab* slab;
+    while (got < count && (slab = heap->slab_lists[sc_id][SLAB_LIST_PARTIAL]) != NULL) {
+        char* slab_addr = slab_addr_of(allocator, slab);
+        // 先回收待回收的释放，窃取者也能拿到这些块
+        nvm_slab_collect_remote(slab, slab_addr);
+        heap_collect_local(allocator, heap, slab, slab_addr);
+        uint32_t want = count - got;
+        if (want > NVM_TCACHE_CAPACITY) want = NVM_TCACHE_CAPACITY;
+        uint32_t n = nvm_slab_alloc_batch(slab, block_idx, want);
+        if (n == 0) {
+            LOG_ERR("Unexpected allocation failure in slab.");
+            break;
         }
-
-        slab = nvm_slab_create(sc_id, slab_base);
-        if (!slab) {
-            space_manager_free_slab(central->space_manager, slab_base);
-            return -1;
+        for (uint32_t i = 0; i < n; ++i) {
+            out_blocks[got++] = slab_addr + (uint64_t)block_idx[i] * slab->block_size;
         }
-
-        // 注册并挂载到默认 CPU 0
-        slab_hashtable_insert(central->slab_lookup_table, slab_base, slab);
-        slab->next_in_chain = allocator->cpu_heaps[0].slab_lists[sc_id];
-        allocator->cpu_heaps[0].slab_lists[sc_id] = slab;
-    } else {
-        // Slab 已存在：校验一致性
-        if (slab->size_type_id != sc_id) {
-            LOG_ERR("Restore mismatch: Size class conflict.");
-            return -1;
+        // 变满后移出部分占用链表，表头随之前进到下一个 Slab
+        if (nvm_slab_is_full(slab)) {
+            heap_settle_slab(allocator, heap, slab);
         }
     }
+    return got;
+}
+
+// 空间耗尽时的最后手段：从其他 CPU 堆与节点堆的部分占用 Slab 中直接分配
+// (Slab 所有权不变，之后的释放对我们而言是远程释放)。第一轮只 trylock，
+// 不等待正在使用的堆；一无所获时第二轮才阻塞获取。每个堆每轮最多访问一次
+static uint32_t heap_steal_blocks(NvmAllocator* allocator, SizeClassID sc_id, void** out_blocks, uint32_t count) {
+    uint32_t heap_count = allocator->cpu_count + allocator->node_count;
+    uint32_t start = (uint32_t)current_cpu_index(allocator);
+    uint32_t got = 0;
+
+    for (int pass = 0; pass < 2 && got == 0; ++pass) {
+        for (uint32_t k = 0; k < heap_count && got < count; ++k) {
+            uint32_t i = (start + 1 + k) % heap_count;
+            NvmCpuHeap* heap = (i < allocator->cpu_count) ? allocator->cpu_heaps[i]
+                                                          : allocator->node_heaps[i - allocator->cpu_count];
+            // 无锁预检：没有部分占用 Slab 的堆不必加锁
+            if (!__atomic_load_n(&heap->slab_lists[sc_id][SLAB_LIST_PARTIAL], __ATOMIC_RELAXED)) continue;
 
-    // 标记位图
-    uint32_t block_idx = (nvm_offset - slab_base) / slab->block_size;
-    return nvm_slab_set_bitmap_at_idx(slab, block_idx);
+            if (pass == 0) {
+                if (NVM_SPINLOCK_TRY_ACQUIRE(&heap->lock) != 0) continue;
+            } else {
+                NVM_SPINLOCK_ACQUIRE(&heap->lock);
+            }
+            got += heap_take_partial(allocator, heap, sc_id, &out_blocks[got], count - got);
+            NVM_SPINLOCK_RELEASE(&heap->lock);
+        }
+    }
+    return got;
 }
 
+// 将一个块直接归还给所属 Slab，并按需迁移 Slab 所在链表
+static void heap_free_block(NvmAllocator* allocator, NvmSlab* slab, uint64_t nvm_offset) {
+    // 计算块索引并释放
+    uint32_t block_idx = nvm_slab_block_index(slab, nvm_offset - slab->nvm_base_offset);
+    NvmCpuHeap* local_heap = allocator->cpu_heaps[current_cpu_index(allocator)];
+    NvmSlab* retired = NULL;
 
-// ============================================================================
-//                          调试与监控 API 实现
-// ============================================================================
+    if (slab->owner_heap == local_heap) {
+        // 本地释放：块仍是已分配，Slab 不会被退役或易主。
+        // [Fast Path] 在所属 CPU 的可重启序列内压入本地释放链表，不加锁、无原子读改写；
+        // 可能是最后一个已分配块时不走此路径，以便空转换就地完成
+        int cpu = allocator->rseq_enabled ? heap_local_cpu(allocator, local_heap) : -1;
+        if (cpu >= 0 &&
+            __atomic_load_n(&slab->allocated_block_count, __ATOMIC_RELAXED) >
+                nvm_slab_local_pending(slab) + nvm_slab_remote_pending(slab) + 1 &&
+            nvm_slab_local_push(slab, slab_addr_of(allocator, slab), block_idx, cpu) == 0) {
+            return;
+        }
 
-void nvm_allocator_debug_print(void) {
-    if (!global_nvm_allocator) {
-        printf("[NvmAllocator] Error: Allocator is not initialized.\n");
+        // [Slow Path] 序列被打断、Slab 已满或即将全空：所属堆锁本就串行化该 Slab 的
+        // 分配、回收与链表迁移，锁内以普通读写归还，链表转换就地完成，不需要栅栏
+        NVM_SPINLOCK_ACQUIRE(&local_heap->lock);
+        nvm_slab_free_local(slab, block_idx);
+        if (slab->list_id == SLAB_LIST_FULL ||
+            nvm_slab_remote_pending(slab) + nvm_slab_local_pending(slab) >= slab->allocated_block_count) {
+            NvmSlabListID new_list = heap_settle_slab(allocator, local_heap, slab);
+            if (new_list == SLAB_LIST_EMPTY) {
+                heap_decay_empty_slabs(allocator, local_heap, (SizeClassID)slab->size_type_id, false, &retired);
+            }
+        }
+        NVM_SPINLOCK_RELEASE(&local_heap->lock);
+        heap_retire_slabs(allocator, retired);
         return;
     }
 
-    NvmCentralHeap* central = &global_nvm_allocator->central_heap;
+    // 远程释放：无锁压入远程释放链表，不争抢所属 CPU 正在使用的堆锁与缓存行
+    // (CAS 自带 SEQ_CST 语义，与 heap_settle_slab 移入已满链表后的栅栏配对)
+    nvm_slab_remote_free(slab, slab_addr_of(allocator, slab), block_idx);
 
-    printf("================================================================\n");
-    printf("                  NVM Allocator Debug Dump                      \n");
-    printf("================================================================\n");
-    
-    printf("Global Info:\n");
-    printf("  NVM Base Address : %p\n", central->nvm_base_addr);
-    
-    // 修改处：传入基地址，并且 verbose 设为 true
-    if (central->slab_lookup_table) {
-        slab_hashtable_print_layout(central->slab_lookup_table, central->nvm_base_addr, true);
-    } else {
-        printf("[NvmAllocator] Warning: Hash table is NULL.\n");
+    // 非满/全空转换：仅在可能需要迁移链表时才获取所属堆的锁，并在锁内复查
+    // 远程与本地链表中的块对 Slab 而言仍是已分配，全部已分配块都在链表中即视为全空
+    uint8_t list_id = __atomic_load_n(&slab->list_id, __ATOMIC_SEQ_CST);
+    if (list_id == SLAB_LIST_FULL ||
+        nvm_slab_remote_pending(slab) + nvm_slab_local_pending(slab) >=
+            __atomic_load_n(&slab->allocated_block_count, __ATOMIC_RELAXED)) {
+        NvmCpuHeap* owner_heap = slab->owner_heap;
+        // 为空说明 Slab 已被其他线程退役并重置，链表迁移已无必要
+        if (!owner_heap) return;
+
+        NVM_SPINLOCK_ACQUIRE(&owner_heap->lock);
+        // 锁内复查：Slab 可能已被退役，或其描述符已被其他堆复用
+        if (slab->list_id != SLAB_LIST_NONE && slab->owner_heap == owner_heap) {
+            NvmSlabListID new_list = heap_settle_slab(allocator, owner_heap, slab);
+            if (new_list == SLAB_LIST_EMPTY) {
+                heap_decay_empty_slabs(allocator, owner_heap, (SizeClassID)slab->size_type_id, false, &retired);
+            }
+        }
+        NVM_SPINLOCK_RELEASE(&owner_heap->lock);
+        heap_retire_slabs(allocator, retired);
+    }
+}
+
+// 获取 Slab 所属堆的锁，并确认 Slab 仍是 slab_base 处挂载中的 Slab，返回已加锁的所属堆
+// 查找 Slab 时未持任何堆锁，期间所属堆可能已将其衰减退役、描述符也可能已被复用：
+// 锁内复查页映射、所属堆与所在链表 (与 heap_free_block 的复查相同)，不一致时重试。
+// Slab 已不在页映射中时返回 NULL (不持有任何锁)
+static NvmCpuHeap* heap_lock_slab_owner(NvmCentralHeap* central, NvmSlab* slab, uint64_t slab_base) {
+    for (;;) {
+        if (slab_pagemap_lookup(central->slab_page_map, slab_base) != slab) return NULL;
+
+        NvmCpuHeap* owner_heap = __atomic_load_n(&slab->owner_heap, __ATOMIC_ACQUIRE);
+        if (owner_heap) {
+            NVM_SPINLOCK_ACQUIRE(&owner_heap->lock);
+            if (slab->owner_heap == owner_heap && slab->list_id != SLAB_LIST_NONE &&
+                slab->nvm_base_offset == slab_base &&
+                slab_pagemap_lookup(central->slab_page_map, slab_base) == slab) {
+                return owner_heap;
+            }
+            NVM_SPINLOCK_RELEASE(&owner_heap->lock);
+        }
+        // 尚未挂载 (正被恢复路径建立)，或已摘链等待退役：让出 CPU 后重新查找
+        sched_yield();
+    }
+}
+
+// 按指针查找所属 Slab 并直接归还
+static void heap_free_ptr(NvmAllocator* allocator, void* nvm_ptr) {
+    uint64_t nvm_offset;
+    NvmCentralHeap* central = central_of_ptr(allocator, nvm_ptr, &nvm_offset);
+    if (!central) return;
+    NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, nvm_offset);
+    if (slab) heap_free_block(allocator, slab, nvm_offset);
+}
+
+// 将应用不再持有的块 (持久位已清除或从未置位) 交还缓存：压入线程缓存，
+// 满时先把较旧的一半归还给 Slab；线程缓存禁用时直接归还
+static void heap_release_block(NvmAllocator* allocator, NvmSlab* slab, void* block, uint64_t nvm_offset) {
+    NvmThreadCache* tc = &thread_cache;
+    if (NVM_LIKELY(tc->generation == allocator->generation) || tcache_bind(allocator, tc)) {
+        SizeClassID sc_id = (SizeClassID)slab->size_type_id;
+        NvmThreadCacheBin* bin = &tc->bins[sc_id];
+        if (NVM_UNLIKELY(bin->count >= allocator->cache_limit[sc_id])) {
+            tcache_spill_bin(allocator, tc, bin, sc_id, allocator->cache_limit[sc_id] / 2);
+        }
+        bin->slabs[bin->count]    = slab;
+        bin->blocks[bin->count++] = block;
+        return;
+    }
+
+    heap_free_block(allocator, slab, nvm_offset);
+}
+
+// 在持久位图中标记块已交给应用。持久位只在块交给应用与应用归还时改写，
+// 线程缓存、CPU 缓存与仓库中的块对持久状态而言始终空闲，崩溃后不会泄漏
+static void heap_persist_block(NvmAllocator* allocator, NvmSlab* slab, const void* block) {
+    uint64_t in_slab = (uint64_t)((const char*)block - slab_addr_of(allocator, slab));
+    nvm_layout_mark(&allocator->central_heaps[slab->region_id].layout, slab->nvm_base_offset,
+                    nvm_slab_block_index(slab, in_slab));
+}
+
+// 按指针查找所属 Slab (慢路径：区域线性查找 + 页映射查找)
+static NvmSlab* heap_slab_of(NvmAllocator* allocator, const void* block) {
+    uint64_t nvm_offset;
+    NvmCentralHeap* central = central_of_ptr(allocator, block, &nvm_offset);
+    return central ? slab_pagemap_lookup(central->slab_page_map, nvm_offset) : NULL;
+}
+
+// 从当前 CPU 的缓存弹出最多 count 个块，返回实际个数
+static uint32_t cpu_cache_pop_batch(NvmAllocator* allocator, SizeClassID sc_id, void** out_blocks, uint32_t count) {
+    uint32_t got = 0;
+
+    if (allocator->rseq_enabled) {
+        // 每次弹出都重新读取 CPU ID：线程迁移后自然切换到新 CPU 的缓存
+        while (got < count) {
+            int cpu = nvm_rseq_cpu_id();
+            if (NVM_UNLIKELY(cpu < 0 || (uint32_t)cpu >= allocator->cpu_count)) {
+                // 本线程未注册 rseq：改走加锁路径，仍然使用 CPU 缓存
+                return got + cpu_cache_pop_locked(allocator, sc_id, &out_blocks[got], count - got);
+            }
+
+            NvmCpuCache* cache = &allocator->cpu_heaps[cpu]->cpu_cache;
+            int ret = nvm_rseq_percpu_pop(cpu, &cache->stopped, &cache->counts[sc_id],
+                                          cache->slots[sc_id], &out_blocks[got]);
+            if (ret == NVM_RSEQ_OK) {
+                got++;
+            } else if (ret == NVM_RSEQ_MISS) {
+                // 被加锁路径停用：重新开放后重试，否则就是栈空
+                if (NVM_UNLIKELY(__atomic_load_n(&cache->stopped, __ATOMIC_RELAXED) == CPU_CACHE_STOPPED)) {
+                    cpu_cache_reopen(allocator->cpu_heaps[cpu]);
+                    continue;
+                }
+                break;
+            }
+        }
+        return got;
+    }
+
+    return cpu_cache_pop_locked(allocator, sc_id, out_blocks, count);
+}
+
+// 将 blocks[0, count) 压入当前 CPU 的缓存，返回实际压入的个数
+static uint32_t cpu_cache_push_batch(NvmAllocator* allocator, SizeClassID sc_id, void** blocks, uint32_t count) {
+    uint32_t put = 0;
+
+    if (allocator->rseq_enabled) {
+        while (put < count) {
+            int cpu = nvm_rseq_cpu_id();
+            if (NVM_UNLIKELY(cpu < 0 || (uint32_t)cpu >= allocator->cpu_count)) {
+                return put + cpu_cache_push_locked(allocator, sc_id, &blocks[put], count - put);
+            }
+
+            NvmCpuCache* cache = &allocator->cpu_heaps[cpu]->cpu_cache;
+            int ret = nvm_rseq_percpu_push(cpu, &cache->stopped, &cache->counts[sc_id],
+                                           cache->slots[sc_id], allocator->cache_limit[sc_id], blocks[put]);
+            if (ret == NVM_RSEQ_OK) {
+                put++;
+            } else if (ret == NVM_RSEQ_MISS) {
+                if (NVM_UNLIKELY(__atomic_load_n(&cache->stopped, __ATOMIC_RELAXED) == CPU_CACHE_STOPPED)) {
+                    cpu_cache_reopen(allocator->cpu_heaps[cpu]);
+                    continue;
+                }
+                break;
+            }
+        }
+        return put;
+    }
+
+    return cpu_cache_push_locked(allocator, sc_id, blocks, count);
+}
+
+// 停用缓存的 rseq 访问 (不持有堆锁调用)：返回时已不会有 rseq 序列访问该缓存
+// 只有 OPEN -> STOPPING 的一方执行栅栏，已停用时直接返回
+static void cpu_cache_stop(NvmCpuCache* cache) {
+    uint32_t state = __atomic_load_n(&cache->stopped, __ATOMIC_ACQUIRE);
+    while (state != CPU_CACHE_STOPPED) {
+        if (state == CPU_CACHE_OPEN) {
+            if (__atomic_compare_exchange_n(&cache->stopped, &state, CPU_CACHE_STOPPING, false,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE)) {
+                nvm_rseq_fence();
+                __atomic_store_n(&cache->stopped, CPU_CACHE_STOPPED, __ATOMIC_RELEASE);
+                return;
+            }
+            continue;   // CAS 失败时 state 已被更新
+        }
+        // 另一加锁者正在执行栅栏，等待其完成
+        state = __atomic_load_n(&cache->stopped, __ATOMIC_ACQUIRE);
+    }
+}
+
+// 重新开放缓存的 rseq 访问：在堆锁内进行，不会与持锁访问缓存的加锁者交错
+static void cpu_cache_reopen(NvmCpuHeap* heap) {
+    NVM_SPINLOCK_ACQUIRE(&heap->lock);
+    if (__atomic_load_n(&heap->cpu_cache.stopped, __ATOMIC_RELAXED) == CPU_CACHE_STOPPED) {
+        __atomic_store_n(&heap->cpu_cache.stopped, CPU_CACHE_OPEN, __ATOMIC_RELEASE);
+    }
+    NVM_SPINLOCK_RELEASE(&heap->lock);
+}
+
+// 回退路径：每 CPU 锁，按 current_cpu_index 选择缓存
+// rseq 模式下同一缓存可能正被 rseq 序列访问：先在锁外停用，取锁后复查未被重新开放
+static void cpu_cache_lock(NvmAllocator* allocator, NvmCpuHeap* heap) {
+    for (;;) {
+        if (allocator->rseq_enabled) cpu_cache_stop(&heap->cpu_cache);
+        NVM_SPINLOCK_ACQUIRE(&heap->lock);
+        if (!allocator->rseq_enabled ||
+            __atomic_load_n(&heap->cpu_cache.stopped, __ATOMIC_ACQUIRE) == CPU_CACHE_STOPPED) {
+            return;
+        }
+        NVM_SPINLOCK_RELEASE(&heap->lock);
+    }
+}
+
+// 保持停用状态：后续的加锁操作无需再次执行栅栏
+static void cpu_cache_unlock(NvmAllocator* allocator, NvmCpuHeap* heap) {
+    (void)allocator;
+    NVM_SPINLOCK_RELEASE(&heap->lock);
+}
+
+static uint32_t cpu_cache_pop_locked(NvmAllocator* allocator, SizeClassID sc_id, void** out_blocks, uint32_t count) {
+    uint32_t got = 0;
+    NvmCpuHeap* heap = allocator->cpu_heaps[current_cpu_index(allocator)];
+    NvmCpuCache* cache = &heap->cpu_cache;
+    cpu_cache_lock(allocator, heap);
+    while (got < count && cache->counts[sc_id] > 0) {
+        out_blocks[got++] = cache->slots[sc_id][--cache->counts[sc_id]];
+    }
+    cpu_cache_unlock(allocator, heap);
+    return got;
+}
+
+static uint32_t cpu_cache_push_locked(NvmAllocator* allocator, SizeClassID sc_id, void** blocks, uint32_t count) {
+    uint32_t put = 0;
+    NvmCpuHeap* heap = allocator->cpu_heaps[current_cpu_index(allocator)];
+    NvmCpuCache* cache = &heap->cpu_cache;
+    cpu_cache_lock(allocator, heap);
+    while (put < count && cache->counts[sc_id] < allocator->cache_limit[sc_id]) {
+        cache->slots[sc_id][cache->counts[sc_id]++] = blocks[put++];
+    }
+    cpu_cache_unlock(allocator, heap);
+    return put;
+}
+
+// 将所有 CPU 缓存中的块归还给 Slab (慢路径，用于 trim)
+// rseq 模式下先停用 (必要时在锁外执行栅栏)，排空后重新开放
+static void cpu_cache_drain_all(NvmAllocator* allocator) {
+    void* blocks[SC_COUNT * NVM_CPU_CACHE_SIZE];
+
+    for (uint32_t i = 0; i < allocator->cpu_count; ++i) {
+        NvmCpuHeap* heap = allocator->cpu_heaps[i];
+        NvmCpuCache* cache = &heap->cpu_cache;
+
+        uint32_t pending = 0;
+        for (int j = 0; j < SC_COUNT; ++j) {
+            pending += __atomic_load_n(&cache->counts[j], __ATOMIC_RELAXED);
+        }
+        if (pending == 0) continue;
+
+        // 堆锁串行化并发的排空者；heap_free_block 需要获取所属堆锁，故先取出再释放
+        uint32_t n = 0;
+        cpu_cache_lock(allocator, heap);
+        for (int j = 0; j < SC_COUNT; ++j) {
+            for (uint32_t k = 0; k < cache->counts[j]; ++k) {
+                blocks[n++] = cache->slots[j][k];
+            }
+            cache->counts[j] = 0;
+        }
+        __atomic_store_n(&cache->stopped, CPU_CACHE_OPEN, __ATOMIC_RELEASE);
+        cpu_cache_unlock(allocator, heap);
+
+        for (uint32_t k = 0; k < n; ++k) {
+            heap_free_ptr(allocator, blocks[k]);
+        }
+    }
+}
+
+// ============================================================================
+//                          弹匣仓库实现
+// ============================================================================
+
+// 获取仓库锁并统计争用：一个周期内争用比例过高时弹匣大小翻倍，
+// 每次交换搬运更多块，摊薄每块的加锁开销
+static void depot_acquire(NvmDepot* depot, uint32_t max_size) {
+    if (NVM_SPINLOCK_TRY_ACQUIRE(&depot->lock) != 0) {
+        NVM_SPINLOCK_ACQUIRE(&depot->lock);
+        depot->contended++;
+    }
+    if (++depot->lock_count < NVM_DEPOT_ADAPT_INTERVAL) return;
+
+    if (depot->contended * NVM_DEPOT_CONTENTION_RATIO > depot->lock_count && depot->mag_size < max_size) {
+        uint32_t size = depot->mag_size * 2;
+        __atomic_store_n(&depot->mag_size, (size < max_size) ? size : max_size, __ATOMIC_RELAXED);
+    }
+    depot->lock_count = 0;
+    depot->contended  = 0;
+}
+
+// 将 blocks 中至多一个弹匣大小的块装入弹匣交给仓库，返回交出的块数 (仓库已满时为 0)
+// 装填在锁外完成，锁内只挂上满弹匣并换回一个空弹匣作为线程的备用
+static uint32_t depot_push(NvmAllocator* allocator, NvmThreadCache* tc, SizeClassID sc_id, void** blocks, uint32_t count) {
+    NvmDepot* depot = &allocator->depots[sc_id];
+    if (__atomic_load_n(&depot->full_count, __ATOMIC_RELAXED) >= NVM_DEPOT_MAX_MAGAZINES) return 0;
+
+    uint32_t size = __atomic_load_n(&depot->mag_size, __ATOMIC_RELAXED);
+    if (count > size) count = size;
+    if (count == 0) return 0;
+
+    NvmMagazine* mag = tc->spare;
+    if (!mag) {
+        mag = (NvmMagazine*)malloc(sizeof(NvmMagazine));
+        if (!mag) return 0;
+    }
+    memcpy(mag->blocks, blocks, count * sizeof(void*));
+    mag->count = count;
+
+    depot_acquire(depot, allocator->cache_limit[sc_id]);
+    if (depot->full_count >= NVM_DEPOT_MAX_MAGAZINES) {
+        NVM_SPINLOCK_RELEASE(&depot->lock);
+        tc->spare = mag;
+        return 0;
+    }
+    mag->next   = depot->full;
+    depot->full = mag;
+    __atomic_store_n(&depot->full_count, depot->full_count + 1, __ATOMIC_RELAXED);
+
+    NvmMagazine* spare = depot->empty;
+    if (spare) {
+        depot->empty = spare->next;
+        depot->empty_count--;
+    }
+    NVM_SPINLOCK_RELEASE(&depot->lock);
+
+    tc->spare = spare;
+    return count;
+}
+
+// 从仓库取走一个满弹匣，块写入 out_blocks (至少 NVM_MAGAZINE_CAPACITY 项)，返回块数
+// 线程的备用弹匣在锁内换给仓库，取走的弹匣倒空后成为新的备用
+static uint32_t depot_pop(NvmAllocator* allocator, NvmThreadCache* tc, SizeClassID sc_id, void** out_blocks) {
+    NvmDepot* depot = &allocator->depots[sc_id];
+    if (__atomic_load_n(&depot->full_count, __ATOMIC_RELAXED) == 0) return 0;
+
+    depot_acquire(depot, allocator->cache_limit[sc_id]);
+    NvmMagazine* mag = depot->full;
+    if (!mag) {
+        NVM_SPINLOCK_RELEASE(&depot->lock);
+        return 0;
+    }
+    depot->full = mag->next;
+    __atomic_store_n(&depot->full_count, depot->full_count - 1, __ATOMIC_RELAXED);
+
+    if (tc->spare && depot->empty_count < NVM_DEPOT_MAX_MAGAZINES) {
+        tc->spare->next = depot->empty;
+        depot->empty    = tc->spare;
+        depot->empty_count++;
+        tc->spare = NULL;
+    }
+    NVM_SPINLOCK_RELEASE(&depot->lock);
+
+    uint32_t count = mag->count;
+    memcpy(out_blocks, mag->blocks, count * sizeof(void*));
+    if (tc->spare) free(mag);
+    else           tc->spare = mag;
+    return count;
+}
+
+// 将所有仓库中的块归还给 Slab，并释放空弹匣 (慢路径，用于 trim)
+static void depot_drain_all(NvmAllocator* allocator) {
+    for (int j = 0; j < SC_COUNT; ++j) {
+        NvmDepot* depot = &allocator->depots[j];
+
+        // 先整条摘下，heap_free_block 需要获取所属堆锁，不在仓库锁内进行
+        NVM_SPINLOCK_ACQUIRE(&depot->lock);
+        NvmMagazine* full  = depot->full;
+        NvmMagazine* empty = depot->empty;
+        depot->full  = NULL;
+        depot->empty = NULL;
+        __atomic_store_n(&depot->full_count, 0, __ATOMIC_RELAXED);
+        depot->empty_count = 0;
+        NVM_SPINLOCK_RELEASE(&depot->lock);
+
+        while (full) {
+            NvmMagazine* next = full->next;
+            for (uint32_t k = 0; k < full->count; ++k) {
+                heap_free_ptr(allocator, full->blocks[k]);
+            }
+            free(full);
+            full = next;
+        }
+        while (empty) {
+            NvmMagazine* next = empty->next;
+            free(empty);
+            empty = next;
+        }
+    }
+}
+
+// 获取 Slab 描述符：优先复用已退役的描述符，否则新建
+static NvmSlab* central_acquire_slab(NvmCentralHeap* central, SizeClassID sc_id, uint64_t offset) {
+    NVM_SPINLOCK_ACQUIRE(&central->slab_cache_lock);
+    NvmSlab* slab = central->slab_cache[sc_id];
+    if (slab) central->slab_cache[sc_id] = slab->next_in_chain;
+    NVM_SPINLOCK_RELEASE(&central->slab_cache_lock);
+
+    if (slab) {
+        nvm_slab_reset(slab, offset);
+    } else {
+        slab = nvm_slab_create(sc_id, offset);
+    }
+    if (slab) slab->region_id = central->region_id;
+    return slab;
+}
+
+// 在已取得的 NVM 空间上建立新 Slab 并注册到该区域的索引；出错时归还空间并返回 NULL
+// offset 须按类别的跨度自然对齐 (恢复时可由块偏移反推 Slab 起点)
+static NvmSlab* central_carve_slab(NvmCentralHeap* central, SizeClassID sc_id, uint64_t offset) {
+    uint64_t span = nvm_slab_class_span_size(sc_id);
+
+    // 1. 创建 (或复用) DRAM 元数据
+    NvmSlab* slab = central_acquire_slab(central, sc_id, offset);
+    if (!slab) {
+        space_manager_free(central->space_manager, offset, span);
+        LOG_ERR("Failed to create slab metadata.");
+        return NULL;
+    }
+
+    // 2. 注册到区域哈希表
+    if (slab_hashtable_insert(central->slab_lookup_table, offset, slab) != 0) {
+        central_recycle_slab(central, slab);
+        space_manager_free(central->space_manager, offset, span);
+        LOG_ERR("Failed to insert slab into hashtable.");
+        return NULL;
+    }
+
+    // 3. 发布到页映射表 (覆盖跨度内每个单元)，此后释放路径可无锁找到该 Slab
+    if (slab_pagemap_insert(central->slab_page_map, offset, span, slab) != 0) {
+        slab_hashtable_remove(central->slab_lookup_table, offset);
+        central_recycle_slab(central, slab);
+        space_manager_free(central->space_manager, offset, span);
+        LOG_ERR("Failed to publish slab into page map.");
+        return NULL;
+    }
+
+    // 4. 记录持久头部 (同时清零位图槽)，此后块的持久位才有意义
+    nvm_layout_set_span(&central->layout, offset, NVM_SPAN_SLAB, (uint8_t)sc_id, span);
+    return slab;
+}
+
+// 将描述符放回缓存 (不再被任何链表/索引引用)
+static void central_recycle_slab(NvmCentralHeap* central, NvmSlab* slab) {
+    NVM_SPINLOCK_ACQUIRE(&central->slab_cache_lock);
+    slab->next_in_chain = central->slab_cache[slab->size_type_id];
+    central->slab_cache[slab->size_type_id] = slab;
+    NVM_SPINLOCK_RELEASE(&central->slab_cache_lock);
+}
+
+// 退役一个已摘链的空 Slab：注销索引、归还 NVM 空间、回收描述符
+static void central_retire_slab(NvmCentralHeap* central, NvmSlab* slab) {
+    // 先撤销无锁映射，之后新的释放无法再找到该 Slab
+    slab_pagemap_remove(central->slab_page_map, slab->nvm_base_offset, slab->span_size);
+
+    slab_hashtable_remove(central->slab_lookup_table, slab->nvm_base_offset);
+    nvm_layout_clear_span(&central->layout, slab->nvm_base_offset);
+    space_manager_free(central->space_manager, slab->nvm_base_offset, slab->span_size);
+    central_recycle_slab(central, slab);
+}
+
+// 按持久布局重建区域的 DRAM 元数据 (创建期间单线程调用，不加锁)
+// 逐个读取跨度头部，按地址递增占位空间并恢复 Slab 与区块；开销与头部表长度及跨度数
+// 成正比，与对象数无关。没有任何块交给应用的 Slab 与区块直接作废 (崩溃前只在缓存中)。
+// 新格式化的区域头部全为空，扫描无结果
+static int central_attach(NvmAllocator* allocator, NvmCentralHeap* central) {
+    NvmLayout* layout = &central->layout;
+    uint64_t unit = layout->meta_size / NVM_SPAN_UNIT;
+
+    while (unit < layout->unit_count) {
+        NvmSpanHeader header = nvm_layout_span_at(layout, unit);
+        if (header.state == NVM_SPAN_FREE) {
+            unit++;
+            continue;
+        }
+
+        uint64_t offset = NVM_START_OFFSET + unit * NVM_SPAN_UNIT;
+        uint64_t span = (uint64_t)header.span_units * NVM_SPAN_UNIT;
+        int ret = -1;
+        if (header.span_units > 0 && header.span_units <= layout->unit_count - unit) {
+            switch (header.state) {
+                case NVM_SPAN_SLAB:  ret = central_attach_slab(allocator, central, offset, header); break;
+                case NVM_SPAN_CHUNK: ret = central_attach_chunk(central, offset, span); break;
+                case NVM_SPAN_HUGE:  ret = central_attach_huge(central, offset, span); break;
+                default: break;
+            }
+        }
+        if (ret != 0) {
+            LOG_ERR("Corrupted span header at offset %llu in region %u.",
+                    (unsigned long long)offset, (unsigned)central->region_id);
+            return -1;
+        }
+        unit += header.span_units;
+    }
+    return 0;
+}
+
+// 为重建或恢复出的 Slab 选择所属堆：在区域所在节点的 CPU 堆之间轮转，
+// 使重启后的释放多为本地释放，整理与链表迁移也分散到各 CPU 的堆锁上；
+// 节点上没有 CPU 时退回在全部 CPU 堆之间轮转
+static NvmCpuHeap* central_attach_heap(NvmAllocator* allocator, NvmCentralHeap* central) {
+    uint32_t count = allocator->cpu_count;
+    uint32_t cursor = __atomic_load_n(&central->attach_cursor, __ATOMIC_RELAXED);
+    for (;;) {
+        uint32_t pick = cursor % count;
+        for (uint32_t k = 0; k < count; ++k) {
+            uint32_t i = (cursor + k) % count;
+            if (allocator->cpu_heaps[i]->node == central->node) {
+                pick = i;
+                break;
+            }
+        }
+        if (__atomic_compare_exchange_n(&central->attach_cursor, &cursor, pick + 1, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return allocator->cpu_heaps[pick];
+        }
+    }
+}
+
+// 由持久位图整字载入 Slab 位图，挂载到区域所在节点的 CPU 堆 (与 nvm_allocator_restore_allocation 一致)
+static int central_attach_slab(NvmAllocator* allocator, NvmCentralHeap* central, uint64_t offset, NvmSpanHeader header) {
+    SizeClassID sc_id = (SizeClassID)header.size_class;
+    if (sc_id >= SC_COUNT) return -1;
+    uint64_t span = nvm_slab_class_span_size(sc_id);
+    if ((uint64_t)header.span_units * NVM_SPAN_UNIT != span || (offset - NVM_START_OFFSET) % span != 0) return -1;
+
+    NvmSlab* slab = central_acquire_slab(central, sc_id, offset);
+    if (!slab) return -1;
+
+    if (nvm_slab_load_bitmap(slab, nvm_layout_bitmap(&central->layout, offset)) == 0) {
+        nvm_layout_clear_span(&central->layout, offset);
+        central_recycle_slab(central, slab);
+        return 0;
+    }
+
+    if (space_manager_alloc_at_offset(central->space_manager, offset, span) != 0) goto fail_recycle;
+    if (slab_hashtable_insert(central->slab_lookup_table, offset, slab) != 0) goto fail_free;
+    if (slab_pagemap_insert(central->slab_page_map, offset, span, slab) != 0) goto fail_remove;
+
+    NvmCpuHeap* heap = central_attach_heap(allocator, central);
+    slab->owner_heap = heap;
+    heap_link_slab(heap, slab, heap_classify_slab(slab));
+    return 0;
+
+fail_remove:
+    slab_hashtable_remove(central->slab_lookup_table, offset);
+fail_free:
+    space_manager_free(central->space_manager, offset, span);
+fail_recycle:
+    central_recycle_slab(central, slab);
+    return -1;
+}
+
+// 页粒度区块：每个对象起始页向后延伸到下一个起始页或首个空闲页
+static int central_attach_chunk(NvmCentralHeap* central, uint64_t offset, uint64_t span) {
+    if (span != NVM_SLAB_SIZE) return -1;
+
+    const uint64_t* bitmap = nvm_layout_bitmap(&central->layout, offset);
+    NvmExtent* chunk = nvm_extent_create(offset, NVM_EXTENT_CHUNK_UNITS);
+    if (!chunk) return -1;
+    chunk->region_id = central->region_id;
+
+    for (uint32_t p = 0; p < NVM_EXTENT_PAGES; ++p) {
+        if (!IS_BIT_SET(bitmap, NVM_LAYOUT_CHUNK_STARTS + p)) continue;
+
+        uint32_t end = p + 1;
+        while (end < NVM_EXTENT_PAGES && IS_BIT_SET(bitmap, end) && !IS_BIT_SET(bitmap, NVM_LAYOUT_CHUNK_STARTS + end)) {
+            end++;
+        }
+        if (!IS_BIT_SET(bitmap, p) || nvm_extent_restore(chunk, p, end - p) != 0) goto fail_destroy;
+        p = end - 1;
+    }
+
+    if (nvm_extent_is_empty(chunk)) {
+        nvm_layout_clear_span(&central->layout, offset);
+        nvm_extent_destroy(chunk);
+        return 0;
+    }
+
+    if (space_manager_alloc_at_offset(central->space_manager, offset, span) != 0) goto fail_destroy;
+    if (slab_pagemap_insert_extent(central->slab_page_map, offset, NVM_SLAB_SIZE, chunk) != 0) {
+        space_manager_free(central->space_manager, offset, span);
+        goto fail_destroy;
+    }
+    chunk_index_insert(central, chunk);
+    return 0;
+
+fail_destroy:
+    nvm_extent_destroy(chunk);
+    return -1;
+}
+
+static int central_attach_huge(NvmCentralHeap* central, uint64_t offset, uint64_t span) {
+    if (span % NVM_SPAN_UNIT != 0 || span <= NVM_SLAB_SIZE) return -1;
+
+    NvmExtent* extent = nvm_extent_create(offset, (uint32_t)(span / NVM_SPAN_UNIT));
+    if (!extent) return -1;
+    extent->region_id = central->region_id;
+
+    if (space_manager_alloc_at_offset(central->space_manager, offset, span) != 0) goto fail_destroy;
+    if (slab_pagemap_insert_extent(central->slab_page_map, offset, NVM_SPAN_UNIT, extent) != 0) {
+        space_manager_free(central->space_manager, offset, span);
+        goto fail_destroy;
+    }
+    extent_link(&central->extent_spans, extent);
+    return 0;
+
+fail_destroy:
+    nvm_extent_destroy(extent);
+    return -1;
+}
+
+// 占用一个空闲的重做日志槽；全部占用时让出 CPU 等待 (槽只在发布/事务期间持有)，
+// 等待 NVM_LOG_CLAIM_YIELDS 次仍无空槽时失败
+static int central_claim_log(NvmCentralHeap* central, uint32_t* out_slot) {
+    uint32_t yields = 0;
+    for (;;) {
+        uint64_t busy = __atomic_load_n(&central->log_busy, __ATOMIC_RELAXED);
+        if (NVM_UNLIKELY(busy == ~0ULL)) {
+            if (++yields > NVM_LOG_CLAIM_YIELDS) {
+                LOG_ERR("All redo log slots of region %u are busy.", central->region_id);
+                return -1;
+            }
+            sched_yield();
+            continue;
+        }
+        uint32_t slot = (uint32_t)__builtin_ctzll(~busy);
+        if (__atomic_compare_exchange_n(&central->log_busy, &busy, busy | (1ULL << slot),
+                                        false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            *out_slot = slot;
+            return 0;
+        }
+    }
+}
+
+static void central_release_log(NvmCentralHeap* central, uint32_t slot) {
+    __atomic_fetch_and(&central->log_busy, ~(1ULL << slot), __ATOMIC_RELEASE);
+}
+
+// 块在持久位图中所在字的日志项目标
+static uint64_t central_bitmap_target(NvmCentralHeap* central, NvmLogOp op, uint64_t slab_offset, uint32_t block_idx) {
+    uint64_t* word = &nvm_layout_bitmap(&central->layout, slab_offset)[block_idx / 64];
+    return nvm_log_target(op, central->region_id, (uint64_t)((char*)word - (char*)central->nvm_base_addr));
+}
+
+// 对照页映射校验预留：slab_offset 处确有 Slab，块索引在范围内，偏移与地址都与二者一致
+// 通过时返回所属 Slab，否则返回 NULL
+static NvmSlab* central_action_slab(NvmAllocator* allocator, const NvmAction* action) {
+    if (action->region_id >= allocator->region_count) return NULL;
+
+    NvmCentralHeap* central = &allocator->central_heaps[action->region_id];
+    NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, action->slab_offset);
+    if (!slab || slab->nvm_base_offset != action->slab_offset) return NULL;
+    if (action->block_idx >= slab->total_block_count) return NULL;
+    if (action->offset != action->slab_offset + (uint64_t)action->block_idx * slab->block_size) return NULL;
+    if ((char*)action->ptr != (char*)central->nvm_base_addr + action->offset) return NULL;
+    return slab;
+}
+
+// 重做各区域中已提交未清空的日志 (上次运行在发布或事务提交途中崩溃)；提交不完整
+// (校验失败) 的日志视为从未提交，直接清空
+static int allocator_replay_logs(NvmAllocator* allocator) {
+    for (uint32_t i = 0; i < allocator->region_count; ++i) {
+        NvmLayout* layout = &allocator->central_heaps[i].layout;
+        for (uint32_t s = 0; s < NVM_LAYOUT_LOG_SLOTS; ++s) {
+            NvmRedoLog* log = nvm_layout_log(layout, s);
+            if (log->count == 0) continue;
+
+            if (nvm_log_valid(log)) {
+                if (nvm_log_apply(log, allocator->region_bases, allocator->region_sizes, allocator->region_count) != 0) {
+                    LOG_ERR("Corrupted redo log %u in region %u.", s, i);
+                    return -1;
+                }
+                nvm_drain();
+            }
+            nvm_log_clear(log);
+        }
+    }
+    return 0;
+}
+
+static NvmAllocator* nvm_allocator_create_impl(const NvmNodeRegion* regions, uint32_t region_count) {
+    if (!regions || region_count == 0) return NULL;
+    if (region_count > UINT16_MAX) {
+        LOG_ERR("Too many NVM regions: %u", region_count);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < region_count; ++i) {
+        if (!regions[i].base_addr) return NULL;
+        if (regions[i].node < 0 || regions[i].node >= NVM_NUMA_MAX_NODES) {
+            LOG_ERR("Invalid NUMA node %d for region %u.", regions[i].node, i);
+            return NULL;
+        }
+    }
+
+    NvmAllocator* allocator = (NvmAllocator*)calloc(1, sizeof(NvmAllocator));
+    if (!allocator) {
+        LOG_ERR("Failed to allocate allocator struct.");
+        return NULL;
+    }
+    NVM_MUTEX_INIT(&allocator->restore_lock);
+
+    // 初始化各区域的中心堆组件
+    allocator->central_heaps = (NvmCentralHeap*)calloc(region_count, sizeof(NvmCentralHeap));
+    allocator->region_bases  = (void**)calloc(region_count, sizeof(void*));
+    allocator->region_sizes  = (uint64_t*)calloc(region_count, sizeof(uint64_t));
+    if (!allocator->central_heaps || !allocator->region_bases || !allocator->region_sizes) {
+        LOG_ERR("Failed to allocate central heap table.");
+        nvm_allocator_destroy_impl(allocator);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < region_count; ++i) {
+        NvmCentralHeap* central = &allocator->central_heaps[i];
+        NVM_SPINLOCK_INIT(&central->slab_cache_lock);
+        NVM_MUTEX_INIT(&central->extent_lock);
+        allocator->region_count = i + 1;
+
+        central->nvm_base_addr = regions[i].base_addr;
+        central->nvm_size      = regions[i].size_bytes;
+        central->node          = regions[i].node;
+        central->region_id     = (uint16_t)i;
+        allocator->region_bases[i] = regions[i].base_addr;
+        allocator->region_sizes[i] = regions[i].size_bytes;
+        central->space_manager = space_manager_create(regions[i].size_bytes, NVM_START_OFFSET);
+        central->slab_lookup_table = slab_hashtable_create(INITIAL_HASHTABLE_CAPACITY);
+        central->slab_page_map = slab_pagemap_create(regions[i].size_bytes, NVM_START_OFFSET);
+
+        if (!central->space_manager || !central->slab_lookup_table || !central->slab_page_map) {
+            LOG_ERR("Failed to create central heap components.");
+            nvm_allocator_destroy_impl(allocator);
+            return NULL;
+        }
+
+        // 打开持久布局 (未格式化时就地格式化)，元数据区永久占位，数据从其后开始
+        if (nvm_layout_open(&central->layout, regions[i].base_addr, regions[i].size_bytes) < 0 ||
+            space_manager_alloc_at_offset(central->space_manager, NVM_START_OFFSET, central->layout.meta_size) != 0) {
+            LOG_ERR("Failed to open persistent layout of region %u.", i);
+            nvm_allocator_destroy_impl(allocator);
+            return NULL;
+        }
+    }
+
+    // 节点号上界：覆盖系统中所有可能的节点，以及区域声明的节点
+    allocator->node_count = nvm_numa_possible_nodes();
+    for (uint32_t i = 0; i < region_count; ++i) {
+        if ((uint32_t)regions[i].node >= allocator->node_count) {
+            allocator->node_count = (uint32_t)regions[i].node + 1;
+        }
+    }
+    if (build_region_order(allocator) != 0) {
+        nvm_allocator_destroy_impl(allocator);
+        return NULL;
+    }
+
+    // 按可能存在的 CPU 数创建 CPU 堆，CPU ID 直接作为下标
+    allocator->cpu_count = nvm_numa_possible_cpus();
+    allocator->cpu_heaps = (NvmCpuHeap**)calloc(allocator->cpu_count, sizeof(NvmCpuHeap*));
+    allocator->node_heaps = (NvmCpuHeap**)calloc(allocator->node_count, sizeof(NvmCpuHeap*));
+    if (!allocator->cpu_heaps || !allocator->node_heaps) {
+        LOG_ERR("Failed to allocate CPU heap table.");
+        nvm_allocator_destroy_impl(allocator);
+        return NULL;
+    }
+    allocator->depots = (NvmDepot*)nvm_numa_alloc_onnode(sizeof(NvmDepot) * SC_COUNT, -1);
+    if (!allocator->depots) {
+        LOG_ERR("Failed to allocate magazine depots.");
+        nvm_allocator_destroy_impl(allocator);
+        return NULL;
+    }
+    for (int j = 0; j < SC_COUNT; ++j) {
+        NVM_SPINLOCK_INIT(&allocator->depots[j].lock);
+    }
+    for (uint32_t n = 0; n < allocator->node_count; ++n) {
+        allocator->node_heaps[n] = cpu_heap_create((int)n, region_order_of_node(allocator, (int)n));
+        if (!allocator->node_heaps[n]) {
+            nvm_allocator_destroy_impl(allocator);
+            return NULL;
+        }
+    }
+    for (uint32_t i = 0; i < allocator->cpu_count; ++i) {
+        int node = nvm_numa_node_of_cpu(i);
+        allocator->cpu_heaps[i] = cpu_heap_create(node, region_order_of_node(allocator, node));
+        if (!allocator->cpu_heaps[i]) {
+            nvm_allocator_destroy_impl(allocator);
+            return NULL;
+        }
+        // 冷类别共享所在节点的节点堆
+        if (node < 0 || (uint32_t)node >= allocator->node_count) node = 0;
+        allocator->cpu_heaps[i]->shared_heap = allocator->node_heaps[node];
+    }
+
+    pthread_once(&sc_lookup_once, sc_lookup_build);
+
+    allocator->generation     = ++global_allocator_generation;
+    allocator->decay_ms       = NVM_SLAB_DECAY_MS;
+    allocator->promote_blocks = NVM_SHARED_PROMOTE_BLOCKS;
+
+    // 小类别沿用固定块数上限；中型类别按字节数收紧，避免每个线程/CPU 囤积数 MB
+    uint32_t max_blocks = (NVM_TCACHE_CAPACITY < NVM_CPU_CACHE_SIZE) ? NVM_TCACHE_CAPACITY : NVM_CPU_CACHE_SIZE;
+    for (int j = 0; j < SC_COUNT; ++j) {
+        uint32_t limit = NVM_CACHE_MAX_BYTES / nvm_slab_class_block_size((SizeClassID)j);
+        if (limit > max_blocks) limit = max_blocks;
+        if (limit < 2)          limit = 2;
+        allocator->cache_limit[j]     = limit;
+        allocator->depots[j].mag_size = limit / 2;
+    }
+
+    // 当前线程已注册 rseq 且 rseq 栅栏可用时，CPU 缓存走无锁路径
+    allocator->rseq_enabled = (nvm_rseq_cpu_id() >= 0) && nvm_rseq_fence_init();
+
+    // 先重做上次运行中已提交未清空的日志，再由持久布局重建已有的 Slab 与区块
+    // (须在 CPU 堆与尺寸查找表就绪之后)
+    if (allocator_replay_logs(allocator) != 0) {
+        nvm_allocator_destroy_impl(allocator);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < region_count; ++i) {
+        if (central_attach(allocator, &allocator->central_heaps[i]) != 0) {
+            nvm_allocator_destroy_impl(allocator);
+            return NULL;
+        }
+    }
+
+    return allocator;
+}
+
+static void nvm_allocator_destroy_impl(NvmAllocator* allocator) {
+    if (!allocator) return;
+
+    // 销毁所有 CPU 堆、节点堆及其中的 Slab (未切分的预留先归还给空间管理器)
+    for (uint32_t i = 0; allocator->cpu_heaps && i < allocator->cpu_count; ++i) {
+        if (allocator->cpu_heaps[i]) {
+            NVM_SPINLOCK_ACQUIRE(&allocator->cpu_heaps[i]->lock);
+            heap_release_reservation(allocator, allocator->cpu_heaps[i]);
+            NVM_SPINLOCK_RELEASE(&allocator->cpu_heaps[i]->lock);
+        }
+        cpu_heap_destroy(allocator->cpu_heaps[i]);
+    }
+    for (uint32_t n = 0; allocator->node_heaps && n < allocator->node_count; ++n) {
+        if (allocator->node_heaps[n]) {
+            NVM_SPINLOCK_ACQUIRE(&allocator->node_heaps[n]->lock);
+            heap_release_reservation(allocator, allocator->node_heaps[n]);
+            NVM_SPINLOCK_RELEASE(&allocator->node_heaps[n]->lock);
+        }
+        cpu_heap_destroy(allocator->node_heaps[n]);
+    }
+    free(allocator->cpu_heaps);
+    free(allocator->node_heaps);
+    free(allocator->region_order);
+
+    // 仓库中的块随 Slab 一起失效，只释放弹匣本身
+    for (int j = 0; allocator->depots && j < SC_COUNT; ++j) {
+        NvmMagazine* lists[] = { allocator->depots[j].full, allocator->depots[j].empty };
+        for (int k = 0; k < 2; ++k) {
+            NvmMagazine* curr = lists[k];
+            while (curr) {
+                NvmMagazine* next = curr->next;
+                free(curr);
+                curr = next;
+            }
+        }
+        NVM_SPINLOCK_DESTROY(&allocator->depots[j].lock);
+    }
+    nvm_numa_free(allocator->depots, sizeof(NvmDepot) * SC_COUNT);
+
+    for (uint32_t i = 0; i < allocator->region_count; ++i) {
+        NvmCentralHeap* central = &allocator->central_heaps[i];
+
+        // 销毁已退役的描述符
+        for (int j = 0; j < SC_COUNT; ++j) {
+            NvmSlab* curr = central->slab_cache[j];
+            while (curr) {
+                NvmSlab* next = curr->next_in_chain;
+                nvm_slab_destroy(curr);
+                curr = next;
+            }
+        }
+        NVM_SPINLOCK_DESTROY(&central->slab_cache_lock);
+
+        // 销毁大对象区块元数据
+        for (uint32_t j = 0; j <= NVM_EXTENT_PAGES + 1; ++j) {
+            NvmExtent* curr = (j <= NVM_EXTENT_PAGES) ? central->extent_chunk_bins[j] : central->extent_spans;
+            while (curr) {
+                NvmExtent* next = curr->next_in_chain;
+                nvm_extent_destroy(curr);
+                curr = next;
+            }
+        }
+        while (central->extent_cache) {
+            NvmExtent* next = central->extent_cache->next_in_chain;
+            nvm_extent_destroy(central->extent_cache);
+            central->extent_cache = next;
+        }
+        NVM_MUTEX_DESTROY(&central->extent_lock);
+
+        // 销毁中心堆组件
+        if (central->space_manager) 
+            space_manager_destroy(central->space_manager);
+        if (central->slab_lookup_table) 
+            slab_hashtable_destroy(central->slab_lookup_table);
+        if (central->slab_page_map)
+            slab_pagemap_destroy(central->slab_page_map);
+    }
+    free(allocator->central_heaps);
+    free(allocator->region_bases);
+    free(allocator->region_sizes);
+
+    NVM_MUTEX_DESTROY(&allocator->restore_lock);
+    free(allocator);
+}
+
+static void* nvm_malloc_impl(NvmAllocator* allocator, size_t size) {
+    if (!allocator || size == 0) return NULL;
+
+    SizeClassID sc_id = map_size_to_sc_id(size);
+    if (sc_id == SC_COUNT) {
+        // 大对象：直接从区块分配，不经过线程缓存与 CPU 缓存
+        void* ptr = extent_alloc(allocator, allocator->cpu_heaps[current_cpu_index(allocator)], size);
+        if (NVM_UNLIKELY(!ptr)) {
+            nvm_malloc_reclaim(allocator);
+            ptr = extent_alloc(allocator, allocator->cpu_heaps[current_cpu_index(allocator)], size);
+        }
+        return ptr;
+    }
+
+    NvmSlab* slab;
+    void* block = nvm_malloc_slab(allocator, sc_id, &slab);
+    if (NVM_LIKELY(block != NULL)) heap_persist_block(allocator, slab, block);
+    return block;
+}
+
+// 分配一个 Slab 块 (不改写持久位图) 并给出所属 Slab：缓存路径，空间耗尽时窃取与回收后重试
+static void* nvm_malloc_slab(NvmAllocator* allocator, SizeClassID sc_id, NvmSlab** out_slab) {
+    void* block = nvm_malloc_class(allocator, sc_id, out_slab);
+    if (NVM_UNLIKELY(!block)) {
+        // 空间耗尽：其他 CPU 的部分占用 Slab 可能仍有大量空闲块，先直接从中分配
+        block = nvm_malloc_steal(allocator, sc_id, out_slab);
+    }
+    if (NVM_UNLIKELY(!block)) {
+        // 缓存中的空闲块可能占着整个 Slab (类别越多越明显)，归还后重试一次；
+        // 回收会结算远程释放，之后可能出现新的部分占用 Slab，再尝试窃取一次
+        nvm_malloc_reclaim(allocator);
+        block = nvm_malloc_class(allocator, sc_id, out_slab);
+        if (!block) block = nvm_malloc_steal(allocator, sc_id, out_slab);
+    }
+    return block;
+}
+
+// 从其他堆窃取块：线程缓存可用时整批窃取并放入 (此时为空的) 缓存，
+// 后续分配不必再次扫描其他堆
+static void* nvm_malloc_steal(NvmAllocator* allocator, SizeClassID sc_id, NvmSlab** out_slab) {
+    NvmThreadCache* tc = &thread_cache;
+    if (tc->generation == allocator->generation) {
+        NvmThreadCacheBin* bin = &tc->bins[sc_id];
+        if (bin->count == 0) {
+            bin->count = heap_steal_blocks(allocator, sc_id, bin->blocks, allocator->cache_limit[sc_id] / 2);
+            if (bin->count == 0) return NULL;
+            tcache_resolve_slabs(allocator, bin);
+            --bin->count;
+            *out_slab = bin->slabs[bin->count];
+            return bin->blocks[bin->count];
+        }
+    }
+
+    void* block = NULL;
+    heap_steal_blocks(allocator, sc_id, &block, 1);
+    if (block) *out_slab = heap_slab_of(allocator, block);
+    return block;
+}
+
+static void* nvm_malloc_class(NvmAllocator* allocator, SizeClassID sc_id, NvmSlab** out_slab) {
+    // [Fast Path] 线程缓存弹出：一次 TLS 访问 + 一次栈弹出，所属 Slab 随块一同弹出
+    NvmThreadCache* tc = &thread_cache;
+    if (NVM_LIKELY(tc->generation == allocator->generation) || tcache_bind(allocator, tc)) {
+        NvmThreadCacheBin* bin = &tc->bins[sc_id];
+        if (NVM_LIKELY(bin->count > 0)) {
+            --bin->count;
+            *out_slab = bin->slabs[bin->count];
+            return bin->blocks[bin->count];
+        }
+        return tcache_refill(allocator, tc, bin, sc_id, out_slab);
+    }
+
+    // 线程缓存已禁用：直接从 CPU 堆分配
+    void* block = NULL;
+    cpu_heap_alloc_blocks(allocator, allocator->cpu_heaps[current_cpu_index(allocator)], sc_id, &block, 1);
+    if (block) *out_slab = heap_slab_of(allocator, block);
+    return block;
+}
+
+static void* nvm_malloc_node_impl(NvmAllocator* allocator, size_t size, int node) {
+    if (!allocator || size == 0) return NULL;
+
+    if (node < 0 || (uint32_t)node >= allocator->node_count) {
+        LOG_ERR("Invalid NUMA node: %d", node);
+        return NULL;
+    }
+
+    SizeClassID sc_id = map_size_to_sc_id(size);
+    if (sc_id == SC_COUNT) {
+        return extent_alloc(allocator, allocator->node_heaps[node], size);
+    }
+
+    // 线程缓存与 CPU 缓存中的块来源不定，节点分配直接走节点堆
+    void* block = NULL;
+    heap_alloc_blocks(allocator, allocator->node_heaps[node], sc_id, &block, 1);
+    if (block) heap_persist_block(allocator, heap_slab_of(allocator, block), block);
+    return block;
+}
+
+static void nvm_free_impl(NvmAllocator* allocator, void* nvm_ptr) {
+    if (!allocator || !nvm_ptr) return;
+
+    // 定位所属区域并计算区域内偏移
+    uint64_t nvm_offset;
+    NvmCentralHeap* central = central_of_ptr(allocator, nvm_ptr, &nvm_offset);
+    if (!central) return;
+
+    // 页映射表无锁查找元数据
+    NvmSlab* target_slab = slab_pagemap_lookup(central->slab_page_map, nvm_offset);
+    if (NVM_UNLIKELY(!target_slab)) {
+        // 不是 Slab 块：可能是大对象
+        NvmExtent* extent = slab_pagemap_lookup_extent(central->slab_page_map, nvm_offset);
+        if (extent) central_free_extent(central, extent, nvm_offset);
+        return;
+    }
+
+    // 先清除持久位：块一旦进入缓存，崩溃后即视为空闲
+    nvm_layout_unmark(&central->layout, target_slab->nvm_base_offset,
+                      nvm_slab_block_index(target_slab, nvm_offset - target_slab->nvm_base_offset));
+
+    // [Fast Path] 压入线程缓存
+    heap_release_block(allocator, target_slab, nvm_ptr, nvm_offset);
+}
+
+static void* nvm_reserve_impl(NvmAllocator* allocator, size_t size, NvmAction* action) {
+    if (!allocator || !action || size == 0) return NULL;
+
+    SizeClassID sc_id = map_size_to_sc_id(size);
+    if (sc_id == SC_COUNT) {
+        LOG_ERR("Reserve supports slab sizes only (%zu bytes requested).", size);
+        return NULL;
+    }
+
+    // 与 nvm_malloc 相同的缓存路径，只是不置位持久位图
+    NvmSlab* slab;
+    void* block = nvm_malloc_slab(allocator, sc_id, &slab);
+    if (!block) return NULL;
+
+    uint64_t in_slab = (uint64_t)((char*)block - slab_addr_of(allocator, slab));
+    action->ptr         = block;
+    action->offset      = slab->nvm_base_offset + in_slab;
+    action->slab_offset = slab->nvm_base_offset;
+    action->block_idx   = nvm_slab_block_index(slab, in_slab);
+    action->region_id   = slab->region_id;
+
+    // 记下预留状态：发布与取消各自原子清除，只有清除成功的一方拥有该块
+    nvm_slab_reserve_block(slab, action->block_idx);
+    return block;
+}
+
+static int nvm_publish_impl(NvmAllocator* allocator, const NvmAction* actions, uint32_t count, uint64_t* const* dest_ptrs) {
+    if (!allocator || (!actions && count > 0)) return -1;
+    if (count == 0) return 0;
+    if (count > NVM_PUBLISH_MAX_ACTIONS) {
+        LOG_ERR("Cannot publish %u actions at once (max %u).", count, (unsigned)NVM_PUBLISH_MAX_ACTIONS);
+        return -1;
+    }
+
+    // 先校验全部预留与目标位置，任何一项非法则一项都不发布
+    NvmSlab* slabs[NVM_PUBLISH_MAX_ACTIONS];
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t* dest = dest_ptrs ? dest_ptrs[i] : NULL;
+        uint64_t dest_offset;
+        slabs[i] = central_action_slab(allocator, &actions[i]);
+        if (!slabs[i]) {
+            LOG_ERR("Publish failed: Action %u (region %u, offset 0x%llx) is not a reserved slab block.", i,
+                    actions[i].region_id, (unsigned long long)actions[i].offset);
+            return -1;
+        }
+        if (dest && ((uintptr_t)dest % sizeof(uint64_t) != 0 || !central_of_ptr(allocator, dest, &dest_offset))) {
+            LOG_ERR("Publish failed: Target %p is not an aligned NVM location.", (void*)dest);
+            return -1;
+        }
+    }
+
+    // 再逐项清除预留标记：已发布、已取消、伪造 (块归他人所有) 或批内重复的预留清除失败，
+    // 此时恢复已清除的标记，一项都不发布
+    for (uint32_t i = 0; i < count; ++i) {
+        if (nvm_slab_unreserve_block(slabs[i], actions[i].block_idx) != 0) {
+            LOG_ERR("Publish failed: Action %u (region %u, offset 0x%llx) is no longer reserved.", i,
+                    actions[i].region_id, (unsigned long long)actions[i].offset);
+            while (i-- > 0) nvm_slab_reserve_block(slabs[i], actions[i].block_idx);
+            return -1;
+        }
+    }
+
+    NvmCentralHeap* home = &allocator->central_heaps[actions[0].region_id];
+    uint32_t slot;
+    if (central_claim_log(home, &slot) != 0) {
+        for (uint32_t i = 0; i < count; ++i) nvm_slab_reserve_block(slabs[i], actions[i].block_idx);
+        return -1;
+    }
+    NvmRedoLog* log = nvm_layout_log(&home->layout, slot);
+    uint32_t n = 0;
+
+    // 先记全部置位：相邻的预留多半来自同一 Slab，同一位图字上的置位合并为一项
+    for (uint32_t i = 0; i < count; ++i) {
+        const NvmAction* action = &actions[i];
+        uint64_t target = central_bitmap_target(&allocator->central_heaps[action->region_id], NVM_LOG_OP_SET,
+                                                action->slab_offset, action->block_idx);
+        uint64_t mask = 1ULL << (action->block_idx % 64);
+
+        if (n > 0 && log->entries[n - 1].target == target) {
+            log->entries[n - 1].value |= mask;
+        } else {
+            log->entries[n].target = target;
+            log->entries[n].value  = mask;
+            n++;
+        }
+    }
+
+    // 再记写入应用位置的块偏移
+    for (uint32_t i = 0; dest_ptrs && i < count; ++i) {
+        uint64_t dest_offset;
+        if (!dest_ptrs[i]) continue;
+        NvmCentralHeap* central = central_of_ptr(allocator, dest_ptrs[i], &dest_offset);
+        log->entries[n].target = nvm_log_target(NVM_LOG_OP_STORE, central->region_id, dest_offset);
+        log->entries[n].value  = actions[i].offset;
+        n++;
+    }
+
+    // 提交 (栅栏 1) -> 应用并等待落盘 (栅栏 2) -> 清空日志 (栅栏 3)
+    // 清空必须在返回前持久：否则之后的释放可能被挂载时重做的旧日志覆盖
+    // 应用失败时日志同样清空，挂载时不会重做一份无法应用的日志
+    nvm_log_commit(log, n);
+    int ret = nvm_log_apply(log, allocator->region_bases, allocator->region_sizes, allocator->region_count);
+    nvm_drain();
+    nvm_log_clear(log);
+
+    central_release_log(home, slot);
+    if (ret != 0) {
+        // 发布失败时预留仍归调用方，可以重试或取消
+        for (uint32_t i = 0; i < count; ++i) nvm_slab_reserve_block(slabs[i], actions[i].block_idx);
+        LOG_ERR("Publish failed: Redo log of region %u could not be applied.", home->region_id);
+    }
+    return ret;
+}
+
+static void nvm_cancel_impl(NvmAllocator* allocator, const NvmAction* actions, uint32_t count) {
+    if (!allocator || !actions) return;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const NvmAction* action = &actions[i];
+        NvmSlab* slab = central_action_slab(allocator, action);
+        if (!slab || nvm_slab_unreserve_block(slab, action->block_idx) != 0) {
+            LOG_ERR("Cancel skipped: Action %u (region %u, offset 0x%llx) is not a reserved slab block.", i,
+                    action->region_id, (unsigned long long)action->offset);
+            continue;
+        }
+        heap_release_block(allocator, slab, action->ptr, action->offset);
+    }
+}
+
+// 本线程进行中的事务；属于已销毁实例的事务 (其日志槽已随实例失效) 视为不存在
+static NvmTx* tx_current(NvmAllocator* allocator) {
+    NvmTx* tx = &thread_tx;
+    if (tx->generation == 0) return NULL;
+    if (NVM_UNLIKELY(tx->generation != allocator->generation)) {
+        tx->generation = 0;
+        return NULL;
+    }
+    return tx;
+}
+
+// 写入一条日志项：同一位图字上的置位/清除合并为一项 (事务内的块互不相同，合并不改变
+// 应用结果)，同一位置的多次写入只保留最后一次
+static int tx_record(NvmTx* tx, NvmRedoLog* log, uint64_t target, uint64_t value) {
+    bool store = (target >> NVM_LOG_OP_SHIFT) == NVM_LOG_OP_STORE;
+
+    for (uint32_t i = 0; i < tx->entry_count; ++i) {
+        NvmLogEntry* entry = &log->entries[i];
+        if (entry->target != target) continue;
+        if (store) {
+            entry->value = value;
+        } else if (entry->value & value) {
+            LOG_ERR("Transaction already touches block bit 0x%llx of word 0x%llx.",
+                    (unsigned long long)value, (unsigned long long)(target & NVM_LOG_OFFSET_MASK));
+            return -1;
+        } else {
+            entry->value |= value;
+        }
+        return 0;
+    }
+
+    if (tx->entry_count == NVM_LOG_CAPACITY) {
+        LOG_ERR("Transaction log full (%u entries).", (unsigned)NVM_LOG_CAPACITY);
+        return -1;
+    }
+    log->entries[tx->entry_count].target = target;
+    log->entries[tx->entry_count].value  = value;
+    tx->entry_count++;
+    return 0;
+}
+
+static int nvm_tx_begin_impl(NvmAllocator* allocator) {
+    if (!allocator) return -1;
+    if (tx_current(allocator)) {
+        LOG_ERR("Transaction already in progress on this thread.");
+        return -1;
+    }
+
+    // 登记线程退出析构：线程在提交/中止前退出时归还日志槽
+    NvmTx* tx = &thread_tx;
+    if (!tx->registered) {
+        pthread_once(&thread_tx_key_once, tx_create_key);
+        if (pthread_setspecific(thread_tx_key, tx) != 0) {
+            LOG_ERR("Failed to register transaction exit handler.");
+            return -1;
+        }
+        tx->registered = true;
+    }
+
+    // 日志槽取自本 CPU 的首选区域，与事务内多数分配同处一个节点
+    tx->region_id = allocator->cpu_heaps[current_cpu_index(allocator)]->region_order[0];
+    if (central_claim_log(&allocator->central_heaps[tx->region_id], &tx->slot) != 0) return -1;
+    tx->entry_count = 0;
+    tx->alloc_count = 0;
+    tx->free_count  = 0;
+    tx->generation  = allocator->generation;
+    return 0;
+}
+
+static void* nvm_tx_alloc_impl(NvmAllocator* allocator, size_t size) {
+    if (!allocator) return NULL;
+    NvmTx* tx = tx_current(allocator);
+    if (!tx) {
+        LOG_ERR("No transaction in progress.");
+        return NULL;
+    }
+    if (tx->alloc_count == NVM_TX_MAX_OPS) {
+        LOG_ERR("Too many allocations in one transaction (max %u).", (unsigned)NVM_TX_MAX_OPS);
+        return NULL;
+    }
+
+    NvmAction action;
+    void* block = nvm_reserve_impl(allocator, size, &action);
+    if (!block) return NULL;
+
+    NvmRedoLog* log = nvm_layout_log(&allocator->central_heaps[tx->region_id].layout, tx->slot);
+    uint64_t target = central_bitmap_target(&allocator->central_heaps[action.region_id], NVM_LOG_OP_SET,
+                                            action.slab_offset, action.block_idx);
+    if (tx_record(tx, log, target, 1ULL << (action.block_idx % 64)) != 0) {
+        nvm_cancel_impl(allocator, &action, 1);
+        return NULL;
+    }
+
+    // 事务自行记住块 (中止时直接归还)，不经由发布或取消，预留标记就此清除
+    nvm_slab_unreserve_block(heap_slab_of(allocator, block), action.block_idx);
+    tx->allocs[tx->alloc_count++] = block;
+    return block;
+}
+
+static int nvm_tx_free_impl(NvmAllocator* allocator, void* nvm_ptr) {
+    if (!allocator || !nvm_ptr) return -1;
+    NvmTx* tx = tx_current(allocator);
+    if (!tx) {
+        LOG_ERR("No transaction in progress.");
+        return -1;
+    }
+    if (tx->free_count == NVM_TX_MAX_OPS) {
+        LOG_ERR("Too many frees in one transaction (max %u).", (unsigned)NVM_TX_MAX_OPS);
+        return -1;
+    }
+
+    uint64_t nvm_offset;
+    NvmCentralHeap* central = central_of_ptr(allocator, nvm_ptr, &nvm_offset);
+    NvmSlab* slab = central ? slab_pagemap_lookup(central->slab_page_map, nvm_offset) : NULL;
+    if (!slab) {
+        LOG_ERR("Transactional free supports slab blocks only (%p).", nvm_ptr);
+        return -1;
+    }
+
+    // 只记清除项，块在提交之后才回到缓存：提交前崩溃时块仍是已分配状态
+    NvmRedoLog* log = nvm_layout_log(&allocator->central_heaps[tx->region_id].layout, tx->slot);
+    uint32_t block_idx = nvm_slab_block_index(slab, nvm_offset - slab->nvm_base_offset);
+    uint64_t target = central_bitmap_target(central, NVM_LOG_OP_CLEAR, slab->nvm_base_offset, block_idx);
+    if (tx_record(tx, log, target, 1ULL << (block_idx % 64)) != 0) return -1;
+
+    tx->frees[tx->free_count++] = nvm_ptr;
+    return 0;
+}
+
+static int nvm_tx_set_impl(NvmAllocator* allocator, uint64_t* dest, uint64_t value) {
+    if (!allocator || !dest) return -1;
+    NvmTx* tx = tx_current(allocator);
+    if (!tx) {
+        LOG_ERR("No transaction in progress.");
+        return -1;
+    }
+
+    uint64_t dest_offset;
+    NvmCentralHeap* central = central_of_ptr(allocator, dest, &dest_offset);
+    if ((uintptr_t)dest % sizeof(uint64_t) != 0 || !central) {
+        LOG_ERR("Transactional store failed: Target %p is not an aligned NVM location.", (void*)dest);
+        return -1;
+    }
+
+    NvmRedoLog* log = nvm_layout_log(&allocator->central_heaps[tx->region_id].layout, tx->slot);
+    return tx_record(tx, log, nvm_log_target(NVM_LOG_OP_STORE, central->region_id, dest_offset), value);
+}
+
+static int nvm_tx_commit_impl(NvmAllocator* allocator) {
+    if (!allocator) return -1;
+    NvmTx* tx = tx_current(allocator);
+    if (!tx) {
+        LOG_ERR("No transaction in progress.");
+        return -1;
+    }
+
+    NvmCentralHeap* home = &allocator->central_heaps[tx->region_id];
+    NvmRedoLog* log = nvm_layout_log(&home->layout, tx->slot);
+
+    // 与发布相同的固定三次栅栏：提交 -> 应用并等待落盘 -> 清空日志
+    int ret = 0;
+    if (tx->entry_count > 0) {
+        ret = nvm_log_commit(log, tx->entry_count);
+        if (ret == 0) ret = nvm_log_apply(log, allocator->region_bases, allocator->region_sizes, allocator->region_count);
+        nvm_drain();
+        nvm_log_clear(log);
+    }
+
+    // 应用失败时清除项可能未生效：推迟释放的块持久位可能仍在，不能回到缓存
+    if (ret != 0) {
+        LOG_ERR("Transaction commit failed: Redo log of region %u could not be applied.", home->region_id);
+        central_release_log(home, tx->slot);
+        tx->generation = 0;
+        return -1;
+    }
+
+    // 清除已持久，推迟的释放此时才让块回到缓存
+    for (uint32_t i = 0; i < tx->free_count; ++i) {
+        uint64_t nvm_offset;
+        NvmCentralHeap* central = central_of_ptr(allocator, tx->frees[i], &nvm_offset);
+        NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, nvm_offset);
+        heap_release_block(allocator, slab, tx->frees[i], nvm_offset);
+    }
+
+    central_release_log(home, tx->slot);
+    tx->generation = 0;
+    return 0;
+}
+
+static void nvm_tx_abort_impl(NvmAllocator* allocator) {
+    if (!allocator) return;
+    NvmTx* tx = tx_current(allocator);
+    if (!tx) return;
+
+    // 日志从未提交 (项数为 0)，持久状态未被改写：预留的块回到缓存，推迟的释放作废
+    for (uint32_t i = 0; i < tx->alloc_count; ++i) {
+        uint64_t nvm_offset;
+        NvmCentralHeap* central = central_of_ptr(allocator, tx->allocs[i], &nvm_offset);
+        NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, nvm_offset);
+        heap_release_block(allocator, slab, tx->allocs[i], nvm_offset);
+    }
+
+    central_release_log(&allocator->central_heaps[tx->region_id], tx->slot);
+    tx->generation = 0;
+}
+
+static void tx_create_key(void) {
+    if (pthread_key_create(&thread_tx_key, tx_thread_exit) != 0) {
+        LOG_ERR("Failed to create transaction key.");
+    }
+}
+
+// 线程退出析构：中止仍在进行的事务。线程缓存可能已先析构，预留的块直接归还 Slab
+static void tx_thread_exit(void* arg) {
+    NvmTx* tx = (NvmTx*)arg;
+    NvmAllocator* allocator = global_nvm_allocator;
+    if (allocator != NULL && tx->generation == allocator->generation) {
+        for (uint32_t i = 0; i < tx->alloc_count; ++i) {
+            heap_free_ptr(allocator, tx->allocs[i]);
+        }
+        central_release_log(&allocator->central_heaps[tx->region_id], tx->slot);
+    }
+    tx->generation = 0;
+}
+
+static int nvm_allocator_restore_allocation_impl(NvmAllocator* allocator, void* nvm_ptr, size_t size) {
+    if (!allocator || !nvm_ptr || size == 0) return -1;
+
+    SizeClassID sc_id = map_size_to_sc_id(size);
+    if (sc_id == SC_COUNT) return -1;
+
+    uint64_t nvm_offset;
+    NvmCentralHeap* central = central_of_ptr(allocator, nvm_ptr, &nvm_offset);
+    if (!central) {
+        LOG_ERR("Restore failed: Pointer outside all NVM regions.");
+        return -1;
+    }
+    // Slab 跨度自然对齐，由块偏移与类别即可反推 Slab 起点；指针须是某个完整块的起点
+    uint64_t span = nvm_slab_class_span_size(sc_id);
+    uint64_t block = nvm_slab_class_block_size(sc_id);
+    uint64_t slab_base = NVM_ALIGN_DOWN(nvm_offset - NVM_START_OFFSET, span) + NVM_START_OFFSET;
+    if ((nvm_offset - slab_base) % block != 0 || (nvm_offset - slab_base) / block >= span / block) {
+        LOG_ERR("Restore failed: Offset %llu is not the start of a %llu-byte block.",
+                (unsigned long long)nvm_offset, (unsigned long long)block);
+        return -1;
+    }
+
+    NvmCpuHeap* owner_heap;
+    NvmSlab* slab;
+    uint32_t retire_waits = 0;              // 遇到退役中的 Slab 后，等待其空间归还的次数
+
+retry:
+    // 空间管理器持有互斥锁且可能分配内存，建立索引要获取读写锁并写回持久头部，均不在
+    // 堆锁 (自旋锁) 内进行；恢复锁保证查找、占位与注册对其他恢复调用整体可见
+    NVM_MUTEX_ACQUIRE(&allocator->restore_lock);
+
+    slab = slab_pagemap_lookup(central->slab_page_map, nvm_offset);
+
+    if (!slab) {
+        // Slab 不存在：重建并占位。恢复与分配交错时，该区间可能落在某个堆未切分的预留中，
+        // 归还所有预留后重试一次 (期间其他线程可能已切分出该 Slab，须重新查找)
+        if (space_manager_alloc_at_offset(central->space_manager, slab_base, span) != 0) {
+            heaps_release_reservations(allocator);
+
+            slab = slab_pagemap_lookup(central->slab_page_map, nvm_offset);
+            if (!slab && space_manager_alloc_at_offset(central->space_manager, slab_base, span) != 0) {
+                NVM_MUTEX_RELEASE(&allocator->restore_lock);
+                // 退役先撤销映射、最后才归还空间，两步之间该区间仍被占用
+                if (retire_waits > 0 && retire_waits++ < NVM_RESTORE_RETIRE_YIELDS) {
+                    sched_yield();
+                    goto retry;
+                }
+                LOG_ERR("Restore failed: Space occupied.");
+                return -1;
+            }
+        }
+    }
+
+    if (!slab) {
+        // 空间已占位：建立描述符、注册索引并记录持久头部 (任何一步失败都已撤销并归还空间)，
+        // 最后在堆锁内挂载到区域所在节点的 CPU 堆
+        slab = central_carve_slab(central, sc_id, slab_base);
+        if (!slab) {
+            NVM_MUTEX_RELEASE(&allocator->restore_lock);
+            return -1;
+        }
+
+        NvmCpuHeap* heap = central_attach_heap(allocator, central);
+        NVM_SPINLOCK_ACQUIRE(&heap->lock);
+        slab->owner_heap = heap;
+        heap_link_slab(heap, slab, SLAB_LIST_PARTIAL);
+        NVM_SPINLOCK_RELEASE(&heap->lock);
+    } else if (slab->size_type_id != sc_id) {
+        // Slab 已存在：校验类别 (同类别的跨度相同，起点必然一致；描述符被复用的情况由
+        // 下方锁内复查处理)
+        NVM_MUTEX_RELEASE(&allocator->restore_lock);
+        LOG_ERR("Restore mismatch: Size class conflict.");
+        return -1;
+    }
+    NVM_MUTEX_RELEASE(&allocator->restore_lock);
+
+    // 本地释放在所属堆锁内以普通读写归还块，置位须持有同一把锁 (已有的 Slab 可能属于其他堆)
+    // 放开恢复锁后 Slab 可能已被所属堆退役：此时重新查找，必要时重建
+    owner_heap = heap_lock_slab_owner(central, slab, slab_base);
+    if (!owner_heap) {
+        if (retire_waits == 0) retire_waits = 1;
+        goto retry;
+    }
+
+    // 标记位图，并按新的占用状态调整所在链表
+    uint32_t block_idx = nvm_slab_block_index(slab, nvm_offset - slab_base);
+    int ret = nvm_slab_set_bitmap_at_idx(slab, block_idx);
+    if (ret == 0) nvm_layout_mark(&central->layout, slab_base, block_idx);
+    heap_move_slab(owner_heap, slab, heap_classify_slab(slab));
+
+    NVM_SPINLOCK_RELEASE(&owner_heap->lock);
+    return ret;
+}
+
+// 条目换算为 (区域, 偏移, 类别)：指针须是所属类别 Slab 跨度内某个完整块的起点
+static int restore_convert(NvmAllocator* allocator, const NvmRestoreEntry* entry, NvmRestoreRecord* out) {
+    if (!entry->nvm_ptr || entry->size == 0) return -1;
+
+    SizeClassID sc_id = map_size_to_sc_id(entry->size);
+    if (sc_id == SC_COUNT) return -1;
+
+    uint64_t nvm_offset;
+    NvmCentralHeap* central = central_of_ptr(allocator, entry->nvm_ptr, &nvm_offset);
+    if (!central) return -1;
+
+    uint64_t span     = nvm_slab_class_span_size(sc_id);
+    uint64_t block    = nvm_slab_class_block_size(sc_id);
+    uint64_t in_slab  = (nvm_offset - NVM_START_OFFSET) % span;
+    if (in_slab / block >= span / block) return -1;
+    if (in_slab % block != 0) {
+        LOG_ERR("Restore failed: Offset %llu is not the start of a %llu-byte block.",
+                (unsigned long long)nvm_offset, (unsigned long long)block);
+        return -1;
+    }
+
+    out->offset    = nvm_offset;
+    out->region_id = central->region_id;
+    out->sc_id     = (uint8_t)sc_id;
+    return 0;
+}
+
+// 记录所在的分桶：区域号为主序，区域内按地址等分 (末桶兜底)
+static uint32_t restore_bucket_of(const NvmRestoreRecord* record, const uint64_t* bucket_span, uint32_t per_region) {
+    uint64_t idx = (record->offset - NVM_START_OFFSET) / bucket_span[record->region_id];
+    if (idx >= per_region) idx = per_region - 1;
+    return (uint32_t)record->region_id * per_region + (uint32_t)idx;
+}
+
+static int restore_record_cmp(const void* a, const void* b) {
+    const NvmRestoreRecord* x = (const NvmRestoreRecord*)a;
+    const NvmRestoreRecord* y = (const NvmRestoreRecord*)b;
+    if (x->region_id != y->region_id) return x->region_id < y->region_id ? -1 : 1;
+    if (x->offset != y->offset) return x->offset < y->offset ? -1 : 1;
+    return 0;
+}
+
+// 调用线程连同至多 threads - 1 个临时线程一起执行 worker (线程创建失败时由已有线程分担)
+static void restore_run(NvmRestoreJob* job, uint32_t threads, void* (*worker)(void*)) {
+    pthread_t tids[NVM_RESTORE_MAX_THREADS];
+    uint32_t started = 0;
+
+    job->next = 0;
+    for (uint32_t t = 1; t < threads && t < NVM_RESTORE_MAX_THREADS; ++t) {
+        if (pthread_create(&tids[started], NULL, worker, job) == 0) started++;
+    }
+    worker(job);
+    for (uint32_t t = 0; t < started; ++t) {
+        pthread_join(tids[t], NULL);
+    }
+}
+
+static void* restore_sort_worker(void* arg) {
+    NvmRestoreJob* job = (NvmRestoreJob*)arg;
+    for (;;) {
+        size_t b = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (b >= job->bucket_count) break;
+
+        size_t n = job->bucket_starts[b + 1] - job->bucket_starts[b];
+        if (n > 1) qsort(&job->records[job->bucket_starts[b]], n, sizeof(NvmRestoreRecord), restore_record_cmp);
+    }
+    return NULL;
+}
+
+static void* restore_mark_worker(void* arg) {
+    NvmRestoreJob* job = (NvmRestoreJob*)arg;
+    for (;;) {
+        size_t g = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (g >= job->group_count) break;
+        if (job->groups[g].slab && restore_mark_group(job->allocator, job->records, &job->groups[g]) != 0) {
+            __atomic_store_n(&job->failed, true, __ATOMIC_RELAXED);
+        }
+    }
+    // 写回积攒在本线程，退出前排空
+    nvm_drain();
+    return NULL;
+}
+
+static int restore_mark_group(NvmAllocator* allocator, const NvmRestoreRecord* records, const NvmRestoreGroup* group) {
+    NvmCentralHeap* central = &allocator->central_heaps[group->region_id];
+    NvmSlab* slab = group->slab;
+
+    if (group->created) {
+        // 新 Slab 尚未挂到任何堆，只有本线程可见：直接在已清零的持久位图上按字置位，
+        // 整段写回后再整字载入 DRAM 位图
+        uint64_t* words = nvm_layout_bitmap(&central->layout, group->slab_base);
+        for (size_t i = group->begin; i < group->end; ++i) {
+            uint32_t idx = nvm_slab_block_index(slab, records[i].offset - group->slab_base);
+            words[idx / 64] |= 1ULL << (idx % 64);
+        }
+        nvm_flush(words, slab->bitmap_words * sizeof(uint64_t));
+        nvm_slab_load_bitmap(slab, words);
+        return 0;
+    }
+
+    // 已有的 Slab 可能正被所属堆使用：本地释放只持所属堆锁，置位须持同一把锁，
+    // 并按新的占用状态调整所在链表。分组时未持锁，Slab 可能已被退役：逐块走单条恢复重建
+    NvmCpuHeap* owner_heap = heap_lock_slab_owner(central, slab, group->slab_base);
+    if (!owner_heap) {
+        uint32_t block_size = nvm_slab_class_block_size((SizeClassID)group->sc_id);
+        for (size_t i = group->begin; i < group->end; ++i) {
+            void* ptr = (char*)central->nvm_base_addr + records[i].offset;
+            if (nvm_allocator_restore_allocation_impl(allocator, ptr, block_size) != 0) return -1;
+        }
+        return 0;
+    }
+    for (size_t i = group->begin; i < group->end; ++i) {
+        uint32_t idx = nvm_slab_block_index(slab, records[i].offset - group->slab_base);
+        if (nvm_slab_set_bitmap_at_idx(slab, idx) == 0) nvm_layout_mark(&central->layout, group->slab_base, idx);
+    }
+    heap_move_slab(owner_heap, slab, heap_classify_slab(slab));
+    NVM_SPINLOCK_RELEASE(&owner_heap->lock);
+    return 0;
+}
+
+// 把有序的记录按 Slab 分组，并与已有的 Slab 核对；同一空间被当作不同类别时失败
+static int restore_group_records(NvmRestoreJob* job, size_t count) {
+    size_t capacity = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        const NvmRestoreRecord* record = &job->records[i];
+        uint64_t span = nvm_slab_class_span_size(record->sc_id);
+        uint64_t base = NVM_ALIGN_DOWN(record->offset - NVM_START_OFFSET, span) + NVM_START_OFFSET;
+        NvmRestoreGroup* last = job->group_count ? &job->groups[job->group_count - 1] : NULL;
+
+        if (last && last->region_id == record->region_id) {
+            if (last->slab_base == base && last->sc_id == record->sc_id) {
+                last->end = i + 1;
+                continue;
+            }
+            // 分组按地址有序且互不重叠，只需与上一组比较
+            if (last->slab_base + nvm_slab_class_span_size(last->sc_id) > base) {
+                LOG_ERR("Restore mismatch: Size class conflict at offset %llu.", (unsigned long long)record->offset);
+                return -1;
+            }
+        }
+
+        if (job->group_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            NvmRestoreGroup* grown = (NvmRestoreGroup*)realloc(job->groups, capacity * sizeof(NvmRestoreGroup));
+            if (!grown) {
+                LOG_ERR("Restore failed: Out of memory.");
+                return -1;
+            }
+            job->groups = grown;
+        }
+        job->groups[job->group_count++] = (NvmRestoreGroup){
+            .slab = NULL, .slab_base = base, .begin = i, .end = i + 1,
+            .region_id = record->region_id, .sc_id = record->sc_id, .created = false,
+        };
+    }
+
+    for (size_t g = 0; g < job->group_count; ++g) {
+        NvmRestoreGroup* group = &job->groups[g];
+        NvmCentralHeap* central = &job->allocator->central_heaps[group->region_id];
+        NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, group->slab_base);
+        if (!slab) {
+            group->created = true;
+        } else if (slab->size_type_id != group->sc_id || slab->nvm_base_offset != group->slab_base) {
+            LOG_ERR("Restore mismatch: Size class conflict at offset %llu.", (unsigned long long)group->slab_base);
+            return -1;
+        } else {
+            group->slab = slab;
+        }
+    }
+    return 0;
+}
+
+// 第 failed 组的新 Slab 建立失败：退役此前建立的新 Slab，归还其后新 Slab 的占位
+static void restore_rollback(NvmAllocator* allocator, NvmRestoreJob* job, size_t failed) {
+    for (size_t g = 0; g < job->group_count; ++g) {
+        NvmRestoreGroup* group = &job->groups[g];
+        if (!group->created || g == failed) continue;
+
+        NvmCentralHeap* central = &allocator->central_heaps[group->region_id];
+        if (g < failed) {
+            central_retire_slab(central, group->slab);
+            group->slab = NULL;
+        } else {
+            space_manager_free(central->space_manager, group->slab_base, nvm_slab_class_span_size(group->sc_id));
+        }
+    }
+}
+
+// 每个区域一次性占位该区域全部新 Slab 的空间 (分组按区域与地址有序)；
+// 某个区域失败时归还之前各区域的占位
+static int restore_reserve(NvmAllocator* allocator, const NvmRestoreJob* job, uint64_t* offsets, uint64_t* sizes) {
+    size_t g = 0;
+    while (g < job->group_count) {
+        uint16_t region_id = job->groups[g].region_id;
+        size_t first = g, n = 0;
+        for (; g < job->group_count && job->groups[g].region_id == region_id; ++g) {
+            if (!job->groups[g].created) continue;
+            offsets[n] = job->groups[g].slab_base;
+            sizes[n]   = nvm_slab_class_span_size(job->groups[g].sc_id);
+            n++;
+        }
+        if (space_manager_alloc_at_offsets(allocator->central_heaps[region_id].space_manager, offsets, sizes, n) == 0) {
+            continue;
+        }
+
+        for (size_t i = 0; i < first; ++i) {
+            const NvmRestoreGroup* group = &job->groups[i];
+            if (!group->created) continue;
+            space_manager_free(allocator->central_heaps[group->region_id].space_manager,
+                               group->slab_base, nvm_slab_class_span_size(group->sc_id));
+        }
+        return -1;
+    }
+    return 0;
+}
+
+static int nvm_allocator_restore_batch_impl(NvmAllocator* allocator, const NvmRestoreEntry* entries, size_t count) {
+    if (!allocator || (!entries && count > 0)) return -1;
+    if (count == 0) return 0;
+
+    uint32_t threads = 1;
+    if (count >= NVM_RESTORE_PARALLEL_MIN) {
+        threads = allocator->cpu_count < NVM_RESTORE_MAX_THREADS ? allocator->cpu_count : NVM_RESTORE_MAX_THREADS;
+    }
+    uint32_t per_region = threads * NVM_RESTORE_BUCKETS_PER_THREAD;
+
+    int ret = -1;
+    NvmRestoreJob job = { .allocator = allocator, .bucket_count = allocator->region_count * per_region };
+    uint64_t* bucket_span  = (uint64_t*)malloc(allocator->region_count * sizeof(uint64_t));
+    size_t*   cursor       = (size_t*)malloc(job.bucket_count * sizeof(size_t));
+    uint64_t* span_offsets = NULL;
+    uint64_t* span_sizes   = NULL;
+    job.bucket_starts = (size_t*)calloc(job.bucket_count + 1, sizeof(size_t));
+    job.records       = (NvmRestoreRecord*)malloc(count * sizeof(NvmRestoreRecord));
+    if (!bucket_span || !cursor || !job.bucket_starts || !job.records) {
+        LOG_ERR("Restore failed: Out of memory.");
+        goto cleanup;
+    }
+
+    // 桶界按最大 Slab 跨度对齐，任何 Slab 都不跨桶
+    for (uint32_t r = 0; r < allocator->region_count; ++r) {
+        bucket_span[r] = NVM_ALIGN_UP(allocator->region_sizes[r] / per_region, (uint64_t)NVM_MAX_SLAB_SPAN);
+        if (bucket_span[r] == 0) bucket_span[r] = NVM_MAX_SLAB_SPAN;
+    }
+
+    // 1. 校验全部条目并按分桶计数：任何一个条目非法则什么都不做
+    for (size_t i = 0; i < count; ++i) {
+        NvmRestoreRecord record;
+        if (restore_convert(allocator, &entries[i], &record) != 0) {
+            LOG_ERR("Restore failed: Invalid entry %zu (%p, %zu bytes).", i, entries[i].nvm_ptr, entries[i].size);
+            goto cleanup;
+        }
+        job.bucket_starts[restore_bucket_of(&record, bucket_span, per_region) + 1]++;
+    }
+    for (uint32_t b = 0; b < job.bucket_count; ++b) {
+        job.bucket_starts[b + 1] += job.bucket_starts[b];
+        cursor[b] = job.bucket_starts[b];
+    }
+
+    // 2. 分散到各桶，各桶并行排序后整体即按区域与地址有序
+    for (size_t i = 0; i < count; ++i) {
+        NvmRestoreRecord record;
+        restore_convert(allocator, &entries[i], &record);
+        job.records[cursor[restore_bucket_of(&record, bucket_span, per_region)]++] = record;
+    }
+    restore_run(&job, threads, restore_sort_worker);
+
+    // 3. 按 Slab 分组；所需的新 Slab 空间按区域一次性占位，与堆的未切分预留冲突时归还预留重试一次
+    //    分组、占位与建立在恢复锁内进行，与单条恢复互斥
+    NVM_MUTEX_ACQUIRE(&allocator->restore_lock);
+    if (restore_group_records(&job, count) != 0) goto unlock;
+
+    span_offsets = (uint64_t*)malloc(job.group_count * sizeof(uint64_t));
+    span_sizes   = (uint64_t*)malloc(job.group_count * sizeof(uint64_t));
+    if (!span_offsets || !span_sizes) {
+        LOG_ERR("Restore failed: Out of memory.");
+        goto unlock;
+    }
+    if (restore_reserve(allocator, &job, span_offsets, span_sizes) != 0) {
+        heaps_release_reservations(allocator);
+        if (restore_reserve(allocator, &job, span_offsets, span_sizes) != 0) {
+            LOG_ERR("Restore failed: Space occupied.");
+            goto unlock;
+        }
+    }
+
+    // 4. 建立新 Slab (注册索引并写入持久头部)；某个失败 (其自身空间已归还) 时退役已建立的
+    //    新 Slab、归还其余新 Slab 的占位，整批不留任何改动
+    for (size_t g = 0; g < job.group_count; ++g) {
+        NvmRestoreGroup* group = &job.groups[g];
+        if (!group->created) continue;
+
+        group->slab = central_carve_slab(&allocator->central_heaps[group->region_id],
+                                         (SizeClassID)group->sc_id, group->slab_base);
+        if (!group->slab) {
+            LOG_ERR("Restore failed: Cannot carve slab at offset %llu.", (unsigned long long)group->slab_base);
+            restore_rollback(allocator, &job, g);
+            goto unlock;
+        }
+    }
+    NVM_MUTEX_RELEASE(&allocator->restore_lock);
+
+    // 5. 各 Slab 互不相干，并行置位 (已退役的已有 Slab 走单条恢复，需要获取恢复锁)
+    //    新 Slab 在挂载前所属堆为空，并发的单条恢复会等待其挂载
+    restore_run(&job, job.group_count < threads ? (uint32_t)job.group_count : threads, restore_mark_worker);
+    ret = 0;
+    if (job.failed) {
+        LOG_ERR("Restore failed: Cannot rebuild retired slabs.");
+        ret = -1;
+    }
+
+    // 6. 新 Slab 挂载到区域所在节点的 CPU 堆 (已有的 Slab 已在置位时调整所在链表)
+    for (size_t g = 0; g < job.group_count; ++g) {
+        NvmSlab* slab = job.groups[g].slab;
+        if (!slab || !job.groups[g].created) continue;
+        NvmCpuHeap* heap = central_attach_heap(allocator, &allocator->central_heaps[job.groups[g].region_id]);
+        NVM_SPINLOCK_ACQUIRE(&heap->lock);
+        slab->owner_heap = heap;
+        heap_link_slab(heap, slab, heap_classify_slab(slab));
+        NVM_SPINLOCK_RELEASE(&heap->lock);
+    }
+    goto cleanup;
+
+unlock:
+    NVM_MUTEX_RELEASE(&allocator->restore_lock);
+cleanup:
+    free(span_sizes);
+    free(span_offsets);
+    free(job.groups);
+    free(job.records);
+    free(job.bucket_starts);
+    free(cursor);
+    free(bucket_span);
+    return ret;
+}
+
+// 先回写当前线程缓存、各 CPU 缓存与弹匣仓库，使其占住的 Slab 有机会变空，再归还所有
+// 空 Slab 与空区块，返回归还的字节数 (其他线程的线程缓存无法触及)
+static size_t nvm_malloc_reclaim(NvmAllocator* allocator) {
+    tcache_flush_all(allocator, &thread_cache);
+    cpu_cache_drain_all(allocator);
+    depot_drain_all(allocator);
+    return nvm_malloc_trim_impl(allocator);
+}
+
+static size_t nvm_malloc_trim_impl(NvmAllocator* allocator) {
+    size_t released = 0;
+
+    for (uint32_t i = 0; i < allocator->cpu_count; ++i) {
+        released += heap_trim(allocator, allocator->cpu_heaps[i]);
+    }
+    for (uint32_t n = 0; n < allocator->node_count; ++n) {
+        released += heap_trim(allocator, allocator->node_heaps[n]);
+    }
+    for (uint32_t i = 0; i < allocator->region_count; ++i) {
+        released += central_trim_extents(&allocator->central_heaps[i]);
+    }
+    return released;
+}
+
+// ============================================================================
+//                          大对象 (区块) 实现
+// ============================================================================
+
+// 以下链表操作均假设已持有 central->extent_lock
+static void extent_link(NvmExtent** head, NvmExtent* extent) {
+    extent->prev_in_chain = NULL;
+    extent->next_in_chain = *head;
+    if (*head) (*head)->prev_in_chain = extent;
+    *head = extent;
+}
+
+static void extent_unlink(NvmExtent** head, NvmExtent* extent) {
+    if (extent->prev_in_chain) extent->prev_in_chain->next_in_chain = extent->next_in_chain;
+    else                       *head = extent->next_in_chain;
+
+    if (extent->next_in_chain) extent->next_in_chain->prev_in_chain = extent->prev_in_chain;
+
+    extent->prev_in_chain = NULL;
+    extent->next_in_chain = NULL;
+}
+
+// 页粒度区块按 max_free_run 入箱；区块的空闲段变化前后须先出箱再入箱
+static void chunk_index_insert(NvmCentralHeap* central, NvmExtent* chunk) {
+    uint32_t bin = chunk->max_free_run;
+    extent_link(&central->extent_chunk_bins[bin], chunk);
+    central->extent_chunk_nonempty[bin / 64] |= 1ULL << (bin % 64);
+    central->extent_chunk_count++;
+}
+
+static void chunk_index_remove(NvmCentralHeap* central, NvmExtent* chunk) {
+    uint32_t bin = chunk->max_free_run;
+    extent_unlink(&central->extent_chunk_bins[bin], chunk);
+    if (!central->extent_chunk_bins[bin]) {
+        central->extent_chunk_nonempty[bin / 64] &= ~(1ULL << (bin % 64));
+    }
+    central->extent_chunk_count--;
+}
+
+// 最长空闲段不小于 pages 的区块中空闲段最短的一个 (Best-Fit)，没有时返回 NULL
+// 逐字扫描非空箱位图，至多 NVM_EXTENT_PAGES / 64 + 1 个字
+static NvmExtent* chunk_index_find(const NvmCentralHeap* central, uint32_t pages) {
+    for (uint32_t w = pages / 64; w <= NVM_EXTENT_PAGES / 64; ++w) {
+        uint64_t word = central->extent_chunk_nonempty[w];
+        if (w == pages / 64) word &= ~0ULL << (pages % 64);
+        if (word) return central->extent_chunk_bins[w * 64 + (uint32_t)__builtin_ctzll(word)];
+    }
+    return NULL;
+}
+
+// 分配超过最大尺寸类别的对象：按堆的区域顺序，本节点的区域优先，耗尽时按距离回退
+static void* extent_alloc(NvmAllocator* allocator, const NvmCpuHeap* heap, size_t size) {
+    if ((uint64_t)size > UINT64_MAX - NVM_SPAN_UNIT) return NULL;
+
+    for (uint32_t i = 0; i < allocator->region_count; ++i) {
+        void* ptr = central_alloc_extent(&allocator->central_heaps[heap->region_order[i]], size);
+        if (ptr) return ptr;
+    }
+    return NULL;
+}
+
+// 在一个区域内分配大对象，区域空间不足时返回 NULL
+static void* central_alloc_extent(NvmCentralHeap* central, size_t size) {
+    char* base = (char*)central->nvm_base_addr;
+
+    // 巨型对象：独占按跨度单元取整的连续空间 (空间管理器按单元分配)
+    if (size > NVM_SLAB_SIZE) {
+        uint64_t span_bytes = NVM_ALIGN_UP((uint64_t)size, (uint64_t)NVM_SPAN_UNIT);
+        uint64_t offset = space_manager_alloc(central->space_manager, span_bytes);
+        if (offset == (uint64_t)-1) return NULL;
+
+        NVM_MUTEX_ACQUIRE(&central->extent_lock);
+        NvmExtent* extent = central_acquire_extent(central, offset, (uint32_t)(span_bytes / NVM_SPAN_UNIT));
+        if (extent) extent_link(&central->extent_spans, extent);
+        NVM_MUTEX_RELEASE(&central->extent_lock);
+        if (!extent) {
+            space_manager_free(central->space_manager, offset, span_bytes);
+            return NULL;
+        }
+
+        // 发布到页映射表 (只映射首页，释放须传入对象起始地址)
+        if (slab_pagemap_insert_extent(central->slab_page_map, offset, NVM_SPAN_UNIT, extent) != 0) {
+            NVM_MUTEX_ACQUIRE(&central->extent_lock);
+            extent_unlink(&central->extent_spans, extent);
+            central_recycle_extent(central, extent);
+            NVM_MUTEX_RELEASE(&central->extent_lock);
+            space_manager_free(central->space_manager, offset, span_bytes);
+            LOG_ERR("Failed to publish extent into page map.");
+            return NULL;
+        }
+        nvm_layout_set_span(&central->layout, offset, NVM_SPAN_HUGE, 0, span_bytes);
+        return base + offset;
+    }
+
+    // 页粒度对象：取最长空闲段刚好放得下的已有区块 (区块内 First-Fit)，都放不下时切分新区块
+    uint32_t pages = (uint32_t)(NVM_ALIGN_UP((uint64_t)size, NVM_EXTENT_PAGE_SIZE) / NVM_EXTENT_PAGE_SIZE);
+    uint32_t page;
+    NvmExtent* chunk;
+
+    NVM_MUTEX_ACQUIRE(&central->extent_lock);
+
+    chunk = chunk_index_find(central, pages);
+    if (chunk) {
+        chunk_index_remove(central, chunk);
+        nvm_extent_alloc(chunk, pages, &page);
+        chunk_index_insert(central, chunk);
+    } else {
+        uint64_t offset = space_manager_alloc_slab(central->space_manager);
+        if (offset == (uint64_t)-1) {
+            NVM_MUTEX_RELEASE(&central->extent_lock);
+            return NULL;
+        }
+
+        chunk = central_acquire_extent(central, offset, NVM_EXTENT_CHUNK_UNITS);
+        if (!chunk) {
+            space_manager_free_slab(central->space_manager, offset);
+            NVM_MUTEX_RELEASE(&central->extent_lock);
+            return NULL;
+        }
+
+        // 区块内任意页都可能是对象起点，映射整个区块
+        if (slab_pagemap_insert_extent(central->slab_page_map, offset, NVM_SLAB_SIZE, chunk) != 0) {
+            central_recycle_extent(central, chunk);
+            space_manager_free_slab(central->space_manager, offset);
+            NVM_MUTEX_RELEASE(&central->extent_lock);
+            LOG_ERR("Failed to publish extent into page map.");
+            return NULL;
+        }
+        nvm_layout_set_span(&central->layout, offset, NVM_SPAN_CHUNK, 0, NVM_SLAB_SIZE);
+
+        nvm_extent_alloc(chunk, pages, &page);
+        chunk_index_insert(central, chunk);
+    }
+
+    // 持久位图：先标记占用页再标记起始页，两步之间以一次屏障排序，任何时刻崩溃都不会
+    // 出现指向空闲页的起始页。位操作是原子的，屏障与起始页放到锁外：对象尚未交出，
+    // 所在区块也因它非空而不会被归还
+    uint64_t chunk_offset = chunk->nvm_base_offset;
+    nvm_layout_mark_range(&central->layout, chunk_offset, page, pages, true);
+    NVM_MUTEX_RELEASE(&central->extent_lock);
+
+    nvm_drain();
+    nvm_layout_mark(&central->layout, chunk_offset, NVM_LAYOUT_CHUNK_STARTS + page);
+    return base + chunk_offset + (uint64_t)page * NVM_EXTENT_PAGE_SIZE;
+}
+
+// 释放大对象。页映射是无锁查到的，区块可能已被归还、描述符已被复用：
+// 一律在 extent_lock 内复查页映射与对象起点后再改动
+static void central_free_extent(NvmCentralHeap* central, NvmExtent* extent, uint64_t nvm_offset) {
+    NVM_MUTEX_ACQUIRE(&central->extent_lock);
+    if (slab_pagemap_lookup_extent(central->slab_page_map, nvm_offset) != extent) {
+        NVM_MUTEX_RELEASE(&central->extent_lock);
+        LOG_ERR("Invalid free of large object at offset %llu.", (unsigned long long)nvm_offset);
+        return;
+    }
+    uint64_t chunk_offset = extent->nvm_base_offset;
+    uint64_t rel = nvm_offset - chunk_offset;
+
+    // 巨型对象：撤销映射后整体归还，空间管理器负责与相邻空闲空间合并
+    if (extent->span_units > NVM_EXTENT_CHUNK_UNITS) {
+        if (rel != 0) {
+            NVM_MUTEX_RELEASE(&central->extent_lock);
+            LOG_ERR("Invalid free of large object at offset %llu.", (unsigned long long)nvm_offset);
+            return;
+        }
+        uint64_t span_bytes = (uint64_t)extent->span_units * NVM_SPAN_UNIT;
+        slab_pagemap_remove_extent(central->slab_page_map, nvm_offset, NVM_SPAN_UNIT);
+        extent_unlink(&central->extent_spans, extent);
+        central_recycle_extent(central, extent);
+        NVM_MUTEX_RELEASE(&central->extent_lock);
+
+        nvm_layout_clear_span(&central->layout, chunk_offset);
+        space_manager_free(central->space_manager, chunk_offset, span_bytes);
+        return;
+    }
+
+    uint32_t page = (uint32_t)(rel / NVM_EXTENT_PAGE_SIZE);
+    if (rel % NVM_EXTENT_PAGE_SIZE != 0 || nvm_extent_object_pages(extent, page) == 0) {
+        NVM_MUTEX_RELEASE(&central->extent_lock);
+        LOG_ERR("Invalid free of large object at offset %llu.", (unsigned long long)nvm_offset);
+        return;
+    }
+
+    // 持久位图：与分配顺序相反，先清除起始页，屏障之后才清除占用页并交还页，
+    // 屏障在锁外执行 (对象仍占用，区块不会被归还，其页也不会被再分配)
+    nvm_layout_unmark(&central->layout, chunk_offset, NVM_LAYOUT_CHUNK_STARTS + page);
+    NVM_MUTEX_RELEASE(&central->extent_lock);
+
+    nvm_drain();
+
+    // 页粒度对象：释放的页与相邻空闲页在位图中自然合并
+    // 区块变空时归还，但保留最后一个区块以免反复切分 (由 trim 归还)
+    NVM_MUTEX_ACQUIRE(&central->extent_lock);
+    chunk_index_remove(central, extent);
+    uint32_t pages = nvm_extent_free(extent, page);
+    chunk_index_insert(central, extent);
+    nvm_layout_mark_range(&central->layout, chunk_offset, page, pages, false);
+    if (nvm_extent_is_empty(extent) && central->extent_chunk_count > 1) {
+        central_release_chunk(central, extent);
+    }
+    NVM_MUTEX_RELEASE(&central->extent_lock);
+}
+
+// 假设已持有 central->extent_lock
+// 归还一个全空的页粒度区块
+static void central_release_chunk(NvmCentralHeap* central, NvmExtent* extent) {
+    chunk_index_remove(central, extent);
+    slab_pagemap_remove_extent(central->slab_page_map, extent->nvm_base_offset, NVM_SLAB_SIZE);
+    nvm_layout_clear_span(&central->layout, extent->nvm_base_offset);
+    space_manager_free_slab(central->space_manager, extent->nvm_base_offset);
+    central_recycle_extent(central, extent);
+}
+
+// 假设已持有 central->extent_lock
+// 取得区块描述符：优先复用已归还的描述符，没有时新建
+static NvmExtent* central_acquire_extent(NvmCentralHeap* central, uint64_t offset, uint32_t span_units) {
+    NvmExtent* extent = central->extent_cache;
+    if (extent) {
+        central->extent_cache = extent->next_in_chain;
+        nvm_extent_reset(extent, offset, span_units);
+    } else {
+        extent = nvm_extent_create(offset, span_units);
+    }
+    if (extent) extent->region_id = central->region_id;
+    return extent;
+}
+
+// 假设已持有 central->extent_lock
+// 归还区块描述符 (已撤销映射、已摘链)，留待复用
+static void central_recycle_extent(NvmCentralHeap* central, NvmExtent* extent) {
+    extent->next_in_chain = central->extent_cache;
+    central->extent_cache = extent;
+}
+
+// 归还区域内所有全空的页粒度区块，返回归还的字节数
+static size_t central_trim_extents(NvmCentralHeap* central) {
+    size_t released = 0;
+
+    // 全空的区块恰好都在最后一个箱中
+    NVM_MUTEX_ACQUIRE(&central->extent_lock);
+    while (central->extent_chunk_bins[NVM_EXTENT_PAGES]) {
+        central_release_chunk(central, central->extent_chunk_bins[NVM_EXTENT_PAGES]);
+        released += NVM_SLAB_SIZE;
+    }
+    NVM_MUTEX_RELEASE(&central->extent_lock);
+    return released;
+}
+
+// ============================================================================
+//                          线程缓存实现
+// ============================================================================
+
+// 绑定当前线程缓存到分配器实例。旧实例遗留的块随旧实例一起失效，直接丢弃
+// 返回 false 表示该线程禁用了缓存
+static bool tcache_bind(NvmAllocator* allocator, NvmThreadCache* tc) {
+    if (tc->disabled) return false;
+
+    if (!tc->registered) {
+        // 登记线程退出析构，确保缓存的块不会随线程退出而泄漏
+        pthread_once(&thread_cache_key_once, tcache_create_key);
+        if (pthread_setspecific(thread_cache_key, tc) != 0) {
+            LOG_ERR("Failed to register thread cache destructor.");
+            return false;
+        }
+        tc->registered = true;
+    }
+
+    for (int i = 0; i < SC_COUNT; ++i) {
+        tc->bins[i].count = 0;
+    }
+    tc->generation = allocator->generation;
+    return true;
+}
+
+// 缓存未命中：优先从 CPU 缓存批量回填，其次从仓库取一个满弹匣，
+// 最后才从 CPU 堆 (或冷类别的共享堆) 分配，返回其中一块
+// 这些来源只有块指针，所属 Slab 在此整批查出，之后的分配不再按指针查找
+static void* tcache_refill(NvmAllocator* allocator, NvmThreadCache* tc, NvmThreadCacheBin* bin, SizeClassID sc_id, NvmSlab** out_slab) {
+    uint32_t batch = allocator->cache_limit[sc_id] / 2;
+    bin->count = cpu_cache_pop_batch(allocator, sc_id, bin->blocks, batch);
+    if (bin->count == 0) {
+        bin->count = depot_pop(allocator, tc, sc_id, bin->blocks);
+    }
+    if (bin->count == 0) {
+        NvmCpuHeap* heap = allocator->cpu_heaps[current_cpu_index(allocator)];
+        bin->count = cpu_heap_alloc_blocks(allocator, heap, sc_id, bin->blocks, batch);
+    }
+    if (bin->count == 0) return NULL;
+    tcache_resolve_slabs(allocator, bin);
+    --bin->count;
+    *out_slab = bin->slabs[bin->count];
+    return bin->blocks[bin->count];
+}
+
+// 为刚回填的整栈块查出所属 Slab。同一批块多半来自同一 Slab，
+// 落在上一块的 Slab 范围内时直接沿用，不再查页映射
+static void tcache_resolve_slabs(NvmAllocator* allocator, NvmThreadCacheBin* bin) {
+    NvmSlab* last = NULL;
+    char*    lo   = NULL;
+    char*    hi   = NULL;
+
+    for (uint32_t i = 0; i < bin->count; ++i) {
+        char* block = (char*)bin->blocks[i];
+        if (!last || block < lo || block >= hi) {
+            last = heap_slab_of(allocator, block);
+            lo   = slab_addr_of(allocator, last);
+            hi   = lo + (uint64_t)last->total_block_count * last->block_size;
+        }
+        bin->slabs[i] = last;
+    }
+}
+
+// 归还栈底 (最久未用) 的 count 个块，其余块下移
+static void tcache_flush_bin(NvmAllocator* allocator, NvmThreadCacheBin* bin, uint32_t count) {
+    if (count > bin->count) count = bin->count;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        heap_free_ptr(allocator, bin->blocks[i]);
+    }
+
+    bin->count -= count;
+    memmove(&bin->blocks[0], &bin->blocks[count], bin->count * sizeof(void*));
+    memmove(&bin->slabs[0], &bin->slabs[count], bin->count * sizeof(NvmSlab*));
+}
+
+// 缓存溢出：栈底的 count 个块优先转入 CPU 缓存；放不下时凑满一个弹匣交给仓库
+// (弹匣大于 count 时多交出一些栈底的块)，仓库也满时才归还 Slab
+static void tcache_spill_bin(NvmAllocator* allocator, NvmThreadCache* tc, NvmThreadCacheBin* bin, SizeClassID sc_id, uint32_t count) {
+    if (count > bin->count) count = bin->count;
+
+    uint32_t put = cpu_cache_push_batch(allocator, sc_id, bin->blocks, count);
+    if (put < count) {
+        uint32_t want = __atomic_load_n(&allocator->depots[sc_id].mag_size, __ATOMIC_RELAXED);
+        if (want < count - put)      want = count - put;
+        if (want > bin->count - put) want = bin->count - put;
+        put += depot_push(allocator, tc, sc_id, &bin->blocks[put], want);
+    }
+    for (uint32_t i = put; i < count; ++i) {
+        heap_free_ptr(allocator, bin->blocks[i]);
+    }
+    if (put > count) count = put;
+
+    bin->count -= count;
+    memmove(&bin->blocks[0], &bin->blocks[count], bin->count * sizeof(void*));
+    memmove(&bin->slabs[0], &bin->slabs[count], bin->count * sizeof(NvmSlab*));
+}
+
+static void tcache_flush_all(NvmAllocator* allocator, NvmThreadCache* tc) {
+    if (tc->generation != allocator->generation) return;
+    for (int i = 0; i < SC_COUNT; ++i) {
+        tcache_flush_bin(allocator, &tc->bins[i], tc->bins[i].count);
+    }
+}
+
+static void tcache_create_key(void) {
+    if (pthread_key_create(&thread_cache_key, tcache_thread_exit) != 0) {
+        LOG_ERR("Failed to create thread cache key.");
+    }
+}
+
+// 线程退出析构：缓存仍属于当前分配器实例时归还全部块
+// 待刷区间是线程本地的，退出前排空，否则本线程最后几次分配的持久位永远不会写回
+static void tcache_thread_exit(void* arg) {
+    NvmThreadCache* tc = (NvmThreadCache*)arg;
+    if (global_nvm_allocator != NULL) {
+        tcache_flush_all(global_nvm_allocator, tc);
+        nvm_drain();
+    }
+    free(tc->spare);
+    tc->spare      = NULL;
+    tc->generation = 0;
+}
+
+// ============================================================================
+//                          调试与监控 API 实现
+// ============================================================================
+
+void nvm_allocator_debug_print(void) {
+    if (!global_nvm_allocator) {
+        printf("[NvmAllocator] Error: Allocator is not initialized.\n");
+        return;
+    }
+
+    printf("================================================================\n");
+    printf("                  NVM Allocator Debug Dump                      \n");
+    printf("================================================================\n");
+    
+    printf("Global Info:\n");
+    printf("  NVM Regions      : %u\n", global_nvm_allocator->region_count);
+
+    for (uint32_t i = 0; i < global_nvm_allocator->region_count; ++i) {
+        NvmCentralHeap* central = &global_nvm_allocator->central_heaps[i];
+
+        printf("Region %u (Node %d):\n", i, central->node);
+        printf("  NVM Base Address : %p\n", central->nvm_base_addr);
+        printf("  NVM Size         : %llu bytes\n", (unsigned long long)central->nvm_size);
+
+        uint32_t chunk_count = 0, span_count = 0;
+        NVM_MUTEX_ACQUIRE(&central->extent_lock);
+        chunk_count = central->extent_chunk_count;
+        for (NvmExtent* e = central->extent_spans; e; e = e->next_in_chain) span_count++;
+        NVM_MUTEX_RELEASE(&central->extent_lock);
+        printf("  Extents          : %u chunks, %u spans\n", chunk_count, span_count);
+    
+        // 修改处：传入基地址，并且 verbose 设为 true
+        if (central->slab_lookup_table) {
+            slab_hashtable_print_layout(central->slab_lookup_table, central->nvm_base_addr, true);
+        } else {
+            printf("[NvmAllocator] Warning: Hash table is NULL.\n");
+        }
     }
 
     printf("================================================================\n");
@@ -0,0 +1,189 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "NvmDefs.h"
+#include "NvmExtent.h"
+
+// ============================================================================
+//                          内部函数前向声明
+// ============================================================================
+
+static int  find_free_run(const NvmExtent* self, uint32_t pages, uint32_t* out_page);
+static void mark_pages(NvmExtent* self, uint32_t page, uint32_t pages, bool used);
+static uint32_t longest_free_run(const NvmExtent* self);
+
+// ============================================================================
+//                          公共 API 实现
+// ============================================================================
+
+NvmExtent* nvm_extent_create(uint64_t nvm_base_offset, uint32_t span_units) {
+    if (span_units < NVM_EXTENT_CHUNK_UNITS || nvm_base_offset % NVM_SPAN_UNIT != 0) {
+        LOG_ERR("Invalid extent: offset %llu, %u units.", (unsigned long long)nvm_base_offset, span_units);
+        return NULL;
+    }
+
+    NvmExtent* self = (NvmExtent*)calloc(1, sizeof(NvmExtent));
+    if (!self) {
+        LOG_ERR("Failed to allocate memory for NvmExtent.");
+        return NULL;
+    }
+
+    nvm_extent_reset(self, nvm_base_offset, span_units);
+    return self;
+}
+
+void nvm_extent_reset(NvmExtent* self, uint64_t nvm_base_offset, uint32_t span_units) {
+    if (!self) return;
+
+    memset(self, 0, sizeof(*self));
+    self->nvm_base_offset = nvm_base_offset;
+    self->span_units      = span_units;
+    self->free_pages      = (span_units == NVM_EXTENT_CHUNK_UNITS) ? NVM_EXTENT_PAGES : 0;
+    self->max_free_run    = self->free_pages;
+}
+
+void nvm_extent_destroy(NvmExtent* self) {
+    free(self);
+}
+
+int nvm_extent_alloc(NvmExtent* self, uint32_t pages, uint32_t* out_page) {
+    if (!self || !out_page || self->span_units != NVM_EXTENT_CHUNK_UNITS) return -1;
+    if (pages == 0 || pages > self->max_free_run) return -1;
+
+    uint32_t page;
+    if (find_free_run(self, pages, &page) != 0) return -1;
+
+    mark_pages(self, page, pages, true);
+    self->run_pages[page] = (uint16_t)pages;
+    self->free_pages -= pages;
+    self->max_free_run = longest_free_run(self);
+
+    *out_page = page;
+    return 0;
+}
+
+uint32_t nvm_extent_free(NvmExtent* self, uint32_t page) {
+    if (!self || self->span_units != NVM_EXTENT_CHUNK_UNITS || page >= NVM_EXTENT_PAGES) return 0;
+
+    uint32_t pages = self->run_pages[page];
+    if (pages == 0) {
+        LOG_ERR("Page %u is not the start of an extent object.", page);
+        return 0;
+    }
+
+    mark_pages(self, page, pages, false);
+    self->run_pages[page] = 0;
+    self->free_pages += pages;
+    self->max_free_run = longest_free_run(self);
+    return pages;
+}
+
+uint32_t nvm_extent_object_pages(const NvmExtent* self, uint32_t page) {
+    if (!self || self->span_units != NVM_EXTENT_CHUNK_UNITS || page >= NVM_EXTENT_PAGES) return 0;
+    return self->run_pages[page];
+}
+
+int nvm_extent_restore(NvmExtent* self, uint32_t page, uint32_t pages) {
+    if (!self || self->span_units != NVM_EXTENT_CHUNK_UNITS || pages == 0) return -1;
+    if (page >= NVM_EXTENT_PAGES || pages > NVM_EXTENT_PAGES - page) return -1;
+
+    // 与已有对象重叠说明持久记录不一致
+    for (uint32_t p = page; p < page + pages; ++p) {
+        if ((self->page_bitmap[p / 64] >> (p % 64)) & 1) return -1;
+    }
+
+    mark_pages(self, page, pages, true);
+    self->run_pages[page] = (uint16_t)pages;
+    self->free_pages -= pages;
+    self->max_free_run = longest_free_run(self);
+    return 0;
+}
+
+bool nvm_extent_is_empty(const NvmExtent* self) {
+    if (!self) return true;
+    return self->span_units == NVM_EXTENT_CHUNK_UNITS && self->free_pages == NVM_EXTENT_PAGES;
+}
+
+// ============================================================================
+//                          内部函数实现
+// ============================================================================
+
+// 按页号递增查找首个长度 >= pages 的连续空闲页段
+// 整字全占用/全空闲时一次跳过 64 页，其余情况用 ctz 跳到下一个边界
+static int find_free_run(const NvmExtent* self, uint32_t pages, uint32_t* out_page) {
+    uint32_t run_start = 0;
+    uint32_t run_len   = 0;
+    uint32_t p         = 0;
+
+    while (p < NVM_EXTENT_PAGES) {
+        uint32_t bit  = p % 64;
+        uint64_t word = self->page_bitmap[p / 64] >> bit;
+        uint32_t left = 64 - bit;   // 本字剩余的页数
+
+        if (word & 1) {
+            // 当前页占用：跳过连续的占用页
+            uint32_t used = (~word == 0) ? left : (uint32_t)__builtin_ctzll(~word);
+            if (used > left) used = left;
+            p += used;
+            run_len = 0;
+            continue;
+        }
+
+        // 当前页空闲：累加连续的空闲页
+        uint32_t avail = (word == 0) ? left : (uint32_t)__builtin_ctzll(word);
+        if (avail > left) avail = left;
+        if (run_len == 0) run_start = p;
+        run_len += avail;
+        p += avail;
+
+        if (run_len >= pages) {
+            *out_page = run_start;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// 最长连续空闲页段：与 find_free_run 相同的按字跳跃，位图只有 NVM_EXTENT_PAGES / 64 个字
+static uint32_t longest_free_run(const NvmExtent* self) {
+    uint32_t best    = 0;
+    uint32_t run_len = 0;
+    uint32_t p       = 0;
+
+    while (p < NVM_EXTENT_PAGES) {
+        uint32_t bit  = p % 64;
+        uint64_t word = self->page_bitmap[p / 64] >> bit;
+        uint32_t left = 64 - bit;
+
+        if (word & 1) {
+            uint32_t used = (~word == 0) ? left : (uint32_t)__builtin_ctzll(~word);
+            if (used > left) used = left;
+            p += used;
+            run_len = 0;
+            continue;
+        }
+
+        uint32_t avail = (word == 0) ? left : (uint32_t)__builtin_ctzll(word);
+        if (avail > left) avail = left;
+        run_len += avail;
+        p += avail;
+        if (run_len > best) best = run_len;
+    }
+    return best;
+}
+
+static void mark_pages(NvmExtent* self, uint32_t page, uint32_t pages, bool used) {
+    for (uint32_t p = page; p < page + pages; ) {
+        uint32_t bit = p % 64;
+        uint32_t n   = 64 - bit;
+        if (n > page + pages - p) n = page + pages - p;
+
+        uint64_t mask = (n == 64) ? ~0ULL : (((1ULL << n) - 1) << bit);
+        if (used) self->page_bitmap[p / 64] |= mask;
+        else      self->page_bitmap[p / 64] &= ~mask;
+        p += n;
+    }
+}
@@ -0,0 +1,168 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "NvmDefs.h"
+#include "NvmLayout.h"
+
+// ============================================================================
+//                          内部函数前向声明
+// ============================================================================
+
+static uint64_t layout_header_offset(void);
+static uint64_t layout_bitmap_offset(uint64_t unit_count);
+static uint64_t layout_log_offset(uint64_t unit_count);
+static void     layout_bind(NvmLayout* self, void* base, uint64_t unit_count, uint64_t meta_size);
+static void     layout_store_header(NvmSpanHeader* slot, NvmSpanHeader header);
+
+// ============================================================================
+//                          公共 API 实现
+// ============================================================================
+
+uint64_t nvm_layout_meta_size(uint64_t region_size) {
+    uint64_t unit_count = region_size / NVM_SPAN_UNIT;
+    uint64_t end = layout_log_offset(unit_count) + (uint64_t)NVM_LAYOUT_LOG_SLOTS * NVM_LOG_SLOT_SIZE;
+    return NVM_ALIGN_UP(end, (uint64_t)NVM_SPAN_UNIT);
+}
+
+int nvm_layout_open(NvmLayout* self, void* base, uint64_t region_size) {
+    if (!self || !base) return -1;
+
+    uint64_t unit_count = region_size / NVM_SPAN_UNIT;
+    uint64_t meta_size  = nvm_layout_meta_size(region_size);
+    if (meta_size >= region_size) {
+        LOG_ERR("Region of %llu bytes too small for persistent metadata.", (unsigned long long)region_size);
+        return -1;
+    }
+
+    NvmSuperblock* sb = (NvmSuperblock*)((char*)base + NVM_START_OFFSET);
+    if (__atomic_load_n(&sb->magic, __ATOMIC_ACQUIRE) == NVM_LAYOUT_MAGIC) {
+        // 已格式化：布局参数须与本次打开的区域完全一致
+        if (sb->version != NVM_LAYOUT_VERSION || sb->unit_size != NVM_SPAN_UNIT ||
+            sb->region_size != region_size || sb->unit_count != unit_count ||
+            sb->header_offset != layout_header_offset() ||
+            sb->bitmap_offset != layout_bitmap_offset(unit_count) ||
+            sb->log_offset != layout_log_offset(unit_count) || sb->log_count != NVM_LAYOUT_LOG_SLOTS ||
+            sb->meta_size != meta_size) {
+            LOG_ERR("Persistent layout (version %u, %llu bytes) does not match region of %llu bytes.",
+                    sb->version, (unsigned long long)sb->region_size, (unsigned long long)region_size);
+            return -1;
+        }
+        layout_bind(self, base, unit_count, meta_size);
+        return 1;
+    }
+
+    // 格式化：先清零头部表与日志头并写好布局参数，持久化之后才发布魔数
+    layout_bind(self, base, unit_count, meta_size);
+    memset(self->headers, 0, unit_count * sizeof(NvmSpanHeader));
+    nvm_flush(self->headers, unit_count * sizeof(NvmSpanHeader));
+    for (uint32_t i = 0; i < NVM_LAYOUT_LOG_SLOTS; ++i) {
+        NvmRedoLog* log = nvm_layout_log(self, i);
+        memset(log, 0, offsetof(NvmRedoLog, entries));
+        nvm_flush(log, offsetof(NvmRedoLog, entries));
+    }
+
+    sb->version       = NVM_LAYOUT_VERSION;
+    sb->unit_size     = NVM_SPAN_UNIT;
+    sb->region_size   = region_size;
+    sb->unit_count    = unit_count;
+    sb->header_offset = layout_header_offset();
+    sb->bitmap_offset = layout_bitmap_offset(unit_count);
+    sb->log_offset    = layout_log_offset(unit_count);
+    sb->log_count     = NVM_LAYOUT_LOG_SLOTS;
+    sb->meta_size     = meta_size;
+    nvm_persist(sb, sizeof(*sb));
+
+    __atomic_store_n(&sb->magic, NVM_LAYOUT_MAGIC, __ATOMIC_RELEASE);
+    nvm_persist(&sb->magic, sizeof(sb->magic));
+    return 0;
+}
+
+void nvm_layout_set_span(NvmLayout* self, uint64_t offset, NvmSpanState state, uint8_t size_class, uint64_t span_bytes) {
+    uint64_t unit = (offset - NVM_START_OFFSET) / NVM_SPAN_UNIT;
+    if (!self || unit >= self->unit_count) return;
+
+    // 位图槽在跨度归还时理应已全部清零，这里仍重新清零，不信任上一任使用者留下的内容
+    if (state == NVM_SPAN_SLAB || state == NVM_SPAN_CHUNK) {
+        uint64_t* bitmap = nvm_layout_bitmap(self, offset);
+        memset(bitmap, 0, NVM_LAYOUT_BITMAP_BYTES);
+        nvm_persist(bitmap, NVM_LAYOUT_BITMAP_BYTES);
+    }
+
+    NvmSpanHeader header = { .state = (uint8_t)state, .size_class = size_class,
+                             .span_units = (uint32_t)(span_bytes / NVM_SPAN_UNIT) };
+    layout_store_header(&self->headers[unit], header);
+}
+
+void nvm_layout_clear_span(NvmLayout* self, uint64_t offset) {
+    uint64_t unit = (offset - NVM_START_OFFSET) / NVM_SPAN_UNIT;
+    if (!self || unit >= self->unit_count) return;
+
+    NvmSpanHeader header = { 0 };
+    layout_store_header(&self->headers[unit], header);
+}
+
+NvmSpanHeader nvm_layout_span_at(const NvmLayout* self, uint64_t unit) {
+    NvmSpanHeader header = { 0 };
+    if (!self || unit >= self->unit_count) return header;
+
+    uint64_t raw = __atomic_load_n((const uint64_t*)&self->headers[unit], __ATOMIC_ACQUIRE);
+    memcpy(&header, &raw, sizeof(header));
+    return header;
+}
+
+void nvm_layout_mark_range(const NvmLayout* self, uint64_t offset, uint32_t first, uint32_t count, bool used) {
+    uint64_t* bitmap = nvm_layout_bitmap(self, offset);
+
+    for (uint32_t b = first; b < first + count; ) {
+        uint32_t bit = b % 64;
+        uint32_t n   = 64 - bit;
+        if (n > first + count - b) n = first + count - b;
+
+        uint64_t mask = (n == 64) ? ~0ULL : (((1ULL << n) - 1) << bit);
+        if (used) __atomic_fetch_or(&bitmap[b / 64], mask, __ATOMIC_RELAXED);
+        else      __atomic_fetch_and(&bitmap[b / 64], ~mask, __ATOMIC_RELAXED);
+        b += n;
+    }
+    if (count > 0) nvm_flush(&bitmap[first / 64], ((first + count - 1) / 64 - first / 64 + 1) * sizeof(uint64_t));
+}
+
+// ============================================================================
+//                          内部函数实现
+// ============================================================================
+
+// 头部表紧随超级块，按缓存行对齐
+static uint64_t layout_header_offset(void) {
+    return NVM_ALIGN_UP((uint64_t)sizeof(NvmSuperblock), (uint64_t)CACHE_LINE_SIZE);
+}
+
+// 位图槽紧随头部表，按缓存行对齐
+static uint64_t layout_bitmap_offset(uint64_t unit_count) {
+    return NVM_ALIGN_UP(layout_header_offset() + unit_count * sizeof(NvmSpanHeader), (uint64_t)CACHE_LINE_SIZE);
+}
+
+// 日志槽紧随位图槽，按日志槽大小对齐
+static uint64_t layout_log_offset(uint64_t unit_count) {
+    return NVM_ALIGN_UP(layout_bitmap_offset(unit_count) + unit_count * NVM_LAYOUT_BITMAP_BYTES, (uint64_t)NVM_LOG_SLOT_SIZE);
+}
+
+static void layout_bind(NvmLayout* self, void* base, uint64_t unit_count, uint64_t meta_size) {
+    char* sb = (char*)base + NVM_START_OFFSET;
+    self->superblock = (NvmSuperblock*)sb;
+    self->headers    = (NvmSpanHeader*)(sb + layout_header_offset());
+    self->bitmaps    = (uint64_t*)(sb + layout_bitmap_offset(unit_count));
+    self->logs       = (NvmRedoLog*)(sb + layout_log_offset(unit_count));
+    self->unit_count = unit_count;
+    self->meta_size  = meta_size;
+}
+
+// 头部整体一次 8 字节原子写入，崩溃时不会留下状态与跨度不一致的半个头部。
+// 跨度的启用与归还都在慢路径上，直接持久化，调用方无需再加屏障
+static void layout_store_header(NvmSpanHeader* slot, NvmSpanHeader header) {
+    uint64_t raw;
+    memcpy(&raw, &header, sizeof(raw));
+    __atomic_store_n((uint64_t*)slot, raw, __ATOMIC_RELEASE);
+    nvm_persist(slot, sizeof(*slot));
+}
@@ -0,0 +1,99 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "NvmDefs.h"
+#include "NvmLog.h"
+
+// 日志槽布局须与常量一致：日志头一个缓存行，其后恰好 NVM_LOG_CAPACITY 项
+_Static_assert(sizeof(NvmRedoLog) == NVM_LOG_SLOT_SIZE, "NvmRedoLog must fill exactly one log slot");
+
+// ============================================================================
+//                          内部函数前向声明
+// ============================================================================
+
+static uint64_t log_checksum(const NvmRedoLog* self, uint32_t count);
+static bool     log_entry_valid(const NvmLogEntry* entry, const uint64_t* sizes, uint32_t region_count);
+
+// ============================================================================
+//                          公共 API 实现
+// ============================================================================
+
+int nvm_log_commit(NvmRedoLog* self, uint32_t count) {
+    if (!self || count == 0 || count > NVM_LOG_CAPACITY) return -1;
+
+    self->count    = count;
+    self->checksum = log_checksum(self, count);
+    nvm_persist(self, offsetof(NvmRedoLog, entries) + count * sizeof(NvmLogEntry));
+    return 0;
+}
+
+bool nvm_log_valid(const NvmRedoLog* self) {
+    if (!self || self->count == 0 || self->count > NVM_LOG_CAPACITY) return false;
+    return self->checksum == log_checksum(self, self->count);
+}
+
+int nvm_log_apply(const NvmRedoLog* self, void* const* bases, const uint64_t* sizes, uint32_t region_count) {
+    if (!nvm_log_valid(self) || !bases || !sizes) return -1;
+
+    for (uint32_t i = 0; i < self->count; ++i) {
+        if (!log_entry_valid(&self->entries[i], sizes, region_count)) {
+            LOG_ERR("Redo log entry %u (target 0x%llx) out of range.", i,
+                    (unsigned long long)self->entries[i].target);
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < self->count; ++i) {
+        const NvmLogEntry* entry = &self->entries[i];
+        uint16_t region = (uint16_t)(entry->target >> NVM_LOG_REGION_SHIFT);
+        uint64_t* word  = (uint64_t*)((char*)bases[region] + (entry->target & NVM_LOG_OFFSET_MASK));
+
+        // 目标字可能正被其他线程改写 (同一位图字上的分配与释放)，一律原子操作
+        switch ((NvmLogOp)(entry->target >> NVM_LOG_OP_SHIFT)) {
+            case NVM_LOG_OP_SET:   __atomic_fetch_or(word, entry->value, __ATOMIC_RELAXED);   break;
+            case NVM_LOG_OP_CLEAR: __atomic_fetch_and(word, ~entry->value, __ATOMIC_RELAXED); break;
+            default:               __atomic_store_n(word, entry->value, __ATOMIC_RELAXED);    break;
+        }
+        nvm_flush(word, sizeof(*word));
+    }
+    return 0;
+}
+
+void nvm_log_clear(NvmRedoLog* self) {
+    if (!self) return;
+    self->count    = 0;
+    self->checksum = 0;
+    nvm_persist(self, offsetof(NvmRedoLog, entries));
+}
+
+// ============================================================================
+//                          内部函数实现
+// ============================================================================
+
+// 64 位乘法-移位混合 (splitmix64 的终结步)，逐项折叠项数与全部日志项
+static uint64_t log_checksum(const NvmRedoLog* self, uint32_t count) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ count;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint64_t words[2] = { self->entries[i].target, self->entries[i].value };
+        for (int w = 0; w < 2; ++w) {
+            h ^= words[w];
+            h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ULL;
+            h ^= h >> 27; h *= 0x94D049BB133111EBULL;
+            h ^= h >> 31;
+        }
+    }
+    return h;
+}
+
+static bool log_entry_valid(const NvmLogEntry* entry, const uint64_t* sizes, uint32_t region_count) {
+    uint32_t op     = (uint32_t)(entry->target >> NVM_LOG_OP_SHIFT);
+    uint32_t region = (uint32_t)((entry->target >> NVM_LOG_REGION_SHIFT) & 0xFFFF);
+    uint64_t offset = entry->target & NVM_LOG_OFFSET_MASK;
+
+    if (op < NVM_LOG_OP_SET || op > NVM_LOG_OP_STORE) return false;
+    if (region >= region_count) return false;
+    return offset % sizeof(uint64_t) == 0 && offset + sizeof(uint64_t) <= sizes[region];
+}
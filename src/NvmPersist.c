@@ -0,0 +1,168 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "NvmDefs.h"
+#include "NvmPersist.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+// ============================================================================
+//                          全局与线程本地状态
+// ============================================================================
+
+// 生效的写回方式，-1 表示尚未探测
+static int persist_mode = -1;
+
+// 待刷区间的代数：nvm_persist_invalidate 递增，旧代数的待刷区间直接丢弃
+static uint64_t persist_generation = 1;
+
+// 线程本地的待刷区间 [persist_lo, persist_hi) (缓存行对齐，空区间时二者为 0)
+static NVM_THREAD_LOCAL uintptr_t persist_lo = 0;
+static NVM_THREAD_LOCAL uintptr_t persist_hi = 0;
+static NVM_THREAD_LOCAL uint64_t  persist_pending_gen = 0;
+
+// 自上次屏障以来本线程是否发出过需要 sfence 排序的写回
+static NVM_THREAD_LOCAL bool persist_unfenced = false;
+
+// ============================================================================
+//                          内部函数前向声明
+// ============================================================================
+
+static NvmFlushMode persist_detect(void);
+static NvmFlushMode persist_current_mode(void);
+static bool         persist_pending_valid(void);
+static void         persist_writeback(NvmFlushMode mode, uintptr_t lo, uintptr_t hi);
+
+// ============================================================================
+//                          公共 API 实现
+// ============================================================================
+
+NvmFlushMode nvm_persist_mode(void) {
+    return persist_current_mode();
+}
+
+NvmFlushMode nvm_persist_set_mode(NvmFlushMode mode) {
+    NvmFlushMode hw = persist_detect();
+    if (mode > hw) mode = hw;
+    __atomic_store_n(&persist_mode, (int)mode, __ATOMIC_RELAXED);
+    return mode;
+}
+
+void nvm_flush(const void* addr, size_t len) {
+    if (len == 0) return;
+    NvmFlushMode mode = persist_current_mode();
+    if (mode == NVM_FLUSH_NONE) return;
+
+    uintptr_t lo = (uintptr_t)addr & ~(uintptr_t)(CACHE_LINE_SIZE - 1);
+    uintptr_t hi = NVM_ALIGN_UP((uintptr_t)addr + len, (uintptr_t)CACHE_LINE_SIZE);
+
+    if (persist_pending_valid()) {
+        // 与待刷区间重叠或相邻：合并，推迟到区间断开或屏障时一次写回
+        if (lo <= persist_hi && hi >= persist_lo) {
+            if (lo < persist_lo) persist_lo = lo;
+            if (hi > persist_hi) persist_hi = hi;
+            return;
+        }
+        persist_writeback(mode, persist_lo, persist_hi);
+    }
+
+    persist_lo = lo;
+    persist_hi = hi;
+    persist_pending_gen = __atomic_load_n(&persist_generation, __ATOMIC_RELAXED);
+}
+
+void nvm_drain(void) {
+    if (persist_pending_valid()) {
+        persist_writeback(persist_current_mode(), persist_lo, persist_hi);
+        persist_lo = persist_hi = 0;
+    }
+
+    if (persist_unfenced) {
+#if defined(__x86_64__) || defined(__i386__)
+        __asm__ volatile("sfence" ::: "memory");
+#endif
+        persist_unfenced = false;
+    } else {
+        // 无需栅栏时仍阻止编译器把屏障之后的写重排到之前
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    }
+}
+
+void nvm_persist(const void* addr, size_t len) {
+    nvm_flush(addr, len);
+    nvm_drain();
+}
+
+void nvm_persist_invalidate(void) {
+    __atomic_fetch_add(&persist_generation, 1, __ATOMIC_RELAXED);
+    persist_lo = persist_hi = 0;
+}
+
+// ============================================================================
+//                          内部函数实现
+// ============================================================================
+
+// CPU 支持的最强写回指令 (CPUID.(EAX=7,ECX=0):EBX 第 24 位 CLWB，第 23 位 CLFLUSHOPT)。
+// 其他架构暂不写回，只能在缓存受掉电保护的平台上保证持久
+static NvmFlushMode persist_detect(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        if (ebx & (1u << 24)) return NVM_FLUSH_CLWB;
+        if (ebx & (1u << 23)) return NVM_FLUSH_CLFLUSHOPT;
+    }
+    return NVM_FLUSH_CLFLUSH;
+#else
+    return NVM_FLUSH_NONE;
+#endif
+}
+
+// 首次调用时探测；并发的首次探测结果相同，重复写入无妨
+static NvmFlushMode persist_current_mode(void) {
+    int mode = __atomic_load_n(&persist_mode, __ATOMIC_RELAXED);
+    if (NVM_UNLIKELY(mode < 0)) {
+        mode = (int)persist_detect();
+        __atomic_store_n(&persist_mode, mode, __ATOMIC_RELAXED);
+    }
+    return (NvmFlushMode)mode;
+}
+
+// 本线程是否有属于当前代数的待刷区间；过期的区间 (所在映射可能已解除) 直接丢弃
+static bool persist_pending_valid(void) {
+    if (persist_hi == 0) return false;
+    if (NVM_UNLIKELY(persist_pending_gen != __atomic_load_n(&persist_generation, __ATOMIC_RELAXED))) {
+        persist_lo = persist_hi = 0;
+        return false;
+    }
+    return true;
+}
+
+// 对 [lo, hi) 的每个缓存行发出写回指令。CLWB / CLFLUSHOPT 以字节编码发出，
+// 不要求编译器开启 -mclwb / -mclflushopt
+static void persist_writeback(NvmFlushMode mode, uintptr_t lo, uintptr_t hi) {
+    if (lo == hi || mode == NVM_FLUSH_NONE) return;
+
+#if defined(__x86_64__) || defined(__i386__)
+    for (uintptr_t line = lo; line < hi; line += CACHE_LINE_SIZE) {
+        volatile char* p = (volatile char*)line;
+        switch (mode) {
+            case NVM_FLUSH_CLWB:
+                __asm__ volatile(".byte 0x66; xsaveopt %0" : "+m"(*p));
+                break;
+            case NVM_FLUSH_CLFLUSHOPT:
+                __asm__ volatile(".byte 0x66; clflush %0" : "+m"(*p));
+                break;
+            default:
+                __asm__ volatile("clflush %0" : "+m"(*p));
+                break;
+        }
+    }
+    if (mode != NVM_FLUSH_CLFLUSH) persist_unfenced = true;
+#else
+    (void)hi;
+#endif
+}
@@ -1,191 +1,441 @@
-#include <stdint.h>
-#include <stdbool.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdio.h>
-
-#include "NvmDefs.h"
-#include "NvmSlab.h"
-
-// ============================================================================
-//                          内部函数前向声明
-// ============================================================================
-
-static uint32_t get_block_size_from_sc_id(SizeClassID sc_id);
-static uint32_t refill_cache(NvmSlab* self);
-static uint32_t drain_cache(NvmSlab* self);
-
-// ============================================================================
-//                          公共 API 实现
-// ============================================================================
-
-NvmSlab* nvm_slab_create(SizeClassID sc_id, uint64_t nvm_base_offset) {
-    uint32_t block_size = get_block_size_from_sc_id(sc_id);
-    if (block_size == 0) {
-        LOG_ERR("Invalid SizeClassID: %d", sc_id);
-        return NULL;
-    }
-
-    uint32_t total_block_count = NVM_SLAB_SIZE / block_size;
-    size_t bitmap_bytes = (total_block_count + 7) / 8;
-    
-    // 分配元数据 (含柔性数组)
-    NvmSlab* self = (NvmSlab*)calloc(1, sizeof(NvmSlab) + bitmap_bytes);
-    if (!self) {
-        LOG_ERR("Failed to allocate metadata.");
-        return NULL;
-    }
-
-    self->nvm_base_offset   = nvm_base_offset;
-    self->size_type_id      = (uint8_t)sc_id;
-    self->block_size        = block_size;
-    self->total_block_count = total_block_count;
-
-    if (NVM_SPINLOCK_INIT(&self->lock) != 0) {
-        LOG_ERR("Failed to init spinlock.");
-        free(self);
-        return NULL;
-    }
-
-    return self;
-}
-
-void nvm_slab_destroy(NvmSlab* self) {
-    if (!self) return;
-    NVM_SPINLOCK_DESTROY(&self->lock);
-    free(self);
-}
-
-int nvm_slab_alloc(NvmSlab* self, uint32_t* out_block_idx) {
-    if (!self || !out_block_idx) return -1;
-
-    NVM_SPINLOCK_ACQUIRE(&self->lock);
-
-    // 缓存为空时尝试填充
-    if (self->cache_count == 0) {
-        refill_cache(self);
-    }
-
-    // 仍为空说明已满
-    if (self->cache_count == 0) {
-        NVM_SPINLOCK_RELEASE(&self->lock);
-        return -1;
-    }
-
-    // 从缓存分配
-    *out_block_idx = self->free_block_buffer[self->cache_head];
-    self->cache_head = (self->cache_head + 1) % SLAB_CACHE_SIZE;
-    self->cache_count--;
-    __atomic_fetch_add(&self->allocated_block_count, 1, __ATOMIC_RELAXED);
-
-    NVM_SPINLOCK_RELEASE(&self->lock);
-    return 0;
-}
-
-void nvm_slab_free(NvmSlab* self, uint32_t block_idx) {
-    if (!self) return;
-    if (block_idx >= self->total_block_count) {
-        LOG_ERR("Block index out of bounds: %u", block_idx);
-        return;
-    }
-
-    NVM_SPINLOCK_ACQUIRE(&self->lock);
-
-    if (self->allocated_block_count > 0) {
-        __atomic_fetch_sub(&self->allocated_block_count, 1, __ATOMIC_RELAXED);
-    }
-
-    // 缓存满时回写位图
-    if (self->cache_count >= SLAB_CACHE_SIZE) {
-        drain_cache(self);
-    }
-    
-    // 放入缓存
-    self->free_block_buffer[self->cache_tail] = block_idx;
-    self->cache_tail = (self->cache_tail + 1) % SLAB_CACHE_SIZE;
-    self->cache_count++;
-
-    NVM_SPINLOCK_RELEASE(&self->lock);
-}
-
-bool nvm_slab_is_full(const NvmSlab* self) {
-    if (!self) return false;
-    
-    uint32_t cnt = __atomic_load_n(&self->allocated_block_count, __ATOMIC_RELAXED);
-    return cnt >= self->total_block_count;
-}
-
-bool nvm_slab_is_empty(const NvmSlab* self) {
-    if (!self) return true;
-
-    uint32_t cnt = __atomic_load_n(&self->allocated_block_count, __ATOMIC_RELAXED);
-    return cnt == 0;
-}
-
-int nvm_slab_set_bitmap_at_idx(NvmSlab* self, uint32_t block_idx) {
-    if (!self || block_idx >= self->total_block_count) return -1;
-
-    NVM_SPINLOCK_ACQUIRE(&self->lock);
-    
-    if (!IS_BIT_SET(self->bitmap, block_idx)) {
-        SET_BIT(self->bitmap, block_idx);    
-        __atomic_fetch_add(&self->allocated_block_count, 1, __ATOMIC_RELAXED);
-    }
-    
-    NVM_SPINLOCK_RELEASE(&self->lock);
-    return 0;
-}
-
-// ============================================================================
-//                          内部函数实现
-// ============================================================================
-
-static uint32_t get_block_size_from_sc_id(SizeClassID sc_id) {
-    static const uint32_t sizes[] = {
-        8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096
-    };
-    if (sc_id >= 0 && sc_id < (sizeof(sizes)/sizeof(sizes[0]))) {
-        return sizes[sc_id];
-    }
-    return 0;
-}
-
-// 假设已持锁
-static uint32_t refill_cache(NvmSlab* self) {
-    if (self->allocated_block_count >= self->total_block_count) {
-        return 0;
-    }
-
-    uint32_t filled = 0;
-    // 批量填充缓存
-    for (uint32_t i = 0; i < self->total_block_count && filled < SLAB_CACHE_BATCH_SIZE; ++i) {
-        if (!IS_BIT_SET(self->bitmap, i)) {
-            self->free_block_buffer[self->cache_tail] = i;
-            self->cache_tail = (self->cache_tail + 1) % SLAB_CACHE_SIZE;
-            SET_BIT(self->bitmap, i); // 预标记
-            filled++;
-        }
-    }
-    self->cache_count += filled;
-    return filled;
-}
-
-// 假设已持锁
-static uint32_t drain_cache(NvmSlab* self) {
-    if (self->cache_count <= SLAB_CACHE_BATCH_SIZE) {
-        return 0;
-    }
-
-    uint32_t to_drain = self->cache_count - SLAB_CACHE_BATCH_SIZE;
-    uint32_t drained = 0;
-
-    for (uint32_t i = 0; i < to_drain; ++i) {
-        uint32_t idx = self->free_block_buffer[self->cache_head];
-        self->cache_head = (self->cache_head + 1) % SLAB_CACHE_SIZE;
-        CLEAR_BIT(self->bitmap, idx); // 回写位图
-        drained++;
-    }
-    
-    self->cache_count -= drained;
-    return drained;
-}
\ No newline at end of file
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "NvmDefs.h"
+#include "NvmSlab.h"
+#include "NvmRseq.h"
+
+// ============================================================================
+//                          内部函数前向声明
+// ============================================================================
+
+static uint32_t get_block_size_from_sc_id(SizeClassID sc_id);
+static uint32_t get_span_size_from_sc_id(SizeClassID sc_id);
+static void     bitmap_init(NvmSlab* self);
+static void     bitmap_mark_used(NvmSlab* self, uint32_t block_idx);
+static void     bitmap_mark_free(NvmSlab* self, uint32_t block_idx);
+static uint32_t refill_cache(NvmSlab* self);
+static void     cache_put(NvmSlab* self, uint32_t block_idx);
+static uint32_t drain_cache(NvmSlab* self);
+static uint32_t put_local_list(NvmSlab* self, const void* slab_addr, uint64_t list);
+
+// ============================================================================
+//                          公共 API 实现
+// ============================================================================
+
+NvmSlab* nvm_slab_create(SizeClassID sc_id, uint64_t nvm_base_offset) {
+    uint32_t block_size = get_block_size_from_sc_id(sc_id);
+    if (block_size == 0) {
+        LOG_ERR("Invalid SizeClassID: %d", sc_id);
+        return NULL;
+    }
+
+    uint32_t span_size = get_span_size_from_sc_id(sc_id);
+    uint32_t total_block_count = span_size / block_size;
+    uint32_t bitmap_words  = (total_block_count + 63) / 64;
+    uint32_t summary_words = (bitmap_words + 63) / 64;
+    
+    // 分配元数据 (含柔性数组：位图 + 摘要 + 预留标记)
+    NvmSlab* self = (NvmSlab*)calloc(1, sizeof(NvmSlab) + (size_t)(2 * bitmap_words + summary_words) * sizeof(uint64_t));
+    if (!self) {
+        LOG_ERR("Failed to allocate metadata.");
+        return NULL;
+    }
+
+    self->nvm_base_offset   = nvm_base_offset;
+    self->block_recip       = ((1ULL << NVM_SLAB_RECIP_SHIFT) + block_size - 1) / block_size;
+    self->size_type_id      = (uint8_t)sc_id;
+    self->list_id           = SLAB_LIST_NONE;
+    self->block_size        = block_size;
+    self->span_size         = span_size;
+    self->total_block_count = total_block_count;
+    self->bitmap_words      = bitmap_words;
+    self->summary_words     = summary_words;
+    self->summary           = &self->bitmap[bitmap_words];
+    self->reserved          = &self->summary[summary_words];
+    bitmap_init(self);
+
+    if (NVM_SPINLOCK_INIT(&self->lock) != 0) {
+        LOG_ERR("Failed to init spinlock.");
+        free(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+void nvm_slab_destroy(NvmSlab* self) {
+    if (!self) return;
+    NVM_SPINLOCK_DESTROY(&self->lock);
+    free(self);
+}
+
+void nvm_slab_reset(NvmSlab* self, uint64_t nvm_base_offset) {
+    if (!self) return;
+
+    self->next_in_chain   = NULL;
+    self->prev_in_chain   = NULL;
+    self->owner_heap      = NULL;
+    self->region_id       = 0;
+    self->empty_since_ns  = 0;
+    self->nvm_base_offset = nvm_base_offset;
+    self->list_id         = SLAB_LIST_NONE;
+
+    self->allocated_block_count = 0;
+    self->cache_head  = 0;
+    self->cache_tail  = 0;
+    self->cache_count = 0;
+    self->local_free  = 0;
+    self->remote_free = 0;
+    memset(self->reserved, 0, (size_t)self->bitmap_words * sizeof(uint64_t));
+    bitmap_init(self);
+}
+
+uint32_t nvm_slab_alloc_batch(NvmSlab* self, uint32_t* out_block_idx, uint32_t count) {
+    if (!self || !out_block_idx) return 0;
+
+    NVM_SPINLOCK_ACQUIRE(&self->lock);
+
+    uint32_t got = 0;
+    while (got < count) {
+        if (self->cache_count == 0 && refill_cache(self) == 0) {
+            break;
+        }
+        out_block_idx[got++] = self->free_block_buffer[self->cache_head];
+        self->cache_head = (self->cache_head + 1) % SLAB_CACHE_SIZE;
+        self->cache_count--;
+    }
+    // 整批只做一次计数更新
+    __atomic_fetch_add(&self->allocated_block_count, got, __ATOMIC_RELAXED);
+
+    NVM_SPINLOCK_RELEASE(&self->lock);
+    return got;
+}
+
+void nvm_slab_free_local(NvmSlab* self, uint32_t block_idx) {
+    if (!self) return;
+    if (block_idx >= self->total_block_count) {
+        LOG_ERR("Block index out of bounds: %u", block_idx);
+        return;
+    }
+
+    uint32_t cnt = self->allocated_block_count;
+    if (cnt > 0) __atomic_store_n(&self->allocated_block_count, cnt - 1, __ATOMIC_RELAXED);
+    cache_put(self, block_idx);
+}
+
+int nvm_slab_local_push(NvmSlab* self, void* slab_addr, uint32_t block_idx, int cpu) {
+    if (!self || !slab_addr || block_idx >= self->total_block_count) return -1;
+
+    uint32_t* link = (uint32_t*)((char*)slab_addr + (uint64_t)block_idx * self->block_size);
+    int ret = nvm_rseq_percpu_link(cpu, &self->list_id, (uint8_t)SLAB_LIST_PARTIAL,
+                                   &self->local_free, link, block_idx);
+    return (ret == NVM_RSEQ_OK) ? 0 : -1;
+}
+
+uint32_t nvm_slab_collect_local(NvmSlab* self, const void* slab_addr, int cpu) {
+    if (!self || !slab_addr) return 0;
+    if (__atomic_load_n(&self->local_free, __ATOMIC_RELAXED) == 0) return 0;
+
+    uint64_t list;
+    if (nvm_rseq_percpu_take(cpu, &self->local_free, &list) != NVM_RSEQ_OK) return 0;
+
+    return put_local_list(self, slab_addr, list);
+}
+
+uint32_t nvm_slab_drain_local(NvmSlab* self, const void* slab_addr) {
+    if (!self || !slab_addr) return 0;
+    if (__atomic_load_n(&self->local_free, __ATOMIC_RELAXED) == 0) return 0;
+
+    // 调用方持有所属堆锁：暂时改写 list_id 不会与链表迁移交错，并发释放路径
+    // 无锁读到 NONE 后都会在堆锁内复查。栅栏之后，已越过闸门的序列要么已提交、
+    // 要么已被打断，新的序列看到闸门关闭直接放弃
+    uint8_t list_id = __atomic_load_n(&self->list_id, __ATOMIC_RELAXED);
+    if (list_id == SLAB_LIST_PARTIAL) {
+        __atomic_store_n(&self->list_id, (uint8_t)SLAB_LIST_NONE, __ATOMIC_SEQ_CST);
+    }
+    nvm_rseq_fence();
+    uint64_t list = __atomic_exchange_n(&self->local_free, 0, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&self->list_id, list_id, __ATOMIC_SEQ_CST);
+
+    return put_local_list(self, slab_addr, list);
+}
+
+int nvm_slab_reserve_block(NvmSlab* self, uint32_t block_idx) {
+    if (!self || block_idx >= self->total_block_count) return -1;
+
+    uint64_t mask = 1ULL << (block_idx % 64);
+    uint64_t old = __atomic_fetch_or(&self->reserved[block_idx / 64], mask, __ATOMIC_ACQ_REL);
+    return (old & mask) ? -1 : 0;
+}
+
+int nvm_slab_unreserve_block(NvmSlab* self, uint32_t block_idx) {
+    if (!self || block_idx >= self->total_block_count) return -1;
+
+    uint64_t mask = 1ULL << (block_idx % 64);
+    uint64_t old = __atomic_fetch_and(&self->reserved[block_idx / 64], ~mask, __ATOMIC_ACQ_REL);
+    return (old & mask) ? 0 : -1;
+}
+
+uint32_t nvm_slab_remote_free(NvmSlab* self, void* slab_addr, uint32_t block_idx) {
+    if (!self || !slab_addr) return 0;
+    if (block_idx >= self->total_block_count) {
+        LOG_ERR("Block index out of bounds: %u", block_idx);
+        return 0;
+    }
+
+    uint32_t* link = (uint32_t*)((char*)slab_addr + (uint64_t)block_idx * self->block_size);
+    uint64_t old_head = __atomic_load_n(&self->remote_free, __ATOMIC_RELAXED);
+    uint64_t new_head;
+    do {
+        // 链表为空时 link 的值无意义，回收按长度遍历
+        *link = (uint32_t)old_head;
+        new_head = (((old_head >> 32) + 1) << 32) | block_idx;
+        // SEQ_CST：与所属堆 "发布已满状态后复查链表" 配对
+    } while (!__atomic_compare_exchange_n(&self->remote_free, &old_head, new_head, true,
+                                          __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+    return (uint32_t)(new_head >> 32);
+}
+
+uint32_t nvm_slab_collect_remote(NvmSlab* self, const void* slab_addr) {
+    if (!self || !slab_addr) return 0;
+    if (__atomic_load_n(&self->remote_free, __ATOMIC_RELAXED) == 0) return 0;
+
+    uint64_t list = __atomic_exchange_n(&self->remote_free, 0, __ATOMIC_ACQUIRE);
+    uint32_t count = (uint32_t)(list >> 32);
+    uint32_t block_idx = (uint32_t)list;
+
+    NVM_SPINLOCK_ACQUIRE(&self->lock);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t next = *(const uint32_t*)((const char*)slab_addr + (uint64_t)block_idx * self->block_size);
+        cache_put(self, block_idx);
+        block_idx = next;
+    }
+    // 整批只做一次计数更新
+    __atomic_fetch_sub(&self->allocated_block_count, count, __ATOMIC_RELAXED);
+    NVM_SPINLOCK_RELEASE(&self->lock);
+
+    return count;
+}
+
+bool nvm_slab_is_full(const NvmSlab* self) {
+    if (!self) return false;
+    
+    uint32_t cnt = __atomic_load_n(&self->allocated_block_count, __ATOMIC_RELAXED);
+    return cnt >= self->total_block_count;
+}
+
+bool nvm_slab_is_empty(const NvmSlab* self) {
+    if (!self) return true;
+
+    uint32_t cnt = __atomic_load_n(&self->allocated_block_count, __ATOMIC_RELAXED);
+    return cnt == 0;
+}
+
+uint32_t nvm_slab_remote_pending(const NvmSlab* self) {
+    if (!self) return 0;
+    return (uint32_t)(__atomic_load_n(&self->remote_free, __ATOMIC_RELAXED) >> 32);
+}
+
+uint32_t nvm_slab_local_pending(const NvmSlab* self) {
+    if (!self) return 0;
+    return (uint32_t)(__atomic_load_n(&self->local_free, __ATOMIC_RELAXED) >> 32);
+}
+
+int nvm_slab_set_bitmap_at_idx(NvmSlab* self, uint32_t block_idx) {
+    if (!self || block_idx >= self->total_block_count) return -1;
+
+    NVM_SPINLOCK_ACQUIRE(&self->lock);
+    
+    if (!IS_BIT_SET(self->bitmap, block_idx)) {
+        bitmap_mark_used(self, block_idx);
+        __atomic_fetch_add(&self->allocated_block_count, 1, __ATOMIC_RELAXED);
+    }
+    
+    NVM_SPINLOCK_RELEASE(&self->lock);
+    return 0;
+}
+
+uint32_t nvm_slab_load_bitmap(NvmSlab* self, const uint64_t* words) {
+    if (!self || !words) return 0;
+
+    NVM_SPINLOCK_ACQUIRE(&self->lock);
+
+    // 按字整体拷贝，末字尾部的无效位仍置 1；缓存与远程链表清空，摘要逐字重建
+    bitmap_init(self);
+    uint32_t allocated = 0;
+    for (uint32_t w = 0; w < self->bitmap_words; ++w) {
+        self->bitmap[w] |= words[w];
+        if (self->bitmap[w] == ~0ULL) CLEAR_BIT(self->summary, w);
+        allocated += (uint32_t)__builtin_popcountll(self->bitmap[w]);
+    }
+    allocated -= self->bitmap_words * 64 - self->total_block_count;
+
+    self->cache_head  = 0;
+    self->cache_tail  = 0;
+    self->cache_count = 0;
+    self->local_free  = 0;
+    self->remote_free = 0;
+    __atomic_store_n(&self->allocated_block_count, allocated, __ATOMIC_RELAXED);
+
+    NVM_SPINLOCK_RELEASE(&self->lock);
+    return allocated;
+}
+
+uint32_t nvm_slab_class_block_size(SizeClassID sc_id) {
+    return get_block_size_from_sc_id(sc_id);
+}
+
+uint32_t nvm_slab_class_span_size(SizeClassID sc_id) {
+    return get_span_size_from_sc_id(sc_id);
+}
+
+// ============================================================================
+//                          内部函数实现
+// ============================================================================
+
+static uint32_t get_block_size_from_sc_id(SizeClassID sc_id) {
+#define NVM_SC_SIZE_ENTRY(name, size, span) size,
+    static const uint32_t sizes[] = {
+        NVM_SIZE_CLASS_TABLE(NVM_SC_SIZE_ENTRY)
+    };
+#undef NVM_SC_SIZE_ENTRY
+    if (sc_id >= 0 && sc_id < (sizeof(sizes)/sizeof(sizes[0]))) {
+        return sizes[sc_id];
+    }
+    return 0;
+}
+
+static uint32_t get_span_size_from_sc_id(SizeClassID sc_id) {
+#define NVM_SC_SPAN_ENTRY(name, size, span) span,
+    static const uint32_t spans[] = {
+        NVM_SIZE_CLASS_TABLE(NVM_SC_SPAN_ENTRY)
+    };
+#undef NVM_SC_SPAN_ENTRY
+    if (sc_id >= 0 && sc_id < (sizeof(spans)/sizeof(spans[0]))) {
+        return spans[sc_id];
+    }
+    return 0;
+}
+
+// 位图全部清零，末字尾部的无效位置 1，摘要按空闲字重建
+static void bitmap_init(NvmSlab* self) {
+    memset(self->bitmap, 0, (size_t)(self->bitmap_words + self->summary_words) * sizeof(uint64_t));
+
+    uint32_t tail_bits = self->total_block_count % 64;
+    if (tail_bits != 0) {
+        self->bitmap[self->bitmap_words - 1] = ~0ULL << tail_bits;
+    }
+    for (uint32_t w = 0; w < self->bitmap_words; ++w) {
+        SET_BIT(self->summary, w);
+    }
+    self->scan_cursor = 0;
+}
+
+static void bitmap_mark_used(NvmSlab* self, uint32_t block_idx) {
+    uint32_t w = block_idx / 64;
+    SET_BIT(self->bitmap, block_idx);
+    if (self->bitmap[w] == ~0ULL) {
+        CLEAR_BIT(self->summary, w);
+    }
+}
+
+static void bitmap_mark_free(NvmSlab* self, uint32_t block_idx) {
+    CLEAR_BIT(self->bitmap, block_idx);
+    SET_BIT(self->summary, block_idx / 64);
+}
+
+// 假设已持锁
+// 从 scan_cursor 起轮转扫描摘要，ctz 定位有空闲位的字，再逐位取出空闲块
+// 开销只与取出的块数和途经的摘要字数有关，与 slab 的块总数无关
+static uint32_t refill_cache(NvmSlab* self) {
+    if (self->allocated_block_count >= self->total_block_count) {
+        return 0;
+    }
+
+    uint32_t filled = 0;
+    uint32_t s      = self->scan_cursor;
+
+    for (uint32_t scanned = 0; scanned <= self->summary_words && filled < SLAB_CACHE_BATCH_SIZE; ) {
+        uint64_t sum = self->summary[s];
+        if (sum == 0) {
+            s = (s + 1 == self->summary_words) ? 0 : s + 1;
+            scanned++;
+            continue;
+        }
+
+        uint32_t w    = s * 64 + (uint32_t)__builtin_ctzll(sum);
+        uint64_t avail = ~self->bitmap[w];
+        uint64_t take = 0;
+
+        // 批量填充缓存
+        while (avail != 0 && filled < SLAB_CACHE_BATCH_SIZE) {
+            uint32_t bit = (uint32_t)__builtin_ctzll(avail);
+            avail &= avail - 1;
+            take |= 1ULL << bit;
+
+            self->free_block_buffer[self->cache_tail] = w * 64 + bit;
+            self->cache_tail = (self->cache_tail + 1) % SLAB_CACHE_SIZE;
+            filled++;
+        }
+
+        // 预标记
+        self->bitmap[w] |= take;
+        if (self->bitmap[w] == ~0ULL) {
+            CLEAR_BIT(self->summary, w);
+        }
+    }
+
+    self->scan_cursor = s;
+    self->cache_count += filled;
+    return filled;
+}
+
+// 假设已持锁
+// 将空闲块放入缓存，缓存满时先回写位图
+static void cache_put(NvmSlab* self, uint32_t block_idx) {
+    if (self->cache_count >= SLAB_CACHE_SIZE) {
+        drain_cache(self);
+    }
+    self->free_block_buffer[self->cache_tail] = block_idx;
+    self->cache_tail = (self->cache_tail + 1) % SLAB_CACHE_SIZE;
+    self->cache_count++;
+}
+
+// 假设已持锁
+static uint32_t drain_cache(NvmSlab* self) {
+    if (self->cache_count <= SLAB_CACHE_BATCH_SIZE) {
+        return 0;
+    }
+
+    uint32_t to_drain = self->cache_count - SLAB_CACHE_BATCH_SIZE;
+    uint32_t drained = 0;
+
+    for (uint32_t i = 0; i < to_drain; ++i) {
+        uint32_t idx = self->free_block_buffer[self->cache_head];
+        self->cache_head = (self->cache_head + 1) % SLAB_CACHE_SIZE;
+        bitmap_mark_free(self, idx); // 回写位图
+        drained++;
+    }
+    
+    self->cache_count -= drained;
+    return drained;
+}
+
+// 将摘下的本地释放链表逐块归还，返回块数
+// 调用方持有所属堆锁，计数以普通存储更新
+static uint32_t put_local_list(NvmSlab* self, const void* slab_addr, uint64_t list) {
+    uint32_t count = (uint32_t)(list >> 32);
+    uint32_t block_idx = (uint32_t)list;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t next = *(const uint32_t*)((const char*)slab_addr + (uint64_t)block_idx * self->block_size);
+        cache_put(self, block_idx);
+        block_idx = next;
+    }
+    uint32_t cnt = self->allocated_block_count;
+    __atomic_store_n(&self->allocated_block_count, cnt - count, __ATOMIC_RELAXED);
+    return count;
+}
@@ -1,38 +1,104 @@
 #include <stdlib.h>
-#include <assert.h>
+#include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
 
 #include "NvmDefs.h"
 #include "NvmSpaceManager.h"
 
+// 伙伴系统最大阶数: 第 o 阶的块为 2^o 个跨度单元 (64KB << 47 远超任何 NVM 设备)
+#define SPACE_MAX_ORDERS 48
+
+#define SPACE_NOT_FOUND  ((uint64_t)-1)
+
+// 空闲区段的两棵索引树
+#define EXTENT_BY_ADDR 0
+#define EXTENT_BY_SIZE 1
+
 // ============================================================================
 //                          核心数据结构
 // ============================================================================
 
-// 空闲段节点：按 NVM 偏移地址排序的双向链表
-typedef struct FreeSegmentNode {
-    uint64_t nvm_offset;
-    uint64_t size;
-    struct FreeSegmentNode* prev;
-    struct FreeSegmentNode* next;
-} FreeSegmentNode;
-
-// 空间管理器
+// 带摘要的位图：summary 第 w 位为 1 表示 bits 第 w 个字非零，
+// 查找置位时按摘要跳过全零的字 (每个摘要字覆盖 4096 位)
+typedef struct SpaceBitmap {
+    uint64_t* bits;
+    uint64_t* summary;
+    uint64_t  nbits;
+    uint64_t  words;
+} SpaceBitmap;
+
+// 空闲区段：一段极大的连续空闲单元 (前后相邻单元均已分配)
+// 同时挂在两棵 AVL 树上：按起始单元排序 (合并时查找邻居) 与按 (单元数, 起始单元) 排序 (Best-Fit)
+typedef struct FreeExtent {
+    uint64_t           first;
+    uint64_t           count;
+    struct FreeExtent* child[2][2];         // [树][左/右]
+    int8_t             height[2];
+} FreeExtent;
+
+// 空间管理器：以 NVM_SPAN_UNIT 为单元的伙伴系统 (buddy)
+// 空闲空间按地址对齐的 2^o 单元块登记在第 o 阶位图中，释放时与伙伴块立即合并，
+// 因此同一空闲集合只有唯一的表示；另有每单元一位的位图记录真实空闲状态，用于区间校验。
+// 跨越块边界的极大空闲段另由区段树索引，服务非 2 的幂大小的分配。对齐均相对于 start_offset
+// 以上结构只登记回收过的空间：从未分配过的高端空间 (荒野，wilderness) 由 wild 之后的全部单元
+// 组成，不进入任何位图与树，分配时以 CAS 推进 wild 无锁切分；紧邻荒野的释放退回荒野
 typedef struct FreeSpaceManager {
-    FreeSegmentNode* head;
-    FreeSegmentNode* tail;
-    nvm_mutex_t      lock;
+    uint64_t    start_offset;
+    uint64_t    unit_count;                 // 管理的单元数 (尾部不足一个单元的空间不参与分配)
+    uint64_t    free_units;
+    uint32_t    max_order;                  // 2^max_order <= unit_count
+    SpaceBitmap units;                      // 第 i 位为 1 表示单元 i 空闲
+    SpaceBitmap orders[SPACE_MAX_ORDERS];   // 第 o 阶: 第 i 位为 1 表示单元 [i << o, (i + 1) << o) 是一个空闲块
+    FreeExtent* extents[2];                 // 区段树根 (EXTENT_BY_ADDR / EXTENT_BY_SIZE)
+    uint64_t    largest_units;              // 最大空闲区段的单元数 (每次修改区段树后更新)
+    FreeExtent* spare;                      // 预留的区段节点，保证持锁修改时无需分配内存
+    nvm_mutex_t lock;
+
+    // 荒野起点 (单元)：[wild, unit_count) 从未被分配，锁外原子推进，独占缓存行
+    uint64_t    wild __attribute__((aligned(CACHE_LINE_SIZE)));
 } FreeSpaceManager;
 
 // ============================================================================
 //                          内部函数前向声明
 // ============================================================================
 
-static FreeSegmentNode* create_segment_node(uint64_t offset, uint64_t size);
-static void remove_node_from_list(FreeSpaceManager* manager, FreeSegmentNode* node);
-static void insert_node_into_list(FreeSpaceManager* manager, FreeSegmentNode* new_node, 
-                                  FreeSegmentNode* prev_node, FreeSegmentNode* next_node);
+static int         space_bitmap_init(SpaceBitmap* bm, uint64_t nbits);
+static void        space_bitmap_destroy(SpaceBitmap* bm);
+static bool        space_bitmap_test(const SpaceBitmap* bm, uint64_t i);
+static void        space_bitmap_set(SpaceBitmap* bm, uint64_t i);
+static void        space_bitmap_clear(SpaceBitmap* bm, uint64_t i);
+static void        space_bitmap_fill(SpaceBitmap* bm, uint64_t first, uint64_t count, bool value);
+static uint64_t    space_bitmap_find_set(const SpaceBitmap* bm, uint64_t from);
+static uint64_t    space_bitmap_find_clear(const SpaceBitmap* bm, uint64_t first, uint64_t count);
+static uint32_t    block_order_at(const FreeSpaceManager* manager, uint64_t first, uint64_t count);
+static void        buddy_insert(FreeSpaceManager* manager, uint64_t idx, uint32_t order);
+static void        buddy_reserve_block(FreeSpaceManager* manager, uint64_t idx, uint32_t order);
+static void        range_release(FreeSpaceManager* manager, uint64_t first, uint64_t count);
+static void        range_reserve(FreeSpaceManager* manager, uint64_t first, uint64_t count);
+static uint64_t    space_find_buddy_block(const FreeSpaceManager* manager, uint32_t order);
+static uint64_t    space_find_best_fit(const FreeSpaceManager* manager, uint64_t count, uint64_t align);
+static uint64_t    space_wild_bump(FreeSpaceManager* manager, uint64_t count, uint64_t align);
+static bool        space_wild_retreat(FreeSpaceManager* manager, uint64_t first, uint64_t count);
+static int         free_extent_cmp(int tree, const FreeExtent* a, uint64_t count, uint64_t first);
+static int         free_extent_height(const FreeExtent* node, int tree);
+static FreeExtent* free_extent_rotate(FreeExtent* root, int tree, int dir);
+static FreeExtent* free_extent_tree_rebalance(FreeExtent* root, int tree);
+static FreeExtent* free_extent_tree_insert(FreeExtent* root, FreeExtent* node, int tree);
+static FreeExtent* free_extent_tree_remove(FreeExtent* root, FreeExtent* node, int tree);
+static FreeExtent* free_extent_find_addr(const FreeSpaceManager* manager, uint64_t unit, bool floor);
+static FreeExtent* free_extent_find_size(const FreeSpaceManager* manager, uint64_t count, uint64_t first);
+static void        free_extent_update_largest(FreeSpaceManager* manager);
+static void        free_extent_link(FreeSpaceManager* manager, FreeExtent* node, uint64_t first, uint64_t count);
+static void        free_extent_unlink(FreeSpaceManager* manager, FreeExtent* node);
+static void        free_extent_recycle(FreeSpaceManager* manager, FreeExtent* node);
+static int         free_extent_prepare_spare(FreeSpaceManager* manager);
+static void        free_extent_destroy_tree(FreeExtent* root);
+static bool        range_to_units(const FreeSpaceManager* manager, uint64_t offset, uint64_t size,
+                                  uint64_t* out_first, uint64_t* out_count);
+static int         range_claim(FreeSpaceManager* manager, uint64_t first, uint64_t count);
+static size_t      range_next_run(const FreeSpaceManager* manager, const uint64_t* offsets, const uint64_t* sizes,
+                                  size_t i, size_t count, uint64_t* out_first, uint64_t* out_count);
 
 // ============================================================================
 //                          公共 API 实现
@@ -40,40 +106,48 @@ static void insert_node_into_list(FreeSpaceManager* manager, FreeSegmentNode* ne
 
 FreeSpaceManager* space_manager_create(uint64_t total_nvm_size, uint64_t nvm_start_offset) {
     if (total_nvm_size < NVM_SLAB_SIZE) {
-        LOG_ERR("Total size (%llu) smaller than slab size (%llu).", 
+        LOG_ERR("Total size (%llu) smaller than slab size (%llu).",
                 (unsigned long long)total_nvm_size, (unsigned long long)NVM_SLAB_SIZE);
         return NULL;
     }
 
-    FreeSpaceManager* manager = (FreeSpaceManager*)malloc(sizeof(FreeSpaceManager));
+    FreeSpaceManager* manager = (FreeSpaceManager*)aligned_alloc(CACHE_LINE_SIZE,
+                                    NVM_ALIGN_UP(sizeof(FreeSpaceManager), CACHE_LINE_SIZE));
+    if (manager) memset(manager, 0, sizeof(FreeSpaceManager));
     if (!manager) {
         LOG_ERR("Failed to allocate manager struct.");
         return NULL;
     }
 
-    manager->head = NULL;
-    manager->tail = NULL;
+    manager->start_offset = nvm_start_offset;
+    manager->unit_count   = total_nvm_size / NVM_SPAN_UNIT;
+    manager->max_order    = 63 - (uint32_t)__builtin_clzll(manager->unit_count);
+    if (manager->max_order >= SPACE_MAX_ORDERS) manager->max_order = SPACE_MAX_ORDERS - 1;
 
-    if (NVM_MUTEX_INIT(&manager->lock) != 0) {
-        LOG_ERR("Failed to init mutex.");
-        goto err_free_manager;
+    if (space_bitmap_init(&manager->units, manager->unit_count) != 0) goto err_free_bitmaps;
+    for (uint32_t o = 0; o <= manager->max_order; ++o) {
+        if (space_bitmap_init(&manager->orders[o], manager->unit_count >> o) != 0) goto err_free_bitmaps;
     }
 
-    // 创建初始的大块空闲节点
-    FreeSegmentNode* initial_node = create_segment_node(nvm_start_offset, total_nvm_size);
-    if (!initial_node) {
-        LOG_ERR("Failed to create initial segment.");
-        goto err_destroy_mutex;
+    if (free_extent_prepare_spare(manager) != 0) goto err_free_bitmaps;
+
+    if (NVM_MUTEX_INIT(&manager->lock) != 0) {
+        LOG_ERR("Failed to init mutex.");
+        goto err_free_bitmaps;
     }
 
-    manager->head = initial_node;
-    manager->tail = initial_node;
+    // 初始时整个空间都是荒野，回收空间为空
+    manager->wild = 0;
 
     return manager;
 
-err_destroy_mutex:
-    NVM_MUTEX_DESTROY(&manager->lock);
-err_free_manager:
+err_free_bitmaps:
+    LOG_ERR("Failed to allocate free space bitmaps.");
+    space_bitmap_destroy(&manager->units);
+    for (uint32_t o = 0; o <= manager->max_order; ++o) {
+        space_bitmap_destroy(&manager->orders[o]);
+    }
+    free(manager->spare);
     free(manager);
     return NULL;
 }
@@ -81,176 +155,730 @@ err_free_manager:
 void space_manager_destroy(FreeSpaceManager* manager) {
     if (!manager) return;
 
-    FreeSegmentNode* current = manager->head;
-    while (current) {
-        FreeSegmentNode* next = current->next;
-        free(current);
-        current = next;
+    space_bitmap_destroy(&manager->units);
+    for (uint32_t o = 0; o <= manager->max_order; ++o) {
+        space_bitmap_destroy(&manager->orders[o]);
     }
-    
+    free_extent_destroy_tree(manager->extents[EXTENT_BY_ADDR]);
+    free(manager->spare);
+
     NVM_MUTEX_DESTROY(&manager->lock);
     free(manager);
 }
 
 uint64_t space_manager_alloc_slab(FreeSpaceManager* manager) {
+    return space_manager_alloc_aligned(manager, NVM_SLAB_SIZE, NVM_SLAB_SIZE);
+}
+
+void space_manager_free_slab(FreeSpaceManager* manager, uint64_t offset_to_free) {
+    space_manager_free(manager, offset_to_free, NVM_SLAB_SIZE);
+}
+
+uint64_t space_manager_alloc(FreeSpaceManager* manager, uint64_t size) {
+    return space_manager_alloc_aligned(manager, size, NVM_SPAN_UNIT);
+}
+
+uint64_t space_manager_alloc_aligned(FreeSpaceManager* manager, uint64_t size, uint64_t align) {
     if (!manager) return (uint64_t)-1;
+    if (size == 0 || size % NVM_SPAN_UNIT != 0) {
+        LOG_ERR("Invalid allocation size %llu (must be a multiple of span unit).", (unsigned long long)size);
+        return (uint64_t)-1;
+    }
+    if (align < NVM_SPAN_UNIT || (align & (align - 1)) != 0) {
+        LOG_ERR("Invalid allocation alignment %llu.", (unsigned long long)align);
+        return (uint64_t)-1;
+    }
+
+    uint64_t count       = size / NVM_SPAN_UNIT;
+    uint64_t align_units = align / NVM_SPAN_UNIT;
+    if (count > manager->unit_count) return (uint64_t)-1;
+
+    // 所需的阶：能容纳 count 个单元，且块自身的对齐不低于 align
+    uint32_t order = (count == 1) ? 0 : 64 - (uint32_t)__builtin_clzll(count - 1);
+    uint32_t align_order = (uint32_t)__builtin_ctzll(align_units);
+    if (align_order > order) order = align_order;
+
+    uint64_t first = SPACE_NOT_FOUND;
+
+    // 回收空间中最大的空闲区段放得下时才加锁查找 (锁外读取只作提示)；
+    // 全新或轻度使用的池上回收空间为空，分配全部走下面的无锁荒野切分
+    if (count <= __atomic_load_n(&manager->largest_units, __ATOMIC_RELAXED)) {
+        NVM_MUTEX_ACQUIRE(&manager->lock);
+        if (count <= manager->largest_units && free_extent_prepare_spare(manager) == 0) {
+            // 2 的幂大小 (Slab 跨度)：地址最低的足够大的伙伴块，O(阶数) 次位图查找
+            bool pow2 = (count & (count - 1)) == 0;
+            if (pow2 && order <= manager->max_order) {
+                first = space_find_buddy_block(manager, order);
+            }
+            // 非 2 的幂大小，或没有单个块放得下 (跨越块边界)：在区段树中 Best-Fit，O(log n)
+            if (first == SPACE_NOT_FOUND) {
+                first = space_find_best_fit(manager, count, align_units);
+            }
+            if (first != SPACE_NOT_FOUND) {
+                range_reserve(manager, first, count);
+            }
+        }
+        NVM_MUTEX_RELEASE(&manager->lock);
+    }
+
+    // 回收空间放不下：从荒野无锁切分
+    if (first == SPACE_NOT_FOUND) {
+        first = space_wild_bump(manager, count, align_units);
+    }
+
+    if (first == SPACE_NOT_FOUND) return (uint64_t)-1;
+    return manager->start_offset + first * NVM_SPAN_UNIT;
+}
+
+void space_manager_free(FreeSpaceManager* manager, uint64_t offset_to_free, uint64_t size) {
+    if (!manager || size == 0) return;
+
+    uint64_t first, count;
+    if (!range_to_units(manager, offset_to_free, size, &first, &count)) {
+        LOG_ERR("Invalid free range at offset %llu.", (unsigned long long)offset_to_free);
+        return;
+    }
 
     NVM_MUTEX_ACQUIRE(&manager->lock);
 
-    // [First-Fit] 查找首个满足大小的节点
-    FreeSegmentNode* curr = manager->head;
-    while (curr) {
-        if (curr->size >= NVM_SLAB_SIZE) {
-            uint64_t offset = curr->nvm_offset;
-
-            if (curr->size == NVM_SLAB_SIZE) {
-                // 大小刚好，移除节点
-                remove_node_from_list(manager, curr);
-                free(curr);
-            } else {
-                // 空间富余，切割节点
-                curr->nvm_offset += NVM_SLAB_SIZE;
-                curr->size       -= NVM_SLAB_SIZE;
-            }
+    // 区间内不能有空闲单元 (重复释放或与空闲空间、荒野重叠)
+    if (first + count > __atomic_load_n(&manager->wild, __ATOMIC_ACQUIRE) ||
+        space_bitmap_find_set(&manager->units, first) < first + count) {
+        NVM_MUTEX_RELEASE(&manager->lock);
+        LOG_ERR("Free range at offset %llu overlaps free space.", (unsigned long long)offset_to_free);
+        return;
+    }
+    if (free_extent_prepare_spare(manager) != 0) {
+        NVM_MUTEX_RELEASE(&manager->lock);
+        LOG_ERR("Failed to allocate free extent node, leaking range at offset %llu.",
+                (unsigned long long)offset_to_free);
+        return;
+    }
+    // 紧邻荒野的区间 (连同其下相邻的空闲区段) 直接退回荒野
+    if (!space_wild_retreat(manager, first, count)) {
+        range_release(manager, first, count);
+    }
+
+    NVM_MUTEX_RELEASE(&manager->lock);
+}
+
+int space_manager_alloc_at_offset(FreeSpaceManager* manager, uint64_t offset, uint64_t size) {
+    if (!manager || size == 0) return -1;
+
+    uint64_t first, count;
+    if (!range_to_units(manager, offset, size, &first, &count)) {
+        LOG_ERR("Invalid reservation range at offset %llu.", (unsigned long long)offset);
+        return -1;
+    }
+
+    NVM_MUTEX_ACQUIRE(&manager->lock);
+    int ret = range_claim(manager, first, count);
+    NVM_MUTEX_RELEASE(&manager->lock);
+
+    if (ret != 0) LOG_ERR("Requested offset %llu is not free.", (unsigned long long)offset);
+    return ret;
+}
+
+int space_manager_alloc_at_offsets(FreeSpaceManager* manager, const uint64_t* offsets,
+                                   const uint64_t* sizes, size_t count) {
+    if (!manager || (count > 0 && (!offsets || !sizes))) return -1;
+
+    // 先在锁外校验全部区间：单元对齐、不越界、升序且互不重叠
+    uint64_t prev_end = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t first, units;
+        if (!range_to_units(manager, offsets[i], sizes[i], &first, &units) || units == 0) {
+            LOG_ERR("Invalid reservation range at offset %llu.", (unsigned long long)offsets[i]);
+            return -1;
+        }
+        if (first < prev_end) {
+            LOG_ERR("Reservation ranges must be sorted and disjoint (offset %llu).", (unsigned long long)offsets[i]);
+            return -1;
+        }
+        prev_end = first + units;
+    }
+
+    NVM_MUTEX_ACQUIRE(&manager->lock);
+
+    size_t i = 0;
+    while (i < count) {
+        uint64_t first, units;
+        size_t next = range_next_run(manager, offsets, sizes, i, count, &first, &units);
+        if (range_claim(manager, first, units) == 0) {
+            i = next;
+            continue;
+        }
 
-            NVM_MUTEX_RELEASE(&manager->lock);
-            return offset;
+        // 回滚已占位的各段 (按占位时同样的合并方式重新切分)
+        LOG_ERR("Requested offset %llu is not free.", (unsigned long long)offsets[i]);
+        for (size_t j = 0; j < i; ) {
+            j = range_next_run(manager, offsets, sizes, j, i, &first, &units);
+            if (free_extent_prepare_spare(manager) != 0) {
+                LOG_ERR("Failed to allocate free extent node, leaking range at unit %llu.",
+                        (unsigned long long)first);
+                continue;
+            }
+            if (!space_wild_retreat(manager, first, units)) {
+                range_release(manager, first, units);
+            }
         }
-        curr = curr->next;
+        NVM_MUTEX_RELEASE(&manager->lock);
+        return -1;
     }
 
     NVM_MUTEX_RELEASE(&manager->lock);
-    return (uint64_t)-1;
+    return 0;
 }
 
-void space_manager_free_slab(FreeSpaceManager* manager, uint64_t offset_to_free) {
-    if (!manager) return;
+uint64_t space_manager_free_bytes(FreeSpaceManager* manager) {
+    if (!manager) return 0;
 
     NVM_MUTEX_ACQUIRE(&manager->lock);
+    uint64_t free_units = manager->free_units;
+    free_units += manager->unit_count - __atomic_load_n(&manager->wild, __ATOMIC_ACQUIRE);
+    NVM_MUTEX_RELEASE(&manager->lock);
+    return free_units * NVM_SPAN_UNIT;
+}
 
-    // 查找插入位置 (prev < offset < next)
-    FreeSegmentNode* prev = NULL;
-    FreeSegmentNode* next = manager->head;
-    while (next && next->nvm_offset < offset_to_free) {
-        prev = next;
-        next = next->next;
-    }
-
-    // 校验重叠 (Debug 模式)
-    assert(!next || (offset_to_free + NVM_SLAB_SIZE <= next->nvm_offset));
-    assert(!prev || (prev->nvm_offset + prev->size <= offset_to_free));
-
-    bool merge_prev = (prev && (prev->nvm_offset + prev->size == offset_to_free));
-    bool merge_next = (next && (offset_to_free + NVM_SLAB_SIZE == next->nvm_offset));
-
-    if (merge_prev && merge_next) {
-        // 双向合并：Prev + Self + Next
-        prev->size += NVM_SLAB_SIZE + next->size;
-        remove_node_from_list(manager, next);
-        free(next);
-    } else if (merge_prev) {
-        // 向前合并
-        prev->size += NVM_SLAB_SIZE;
-    } else if (merge_next) {
-        // 向后合并 (节点前移)
-        next->nvm_offset = offset_to_free;
-        next->size      += NVM_SLAB_SIZE;
-    } else {
-        // 无法合并，插入新节点
-        FreeSegmentNode* node = create_segment_node(offset_to_free, NVM_SLAB_SIZE);
-        if (!node) {
-            LOG_ERR("Failed to create free segment node (Memory Leak!).");
-            // 无法插入回链表，只能丢弃该块（这属于严重系统错误）
+uint64_t space_manager_largest_free(FreeSpaceManager* manager) {
+    if (!manager) return 0;
+
+    uint64_t wild_units = manager->unit_count - __atomic_load_n(&manager->wild, __ATOMIC_ACQUIRE);
+    uint64_t largest_units = __atomic_load_n(&manager->largest_units, __ATOMIC_RELAXED);
+    return ((largest_units > wild_units) ? largest_units : wild_units) * NVM_SPAN_UNIT;
+}
+
+int space_manager_next_free_range(FreeSpaceManager* manager, uint64_t from,
+                                  uint64_t* out_offset, uint64_t* out_size) {
+    if (!manager || !out_offset || !out_size) return -1;
+
+    uint64_t first = (from > manager->start_offset) ? (from - manager->start_offset) / NVM_SPAN_UNIT : 0;
+    int ret = -1;
+
+    NVM_MUTEX_ACQUIRE(&manager->lock);
+    uint64_t wild = __atomic_load_n(&manager->wild, __ATOMIC_ACQUIRE);
+
+    // 包含 first 的区段，或其后的第一个区段；都没有时为荒野 (与之相邻的区段并入荒野)
+    FreeExtent* extent = free_extent_find_addr(manager, first, true);
+    if (!extent || extent->first + extent->count <= first) {
+        extent = free_extent_find_addr(manager, first, false);
+    }
+    uint64_t start = extent ? extent->first : wild;
+    uint64_t end   = extent ? extent->first + extent->count : manager->unit_count;
+    if (end == wild) end = manager->unit_count;
+    if (start < end && first < end) {
+        *out_offset = manager->start_offset + start * NVM_SPAN_UNIT;
+        *out_size   = (end - start) * NVM_SPAN_UNIT;
+        ret = 0;
+    }
+    NVM_MUTEX_RELEASE(&manager->lock);
+    return ret;
+}
+
+// ============================================================================
+//                          内部函数实现 (位图)
+// ============================================================================
+
+static int space_bitmap_init(SpaceBitmap* bm, uint64_t nbits) {
+    bm->nbits = nbits;
+    bm->words = (nbits + 63) / 64;
+    uint64_t summary_words = (bm->words + 63) / 64;
+    bm->bits = (uint64_t*)calloc((size_t)(bm->words + summary_words + 1), sizeof(uint64_t));
+    if (!bm->bits) return -1;
+    bm->summary = &bm->bits[bm->words];
+    return 0;
+}
+
+static void space_bitmap_destroy(SpaceBitmap* bm) {
+    free(bm->bits);
+    bm->bits    = NULL;
+    bm->summary = NULL;
+}
+
+static bool space_bitmap_test(const SpaceBitmap* bm, uint64_t i) {
+    return i < bm->nbits && ((bm->bits[i / 64] >> (i % 64)) & 1);
+}
+
+static void space_bitmap_set(SpaceBitmap* bm, uint64_t i) {
+    bm->bits[i / 64]       |= 1ULL << (i % 64);
+    bm->summary[i / 4096]  |= 1ULL << ((i / 64) % 64);
+}
+
+static void space_bitmap_clear(SpaceBitmap* bm, uint64_t i) {
+    bm->bits[i / 64] &= ~(1ULL << (i % 64));
+    if (bm->bits[i / 64] == 0) {
+        bm->summary[i / 4096] &= ~(1ULL << ((i / 64) % 64));
+    }
+}
+
+// 按字批量置位/清零 [first, first + count)，同步维护摘要
+static void space_bitmap_fill(SpaceBitmap* bm, uint64_t first, uint64_t count, bool value) {
+    while (count > 0) {
+        uint64_t w   = first / 64;
+        uint64_t bit = first % 64;
+        uint64_t n   = (64 - bit < count) ? 64 - bit : count;
+        uint64_t mask = (n == 64) ? ~0ULL : ((1ULL << n) - 1) << bit;
+
+        if (value) bm->bits[w] |= mask;
+        else       bm->bits[w] &= ~mask;
+
+        if (bm->bits[w]) bm->summary[w / 64] |= 1ULL << (w % 64);
+        else             bm->summary[w / 64] &= ~(1ULL << (w % 64));
+
+        first += n;
+        count -= n;
+    }
+}
+
+// 返回 from 及之后的第一个置位，没有则返回 SPACE_NOT_FOUND
+static uint64_t space_bitmap_find_set(const SpaceBitmap* bm, uint64_t from) {
+    if (from >= bm->nbits) return SPACE_NOT_FOUND;
+
+    uint64_t w = from / 64;
+    uint64_t word = bm->bits[w] & (~0ULL << (from % 64));
+    if (word) return w * 64 + (uint64_t)__builtin_ctzll(word);
+
+    // 当前字之后：按摘要跳过全零的字
+    for (uint64_t next = w + 1; next < bm->words; ) {
+        uint64_t s   = next / 64;
+        uint64_t sum = bm->summary[s] & (~0ULL << (next % 64));
+        if (sum) {
+            uint64_t found = s * 64 + (uint64_t)__builtin_ctzll(sum);
+            return found * 64 + (uint64_t)__builtin_ctzll(bm->bits[found]);
+        }
+        next = (s + 1) * 64;
+    }
+    return SPACE_NOT_FOUND;
+}
+
+// 返回 [first, first + count) 内的第一个清零位，全部置位时返回 first + count
+static uint64_t space_bitmap_find_clear(const SpaceBitmap* bm, uint64_t first, uint64_t count) {
+    uint64_t end = first + count;
+    while (first < end) {
+        uint64_t w    = first / 64;
+        uint64_t word = ~bm->bits[w] & (~0ULL << (first % 64));
+        if (word) {
+            uint64_t found = w * 64 + (uint64_t)__builtin_ctzll(word);
+            return (found < end) ? found : end;
+        }
+        first = (w + 1) * 64;
+    }
+    return end;
+}
+
+// ============================================================================
+//                          内部函数实现 (伙伴系统)
+// ============================================================================
+
+// 从单元 first 起、不超过 count 个单元的最大对齐块的阶
+static uint32_t block_order_at(const FreeSpaceManager* manager, uint64_t first, uint64_t count) {
+    uint32_t order = (first == 0) ? manager->max_order : (uint32_t)__builtin_ctzll(first);
+    if (order > manager->max_order) order = manager->max_order;
+    while ((1ULL << order) > count) order--;
+    return order;
+}
+
+// 假设已持锁
+// 登记一个空闲块，并与空闲的伙伴块逐阶合并 (越界的伙伴块从不会被登记)
+static void buddy_insert(FreeSpaceManager* manager, uint64_t idx, uint32_t order) {
+    while (order < manager->max_order) {
+        uint64_t buddy = idx ^ (1ULL << order);
+        if (!space_bitmap_test(&manager->orders[order], buddy >> order)) break;
+
+        space_bitmap_clear(&manager->orders[order], buddy >> order);
+        idx &= ~(1ULL << order);
+        order++;
+    }
+    space_bitmap_set(&manager->orders[order], idx >> order);
+}
+
+// 假设已持锁，且对齐块 [idx, idx + 2^order) 整体空闲
+// 找到包含它的空闲块，逐阶对半拆分，不含目标的一半登记回对应的阶
+static void buddy_reserve_block(FreeSpaceManager* manager, uint64_t idx, uint32_t order) {
+    uint32_t o = order;
+    while (o <= manager->max_order && !space_bitmap_test(&manager->orders[o], idx >> o)) o++;
+    if (o > manager->max_order) {
+        LOG_ERR("Free space bitmaps are inconsistent at unit %llu.", (unsigned long long)idx);
+        return;
+    }
+
+    uint64_t base = (idx >> o) << o;
+    space_bitmap_clear(&manager->orders[o], base >> o);
+    while (o > order) {
+        o--;
+        uint64_t half = base + (1ULL << o);
+        if (idx >= half) {
+            space_bitmap_set(&manager->orders[o], base >> o);
+            base = half;
         } else {
-            insert_node_into_list(manager, node, prev, next);
+            space_bitmap_set(&manager->orders[o], half >> o);
         }
     }
+}
 
-    NVM_MUTEX_RELEASE(&manager->lock);
+// 假设已持锁，且区间整体已分配：与相邻的空闲区段合并，再拆成对齐块逐个归还
+// 调用前须已通过 free_extent_prepare_spare 预留节点
+static void range_release(FreeSpaceManager* manager, uint64_t first, uint64_t count) {
+    uint64_t    ext_first = first;
+    uint64_t    ext_count = count;
+    FreeExtent* node      = NULL;
+
+    FreeExtent* left = (first > 0) ? free_extent_find_addr(manager, first - 1, true) : NULL;
+    if (left && left->first + left->count == first) {
+        ext_first  = left->first;
+        ext_count += left->count;
+        free_extent_unlink(manager, left);
+        node = left;
+    }
+    FreeExtent* right = free_extent_find_addr(manager, first + count, false);
+    if (right && right->first == first + count) {
+        ext_count += right->count;
+        free_extent_unlink(manager, right);
+        if (node) free_extent_recycle(manager, right);
+        else      node = right;
+    }
+    if (!node) {
+        node = manager->spare;
+        manager->spare = NULL;
+    }
+    free_extent_link(manager, node, ext_first, ext_count);
+
+    space_bitmap_fill(&manager->units, first, count, true);
+    manager->free_units += count;
+
+    while (count > 0) {
+        uint32_t order = block_order_at(manager, first, count);
+        buddy_insert(manager, first, order);
+        first += 1ULL << order;
+        count -= 1ULL << order;
+    }
 }
 
-int space_manager_alloc_at_offset(FreeSpaceManager* manager, uint64_t offset) {
-    if (!manager) return -1;
-
-    const uint64_t req_size = NVM_SLAB_SIZE;
-    uint64_t req_end = offset + req_size;
-
-    // 遍历查找包含目标区域的节点
-    FreeSegmentNode* curr = manager->head;
-    while (curr) {
-        uint64_t curr_end = curr->nvm_offset + curr->size;
-
-        if (curr->nvm_offset <= offset && curr_end >= req_end) {
-            bool match_head = (curr->nvm_offset == offset);
-            bool match_tail = (curr_end == req_end);
-
-            if (match_head && match_tail) {
-                // 情况 1: 完全重合 -> 移除节点
-                remove_node_from_list(manager, curr);
-                free(curr);
-            } else if (match_head) {
-                // 情况 2: 头部重合 -> 头部缩进
-                curr->nvm_offset += req_size;
-                curr->size       -= req_size;
-            } else if (match_tail) {
-                // 情况 3: 尾部重合 -> 尾部截断
-                curr->size -= req_size;
-            } else {
-                // 情况 4: 中间挖空 -> 分裂节点
-                FreeSegmentNode* new_tail = create_segment_node(req_end, curr_end - req_end);
-                if (!new_tail) {
-                    LOG_ERR("Failed to create split node during restore.");
-                    return -1;
-                }
-                // 修改前段大小，插入后段节点
-                curr->size = offset - curr->nvm_offset;
-                insert_node_into_list(manager, new_tail, curr, curr->next);
-            }
-            return 0; // 成功
+// 假设已持锁，且区间整体空闲：从所在区段中切出，再拆成对齐块逐个占用
+// 调用前须已通过 free_extent_prepare_spare 预留节点 (区段一分为二时需要)
+static void range_reserve(FreeSpaceManager* manager, uint64_t first, uint64_t count) {
+    FreeExtent* extent = free_extent_find_addr(manager, first, true);
+    if (!extent || extent->first + extent->count < first + count) {
+        LOG_ERR("Free extents are inconsistent at unit %llu.", (unsigned long long)first);
+    } else {
+        uint64_t ext_first = extent->first;
+        uint64_t ext_end   = extent->first + extent->count;
+        free_extent_unlink(manager, extent);
+
+        if (ext_first < first) {
+            free_extent_link(manager, extent, ext_first, first - ext_first);
+            extent = NULL;
+        }
+        if (first + count < ext_end) {
+            FreeExtent* node = extent ? extent : manager->spare;
+            if (node == manager->spare) manager->spare = NULL;
+            free_extent_link(manager, node, first + count, ext_end - first - count);
+            extent = NULL;
+        }
+        if (extent) free_extent_recycle(manager, extent);
+    }
+
+    space_bitmap_fill(&manager->units, first, count, false);
+    manager->free_units -= count;
+
+    while (count > 0) {
+        uint32_t order = block_order_at(manager, first, count);
+        buddy_reserve_block(manager, first, order);
+        first += 1ULL << order;
+        count -= 1ULL << order;
+    }
+}
+
+// 假设已持锁
+// 在不低于 order 的各阶中取地址最低的空闲块 (地址有序，空间保持紧凑)，返回起始单元
+static uint64_t space_find_buddy_block(const FreeSpaceManager* manager, uint32_t order) {
+    uint64_t best = SPACE_NOT_FOUND;
+    for (uint32_t o = order; o <= manager->max_order; ++o) {
+        uint64_t i = space_bitmap_find_set(&manager->orders[o], 0);
+        if (i != SPACE_NOT_FOUND && (i << o) < best) best = i << o;
+    }
+    return best;
+}
+
+// 假设已持锁
+// Best-Fit：取能放下 count 个单元 (起点按 align 个单元对齐) 的最小空闲区段，
+// 同样大小的区段取地址最低者，返回起始单元
+static uint64_t space_find_best_fit(const FreeSpaceManager* manager, uint64_t count, uint64_t align) {
+    FreeExtent* extent = free_extent_find_size(manager, count, 0);
+    while (extent) {
+        uint64_t start = NVM_ALIGN_UP(extent->first, align);
+        if (start + count <= extent->first + extent->count) return start;
+        // 对齐后放不下 (仅 align > 1 时发生)：按 (单元数, 起始单元) 顺序取下一个区段
+        extent = free_extent_find_size(manager, extent->count, extent->first + 1);
+    }
+    return SPACE_NOT_FOUND;
+}
+
+// 无锁从荒野切分 count 个单元 (起点按 align 个单元对齐)，返回起始单元
+// 对齐产生的空隙在推进成功后加锁转入回收空间
+static uint64_t space_wild_bump(FreeSpaceManager* manager, uint64_t count, uint64_t align) {
+    uint64_t wild = __atomic_load_n(&manager->wild, __ATOMIC_ACQUIRE);
+    uint64_t first;
+    do {
+        first = NVM_ALIGN_UP(wild, align);
+        if (first > manager->unit_count || count > manager->unit_count - first) return SPACE_NOT_FOUND;
+    } while (!__atomic_compare_exchange_n(&manager->wild, &wild, first + count, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    if (first > wild) {
+        NVM_MUTEX_ACQUIRE(&manager->lock);
+        if (free_extent_prepare_spare(manager) == 0) {
+            range_release(manager, wild, first - wild);
+        } else {
+            LOG_ERR("Failed to allocate free extent node, leaking %llu units.",
+                    (unsigned long long)(first - wild));
         }
-        curr = curr->next;
+        NVM_MUTEX_RELEASE(&manager->lock);
     }
+    return first;
+}
 
-    LOG_ERR("Requested offset %llu is not free.", (unsigned long long)offset);
-    return -1;
+// 假设已持锁
+// 区间 [first, first + count) 紧邻荒野时，连同其下相邻的空闲区段一起退回荒野，返回是否退回
+// 与无锁切分竞争失败 (荒野起点已被推进) 时不做任何修改，由调用方按普通释放处理
+static bool space_wild_retreat(FreeSpaceManager* manager, uint64_t first, uint64_t count) {
+    uint64_t end = first + count;
+    if (__atomic_load_n(&manager->wild, __ATOMIC_ACQUIRE) != end) return false;
+
+    FreeExtent* left  = (first > 0) ? free_extent_find_addr(manager, first - 1, true) : NULL;
+    uint64_t    start = first;
+    if (left && left->first + left->count == first) {
+        start = left->first;
+    } else {
+        left = NULL;
+    }
+    if (!__atomic_compare_exchange_n(&manager->wild, &end, start, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    // 荒野已覆盖左邻区段：从回收空间中整体摘除 (锁外的切分此时可能已取用这些单元，
+    // 但不会触碰回收结构，摘除后两边的视图一致)
+    if (left) range_reserve(manager, left->first, left->count);
+    return true;
 }
 
 // ============================================================================
-//                          内部函数实现
+//                          内部函数实现 (空闲区段树)
 // ============================================================================
 
-static FreeSegmentNode* create_segment_node(uint64_t offset, uint64_t size) {
-    FreeSegmentNode* node = (FreeSegmentNode*)malloc(sizeof(FreeSegmentNode));
-    if (node) {
-        node->nvm_offset = offset;
-        node->size       = size;
-        node->prev       = NULL;
-        node->next       = NULL;
+// 节点 a 与键 (count, first) 比较；按地址的树只比较 first
+static int free_extent_cmp(int tree, const FreeExtent* a, uint64_t count, uint64_t first) {
+    if (tree == EXTENT_BY_SIZE && a->count != count) return (a->count < count) ? -1 : 1;
+    if (a->first != first) return (a->first < first) ? -1 : 1;
+    return 0;
+}
+
+static int free_extent_height(const FreeExtent* node, int tree) {
+    return node ? node->height[tree] : 0;
+}
+
+static FreeExtent* free_extent_rotate(FreeExtent* root, int tree, int dir) {
+    FreeExtent* pivot = root->child[tree][!dir];
+    root->child[tree][!dir] = pivot->child[tree][dir];
+    pivot->child[tree][dir] = root;
+
+    int lh = free_extent_height(root->child[tree][0], tree), rh = free_extent_height(root->child[tree][1], tree);
+    root->height[tree] = (int8_t)((lh > rh ? lh : rh) + 1);
+    lh = free_extent_height(pivot->child[tree][0], tree);
+    rh = free_extent_height(pivot->child[tree][1], tree);
+    pivot->height[tree] = (int8_t)((lh > rh ? lh : rh) + 1);
+    return pivot;
+}
+
+// 更新高度，左右子树高度差超过 1 时旋转，返回新的子树根
+static FreeExtent* free_extent_tree_rebalance(FreeExtent* root, int tree) {
+    int lh = free_extent_height(root->child[tree][0], tree);
+    int rh = free_extent_height(root->child[tree][1], tree);
+    root->height[tree] = (int8_t)((lh > rh ? lh : rh) + 1);
+
+    if (lh - rh > 1 || rh - lh > 1) {
+        int heavy = (rh > lh);      // 0: 左重, 1: 右重
+        FreeExtent* child = root->child[tree][heavy];
+        if (free_extent_height(child->child[tree][!heavy], tree) > free_extent_height(child->child[tree][heavy], tree)) {
+            root->child[tree][heavy] = free_extent_rotate(child, tree, heavy);
+        }
+        root = free_extent_rotate(root, tree, !heavy);
+    }
+    return root;
+}
+
+static FreeExtent* free_extent_tree_insert(FreeExtent* root, FreeExtent* node, int tree) {
+    if (!root) {
+        node->child[tree][0] = node->child[tree][1] = NULL;
+        node->height[tree] = 1;
+        return node;
+    }
+    int dir = free_extent_cmp(tree, root, node->count, node->first) < 0;
+    root->child[tree][dir] = free_extent_tree_insert(root->child[tree][dir], node, tree);
+    return free_extent_tree_rebalance(root, tree);
+}
+
+static FreeExtent* free_extent_tree_remove(FreeExtent* root, FreeExtent* node, int tree) {
+    if (!root) return NULL;
+
+    int cmp = free_extent_cmp(tree, root, node->count, node->first);
+    if (cmp != 0) {
+        int dir = cmp < 0;
+        root->child[tree][dir] = free_extent_tree_remove(root->child[tree][dir], node, tree);
+        return free_extent_tree_rebalance(root, tree);
+    }
+
+    // 命中：至多一个孩子时直接接上，否则用右子树的最小节点顶替
+    FreeExtent* left  = root->child[tree][0];
+    FreeExtent* right = root->child[tree][1];
+    if (!left || !right) return left ? left : right;
+
+    FreeExtent* succ = right;
+    while (succ->child[tree][0]) succ = succ->child[tree][0];
+    succ->child[tree][1] = free_extent_tree_remove(right, succ, tree);
+    succ->child[tree][0] = left;
+    return free_extent_tree_rebalance(succ, tree);
+}
+
+// 按地址查找：floor 为真时返回起始单元 <= unit 的最后一个区段，否则返回起始单元 >= unit 的第一个区段
+static FreeExtent* free_extent_find_addr(const FreeSpaceManager* manager, uint64_t unit, bool floor) {
+    FreeExtent* node = manager->extents[EXTENT_BY_ADDR];
+    FreeExtent* best = NULL;
+    while (node) {
+        if (node->first == unit) return node;
+        bool go_right = node->first < unit;
+        if (go_right == floor) best = node;
+        node = node->child[EXTENT_BY_ADDR][go_right];
+    }
+    return best;
+}
+
+// 按大小查找：返回 (单元数, 起始单元) >= (count, first) 的第一个区段
+static FreeExtent* free_extent_find_size(const FreeSpaceManager* manager, uint64_t count, uint64_t first) {
+    FreeExtent* node = manager->extents[EXTENT_BY_SIZE];
+    FreeExtent* best = NULL;
+    while (node) {
+        if (free_extent_cmp(EXTENT_BY_SIZE, node, count, first) >= 0) {
+            best = node;
+            node = node->child[EXTENT_BY_SIZE][0];
+        } else {
+            node = node->child[EXTENT_BY_SIZE][1];
+        }
+    }
+    return best;
+}
+
+// 更新最大空闲区段：按大小的树的最右节点，O(log n)
+static void free_extent_update_largest(FreeSpaceManager* manager) {
+    FreeExtent* node = manager->extents[EXTENT_BY_SIZE];
+    while (node && node->child[EXTENT_BY_SIZE][1]) node = node->child[EXTENT_BY_SIZE][1];
+    __atomic_store_n(&manager->largest_units, node ? node->count : 0, __ATOMIC_RELAXED);
+}
+
+static void free_extent_link(FreeSpaceManager* manager, FreeExtent* node, uint64_t first, uint64_t count) {
+    node->first = first;
+    node->count = count;
+    manager->extents[EXTENT_BY_ADDR] = free_extent_tree_insert(manager->extents[EXTENT_BY_ADDR], node, EXTENT_BY_ADDR);
+    manager->extents[EXTENT_BY_SIZE] = free_extent_tree_insert(manager->extents[EXTENT_BY_SIZE], node, EXTENT_BY_SIZE);
+    free_extent_update_largest(manager);
+}
+
+static void free_extent_unlink(FreeSpaceManager* manager, FreeExtent* node) {
+    manager->extents[EXTENT_BY_ADDR] = free_extent_tree_remove(manager->extents[EXTENT_BY_ADDR], node, EXTENT_BY_ADDR);
+    manager->extents[EXTENT_BY_SIZE] = free_extent_tree_remove(manager->extents[EXTENT_BY_SIZE], node, EXTENT_BY_SIZE);
+    free_extent_update_largest(manager);
+}
+
+// 不再使用的节点：补充预留，预留已满则直接释放
+static void free_extent_recycle(FreeSpaceManager* manager, FreeExtent* node) {
+    if (!manager->spare) {
+        manager->spare = node;
     } else {
-        LOG_ERR("Malloc failed for segment node.");
+        free(node);
+    }
+}
+
+// 假设已持锁 (或在创建期间)
+// 每次修改至多新增一个区段，修改前预留一个节点，失败时调用方放弃修改
+static int free_extent_prepare_spare(FreeSpaceManager* manager) {
+    if (manager->spare) return 0;
+    manager->spare = (FreeExtent*)malloc(sizeof(FreeExtent));
+    if (!manager->spare) {
+        LOG_ERR("Failed to allocate free extent node.");
+        return -1;
     }
-    return node;
+    return 0;
+}
+
+static void free_extent_destroy_tree(FreeExtent* root) {
+    if (!root) return;
+    free_extent_destroy_tree(root->child[EXTENT_BY_ADDR][0]);
+    free_extent_destroy_tree(root->child[EXTENT_BY_ADDR][1]);
+    free(root);
 }
 
-static void remove_node_from_list(FreeSpaceManager* manager, FreeSegmentNode* node) {
-    if (node->prev) node->prev->next = node->next;
-    else            manager->head    = node->next;
+// 占用单元区间 [first, first + count) (须持有锁)：荒野之下的部分必须整体空闲
+static int range_claim(FreeSpaceManager* manager, uint64_t first, uint64_t count) {
+    if (free_extent_prepare_spare(manager) != 0) return -1;
+
+    uint64_t end  = first + count;
+    uint64_t wild = __atomic_load_n(&manager->wild, __ATOMIC_ACQUIRE);
+    for (;;) {
+        // 空闲集合的表示唯一，整体空闲的对齐块必定落在某个空闲伙伴块内
+        uint64_t recycled_end = (end < wild) ? end : wild;
+        if (first < recycled_end &&
+            space_bitmap_find_clear(&manager->units, first, recycled_end - first) < recycled_end) {
+            return -1;
+        }
+        if (end <= wild) break;
+
+        // 区间伸入荒野：推进荒野起点 (与无锁切分竞争，失败则按新的起点重新检查)
+        if (__atomic_compare_exchange_n(&manager->wild, &wild, end, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+    }
 
-    if (node->next) node->next->prev = node->prev;
-    else            manager->tail    = node->prev;
+    if (end > wild && first >= wild) {
+        // 整体取自荒野：越过的空隙转入回收空间
+        if (first > wild) range_release(manager, wild, first - wild);
+    } else {
+        // 落在回收空间 (或跨越原荒野起点)：占用其中的部分
+        range_reserve(manager, first, ((end < wild) ? end : wild) - first);
+    }
+    return 0;
+}
 
-    node->prev = NULL;
-    node->next = NULL;
+// 从第 i 个区间起合并首尾相接的区间 (区间已校验)，返回下一段的起始下标
+static size_t range_next_run(const FreeSpaceManager* manager, const uint64_t* offsets, const uint64_t* sizes,
+                             size_t i, size_t count, uint64_t* out_first, uint64_t* out_count) {
+    uint64_t first, units;
+    range_to_units(manager, offsets[i], sizes[i], &first, &units);
+    uint64_t end = first + units;
+
+    for (++i; i < count; ++i) {
+        uint64_t next_first, next_units;
+        range_to_units(manager, offsets[i], sizes[i], &next_first, &next_units);
+        if (next_first != end) break;
+        end += next_units;
+    }
+    *out_first = first;
+    *out_count = end - first;
+    return i;
 }
 
-static void insert_node_into_list(FreeSpaceManager* manager, FreeSegmentNode* new_node, 
-                                  FreeSegmentNode* prev, FreeSegmentNode* next) {
-    new_node->prev = prev;
-    new_node->next = next;
+// 把字节区间换算为单元区间，要求单元对齐且不越界
+static bool range_to_units(const FreeSpaceManager* manager, uint64_t offset, uint64_t size,
+                           uint64_t* out_first, uint64_t* out_count) {
+    if (offset < manager->start_offset) return false;
+    uint64_t rel = offset - manager->start_offset;
+    if (rel % NVM_SPAN_UNIT != 0 || size % NVM_SPAN_UNIT != 0) return false;
 
-    if (prev) prev->next     = new_node;
-    else      manager->head  = new_node;
+    uint64_t first = rel / NVM_SPAN_UNIT;
+    uint64_t count = size / NVM_SPAN_UNIT;
+    if (first >= manager->unit_count || count > manager->unit_count - first) return false;
 
-    if (next) next->prev     = new_node;
-    else      manager->tail  = new_node;
-}
\ No newline at end of file
+    *out_first = first;
+    *out_count = count;
+    return true;
+}
@@ -22,7 +22,7 @@ typedef struct SlabHashTable {
     nvm_rwlock_t   lock;         // 读写锁
 } SlabHashTable;
 
-#define CHECK_BIT(bitmap, idx) ((bitmap)[(idx) / 8] & (1 << ((idx) % 8)))
+#define CHECK_BIT(bitmap, idx) ((bitmap)[(idx) / 64] & (1ULL << ((idx) % 64)))
 
 
 // ============================================================================
@@ -292,8 +292,8 @@ void slab_hashtable_print_layout(SlabHashTable* table, void* base_addr, bool ver
 // ============================================================================
 
 static uint32_t hash_function(const SlabHashTable* table, uint64_t key) {
-    // 偏移量是 SLAB_SIZE 对齐的，除以 SLAB_SIZE 得到索引以增加离散度
-    uint64_t index = key / NVM_SLAB_SIZE;
+    // 偏移量按 NVM_SPAN_UNIT 对齐，除以单元大小得到索引以增加离散度
+    uint64_t index = key / NVM_SPAN_UNIT;
     return index % table->capacity;
 }
 
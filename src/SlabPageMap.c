@@ -0,0 +1,235 @@
+#include "SlabPageMap.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+// ============================================================================
+//                          核心数据结构
+// ============================================================================
+
+#define PAGEMAP_LEAF_ENTRIES  (1u << SLAB_PAGEMAP_LEAF_BITS)
+#define PAGEMAP_LEAF_MASK     (PAGEMAP_LEAF_ENTRIES - 1)
+
+// 表项最低位：0 = NvmSlab*，1 = NvmExtent* (两者均由 malloc 分配，至少 8 字节对齐)
+#define PAGEMAP_TAG_SLAB      ((uintptr_t)0)
+#define PAGEMAP_TAG_EXTENT    ((uintptr_t)1)
+#define PAGEMAP_TAG_MASK      ((uintptr_t)1)
+
+// 叶子：连续 PAGEMAP_LEAF_ENTRIES 个页的元数据指针 (带类型标记)
+typedef struct SlabPageMapLeaf {
+    uintptr_t entries[PAGEMAP_LEAF_ENTRIES];
+} SlabPageMapLeaf;
+
+// 页映射表
+typedef struct SlabPageMap {
+    uint64_t          nvm_start_offset;   // 起始偏移
+    uint64_t          page_count;         // 可映射的页数
+    uint32_t          root_count;         // 根数组长度
+    uint32_t          count;              // 已映射的页数 (原子更新)
+    SlabPageMapLeaf** root;               // 根数组 (元素原子访问)
+} SlabPageMap;
+
+// ============================================================================
+//                          内部函数前向声明
+// ============================================================================
+
+static int              offset_to_page(const SlabPageMap* map, uint64_t nvm_offset, uint64_t* out_page);
+static SlabPageMapLeaf* get_or_create_leaf(SlabPageMap* map, uint64_t page);
+static int              pagemap_insert_entry(SlabPageMap* map, uint64_t nvm_offset, uint64_t size, uintptr_t entry);
+static uintptr_t        pagemap_lookup_entry(const SlabPageMap* map, uint64_t nvm_offset);
+static uintptr_t        pagemap_remove_entry(SlabPageMap* map, uint64_t nvm_offset, uint64_t size, uintptr_t tag);
+static void             pagemap_clear_pages(SlabPageMap* map, uint64_t page, uint64_t pages, uintptr_t entry);
+
+// ============================================================================
+//                          公共 API 实现
+// ============================================================================
+
+SlabPageMap* slab_pagemap_create(uint64_t total_nvm_size, uint64_t nvm_start_offset) {
+    uint64_t page_count = total_nvm_size / NVM_SPAN_UNIT;
+    if (page_count == 0) {
+        LOG_ERR("Total size (%llu) smaller than span unit.", (unsigned long long)total_nvm_size);
+        return NULL;
+    }
+
+    SlabPageMap* map = (SlabPageMap*)malloc(sizeof(SlabPageMap));
+    if (!map) {
+        LOG_ERR("Failed to allocate page map struct.");
+        return NULL;
+    }
+
+    map->nvm_start_offset = nvm_start_offset;
+    map->page_count       = page_count;
+    map->root_count       = (uint32_t)((page_count + PAGEMAP_LEAF_ENTRIES - 1) >> SLAB_PAGEMAP_LEAF_BITS);
+    map->count            = 0;
+
+    map->root = (SlabPageMapLeaf**)calloc(map->root_count, sizeof(SlabPageMapLeaf*));
+    if (!map->root) {
+        LOG_ERR("Failed to allocate page map root.");
+        free(map);
+        return NULL;
+    }
+
+    return map;
+}
+
+void slab_pagemap_destroy(SlabPageMap* map) {
+    if (!map) return;
+
+    for (uint32_t i = 0; i < map->root_count; ++i) {
+        free(map->root[i]);
+    }
+    free(map->root);
+    free(map);
+}
+
+int slab_pagemap_insert(SlabPageMap* map, uint64_t nvm_offset, uint64_t size, NvmSlab* slab_ptr) {
+    if (!map || !slab_ptr) return -1;
+    return pagemap_insert_entry(map, nvm_offset, size, (uintptr_t)slab_ptr | PAGEMAP_TAG_SLAB);
+}
+
+NvmSlab* slab_pagemap_lookup(const SlabPageMap* map, uint64_t nvm_offset) {
+    if (!map) return NULL;
+
+    uintptr_t entry = pagemap_lookup_entry(map, nvm_offset);
+    if (NVM_UNLIKELY(entry & PAGEMAP_TAG_MASK)) return NULL;
+    return (NvmSlab*)entry;
+}
+
+NvmSlab* slab_pagemap_remove(SlabPageMap* map, uint64_t nvm_offset, uint64_t size) {
+    if (!map) return NULL;
+    return (NvmSlab*)pagemap_remove_entry(map, nvm_offset, size, PAGEMAP_TAG_SLAB);
+}
+
+int slab_pagemap_insert_extent(SlabPageMap* map, uint64_t nvm_offset, uint64_t size, NvmExtent* extent_ptr) {
+    if (!map || !extent_ptr) return -1;
+    return pagemap_insert_entry(map, nvm_offset, size, (uintptr_t)extent_ptr | PAGEMAP_TAG_EXTENT);
+}
+
+NvmExtent* slab_pagemap_lookup_extent(const SlabPageMap* map, uint64_t nvm_offset) {
+    if (!map) return NULL;
+
+    uintptr_t entry = pagemap_lookup_entry(map, nvm_offset);
+    if (!(entry & PAGEMAP_TAG_MASK)) return NULL;
+    return (NvmExtent*)(entry & ~PAGEMAP_TAG_MASK);
+}
+
+NvmExtent* slab_pagemap_remove_extent(SlabPageMap* map, uint64_t nvm_offset, uint64_t size) {
+    if (!map) return NULL;
+
+    uintptr_t entry = pagemap_remove_entry(map, nvm_offset, size, PAGEMAP_TAG_EXTENT);
+    return (NvmExtent*)(entry & ~PAGEMAP_TAG_MASK);
+}
+
+uint32_t slab_pagemap_count(const SlabPageMap* map) {
+    if (!map) return 0;
+    return __atomic_load_n(&map->count, __ATOMIC_RELAXED);
+}
+
+// ============================================================================
+//                          内部函数实现
+// ============================================================================
+
+static int offset_to_page(const SlabPageMap* map, uint64_t nvm_offset, uint64_t* out_page) {
+    if (nvm_offset < map->nvm_start_offset) return -1;
+
+    uint64_t page = (nvm_offset - map->nvm_start_offset) / NVM_SPAN_UNIT;
+    if (page >= map->page_count) return -1;
+
+    *out_page = page;
+    return 0;
+}
+
+// 将 [nvm_offset, nvm_offset + size) 覆盖的每个页都指向 entry
+// 任一页已被占用时撤销本次已发布的页，整体失败
+static int pagemap_insert_entry(SlabPageMap* map, uint64_t nvm_offset, uint64_t size, uintptr_t entry) {
+    uint64_t page;
+    uint64_t pages = size / NVM_SPAN_UNIT;
+    if (pages == 0 || size % NVM_SPAN_UNIT != 0 || offset_to_page(map, nvm_offset, &page) != 0 ||
+        page + pages > map->page_count) {
+        LOG_ERR("Range [%llu, +%llu) out of page map range.",
+                (unsigned long long)nvm_offset, (unsigned long long)size);
+        return -1;
+    }
+
+    for (uint64_t i = 0; i < pages; ++i) {
+        SlabPageMapLeaf* leaf = get_or_create_leaf(map, page + i);
+
+        // 发布：Release 保证读者看到已初始化完毕的元数据
+        uintptr_t expected = 0;
+        if (!leaf || !__atomic_compare_exchange_n(&leaf->entries[(page + i) & PAGEMAP_LEAF_MASK], &expected, entry,
+                                                  false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            if (leaf) LOG_ERR("Page %llu already mapped.", (unsigned long long)(page + i));
+            pagemap_clear_pages(map, page, i, entry);
+            return -1;
+        }
+        __atomic_fetch_add(&map->count, 1, __ATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+static uintptr_t pagemap_lookup_entry(const SlabPageMap* map, uint64_t nvm_offset) {
+    uint64_t page;
+    if (NVM_UNLIKELY(offset_to_page(map, nvm_offset, &page) != 0)) return 0;
+
+    SlabPageMapLeaf* leaf = __atomic_load_n(&map->root[page >> SLAB_PAGEMAP_LEAF_BITS], __ATOMIC_ACQUIRE);
+    if (NVM_UNLIKELY(!leaf)) return 0;
+
+    return __atomic_load_n(&leaf->entries[page & PAGEMAP_LEAF_MASK], __ATOMIC_ACQUIRE);
+}
+
+// 仅当首页表项类型与 tag 一致时撤销整段，返回原表项 (含标记)；否则返回 0
+// 后续页只清空与首页指向同一元数据的表项
+static uintptr_t pagemap_remove_entry(SlabPageMap* map, uint64_t nvm_offset, uint64_t size, uintptr_t tag) {
+    uint64_t page;
+    uint64_t pages = size / NVM_SPAN_UNIT;
+    if (pages == 0 || offset_to_page(map, nvm_offset, &page) != 0) return 0;
+    if (page + pages > map->page_count) pages = map->page_count - page;
+
+    SlabPageMapLeaf* leaf = __atomic_load_n(&map->root[page >> SLAB_PAGEMAP_LEAF_BITS], __ATOMIC_ACQUIRE);
+    if (!leaf) return 0;
+
+    // 叶子数组在映射表生命周期内不回收，撤销只需原子清空表项
+    uintptr_t* slot = &leaf->entries[page & PAGEMAP_LEAF_MASK];
+    uintptr_t old = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    do {
+        if (old == 0 || (old & PAGEMAP_TAG_MASK) != tag) return 0;
+    } while (!__atomic_compare_exchange_n(slot, &old, 0, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    __atomic_fetch_sub(&map->count, 1, __ATOMIC_RELAXED);
+    pagemap_clear_pages(map, page + 1, pages - 1, old);
+    return old;
+}
+
+// 清空 [page, page + pages) 中仍指向 entry 的表项
+static void pagemap_clear_pages(SlabPageMap* map, uint64_t page, uint64_t pages, uintptr_t entry) {
+    for (uint64_t p = page; p < page + pages; ++p) {
+        SlabPageMapLeaf* leaf = __atomic_load_n(&map->root[p >> SLAB_PAGEMAP_LEAF_BITS], __ATOMIC_ACQUIRE);
+        if (!leaf) continue;
+
+        uintptr_t expected = entry;
+        if (__atomic_compare_exchange_n(&leaf->entries[p & PAGEMAP_LEAF_MASK], &expected, 0,
+                                        false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            __atomic_fetch_sub(&map->count, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static SlabPageMapLeaf* get_or_create_leaf(SlabPageMap* map, uint64_t page) {
+    SlabPageMapLeaf** slot = &map->root[page >> SLAB_PAGEMAP_LEAF_BITS];
+
+    SlabPageMapLeaf* leaf = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (leaf) return leaf;
+
+    SlabPageMapLeaf* new_leaf = (SlabPageMapLeaf*)calloc(1, sizeof(SlabPageMapLeaf));
+    if (!new_leaf) {
+        LOG_ERR("Failed to allocate page map leaf.");
+        return NULL;
+    }
+
+    // 并发安装：CAS 失败说明其他线程已安装，丢弃自己的叶子
+    if (!__atomic_compare_exchange_n(slot, &leaf, new_leaf, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(new_leaf);
+        return leaf;
+    }
+    return new_leaf;
+}
\ No newline at end of file
@@ -5,12 +5,17 @@
 #include "NvmSlab.h"
 #include "NvmSpaceManager.h"
 #include "SlabHashTable.h"
+#include "SlabPageMap.h"
 #include "NvmAllocator.h"
 
 // 包含所有组件的实现文件
 #include "NvmSlab.c"
 #include "NvmSpaceManager.c"
 #include "SlabHashTable.c"
+#include "NvmExtent.c"
+#include "NvmLog.c"
+#include "NvmLayout.c"
+#include "SlabPageMap.c"
 #include "NvmAllocator.c"
 
 #include <stdlib.h>
@@ -19,6 +24,8 @@
 
 #define MAX_BLOCK_SIZE 4096
 #define TOTAL_NVM_SIZE (10 * NVM_SLAB_SIZE)
+// 区域开头的持久元数据区不参与分配
+#define USABLE_NVM_SIZE (TOTAL_NVM_SIZE - nvm_layout_meta_size(TOTAL_NVM_SIZE))
 #define NUM_SLABS 10
 
 static void* mock_nvm_base = NULL;
@@ -31,6 +38,10 @@ void setUp(void) {
     memset(mock_nvm_base, 0, TOTAL_NVM_SIZE);
     int result = nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE);
     TEST_ASSERT_EQUAL_INT(0, result);
+    // 本文件检查 CPU 堆链表与 Slab 计数，关闭线程缓存使每次分配/释放直达 Slab，
+    // 并关闭冷类别共享，使分配直接落在 CPU 独占 Slab 上
+    nvm_thread_cache_set_enabled(false);
+    nvm_allocator_set_promote_threshold(0);
 }
 
 void tearDown(void) {
@@ -42,12 +53,14 @@ void tearDown(void) {
 // ... (test_allocator_lifecycle 保持不变) ...
 void test_allocator_lifecycle(void) {
     TEST_ASSERT_NOT_NULL(global_nvm_allocator);
-    TEST_ASSERT_EQUAL_PTR(mock_nvm_base, global_nvm_allocator->central_heap.nvm_base_addr);
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->central_heap.space_manager);
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->central_heap.slab_lookup_table);
-    TEST_ASSERT_EQUAL_UINT64(TOTAL_NVM_SIZE, global_nvm_allocator->central_heap.space_manager->head->size);
+    TEST_ASSERT_EQUAL_PTR(mock_nvm_base, global_nvm_allocator->central_heaps[0].nvm_base_addr);
+    TEST_ASSERT_NOT_NULL(global_nvm_allocator->central_heaps[0].space_manager);
+    TEST_ASSERT_NOT_NULL(global_nvm_allocator->central_heaps[0].slab_lookup_table);
+    TEST_ASSERT_EQUAL_UINT64(USABLE_NVM_SIZE, space_manager_free_bytes(global_nvm_allocator->central_heaps[0].space_manager));
     for (int i = 0; i < SC_COUNT; ++i) {
-        TEST_ASSERT_NULL(global_nvm_allocator->cpu_heaps[0].slab_lists[i]);
+        for (int j = 0; j < SLAB_LIST_COUNT; ++j) {
+            TEST_ASSERT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[i][j]);
+        }
     }
 
     nvm_allocator_destroy(); 
@@ -62,37 +75,39 @@ void test_allocator_lifecycle(void) {
 void test_basic_malloc_and_free(void) {
     void* ptr = nvm_malloc(30);
     TEST_ASSERT_NOT_NULL(ptr);
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0].slab_lists[SC_32B]); // 这里的[0]现在安全了
-    TEST_ASSERT_EQUAL_UINT32(1, global_nvm_allocator->central_heap.slab_lookup_table->count);
-    TEST_ASSERT_EQUAL_UINT64((NUM_SLABS - 1) * NVM_SLAB_SIZE, global_nvm_allocator->central_heap.space_manager->head->size);
+    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_32B][SLAB_LIST_PARTIAL]); // 这里的[0]现在安全了
+    TEST_ASSERT_EQUAL_UINT32(1, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
+    TEST_ASSERT_EQUAL_UINT64(USABLE_NVM_SIZE - nvm_slab_class_span_size(SC_32B), space_manager_free_bytes(global_nvm_allocator->central_heaps[0].space_manager));
 
     nvm_free(ptr);
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0].slab_lists[SC_32B]);
-    TEST_ASSERT_TRUE(nvm_slab_is_empty(global_nvm_allocator->cpu_heaps[0].slab_lists[SC_32B]));
+    // 全空后迁移到全空链表
+    TEST_ASSERT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_32B][SLAB_LIST_PARTIAL]);
+    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_32B][SLAB_LIST_EMPTY]);
+    TEST_ASSERT_TRUE(nvm_slab_is_empty(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_32B][SLAB_LIST_EMPTY]));
 }
 
 // ... (test_slab_creation_and_reuse 保持不变) ...
 void test_slab_creation_and_reuse(void) {
     void* ptr1 = nvm_malloc(60);
     TEST_ASSERT_NOT_NULL(ptr1);
-    NvmSlab* slab64_ptr = global_nvm_allocator->cpu_heaps[0].slab_lists[SC_64B];
+    NvmSlab* slab64_ptr = global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_64B][SLAB_LIST_PARTIAL];
     TEST_ASSERT_NOT_NULL(slab64_ptr);
 
     void* ptr2 = nvm_malloc(60);
     TEST_ASSERT_NOT_NULL(ptr2);
-    TEST_ASSERT_EQUAL_PTR(slab64_ptr, global_nvm_allocator->cpu_heaps[0].slab_lists[SC_64B]);
+    TEST_ASSERT_EQUAL_PTR(slab64_ptr, global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_64B][SLAB_LIST_PARTIAL]);
 
     void* ptr3 = nvm_malloc(8);
     TEST_ASSERT_NOT_NULL(ptr3);
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0].slab_lists[SC_8B]);
-    TEST_ASSERT_EQUAL_UINT32(2, global_nvm_allocator->central_heap.slab_lookup_table->count);
+    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_8B][SLAB_LIST_PARTIAL]);
+    TEST_ASSERT_EQUAL_UINT32(2, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
 }
 
 // ... (test_empty_slab_recycling 保持不变) ...
 void test_empty_slab_recycling(void) {
     size_t alloc_size = 128;
     SizeClassID sc_id = SC_128B;
-    uint32_t blocks_per_slab = NVM_SLAB_SIZE / alloc_size;
+    uint32_t blocks_per_slab = nvm_slab_class_span_size(sc_id) / alloc_size;
 
     void** ptrs = malloc(sizeof(void*) * (blocks_per_slab + 1));
     TEST_ASSERT_NOT_NULL(ptrs);
@@ -105,46 +120,952 @@ void test_empty_slab_recycling(void) {
     ptrs[blocks_per_slab] = nvm_malloc(alloc_size);
     TEST_ASSERT_NOT_NULL(ptrs[blocks_per_slab]);
     
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0].slab_lists[sc_id]->next_in_chain);
+    // 第一个 Slab 已满，第二个 Slab 部分占用
+    NvmSlab* first_slab = global_nvm_allocator->cpu_heaps[0]->slab_lists[sc_id][SLAB_LIST_FULL];
+    NvmSlab* second_slab = global_nvm_allocator->cpu_heaps[0]->slab_lists[sc_id][SLAB_LIST_PARTIAL];
+    TEST_ASSERT_NOT_NULL(first_slab);
+    TEST_ASSERT_NOT_NULL(second_slab);
+    TEST_ASSERT_NULL(first_slab->next_in_chain);
     
     for (uint32_t i = 0; i < blocks_per_slab; ++i) {
         nvm_free(ptrs[i]);
     }
 
-    NvmSlab* first_slab = global_nvm_allocator->cpu_heaps[0].slab_lists[sc_id]; 
-    TEST_ASSERT_NOT_NULL(first_slab); // 增加断言，防止NULL解引用
-    
-    NvmSlab* second_slab = first_slab->next_in_chain;                           
-    
-    TEST_ASSERT_NOT_NULL(second_slab); 
-    TEST_ASSERT_TRUE(nvm_slab_is_empty(second_slab)); 
+    // 第一个 Slab 经 满 -> 部分占用 -> 全空 迁移到全空链表
+    TEST_ASSERT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[sc_id][SLAB_LIST_FULL]);
+    TEST_ASSERT_EQUAL_PTR(first_slab, global_nvm_allocator->cpu_heaps[0]->slab_lists[sc_id][SLAB_LIST_EMPTY]);
+    TEST_ASSERT_EQUAL_PTR(second_slab, global_nvm_allocator->cpu_heaps[0]->slab_lists[sc_id][SLAB_LIST_PARTIAL]);
+    TEST_ASSERT_TRUE(nvm_slab_is_empty(first_slab)); 
     
-    TEST_ASSERT_EQUAL_UINT32(2, global_nvm_allocator->central_heap.slab_lookup_table->count);
+    TEST_ASSERT_EQUAL_UINT32(2, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
     
     nvm_free(ptrs[blocks_per_slab]);
     free(ptrs);
 }
 
-// ... (test_parameter_and_error_handling, test_nvm_space_exhaustion, test_mixed_load_and_fragmentation 保持不变) ...
+void test_slab_list_transitions(void) {
+    uint32_t blocks_per_slab = nvm_slab_class_span_size(SC_4K) / 4096;
+    NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[0];
+
+    void** ptrs = malloc(sizeof(void*) * blocks_per_slab);
+    TEST_ASSERT_NOT_NULL(ptrs);
+
+    // 1. 填满一个 Slab：满转换后部分占用链表为空
+    for (uint32_t i = 0; i < blocks_per_slab; ++i) {
+        ptrs[i] = nvm_malloc(4096);
+        TEST_ASSERT_NOT_NULL(ptrs[i]);
+    }
+    NvmSlab* slab = heap->slab_lists[SC_4K][SLAB_LIST_FULL];
+    TEST_ASSERT_NOT_NULL(slab);
+    TEST_ASSERT_NULL(heap->slab_lists[SC_4K][SLAB_LIST_PARTIAL]);
+    TEST_ASSERT_EQUAL_UINT8(SLAB_LIST_FULL, slab->list_id);
+
+    // 2. 释放一个块：非满转换，回到部分占用链表
+    nvm_free(ptrs[7]);
+    TEST_ASSERT_NULL(heap->slab_lists[SC_4K][SLAB_LIST_FULL]);
+    TEST_ASSERT_EQUAL_PTR(slab, heap->slab_lists[SC_4K][SLAB_LIST_PARTIAL]);
+    TEST_ASSERT_EQUAL_UINT8(SLAB_LIST_PARTIAL, slab->list_id);
+
+    // 3. 再次分配直接复用该 Slab，不会申请新的 Slab
+    ptrs[7] = nvm_malloc(4096);
+    TEST_ASSERT_NOT_NULL(ptrs[7]);
+    TEST_ASSERT_EQUAL_PTR(slab, heap->slab_lists[SC_4K][SLAB_LIST_FULL]);
+    TEST_ASSERT_EQUAL_UINT32(1, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
+
+    for (uint32_t i = 0; i < blocks_per_slab; ++i) {
+        nvm_free(ptrs[i]);
+    }
+    TEST_ASSERT_EQUAL_PTR(slab, heap->slab_lists[SC_4K][SLAB_LIST_EMPTY]);
+    free(ptrs);
+}
+
+void test_empty_slab_trim_and_decay(void) {
+    NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[0];
+
+    // 1. 默认衰减时间下，空 Slab 保留在全空链表中
+    void* p = nvm_malloc(64);
+    TEST_ASSERT_NOT_NULL(p);
+    nvm_free(p);
+    NvmSlab* slab = heap->slab_lists[SC_64B][SLAB_LIST_EMPTY];
+    TEST_ASSERT_NOT_NULL(slab);
+    TEST_ASSERT_EQUAL_UINT32(1, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
+
+    // 2. trim 立即归还：索引注销、空间合并回完整的空闲段，描述符进入缓存
+    TEST_ASSERT_EQUAL_UINT64(nvm_slab_class_span_size(SC_64B), nvm_malloc_trim());
+    TEST_ASSERT_NULL(heap->slab_lists[SC_64B][SLAB_LIST_EMPTY]);
+    TEST_ASSERT_EQUAL_UINT32(0, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
+    TEST_ASSERT_EQUAL_UINT64(USABLE_NVM_SIZE, space_manager_free_bytes(global_nvm_allocator->central_heaps[0].space_manager));
+    TEST_ASSERT_EQUAL_PTR(slab, global_nvm_allocator->central_heaps[0].slab_cache[SC_64B]);
+    TEST_ASSERT_EQUAL_UINT64(0, nvm_malloc_trim());
+
+    // 3. 描述符被复用，且状态已重置
+    p = nvm_malloc(64);
+    TEST_ASSERT_NOT_NULL(p);
+    TEST_ASSERT_EQUAL_PTR(slab, heap->slab_lists[SC_64B][SLAB_LIST_PARTIAL]);
+    TEST_ASSERT_EQUAL_UINT32(1, slab->allocated_block_count);
+
+    // 4. 衰减时间为 0：变空即归还
+    nvm_allocator_set_decay_ms(0);
+    nvm_free(p);
+    TEST_ASSERT_NULL(heap->slab_lists[SC_64B][SLAB_LIST_EMPTY]);
+    TEST_ASSERT_EQUAL_UINT32(0, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
+
+    // 5. 衰减时间为负：从不自动归还
+    nvm_allocator_set_decay_ms(-1);
+    p = nvm_malloc(64);
+    nvm_free(p);
+    TEST_ASSERT_NOT_NULL(heap->slab_lists[SC_64B][SLAB_LIST_EMPTY]);
+}
+
+static void* thread_cache_exit_worker(void* arg) {
+    *(void**)arg = nvm_malloc(64);
+    return NULL;
+}
+
+void test_thread_cache_fill_and_flush(void) {
+    nvm_thread_cache_set_enabled(true);
+    NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[0];
+    NvmThreadCacheBin* bin = &thread_cache.bins[SC_64B];
+
+    // 1. 首次未命中：整批回填，Slab 计数按批增长
+    void* p = nvm_malloc(64);
+    TEST_ASSERT_NOT_NULL(p);
+    NvmSlab* slab = heap->slab_lists[SC_64B][SLAB_LIST_PARTIAL];
+    TEST_ASSERT_NOT_NULL(slab);
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH - 1, bin->count);
+    // 回填时整批查出所属 Slab，分配不再按指针查找
+    for (uint32_t i = 0; i < bin->count; ++i) {
+        TEST_ASSERT_EQUAL_PTR(slab, bin->slabs[i]);
+    }
+
+    // 2. 释放后立即复用 (LIFO)，不经过 Slab；所属 Slab 随块一同入栈
+    nvm_free(p);
+    TEST_ASSERT_EQUAL_PTR(slab, bin->slabs[bin->count - 1]);
+    TEST_ASSERT_EQUAL_PTR(p, nvm_malloc(64));
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, slab->allocated_block_count);
+    nvm_free(p);
+
+    // 3. flush 后 Slab 全空
+    nvm_thread_cache_flush();
+    TEST_ASSERT_EQUAL_UINT32(0, bin->count);
+    TEST_ASSERT_EQUAL_PTR(slab, heap->slab_lists[SC_64B][SLAB_LIST_EMPTY]);
+
+    // 4. 缓存满时较旧的一半转入 CPU 缓存 (对 Slab 而言仍是已分配)
+    const int n = NVM_TCACHE_CAPACITY + 1;
+    void* ptrs[NVM_TCACHE_CAPACITY + 1];
+    for (int i = 0; i < n; ++i) {
+        ptrs[i] = nvm_malloc(64);
+        TEST_ASSERT_NOT_NULL(ptrs[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(3 * NVM_TCACHE_BATCH, slab->allocated_block_count);
+    for (int i = 0; i < n; ++i) {
+        nvm_free(ptrs[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_CAPACITY, bin->count);
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, heap->cpu_cache.counts[SC_64B]);
+    TEST_ASSERT_EQUAL_UINT32(3 * NVM_TCACHE_BATCH, slab->allocated_block_count);
+    // 溢出后剩余的块与 Slab 仍一一对应
+    TEST_ASSERT_EQUAL_PTR(ptrs[n - 1], bin->blocks[bin->count - 1]);
+    for (uint32_t i = 0; i < bin->count; ++i) {
+        TEST_ASSERT_EQUAL_PTR(slab, bin->slabs[i]);
+    }
+    nvm_thread_cache_flush();
+    // 本地归还的块可能仍在本地释放链表中，等所属堆回填时回收
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, slab->allocated_block_count - nvm_slab_local_pending(slab));
+
+    // 下一次未命中从 CPU 缓存回填，不触碰 Slab
+    p = nvm_malloc(64);
+    TEST_ASSERT_EQUAL_UINT32(0, heap->cpu_cache.counts[SC_64B]);
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH - 1, bin->count);
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, slab->allocated_block_count - nvm_slab_local_pending(slab));
+    nvm_free(p);
+    nvm_thread_cache_flush();
+    TEST_ASSERT_TRUE(nvm_slab_is_empty(slab));
+
+    // 5. 线程退出时析构回写，只剩它返回的那一块
+    void* leaked = NULL;
+    pthread_t tid;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&tid, NULL, thread_cache_exit_worker, &leaked));
+    pthread_join(tid, NULL);
+    TEST_ASSERT_NOT_NULL(leaked);
+    TEST_ASSERT_EQUAL_UINT32(1, slab->allocated_block_count - nvm_slab_local_pending(slab));
+
+    // 6. 禁用时回写
+    p = nvm_malloc(64);
+    nvm_thread_cache_set_enabled(false);
+    TEST_ASSERT_EQUAL_UINT32(2, slab->allocated_block_count - nvm_slab_local_pending(slab));
+}
+
+static void* depot_consumer_worker(void* arg) {
+    void** ptrs = (void**)arg;
+    for (int i = 0; i < 4 * NVM_TCACHE_BATCH; ++i) {
+        ptrs[i] = nvm_malloc(64);
+    }
+    return NULL;
+}
+
+void test_magazine_depot_exchange(void) {
+    nvm_thread_cache_set_enabled(true);
+    NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[0];
+    NvmDepot* depot = &global_nvm_allocator->depots[SC_64B];
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, depot->mag_size);
+
+    // 1. 生产者释放大量块：线程缓存与 CPU 缓存都满后，整批装弹匣交给仓库
+    const int n = 4 * NVM_TCACHE_CAPACITY;
+    void* ptrs[4 * NVM_TCACHE_CAPACITY];
+    for (int i = 0; i < n; ++i) {
+        ptrs[i] = nvm_malloc(64);
+        TEST_ASSERT_NOT_NULL(ptrs[i]);
+    }
+    NvmSlab* slab = heap->slab_lists[SC_64B][SLAB_LIST_PARTIAL];
+    TEST_ASSERT_NOT_NULL(slab);
+    TEST_ASSERT_EQUAL_UINT32(n, slab->allocated_block_count);
+    for (int i = 0; i < n; ++i) {
+        nvm_free(ptrs[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_CAPACITY, thread_cache.bins[SC_64B].count);
+    TEST_ASSERT_EQUAL_UINT32(NVM_CPU_CACHE_SIZE, heap->cpu_cache.counts[SC_64B]);
+    TEST_ASSERT_EQUAL_UINT32(4, depot->full_count);
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, depot->full->count);
+    TEST_ASSERT_EQUAL_UINT32(n, slab->allocated_block_count);
+
+    // 2. 消费者线程先取 CPU 缓存，再整弹匣取走仓库中的块，不触碰 Slab
+    void* taken[4 * NVM_TCACHE_BATCH];
+    pthread_t tid;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&tid, NULL, depot_consumer_worker, taken));
+    pthread_join(tid, NULL);
+    for (int i = 0; i < 4 * NVM_TCACHE_BATCH; ++i) {
+        TEST_ASSERT_NOT_NULL(taken[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, depot->full_count);
+    TEST_ASSERT_EQUAL_UINT32(n, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(1, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
+
+    // 3. 争用比例过高时弹匣大小翻倍，不超过类别块数上限
+    depot->lock_count = NVM_DEPOT_ADAPT_INTERVAL - 1;
+    depot->contended  = NVM_DEPOT_ADAPT_INTERVAL;
+    depot_acquire(depot, global_nvm_allocator->cache_limit[SC_64B]);
+    NVM_SPINLOCK_RELEASE(&depot->lock);
+    TEST_ASSERT_EQUAL_UINT32(2 * NVM_TCACHE_BATCH, depot->mag_size);
+    depot->lock_count = NVM_DEPOT_ADAPT_INTERVAL - 1;
+    depot->contended  = NVM_DEPOT_ADAPT_INTERVAL;
+    depot_acquire(depot, global_nvm_allocator->cache_limit[SC_64B]);
+    NVM_SPINLOCK_RELEASE(&depot->lock);
+    TEST_ASSERT_EQUAL_UINT32(global_nvm_allocator->cache_limit[SC_64B], depot->mag_size);
+    TEST_ASSERT_EQUAL_UINT32(0, depot->lock_count);
+
+    // 4. trim 排空仓库，所有块回到 Slab 后整个 Slab 被归还
+    for (int i = 0; i < 4 * NVM_TCACHE_BATCH; ++i) {
+        nvm_free(taken[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT64(nvm_slab_class_span_size(SC_64B), nvm_malloc_trim());
+    TEST_ASSERT_EQUAL_UINT32(0, depot->full_count);
+    TEST_ASSERT_NULL(depot->full);
+    TEST_ASSERT_NULL(depot->empty);
+    TEST_ASSERT_EQUAL_UINT32(0, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
+
+    nvm_thread_cache_set_enabled(false);
+}
+
+void test_cpu_heaps_sized_from_topology(void) {
+    // 每个可能存在的 CPU 独占一个堆，CPU ID 直接作为下标，不取模
+    TEST_ASSERT_EQUAL_UINT32(nvm_numa_possible_cpus(), global_nvm_allocator->cpu_count);
+    TEST_ASSERT_TRUE(global_nvm_allocator->cpu_count >= 1);
+    for (uint32_t i = 0; i < global_nvm_allocator->cpu_count; ++i) {
+        NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[i];
+        TEST_ASSERT_NOT_NULL(heap);
+        // 节点本地分配按页对齐，至少满足缓存行对齐
+        TEST_ASSERT_EQUAL_UINT64(0, (uintptr_t)heap % CACHE_LINE_SIZE);
+        for (uint32_t j = 0; j < i; ++j) {
+            TEST_ASSERT_TRUE(heap != global_nvm_allocator->cpu_heaps[j]);
+        }
+    }
+    TEST_ASSERT_TRUE((uint32_t)nvm_get_current_cpu_id() < global_nvm_allocator->cpu_count);
+    TEST_ASSERT_TRUE(nvm_numa_node_of_cpu(0) >= 0);
+}
+
+static bool ptr_in_region(const void* p, const NvmNodeRegion* region) {
+    return (const char*)p >= (const char*)region->base_addr &&
+           (const char*)p <  (const char*)region->base_addr + region->size_bytes;
+}
+
+void test_numa_regions_local_first(void) {
+    nvm_allocator_destroy();
+    // 重新划分区域：清除整个缓冲区原有的持久布局，各区域重新格式化
+    memset(mock_nvm_base, 0, TOTAL_NVM_SIZE);
+
+    // 模拟 NVM 前 4 个 Slab 属于 CPU 0 所在节点，其余属于另一个 (远端) 节点
+    // 远端区域故意排在前面，验证回退顺序由距离而非注册顺序决定
+    int local = nvm_numa_node_of_cpu(0);
+    int remote = local + 1;
+    NvmNodeRegion regions[2] = {
+        { remote, (char*)mock_nvm_base + 4 * NVM_SLAB_SIZE, TOTAL_NVM_SIZE - 4 * NVM_SLAB_SIZE },
+        { local,  mock_nvm_base,                            4 * NVM_SLAB_SIZE },
+    };
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create_numa(regions, 2));
+
+    NvmAllocator* allocator = global_nvm_allocator;
+    TEST_ASSERT_EQUAL_UINT32(2, allocator->region_count);
+    TEST_ASSERT_TRUE(allocator->node_count > (uint32_t)remote);
+    TEST_ASSERT_EQUAL_UINT16(1, allocator->cpu_heaps[0]->region_order[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, allocator->cpu_heaps[0]->region_order[1]);
+    TEST_ASSERT_EQUAL_UINT16(0, allocator->node_heaps[remote]->region_order[0]);
+    TEST_ASSERT_EQUAL_UINT16(1, allocator->node_heaps[remote]->region_order[1]);
+
+    // 1. 节点分配：各自落在本节点的区域，由节点堆持有
+    void* on_remote = nvm_malloc_node(64, remote);
+    void* on_local  = nvm_malloc_node(64, local);
+    TEST_ASSERT_TRUE(ptr_in_region(on_remote, &regions[0]));
+    TEST_ASSERT_TRUE(ptr_in_region(on_local, &regions[1]));
+    NvmSlab* slab = allocator->node_heaps[remote]->slab_lists[SC_64B][SLAB_LIST_PARTIAL];
+    TEST_ASSERT_NOT_NULL(slab);
+    TEST_ASSERT_EQUAL_UINT16(0, slab->region_id);
+    TEST_ASSERT_EQUAL_PTR(allocator->node_heaps[remote], slab->owner_heap);
+
+    TEST_ASSERT_NULL(nvm_malloc_node(64, -1));
+    TEST_ASSERT_NULL(nvm_malloc_node(64, (int)allocator->node_count));
+
+    // 2. CPU 堆先耗尽本地区域，再回退到远端区域
+    // 本地 8MB：元数据区之后是 64B Slab，8K 类别的 2MB 跨度对齐到 [2M, 4M)，
+    // 12K 类别的 4MB 跨度占满 [4M, 8M)，16K 类别已无 4MB 对齐的空间
+    const size_t sizes[3] = { 8192, 12288, 16384 };
+    void* p[3];
+    for (int i = 0; i < 3; ++i) {
+        p[i] = nvm_malloc(sizes[i]);
+        TEST_ASSERT_NOT_NULL(p[i]);
+    }
+    TEST_ASSERT_TRUE(ptr_in_region(p[0], &regions[1]));
+    TEST_ASSERT_TRUE(ptr_in_region(p[1], &regions[1]));
+    TEST_ASSERT_TRUE(ptr_in_region(p[2], &regions[0]));
+    TEST_ASSERT_EQUAL_UINT64(NVM_SLAB_SIZE - nvm_layout_meta_size(regions[1].size_bytes) - nvm_slab_class_span_size(SC_64B),
+                             space_manager_free_bytes(allocator->central_heaps[1].space_manager));
+
+    // 3. 跨区域释放后全部归还，两个区域各自恢复完整
+    nvm_free(on_remote);
+    nvm_free(on_local);
+    for (int i = 0; i < 3; ++i) nvm_free(p[i]);
+    TEST_ASSERT_EQUAL_size_t(2 * nvm_slab_class_span_size(SC_64B) + nvm_slab_class_span_size(SC_8K) +
+                             2 * nvm_slab_class_span_size(SC_12K), nvm_malloc_trim());
+    for (int i = 0; i < 2; ++i) {
+        TEST_ASSERT_EQUAL_UINT64(regions[i].size_bytes - nvm_layout_meta_size(regions[i].size_bytes),
+                                 space_manager_free_bytes(allocator->central_heaps[i].space_manager));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, allocator->central_heaps[0].slab_lookup_table->count);
+    TEST_ASSERT_EQUAL_UINT32(0, allocator->central_heaps[1].slab_lookup_table->count);
+}
+
+void test_remote_free_batched_reclaim(void) {
+    // 节点堆持有的 Slab 不属于任何 CPU 堆，当前线程对其释放即为远程释放
+    NvmCpuHeap* owner = global_nvm_allocator->node_heaps[0];
+    void* blocks[256];
+    for (int i = 0; i < 256; ++i) {
+        blocks[i] = nvm_malloc_node(4096, 0);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+    }
+    NvmSlab* slab = owner->slab_lists[SC_4K][SLAB_LIST_FULL];
+    TEST_ASSERT_NOT_NULL(slab);
+    TEST_ASSERT_EQUAL_PTR(owner, slab->owner_heap);
+
+    // 1. 已满 Slab 收到远程释放：释放者在所属堆锁内回收，Slab 回到部分占用链表
+    nvm_free(blocks[7]);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_remote_pending(slab));
+    TEST_ASSERT_EQUAL_UINT32(255, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_PTR(slab, owner->slab_lists[SC_4K][SLAB_LIST_PARTIAL]);
+
+    // 2. 部分占用 Slab 的远程释放只压链表，不加锁、不迁移
+    nvm_free(blocks[8]);
+    nvm_free(blocks[9]);
+    TEST_ASSERT_EQUAL_UINT32(2, nvm_slab_remote_pending(slab));
+    TEST_ASSERT_EQUAL_UINT32(255, slab->allocated_block_count);
+
+    // 3. 所属堆分配到 Slab 变满时批量回收整条链表
+    void* again = nvm_malloc_node(4096, 0);
+    TEST_ASSERT_NOT_NULL(again);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_remote_pending(slab));
+    TEST_ASSERT_EQUAL_UINT32(254, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_PTR(slab, owner->slab_lists[SC_4K][SLAB_LIST_PARTIAL]);
+    TEST_ASSERT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_4K][SLAB_LIST_PARTIAL]);
+
+    // 4. 全部已分配块都进入远程链表时，Slab 立即被回收并移入全空链表
+    blocks[7] = again;
+    blocks[8] = blocks[9] = NULL;
+    for (int i = 0; i < 256; ++i) {
+        if (blocks[i]) nvm_free(blocks[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_remote_pending(slab));
+    TEST_ASSERT_TRUE(nvm_slab_is_empty(slab));
+    TEST_ASSERT_EQUAL_PTR(slab, owner->slab_lists[SC_4K][SLAB_LIST_EMPTY]);
+    TEST_ASSERT_EQUAL_UINT64(nvm_slab_class_span_size(SC_4K), nvm_malloc_trim());
+}
+
+void test_local_free_drained_across_cpus(void) {
+#ifdef NVM_HAVE_RSEQ
+    // 主线程绑定在 CPU 0；把 cpu_heaps[0] 暂时换成节点堆，即可模拟"不在所属 CPU 上"
+    if (nvm_rseq_cpu_id() != 0 || !global_nvm_allocator->rseq_enabled) return;
+    NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[0];
+    NvmCpuHeap* other = global_nvm_allocator->node_heaps[0];
+    uint32_t total = nvm_slab_class_span_size(SC_4K) / 4096;
+    void* blocks[256];
+    TEST_ASSERT_EQUAL_UINT32(total, heap_alloc_blocks(global_nvm_allocator, heap, SC_4K, blocks, total));
+    NvmSlab* slab = heap_slab_of(global_nvm_allocator, blocks[0]);
+    TEST_ASSERT_NOT_NULL(slab);
+
+    // 1. 所属 CPU 上的释放进入本地释放链表；trim 在别的 CPU 上运行时也能回收
+    for (uint32_t i = 0; i < total / 2; ++i) heap_free_ptr(global_nvm_allocator, blocks[i]);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, nvm_slab_local_pending(slab));
+    global_nvm_allocator->cpu_heaps[0] = other;
+    heap_trim(global_nvm_allocator, heap);
+    global_nvm_allocator->cpu_heaps[0] = heap;
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_local_pending(slab));
+    TEST_ASSERT_EQUAL_UINT32(total - total / 2, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT8(SLAB_LIST_PARTIAL, slab->list_id);
+
+    // 2. 其余块除最后一个外在所属 CPU 上释放，最后一个远程释放：
+    //    全空判断计入本地链表，远程释放者跨 CPU 回收后 Slab 移入全空链表
+    for (uint32_t i = total / 2; i < total - 1; ++i) heap_free_ptr(global_nvm_allocator, blocks[i]);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, nvm_slab_local_pending(slab));
+    global_nvm_allocator->cpu_heaps[0] = other;
+    heap_free_ptr(global_nvm_allocator, blocks[total - 1]);
+    global_nvm_allocator->cpu_heaps[0] = heap;
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_local_pending(slab));
+    TEST_ASSERT_TRUE(nvm_slab_is_empty(slab));
+    TEST_ASSERT_EQUAL_PTR(slab, heap->slab_lists[SC_4K][SLAB_LIST_EMPTY]);
+    TEST_ASSERT_EQUAL_UINT64(nvm_slab_class_span_size(SC_4K), nvm_malloc_trim());
+#endif
+}
+
+void test_cpu_cache_rseq_and_drain(void) {
+    NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[0];
+    NvmCpuCache* cache = &heap->cpu_cache;
+
+    // 1. CPU ID 取自 rseq 区域 (若可用)，与内核视图一致
+    TEST_ASSERT_EQUAL_INT(sched_getcpu(), nvm_get_current_cpu_id());
+#ifdef NVM_HAVE_RSEQ
+    if (nvm_rseq_cpu_id() >= 0) {
+        TEST_ASSERT_TRUE(global_nvm_allocator->rseq_enabled);
+
+        // 可重启序列：栈满/栈空/停用时返回 MISS
+        uint32_t stopped = 0, count = 0;
+        void* slots[2];
+        void* out = NULL;
+        TEST_ASSERT_EQUAL_INT(NVM_RSEQ_MISS, nvm_rseq_percpu_pop(0, &stopped, &count, slots, &out));
+        TEST_ASSERT_EQUAL_INT(NVM_RSEQ_OK, nvm_rseq_percpu_push(0, &stopped, &count, slots, 2, (void*)0x10));
+        TEST_ASSERT_EQUAL_INT(NVM_RSEQ_OK, nvm_rseq_percpu_push(0, &stopped, &count, slots, 2, (void*)0x20));
+        TEST_ASSERT_EQUAL_INT(NVM_RSEQ_MISS, nvm_rseq_percpu_push(0, &stopped, &count, slots, 2, (void*)0x30));
+        TEST_ASSERT_EQUAL_UINT32(2, count);
+        TEST_ASSERT_EQUAL_INT(NVM_RSEQ_OK, nvm_rseq_percpu_pop(0, &stopped, &count, slots, &out));
+        TEST_ASSERT_EQUAL_PTR((void*)0x20, out);
+        stopped = 1;
+        TEST_ASSERT_EQUAL_INT(NVM_RSEQ_MISS, nvm_rseq_percpu_pop(0, &stopped, &count, slots, &out));
+        TEST_ASSERT_EQUAL_UINT32(1, count);
+
+        // 被加锁路径停用的缓存由本 CPU 的 rseq 线程重新开放，rseq 压入照常成功
+        for (uint32_t i = 0; i < global_nvm_allocator->cpu_count; ++i) {
+            global_nvm_allocator->cpu_heaps[i]->cpu_cache.stopped = CPU_CACHE_STOPPED;
+        }
+        void* block = NULL;
+        TEST_ASSERT_EQUAL_UINT32(1, heap_alloc_blocks(global_nvm_allocator, heap, SC_128B, &block, 1));
+        TEST_ASSERT_EQUAL_UINT32(1, cpu_cache_push_batch(global_nvm_allocator, SC_128B, &block, 1));
+        void* popped = NULL;
+        TEST_ASSERT_EQUAL_UINT32(1, cpu_cache_pop_batch(global_nvm_allocator, SC_128B, &popped, 1));
+        TEST_ASSERT_EQUAL_PTR(block, popped);
+        for (uint32_t i = 0; i < global_nvm_allocator->cpu_count; ++i) {
+            global_nvm_allocator->cpu_heaps[i]->cpu_cache.stopped = CPU_CACHE_OPEN;
+        }
+        heap_free_ptr(global_nvm_allocator, popped);
+    }
+#endif
+
+    // 2. 压入 CPU 缓存的块在 trim 时被排空并归还，随后整个 Slab 被释放
+    void* blocks[NVM_TCACHE_BATCH];
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, heap_alloc_blocks(global_nvm_allocator, heap, SC_128B, blocks, NVM_TCACHE_BATCH));
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, cpu_cache_push_batch(global_nvm_allocator, SC_128B, blocks, NVM_TCACHE_BATCH));
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, cache->counts[SC_128B]);
+    TEST_ASSERT_NOT_NULL(heap->slab_lists[SC_128B][SLAB_LIST_PARTIAL]);
+
+    TEST_ASSERT_EQUAL_UINT64(nvm_slab_class_span_size(SC_128B), nvm_malloc_trim());
+    TEST_ASSERT_EQUAL_UINT32(0, cache->counts[SC_128B]);
+    TEST_ASSERT_EQUAL_UINT32(0, cache->stopped);
+    TEST_ASSERT_EQUAL_UINT32(0, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
+
+    // 3. rseq 模式下本线程未注册 rseq (CPU ID 读不到) 时改走加锁路径，CPU 缓存照常可用
+    if (nvm_rseq_cpu_id() < 0) {
+        bool saved = global_nvm_allocator->rseq_enabled;
+        global_nvm_allocator->rseq_enabled = true;
+        NvmCpuCache* local = &global_nvm_allocator->cpu_heaps[current_cpu_index(global_nvm_allocator)]->cpu_cache;
+        TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, heap_alloc_blocks(global_nvm_allocator, heap, SC_128B, blocks, NVM_TCACHE_BATCH));
+        TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, cpu_cache_push_batch(global_nvm_allocator, SC_128B, blocks, NVM_TCACHE_BATCH));
+        TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, local->counts[SC_128B]);
+        // 加锁路径停用缓存后保持停用，后续加锁操作不再执行栅栏
+        TEST_ASSERT_EQUAL_UINT32(CPU_CACHE_STOPPED, local->stopped);
+        void* back[NVM_TCACHE_BATCH];
+        TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_BATCH, cpu_cache_pop_batch(global_nvm_allocator, SC_128B, back, NVM_TCACHE_BATCH));
+        TEST_ASSERT_EQUAL_PTR(blocks[0], back[NVM_TCACHE_BATCH - 1]);
+        TEST_ASSERT_EQUAL_UINT32(0, local->counts[SC_128B]);
+        TEST_ASSERT_EQUAL_UINT32(CPU_CACHE_STOPPED, local->stopped);
+        local->stopped = CPU_CACHE_OPEN;
+        global_nvm_allocator->rseq_enabled = saved;
+        for (uint32_t i = 0; i < NVM_TCACHE_BATCH; ++i) heap_free_ptr(global_nvm_allocator, back[i]);
+    }
+}
+
+void test_attach_heap_follows_region_node(void) {
+    NvmAllocator* allocator = global_nvm_allocator;
+    NvmCentralHeap* central = &allocator->central_heaps[0];
+    uint32_t count = allocator->cpu_count;
+    int* saved = (int*)malloc(count * sizeof(int));
+    TEST_ASSERT_NOT_NULL(saved);
+    for (uint32_t i = 0; i < count; ++i) saved[i] = allocator->cpu_heaps[i]->node;
+
+    // 1. 只有偶数号 CPU 在区域所在节点上：依次轮转到这些 CPU 的堆
+    for (uint32_t i = 0; i < count; ++i) {
+        allocator->cpu_heaps[i]->node = (i % 2 == 0) ? central->node : central->node + 1;
+    }
+    central->attach_cursor = 0;
+    uint32_t local_cpus = (count + 1) / 2;
+    for (uint32_t k = 0; k < 2 * local_cpus; ++k) {
+        TEST_ASSERT_EQUAL_PTR(allocator->cpu_heaps[(k % local_cpus) * 2], central_attach_heap(allocator, central));
+    }
+
+    // 2. 节点上没有 CPU：在全部 CPU 堆之间轮转
+    for (uint32_t i = 0; i < count; ++i) allocator->cpu_heaps[i]->node = central->node + 1;
+    central->attach_cursor = 0;
+    for (uint32_t k = 0; k < 2 * count; ++k) {
+        TEST_ASSERT_EQUAL_PTR(allocator->cpu_heaps[k % count], central_attach_heap(allocator, central));
+    }
+
+    for (uint32_t i = 0; i < count; ++i) allocator->cpu_heaps[i]->node = saved[i];
+    free(saved);
+}
+
+void test_large_object_extents(void) {
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    char* base = (char*)mock_nvm_base;
+
+    // 1. 页粒度对象共享同一个区块，First-Fit 连续排列
+    char* a = nvm_malloc(600 * 1024);
+    char* b = nvm_malloc(NVM_MAX_SLAB_BLOCK_SIZE + 1);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_EQUAL_PTR(a + 600 * 1024, b);
+    NvmExtent* chunk = slab_pagemap_lookup_extent(central->slab_page_map, (uint64_t)(a - base));
+    TEST_ASSERT_NOT_NULL(chunk);
+    TEST_ASSERT_EQUAL_UINT32(1, central->extent_chunk_count);
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_PAGES - 150 - 129, chunk->free_pages);
+    TEST_ASSERT_EQUAL_PTR(chunk, central->extent_chunk_bins[chunk->max_free_run]);
+    TEST_ASSERT_NULL(slab_pagemap_lookup(central->slab_page_map, (uint64_t)(a - base)));
+
+    // 2. 超过 2MB 的对象独占按跨度单元取整的连续空间
+    char* huge = nvm_malloc(3 * NVM_SLAB_SIZE + 1);
+    TEST_ASSERT_NOT_NULL(huge);
+    huge[0] = 'h';
+    huge[3 * NVM_SLAB_SIZE + NVM_SPAN_UNIT - 1] = 'e';
+    NvmExtent* span = slab_pagemap_lookup_extent(central->slab_page_map, (uint64_t)(huge - base));
+    TEST_ASSERT_NOT_NULL(span);
+    TEST_ASSERT_EQUAL_UINT32(3 * NVM_EXTENT_CHUNK_UNITS + 1, span->span_units);
+    // 2MB + 4KB 只多占一个跨度单元，不再取整到 4MB
+    uint64_t free_before = space_manager_free_bytes(central->space_manager);
+    void* just_over = nvm_malloc(NVM_SLAB_SIZE + 4096);
+    TEST_ASSERT_NOT_NULL(just_over);
+    TEST_ASSERT_EQUAL_UINT64(free_before - NVM_SLAB_SIZE - NVM_SPAN_UNIT, space_manager_free_bytes(central->space_manager));
+    nvm_free(just_over);
+    TEST_ASSERT_EQUAL_UINT64(free_before, space_manager_free_bytes(central->space_manager));
+    TEST_ASSERT_NULL(nvm_malloc(6 * NVM_SLAB_SIZE));
+
+    // 3. Slab 对象与区块对象在页映射表中互不混淆
+    void* small = nvm_malloc(64);
+    TEST_ASSERT_NOT_NULL(small);
+    uint64_t small_off = (uint64_t)((char*)small - base);
+    TEST_ASSERT_NOT_NULL(slab_pagemap_lookup(central->slab_page_map, small_off));
+    TEST_ASSERT_NULL(slab_pagemap_lookup_extent(central->slab_page_map, small_off));
+    nvm_free(small);
+
+    // 4. 释放的页被复用；区块全空后保留到 trim
+    nvm_free(a);
+    char* c = nvm_malloc(550 * 1024);
+    TEST_ASSERT_EQUAL_PTR(a, c);
+    nvm_free(b);
+    nvm_free(c);
+    TEST_ASSERT_EQUAL_UINT32(1, central->extent_chunk_count);
+    TEST_ASSERT_TRUE(nvm_extent_is_empty(chunk));
+    TEST_ASSERT_EQUAL_PTR(chunk, central->extent_chunk_bins[NVM_EXTENT_PAGES]);
+    TEST_ASSERT_EQUAL_UINT64(NVM_SLAB_SIZE + nvm_slab_class_span_size(SC_64B), nvm_malloc_trim());
+    TEST_ASSERT_EQUAL_UINT32(0, central->extent_chunk_count);
+    TEST_ASSERT_NULL(central->extent_chunk_bins[NVM_EXTENT_PAGES]);
+
+    // 归还的描述符留待复用；无锁查到的过期指针在锁内复查后被拒绝
+    TEST_ASSERT_EQUAL_PTR(chunk, central->extent_cache);
+    central_free_extent(central, chunk, (uint64_t)(a - base));
+    TEST_ASSERT_EQUAL_PTR(chunk, central->extent_cache);
+
+    // 5. 巨型对象归还后与相邻空闲空间合并，空间恢复为一整块
+    nvm_free(huge);
+    TEST_ASSERT_NULL(central->extent_spans);
+    TEST_ASSERT_EQUAL_PTR(span, central->extent_cache);
+    TEST_ASSERT_NULL(slab_pagemap_lookup_extent(central->slab_page_map, (uint64_t)(huge - base)));
+    TEST_ASSERT_EQUAL_UINT64(USABLE_NVM_SIZE, space_manager_free_bytes(central->space_manager));
+    TEST_ASSERT_NOT_NULL(nvm_malloc(NVM_ALIGN_DOWN(USABLE_NVM_SIZE, NVM_SLAB_SIZE)));
+}
+
+/**
+ * @brief 页粒度区块按最长空闲段分箱：请求落在刚好放得下的区块，
+ *        已有区块都放不下时才切分新区块。
+ */
+void test_extent_chunk_best_fit(void) {
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    char* base = (char*)mock_nvm_base;
+    const size_t page = NVM_EXTENT_PAGE_SIZE;
+
+    // 两个区块各剩 212 页
+    char* x = nvm_malloc(300 * page);
+    char* y = nvm_malloc(300 * page);
+    TEST_ASSERT_NOT_NULL(y);
+    TEST_ASSERT_EQUAL_UINT32(2, central->extent_chunk_count);
+    NvmExtent* cx = slab_pagemap_lookup_extent(central->slab_page_map, (uint64_t)(x - base));
+    NvmExtent* cy = slab_pagemap_lookup_extent(central->slab_page_map, (uint64_t)(y - base));
+    TEST_ASSERT_NOT_EQUAL(cx, cy);
+    TEST_ASSERT_EQUAL_UINT32(212, cx->max_free_run);
+
+    // 200 页放进其中一个，剩 12 页；150 页只能放进另一个，剩 62 页
+    char* z = nvm_malloc(200 * page);
+    NvmExtent* cz = slab_pagemap_lookup_extent(central->slab_page_map, (uint64_t)(z - base));
+    NvmExtent* other = (cz == cx) ? cy : cx;
+    TEST_ASSERT_EQUAL_UINT32(12, cz->max_free_run);
+    char* w = nvm_malloc(150 * page);
+    TEST_ASSERT_EQUAL_PTR(other, slab_pagemap_lookup_extent(central->slab_page_map, (uint64_t)(w - base)));
+    TEST_ASSERT_EQUAL_UINT32(62, other->max_free_run);
+    TEST_ASSERT_EQUAL_UINT32(2, central->extent_chunk_count);
+    TEST_ASSERT_EQUAL_PTR(cz, central->extent_chunk_bins[12]);
+    TEST_ASSERT_EQUAL_PTR(other, central->extent_chunk_bins[62]);
+
+    // 都放不下：切分第三个区块
+    char* v = nvm_malloc(150 * page);
+    TEST_ASSERT_NOT_NULL(v);
+    TEST_ASSERT_EQUAL_UINT32(3, central->extent_chunk_count);
+
+    // 释放后区块换箱；全空的区块在保留至少一个的前提下立即归还
+    nvm_free(w);
+    TEST_ASSERT_EQUAL_UINT32(212, other->max_free_run);
+    TEST_ASSERT_NULL(central->extent_chunk_bins[62]);
+    nvm_free(v);
+    TEST_ASSERT_EQUAL_UINT32(2, central->extent_chunk_count);
+    nvm_free(x);
+    nvm_free(y);
+    nvm_free(z);
+    TEST_ASSERT_EQUAL_UINT32(1, central->extent_chunk_count);
+    TEST_ASSERT_NOT_NULL(central->extent_chunk_bins[NVM_EXTENT_PAGES]);
+}
+
+void test_size_class_lookup(void) {
+    // 查找表与按块大小线性查找的结果逐字节一致
+    int expected = 0;
+    for (size_t size = 1; size <= NVM_MAX_SLAB_BLOCK_SIZE; ++size) {
+        while (nvm_slab_class_block_size((SizeClassID)expected) < size) expected++;
+        TEST_ASSERT_EQUAL_INT(expected, map_size_to_sc_id(size));
+    }
+    TEST_ASSERT_EQUAL_INT(SC_COUNT, map_size_to_sc_id(NVM_MAX_SLAB_BLOCK_SIZE + 1));
+
+    // 每次翻倍 4 档：典型尺寸落在紧邻的类别
+    TEST_ASSERT_EQUAL_INT(SC_80B, map_size_to_sc_id(65));
+    TEST_ASSERT_EQUAL_INT(SC_2560B, map_size_to_sc_id(2049));
+    TEST_ASSERT_EQUAL_INT(SC_24B, map_size_to_sc_id(24));
+
+    // 32B 以上的请求，块大小与请求大小之比低于 1.25
+    for (size_t size = 33; size <= NVM_SMALL_MAX_SIZE; ++size) {
+        uint32_t block = nvm_slab_class_block_size(map_size_to_sc_id(size));
+        TEST_ASSERT_TRUE(block * 4 < size * 5);
+    }
+
+    // 中型类别同样如此
+    for (size_t size = NVM_SMALL_MAX_SIZE + 1; size <= NVM_MAX_SLAB_BLOCK_SIZE; ++size) {
+        uint32_t block = nvm_slab_class_block_size(map_size_to_sc_id(size));
+        TEST_ASSERT_TRUE(block * 4 < size * 5);
+    }
+    TEST_ASSERT_EQUAL_INT(SC_5K, map_size_to_sc_id(4097));
+    TEST_ASSERT_EQUAL_INT(SC_10K, map_size_to_sc_id(8193));
+}
+
+void test_medium_size_classes(void) {
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[0];
+    uint64_t base = (uint64_t)(uintptr_t)mock_nvm_base;
+
+    // 1. 中型对象按类别落在 CPU 堆的 Slab 中，不经过大对象区块
+    struct { size_t size; SizeClassID sc_id; uint32_t block_size; } cases[] = {
+        { 4097,        SC_5K,   5 * 1024 },
+        { 6 * 1024,    SC_6K,   6 * 1024 },
+        { 64 * 1024,   SC_64K,  64 * 1024 },
+        { 200 * 1024,  SC_224K, 224 * 1024 },
+        { 512 * 1024,  SC_512K, 512 * 1024 },
+    };
+    void* ptrs[5];
+    for (int i = 0; i < 5; ++i) {
+        TEST_ASSERT_EQUAL_INT(cases[i].sc_id, map_size_to_sc_id(cases[i].size));
+        ptrs[i] = nvm_malloc(cases[i].size);
+        TEST_ASSERT_NOT_NULL(ptrs[i]);
+        NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, (uint64_t)(uintptr_t)ptrs[i] - base);
+        TEST_ASSERT_NOT_NULL(slab);
+        TEST_ASSERT_EQUAL_UINT32(cases[i].block_size, slab->block_size);
+        TEST_ASSERT_EQUAL_PTR(heap, slab->owner_heap);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, central->extent_chunk_count);
+    TEST_ASSERT_EQUAL_UINT32(5, central->slab_lookup_table->count);
+
+    // 2. 同类别的后续分配复用本地 Slab，不再向中心堆切分
+    void* more = nvm_malloc(60 * 1024);
+    TEST_ASSERT_EQUAL_PTR((char*)ptrs[2] + 64 * 1024, more);
+    TEST_ASSERT_EQUAL_UINT32(5, central->slab_lookup_table->count);
+
+    // 3. 缓存上限按字节数收紧
+    TEST_ASSERT_EQUAL_UINT32(NVM_TCACHE_CAPACITY, global_nvm_allocator->cache_limit[SC_4K]);
+    TEST_ASSERT_EQUAL_UINT32(32, global_nvm_allocator->cache_limit[SC_8K]);
+    TEST_ASSERT_EQUAL_UINT32(4, global_nvm_allocator->cache_limit[SC_64K]);
+    TEST_ASSERT_EQUAL_UINT32(2, global_nvm_allocator->cache_limit[SC_512K]);
+
+    nvm_free(more);
+    for (int i = 0; i < 5; ++i) nvm_free(ptrs[i]);
+    TEST_ASSERT_EQUAL_UINT64(nvm_slab_class_span_size(SC_5K) + nvm_slab_class_span_size(SC_6K) + 3 * NVM_MAX_SLAB_SPAN,
+                             nvm_malloc_trim());
+}
+
+void test_per_class_slab_spans(void) {
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[0];
+    char* base = (char*)mock_nvm_base;
+
+    // 1. 小类别使用 64KB 跨度，中型类别使用 4MB 跨度，起点按跨度自然对齐
+    void* small = nvm_malloc(16);
+    void* medium = nvm_malloc(120 * 1024);
+    TEST_ASSERT_NOT_NULL(small);
+    TEST_ASSERT_NOT_NULL(medium);
+    NvmSlab* small_slab = heap->slab_lists[SC_16B][SLAB_LIST_PARTIAL];
+    NvmSlab* medium_slab = heap->slab_lists[SC_128K][SLAB_LIST_PARTIAL];
+    TEST_ASSERT_EQUAL_UINT32(NVM_SPAN_UNIT, small_slab->span_size);
+    TEST_ASSERT_EQUAL_UINT32(NVM_MAX_SLAB_SPAN, medium_slab->span_size);
+    TEST_ASSERT_EQUAL_UINT32(NVM_MAX_SLAB_SPAN / (128 * 1024), medium_slab->total_block_count);
+    TEST_ASSERT_EQUAL_UINT64(0, medium_slab->nvm_base_offset % NVM_MAX_SLAB_SPAN);
+
+    // 2. 跨多个单元的 Slab：任意单元内的偏移都解析到同一 Slab
+    for (uint64_t off = 0; off < NVM_MAX_SLAB_SPAN; off += NVM_SPAN_UNIT) {
+        TEST_ASSERT_EQUAL_PTR(medium_slab,
+                              slab_pagemap_lookup(central->slab_page_map, medium_slab->nvm_base_offset + off));
+    }
+
+    // 3. 最后一个单元中的块可以正常释放
+    void* blocks[NVM_MAX_SLAB_SPAN / (128 * 1024)];
+    uint32_t n = medium_slab->total_block_count - 1;
+    for (uint32_t i = 0; i < n; ++i) {
+        blocks[i] = nvm_malloc(128 * 1024);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+    }
+    TEST_ASSERT_TRUE(nvm_slab_is_full(medium_slab));
+    TEST_ASSERT_EQUAL_PTR(base + medium_slab->nvm_base_offset + NVM_MAX_SLAB_SPAN - 128 * 1024, blocks[n - 1]);
+    nvm_free(blocks[n - 1]);
+    TEST_ASSERT_FALSE(nvm_slab_is_full(medium_slab));
+
+    for (uint32_t i = 0; i + 1 < n; ++i) nvm_free(blocks[i]);
+    nvm_free(medium);
+    nvm_free(small);
+    TEST_ASSERT_EQUAL_UINT64(NVM_SPAN_UNIT + NVM_MAX_SLAB_SPAN, nvm_malloc_trim());
+    TEST_ASSERT_EQUAL_UINT64(USABLE_NVM_SIZE, space_manager_free_bytes(central->space_manager));
+}
+
+void test_cold_class_shared_then_promoted(void) {
+    NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[0];
+    NvmCpuHeap* shared = heap->shared_heap;
+    TEST_ASSERT_NOT_NULL(shared);
+    TEST_ASSERT_NULL(shared->shared_heap);
+    nvm_allocator_set_promote_threshold(4);
+
+    // 1. 冷类别：块来自节点的共享 Slab，CPU 堆不持有该类别的 Slab
+    void* p[6];
+    for (int i = 0; i < 3; ++i) {
+        p[i] = nvm_malloc(64);
+        TEST_ASSERT_NOT_NULL(p[i]);
+    }
+    NvmSlab* shared_slab = shared->slab_lists[SC_64B][SLAB_LIST_PARTIAL];
+    TEST_ASSERT_NOT_NULL(shared_slab);
+    TEST_ASSERT_EQUAL_PTR(shared, shared_slab->owner_heap);
+    TEST_ASSERT_EQUAL_UINT32(3, shared_slab->allocated_block_count);
+    TEST_ASSERT_NULL(heap->slab_lists[SC_64B][SLAB_LIST_PARTIAL]);
+    TEST_ASSERT_EQUAL_UINT8(0, heap->dedicated[SC_64B]);
+
+    // 2. 窗口内达到阈值后晋升，后续分配切分 CPU 独占 Slab
+    p[3] = nvm_malloc(64);
+    TEST_ASSERT_EQUAL_UINT8(1, heap->dedicated[SC_64B]);
+    p[4] = nvm_malloc(64);
+    p[5] = nvm_malloc(64);
+    NvmSlab* own_slab = heap->slab_lists[SC_64B][SLAB_LIST_PARTIAL];
+    TEST_ASSERT_NOT_NULL(own_slab);
+    TEST_ASSERT_EQUAL_PTR(heap, own_slab->owner_heap);
+    TEST_ASSERT_EQUAL_UINT32(2, own_slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(4, shared_slab->allocated_block_count);
+
+    // 3. 共享 Slab 上的块走远程释放，全部归还后两个 Slab 均可 trim；
+    //    独占 Slab 归还后该类别回到共享模式
+    for (int i = 0; i < 6; ++i) nvm_free(p[i]);
+    TEST_ASSERT_EQUAL_UINT64(2 * nvm_slab_class_span_size(SC_64B), nvm_malloc_trim());
+    TEST_ASSERT_EQUAL_UINT8(0, heap->dedicated[SC_64B]);
+    TEST_ASSERT_EQUAL_UINT32(0, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
+
+    // 4. 阈值为 0 时始终使用独占 Slab
+    nvm_allocator_set_promote_threshold(0);
+    void* q = nvm_malloc(64);
+    TEST_ASSERT_NOT_NULL(heap->slab_lists[SC_64B][SLAB_LIST_PARTIAL]);
+    TEST_ASSERT_NULL(shared->slab_lists[SC_64B][SLAB_LIST_PARTIAL]);
+    nvm_free(q);
+}
+
+void test_slab_reservation_batches(void) {
+    NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[0];
+    FreeSpaceManager* manager = global_nvm_allocator->central_heaps[0].space_manager;
+    const uint64_t span = nvm_slab_class_span_size(SC_256B);
+    const uint32_t per_slab = (uint32_t)(span / 256);
+    static void* blocks[8 * 256 + 1];
+    uint32_t n = 0;
+
+    // 1. 首个 Slab 只预留所需跨度
+    while (n < per_slab) blocks[n++] = nvm_malloc(256);
+    TEST_ASSERT_EQUAL_UINT64(USABLE_NVM_SIZE - span, space_manager_free_bytes(manager));
+    TEST_ASSERT_EQUAL_UINT64(0, heap->resv_batch);
+
+    // 2. 紧接着切分第二个 Slab：批次翻倍，多出的跨度留在堆内
+    blocks[n++] = nvm_malloc(256);
+    TEST_ASSERT_EQUAL_UINT64(2 * span, heap->resv_batch);
+    TEST_ASSERT_EQUAL_UINT64(USABLE_NVM_SIZE - 3 * span, space_manager_free_bytes(manager));
+    TEST_ASSERT_EQUAL_UINT64(span, heap->resv_end - heap->resv_next);
+
+    // 3. 第三个 Slab 在批次内切分，不触碰空间管理器
+    while (n < 2 * per_slab + 1) blocks[n++] = nvm_malloc(256);
+    TEST_ASSERT_EQUAL_UINT64(USABLE_NVM_SIZE - 3 * span, space_manager_free_bytes(manager));
+    TEST_ASSERT_EQUAL_UINT64(heap->resv_end, heap->resv_next);
+
+    // 4. 持续快速切分：批次继续翻倍，但不超过区域大小的 1/NVM_RESERVE_REGION_SHARE
+    while (n < 8 * per_slab) blocks[n++] = nvm_malloc(256);
+    for (uint32_t i = 0; i < n; ++i) TEST_ASSERT_NOT_NULL(blocks[i]);
+    TEST_ASSERT_EQUAL_UINT64(4 * span, heap->resv_batch);
+    TEST_ASSERT_TRUE(heap->resv_batch <= TOTAL_NVM_SIZE / NVM_RESERVE_REGION_SHARE);
+    TEST_ASSERT_EQUAL_UINT64(USABLE_NVM_SIZE - 11 * span, space_manager_free_bytes(manager));
+
+    // 5. trim 归还空 Slab 与未切分的预留，批次回到初始大小
+    for (uint32_t i = 0; i < n; ++i) nvm_free(blocks[i]);
+    TEST_ASSERT_EQUAL_UINT64(11 * span, nvm_malloc_trim());
+    TEST_ASSERT_EQUAL_UINT64(USABLE_NVM_SIZE, space_manager_free_bytes(manager));
+    TEST_ASSERT_EQUAL_UINT64(0, heap->resv_batch);
+}
+
+// 交替切分两种跨度不同的类别 (批次内产生对齐空隙)，全部释放后退出
+static void* reservation_refill_worker(void* arg) {
+    (void)arg;
+    static const size_t sizes[] = { 256, 12 * 1024 };
+    void* blocks[512];
+    for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < 512; ++i) blocks[i] = nvm_malloc(sizes[i % 2]);
+        for (int i = 0; i < 512; ++i) nvm_free(blocks[i]);
+    }
+    return NULL;
+}
+
+void test_slab_reservation_concurrent_refill(void) {
+    FreeSpaceManager* manager = global_nvm_allocator->central_heaps[0].space_manager;
+
+    // 多个线程同时在同一堆上重新预留：放开堆锁期间的竞争不得泄漏或重复占用空间
+    pthread_t tids[4];
+    for (int i = 0; i < 4; ++i) TEST_ASSERT_EQUAL_INT(0, pthread_create(&tids[i], NULL, reservation_refill_worker, NULL));
+    for (int i = 0; i < 4; ++i) pthread_join(tids[i], NULL);
+
+    nvm_malloc_trim();
+    TEST_ASSERT_EQUAL_UINT64(USABLE_NVM_SIZE, space_manager_free_bytes(manager));
+}
+
+// ... (test_nvm_space_exhaustion, test_mixed_load_and_fragmentation 保持不变) ...
 void test_parameter_and_error_handling(void) {
     TEST_ASSERT_NULL(nvm_malloc(0));
-    TEST_ASSERT_NULL(nvm_malloc(MAX_BLOCK_SIZE + 1));
+    // 超过最大尺寸类别的请求由区块分配
+    void* large = nvm_malloc(NVM_MAX_SLAB_BLOCK_SIZE + 1);
+    TEST_ASSERT_NOT_NULL(large);
+    nvm_free(large);
+    TEST_ASSERT_NULL(nvm_malloc(TOTAL_NVM_SIZE + 1));
     nvm_free(NULL); 
 }
 
 void test_nvm_space_exhaustion(void) {
     nvm_allocator_destroy();
     const size_t small_nvm_size = 2 * NVM_SLAB_SIZE;
+    memset(mock_nvm_base, 0, TOTAL_NVM_SIZE);
     TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, small_nvm_size));
 
     for (int i = 0; i < NVM_SLAB_SIZE / 8; ++i) nvm_malloc(8);
     for (int i = 0; i < NVM_SLAB_SIZE / 16; ++i) nvm_malloc(16);
 
-    TEST_ASSERT_NULL(global_nvm_allocator->central_heap.space_manager->head);
+    TEST_ASSERT_EQUAL_UINT64(0, space_manager_free_bytes(global_nvm_allocator->central_heaps[0].space_manager));
     TEST_ASSERT_NULL(nvm_malloc(32));
 }
 
+void test_reclaim_cached_blocks_before_oom(void) {
+    // 8MB 区域的开头是元数据区，只剩 [4M, 8M) 一个 4MB 对齐的跨度
+    nvm_allocator_destroy();
+    memset(mock_nvm_base, 0, TOTAL_NVM_SIZE);
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, 4 * NVM_SLAB_SIZE));
+    nvm_thread_cache_set_enabled(true);
+
+    // 释放的块留在线程缓存中，占住唯一 4MB 跨度的 Slab 不为空
+    nvm_free(nvm_malloc(12 * 1024));
+    TEST_ASSERT_EQUAL_UINT64(NVM_MAX_SLAB_SPAN - nvm_layout_meta_size(4 * NVM_SLAB_SIZE),
+                             space_manager_free_bytes(global_nvm_allocator->central_heaps[0].space_manager));
+
+    // 另一个 4MB 跨度的类别：先回写缓存、归还空 Slab，再重试成功
+    void* p = nvm_malloc(16 * 1024);
+    TEST_ASSERT_NOT_NULL(p);
+    NvmCpuHeap* heap = global_nvm_allocator->cpu_heaps[0];
+    TEST_ASSERT_NULL(heap->slab_lists[SC_12K][SLAB_LIST_PARTIAL]);
+    TEST_ASSERT_NULL(heap->slab_lists[SC_12K][SLAB_LIST_EMPTY]);
+
+    nvm_free(p);
+    nvm_thread_cache_set_enabled(false);
+}
+
+void test_steal_partial_slab_before_oom(void) {
+    // 8MB 区域的开头是元数据区，只剩 [4M, 8M) 一个 4MB 对齐的跨度
+    nvm_allocator_destroy();
+    memset(mock_nvm_base, 0, TOTAL_NVM_SIZE);
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, 4 * NVM_SLAB_SIZE));
+    nvm_allocator_set_promote_threshold(0);
+
+    // 节点堆的 4MB Slab 占住唯一的 4MB 跨度，只分配了一块
+    void* first = nvm_malloc_node(12 * 1024, 0);
+    TEST_ASSERT_NOT_NULL(first);
+    NvmCpuHeap* victim = global_nvm_allocator->node_heaps[0];
+    NvmSlab* slab = victim->slab_lists[SC_12K][SLAB_LIST_PARTIAL];
+    TEST_ASSERT_NOT_NULL(slab);
+
+    // 其他类别无法切分新 Slab，回收也腾不出空间
+    TEST_ASSERT_NULL(nvm_malloc(16 * 1024));
+
+    // 同类别：CPU 堆切分失败后，直接从节点堆的部分占用 Slab 分配，所有权不变
+    void* stolen = nvm_malloc(12 * 1024);
+    TEST_ASSERT_NOT_NULL(stolen);
+    TEST_ASSERT_EQUAL_PTR(slab, slab_pagemap_lookup(global_nvm_allocator->central_heaps[0].slab_page_map,
+                                                    (uint64_t)((char*)stolen - (char*)mock_nvm_base)));
+    TEST_ASSERT_EQUAL_PTR(victim, slab->owner_heap);
+    TEST_ASSERT_EQUAL_UINT32(2, slab->allocated_block_count);
+    TEST_ASSERT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_12K][SLAB_LIST_PARTIAL]);
+
+    // 窃取的块作为远程释放归还，Slab 变空后可被 trim 归还
+    nvm_free(stolen);
+    nvm_free(first);
+    TEST_ASSERT_EQUAL_UINT64(nvm_slab_class_span_size(SC_12K), nvm_malloc_trim());
+}
+
 void test_mixed_load_and_fragmentation(void) {
+    // 1 ~ 100 字节跨越 14 个尺寸类别，每个类别至少占一个 Slab
+    nvm_allocator_destroy();
+    free(mock_nvm_base);
+    const size_t mixed_nvm_size = 16 * NVM_SLAB_SIZE;
+    mock_nvm_base = calloc(1, mixed_nvm_size);
+    TEST_ASSERT_NOT_NULL(mock_nvm_base);
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, mixed_nvm_size));
+
     const int num_allocs = 1000;
     void** ptrs = malloc(sizeof(void*) * num_allocs);
     TEST_ASSERT_NOT_NULL(ptrs);
@@ -356,8 +1277,28 @@ int main(void) {
     RUN_TEST(test_basic_malloc_and_free);
     RUN_TEST(test_slab_creation_and_reuse);
     RUN_TEST(test_empty_slab_recycling);
+    RUN_TEST(test_slab_list_transitions);
+    RUN_TEST(test_empty_slab_trim_and_decay);
+    RUN_TEST(test_thread_cache_fill_and_flush);
+    RUN_TEST(test_local_free_drained_across_cpus);
+    RUN_TEST(test_cpu_cache_rseq_and_drain);
+    RUN_TEST(test_magazine_depot_exchange);
+    RUN_TEST(test_cpu_heaps_sized_from_topology);
+    RUN_TEST(test_numa_regions_local_first);
+    RUN_TEST(test_remote_free_batched_reclaim);
+    RUN_TEST(test_attach_heap_follows_region_node);
+    RUN_TEST(test_large_object_extents);
+    RUN_TEST(test_extent_chunk_best_fit);
+    RUN_TEST(test_size_class_lookup);
+    RUN_TEST(test_medium_size_classes);
+    RUN_TEST(test_per_class_slab_spans);
+    RUN_TEST(test_cold_class_shared_then_promoted);
+    RUN_TEST(test_slab_reservation_batches);
+    RUN_TEST(test_slab_reservation_concurrent_refill);
     RUN_TEST(test_parameter_and_error_handling);
     RUN_TEST(test_nvm_space_exhaustion);
+    RUN_TEST(test_reclaim_cached_blocks_before_oom);
+    RUN_TEST(test_steal_partial_slab_before_oom);
     RUN_TEST(test_mixed_load_and_fragmentation);
 
     RUN_TEST(test_debug_print_api);
@@ -19,12 +19,17 @@
 #include "NvmSlab.h"
 #include "NvmSpaceManager.h"
 #include "SlabHashTable.h"
+#include "SlabPageMap.h"
 #include "NvmAllocator.h"
 
 // 直接包含实现文件
 #include "NvmSlab.c"
 #include "NvmSpaceManager.c"
 #include "SlabHashTable.c"
+#include "NvmExtent.c"
+#include "NvmLog.c"
+#include "NvmLayout.c"
+#include "SlabPageMap.c"
 #include "NvmAllocator.c"
 
 #define _GNU_SOURCE // 为了使用 sched_setaffinity
@@ -58,6 +63,8 @@ void setUp(void) {
     
     int result = nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE);
     TEST_ASSERT_EQUAL_INT(0, result);
+    // 本文件检查 CPU 堆链表，关闭冷类别共享
+    nvm_allocator_set_promote_threshold(0);
 }
 
 void tearDown(void) {
@@ -78,6 +85,7 @@ void reinit_allocator_with_size(size_t new_size) {
     
     int result = nvm_allocator_create(mock_nvm_base, new_size);
     TEST_ASSERT_EQUAL_INT(0, result);
+    nvm_allocator_set_promote_threshold(0);
 }
 
 // ============================================================================
@@ -86,12 +94,14 @@ void reinit_allocator_with_size(size_t new_size) {
 
 void test_allocator_lifecycle(void) {
     TEST_ASSERT_NOT_NULL(global_nvm_allocator);
-    TEST_ASSERT_EQUAL_PTR(mock_nvm_base, global_nvm_allocator->central_heap.nvm_base_addr);
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->central_heap.space_manager);
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->central_heap.slab_lookup_table);
+    TEST_ASSERT_EQUAL_PTR(mock_nvm_base, global_nvm_allocator->central_heaps[0].nvm_base_addr);
+    TEST_ASSERT_NOT_NULL(global_nvm_allocator->central_heaps[0].space_manager);
+    TEST_ASSERT_NOT_NULL(global_nvm_allocator->central_heaps[0].slab_lookup_table);
     
     for (int i = 0; i < SC_COUNT; ++i) {
-        TEST_ASSERT_NULL(global_nvm_allocator->cpu_heaps[0].slab_lists[i]);
+        for (int j = 0; j < SLAB_LIST_COUNT; ++j) {
+            TEST_ASSERT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[i][j]);
+        }
     }
 
     // --- 修复开始 ---
@@ -125,33 +135,34 @@ void test_basic_malloc_and_free(void) {
     TEST_ASSERT_NOT_NULL(ptr);
     
     // 验证是否已创建对应的 Slab
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0].slab_lists[SC_32B]); 
+    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_32B][SLAB_LIST_PARTIAL]); 
     // 验证 Hash 表中是否记录了该 Slab
-    TEST_ASSERT_EQUAL_UINT32(1, global_nvm_allocator->central_heap.slab_lookup_table->count);
+    TEST_ASSERT_EQUAL_UINT32(1, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
 
     nvm_free(ptr);
+    nvm_thread_cache_flush();
     
-    // 释放后 Slab 还在，但应该是空的（或者根据策略只有1个空闲块）
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0].slab_lists[SC_32B]);
-    TEST_ASSERT_TRUE(nvm_slab_is_empty(global_nvm_allocator->cpu_heaps[0].slab_lists[SC_32B]));
+    // 释放后 Slab 还在，但应该是空的，并已迁移到全空链表
+    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_32B][SLAB_LIST_EMPTY]);
+    TEST_ASSERT_TRUE(nvm_slab_is_empty(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_32B][SLAB_LIST_EMPTY]));
 }
 
 void test_slab_creation_and_reuse(void) {
     void* ptr1 = nvm_malloc(60); // 64B
     TEST_ASSERT_NOT_NULL(ptr1);
-    NvmSlab* slab64_ptr = global_nvm_allocator->cpu_heaps[0].slab_lists[SC_64B];
+    NvmSlab* slab64_ptr = global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_64B][SLAB_LIST_PARTIAL];
     TEST_ASSERT_NOT_NULL(slab64_ptr);
 
     void* ptr2 = nvm_malloc(60); // 应该复用同一个 64B Slab
     TEST_ASSERT_NOT_NULL(ptr2);
-    TEST_ASSERT_EQUAL_PTR(slab64_ptr, global_nvm_allocator->cpu_heaps[0].slab_lists[SC_64B]);
+    TEST_ASSERT_EQUAL_PTR(slab64_ptr, global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_64B][SLAB_LIST_PARTIAL]);
 
     void* ptr3 = nvm_malloc(8); // 8B, 新的 Size Class
     TEST_ASSERT_NOT_NULL(ptr3);
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0].slab_lists[SC_8B]);
+    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_8B][SLAB_LIST_PARTIAL]);
     
     // 现在应该有 2 个 Slab 在 Hash 表中
-    TEST_ASSERT_EQUAL_UINT32(2, global_nvm_allocator->central_heap.slab_lookup_table->count);
+    TEST_ASSERT_EQUAL_UINT32(2, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
     
     nvm_free(ptr1);
     nvm_free(ptr2);
@@ -177,17 +188,23 @@ void test_empty_slab_recycling(void) {
     
     TEST_ASSERT_TRUE_MESSAGE(allocated_count > 100, "Allocation failed too early");
 
-    NvmSlab* head_slab = global_nvm_allocator->cpu_heaps[0].slab_lists[sc_id];
+    NvmSlab* head_slab = global_nvm_allocator->cpu_heaps[0]->slab_lists[sc_id][SLAB_LIST_FULL];
     TEST_ASSERT_NOT_NULL(head_slab);
     
     // 2. 全部释放
     for (int i = 0; i < allocated_count; ++i) {
         nvm_free(ptrs[i]);
     }
+    nvm_thread_cache_flush();
+    cpu_cache_drain_all(global_nvm_allocator);
+    depot_drain_all(global_nvm_allocator);
     
-    // 3. 验证头部 Slab 是否为空
-    head_slab = global_nvm_allocator->cpu_heaps[0].slab_lists[sc_id];
-    if (head_slab) {
+    // 3. 验证所有 Slab 均已迁移到全空链表
+    TEST_ASSERT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[sc_id][SLAB_LIST_FULL]);
+    TEST_ASSERT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[sc_id][SLAB_LIST_PARTIAL]);
+    head_slab = global_nvm_allocator->cpu_heaps[0]->slab_lists[sc_id][SLAB_LIST_EMPTY];
+    TEST_ASSERT_NOT_NULL(head_slab);
+    for (; head_slab; head_slab = head_slab->next_in_chain) {
         TEST_ASSERT_TRUE(nvm_slab_is_empty(head_slab));
     }
 
@@ -200,8 +217,11 @@ void test_empty_slab_recycling(void) {
 
 void test_parameter_and_error_handling(void) {
     TEST_ASSERT_NULL(nvm_malloc(0));
-    // 假设最大块限制
-    TEST_ASSERT_NULL(nvm_malloc(MAX_BLOCK_SIZE + 1));
+    // 超过最大尺寸类别的请求由区块分配，超过总空间的请求失败
+    void* large = nvm_malloc(NVM_MAX_SLAB_BLOCK_SIZE + 1);
+    TEST_ASSERT_NOT_NULL(large);
+    nvm_free(large);
+    TEST_ASSERT_NULL(nvm_malloc(TOTAL_NVM_SIZE + 1));
     // 释放 NULL 不应崩溃
     nvm_free(NULL); 
 }
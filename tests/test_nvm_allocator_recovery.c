@@ -5,12 +5,17 @@
 #include "NvmSlab.h"
 #include "NvmSpaceManager.h"
 #include "SlabHashTable.h"
+#include "SlabPageMap.h"
 #include "NvmAllocator.h"
 
 // 包含所有组件的实现文件
 #include "NvmSlab.c"
 #include "NvmSpaceManager.c"
 #include "SlabHashTable.c"
+#include "NvmExtent.c"
+#include "NvmLog.c"
+#include "NvmLayout.c"
+#include "SlabPageMap.c"
 #include "NvmAllocator.c"
 
 #include <stdlib.h>
@@ -19,6 +24,8 @@
 #define MAX_BLOCK_SIZE 4096
 
 #define TOTAL_NVM_SIZE (10 * NVM_SLAB_SIZE)
+// 区域开头是持久元数据区，数据空间从这里开始
+#define DATA_START     nvm_layout_meta_size(TOTAL_NVM_SIZE)
 #define NUM_SLABS 10
 
 static void* mock_nvm_base = NULL;
@@ -65,7 +72,7 @@ void test_restore_first_object_in_new_slab(void) {
 
     // 白盒验证
     // [Updated for Parallel Heap]: 访问 cpu_heaps[0]
-    NvmSlab* restored_slab = global_nvm_allocator->cpu_heaps[0].slab_lists[sc_id];
+    NvmSlab* restored_slab = global_nvm_allocator->cpu_heaps[0]->slab_lists[sc_id][SLAB_LIST_PARTIAL];
     TEST_ASSERT_NOT_NULL(restored_slab);
     TEST_ASSERT_EQUAL_UINT64(slab_base_offset, restored_slab->nvm_base_offset);
     uint32_t block_idx = (obj_offset - slab_base_offset) / restored_slab->block_size;
@@ -77,10 +84,10 @@ void test_restore_first_object_in_new_slab(void) {
  */
 void test_restore_second_object_in_existing_slab(void) {
     // 先恢复第一个对象
-    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_allocation(mock_nvm_base, 32));
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_allocation((char*)mock_nvm_base + DATA_START, 32));
     
     // 现在恢复同一Slab中的第二个对象
-    const uint64_t obj_offset = 128;
+    const uint64_t obj_offset = DATA_START + 128;
     void* obj_ptr = (void*)((char*)mock_nvm_base + obj_offset);
 
     int result = nvm_allocator_restore_allocation(obj_ptr, 32);
@@ -88,7 +95,7 @@ void test_restore_second_object_in_existing_slab(void) {
 
     // 白盒验证
     // [Updated for Parallel Heap]: 访问 cpu_heaps[0]
-    NvmSlab* slab = global_nvm_allocator->cpu_heaps[0].slab_lists[SC_32B];
+    NvmSlab* slab = global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_32B][SLAB_LIST_PARTIAL];
     TEST_ASSERT_EQUAL_UINT32(2, slab->allocated_block_count);
     TEST_ASSERT_TRUE(IS_BIT_SET(slab->bitmap, 0));
     TEST_ASSERT_TRUE(IS_BIT_SET(slab->bitmap, 4));
@@ -98,26 +105,30 @@ void test_restore_second_object_in_existing_slab(void) {
  * @brief 测试恢复一个对象，其Slab正好是整个空闲空间的头部。
  */
 void test_restore_object_at_head_of_space(void) {
-    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_allocation(mock_nvm_base, 16));
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_allocation((char*)mock_nvm_base + DATA_START, 16));
     
     // [Updated for Parallel Heap]: 访问 central_heap
-    FreeSegmentNode* head = global_nvm_allocator->central_heap.space_manager->head;
-    TEST_ASSERT_EQUAL_UINT64(NVM_SLAB_SIZE, head->nvm_offset);
+    uint64_t offset, size;
+    TEST_ASSERT_EQUAL_INT(0, space_manager_next_free_range(global_nvm_allocator->central_heaps[0].space_manager, 0, &offset, &size));
+    TEST_ASSERT_EQUAL_UINT64(DATA_START + nvm_slab_class_span_size(SC_16B), offset);
 }
 
 /**
  * @brief 测试恢复一个对象，其Slab正好是整个空闲空间的尾部。
  */
 void test_restore_object_at_tail_of_space(void) {
-    const uint64_t slab_base_offset = (NUM_SLABS - 1) * NVM_SLAB_SIZE;
+    const uint64_t slab_base_offset = TOTAL_NVM_SIZE - nvm_slab_class_span_size(SC_16B);
     void* obj_ptr = (void*)((char*)mock_nvm_base + slab_base_offset);
 
     TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_allocation(obj_ptr, 16));
 
     // [Updated for Parallel Heap]: 访问 central_heap
-    FreeSegmentNode* head = global_nvm_allocator->central_heap.space_manager->head;
-    TEST_ASSERT_EQUAL_UINT64(slab_base_offset, head->size);
-    TEST_ASSERT_NULL(head->next);
+    FreeSpaceManager* manager = global_nvm_allocator->central_heaps[0].space_manager;
+    uint64_t offset, size;
+    TEST_ASSERT_EQUAL_INT(0, space_manager_next_free_range(manager, 0, &offset, &size));
+    TEST_ASSERT_EQUAL_UINT64(DATA_START, offset);
+    TEST_ASSERT_EQUAL_UINT64(slab_base_offset - DATA_START, size);
+    TEST_ASSERT_EQUAL_INT(-1, space_manager_next_free_range(manager, offset + size, &offset, &size));
 }
 
 /**
@@ -128,17 +139,28 @@ void test_restore_error_handling(void) {
     TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_restore_allocation(NULL, 10));
     TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_restore_allocation(mock_nvm_base, 0));
 
-    // 2. 恢复一个大对象
-    TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_restore_allocation(mock_nvm_base, MAX_BLOCK_SIZE + 1));
+    // 2. 恢复一个大对象 (超过最大 Slab 尺寸类别，不支持)
+    TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_restore_allocation(mock_nvm_base, NVM_MAX_SLAB_BLOCK_SIZE + 1));
 
     // 3. 恢复一个与已存在Slab尺寸冲突的对象
-    nvm_allocator_restore_allocation(mock_nvm_base, 16);
-    void* conflict_ptr = (void*)((char*)mock_nvm_base + 32);
+    char* data = (char*)mock_nvm_base + DATA_START;
+    nvm_allocator_restore_allocation(data, 16);
+    void* conflict_ptr = (void*)(data + 32);
     TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_restore_allocation(conflict_ptr, 32));
 
     // 4. 恢复一个位于已被占用的空间中的对象
-    void* occupied_ptr = (void*)((char*)mock_nvm_base + 64);
+    void* occupied_ptr = (void*)(data + 64);
     TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_restore_allocation(occupied_ptr, 64));
+
+    // 5. 持久元数据区不能被恢复为对象
+    TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_restore_allocation(mock_nvm_base, 16));
+
+    // 6. 指向块内部的指针：已有 Slab 与新 Slab 都拒绝，且不建立 Slab
+    TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_restore_allocation(data + 8, 16));
+    TEST_ASSERT_EQUAL_UINT32(1, slab_pagemap_lookup(global_nvm_allocator->central_heaps[0].slab_page_map,
+                                                    DATA_START)->allocated_block_count);
+    TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_restore_allocation((char*)mock_nvm_base + 2 * NVM_SLAB_SIZE + 24, 16));
+    TEST_ASSERT_NULL(slab_pagemap_lookup(global_nvm_allocator->central_heaps[0].slab_page_map, 2 * NVM_SLAB_SIZE));
 }
 
 // ============================================================================
@@ -154,10 +176,10 @@ typedef struct {
 
 static void restore_single_slab_for_stress_test(const StressTestSlabInfo* info) {
     for (int i = 0; i < info->num_objects_to_restore; ++i) {
-        uint64_t block_offset_in_slab = (uint64_t)i * (info->block_size + 7);
+        uint64_t block_offset_in_slab = (uint64_t)i * info->block_size;
         uint64_t obj_offset = info->slab_base_offset + block_offset_in_slab;
 
-        if (obj_offset + info->block_size > info->slab_base_offset + NVM_SLAB_SIZE) {
+        if (obj_offset + info->block_size > info->slab_base_offset + nvm_slab_class_span_size(info->sc_id)) {
             continue;
         }
         
@@ -170,7 +192,7 @@ static void restore_single_slab_for_stress_test(const StressTestSlabInfo* info)
 
 static void verify_restored_slab(const StressTestSlabInfo* info) {
     // [Updated for Parallel Heap]: 访问 central_heap
-    NvmSlab* slab = slab_hashtable_lookup(global_nvm_allocator->central_heap.slab_lookup_table, info->slab_base_offset);
+    NvmSlab* slab = slab_hashtable_lookup(global_nvm_allocator->central_heaps[0].slab_lookup_table, info->slab_base_offset);
     TEST_ASSERT_NOT_NULL(slab);
     TEST_ASSERT_EQUAL_UINT64(info->slab_base_offset, slab->nvm_base_offset);
     TEST_ASSERT_EQUAL_UINT8(info->sc_id, slab->size_type_id);
@@ -191,8 +213,8 @@ static void verify_restored_slab(const StressTestSlabInfo* info) {
 void test_restore_multiple_slabs_and_stress(void) {
     StressTestSlabInfo test_scenario[] = {
         { .slab_base_offset = 1 * NVM_SLAB_SIZE, .sc_id = SC_16B,  .block_size = 16,   .num_objects_to_restore = 2000 },
-        { .slab_base_offset = 4 * NVM_SLAB_SIZE, .sc_id = SC_128B, .block_size = 128,  .num_objects_to_restore = 1000 },
-        { .slab_base_offset = 8 * NVM_SLAB_SIZE, .sc_id = SC_4K,   .block_size = 4096, .num_objects_to_restore = 511 }
+        { .slab_base_offset = 4 * NVM_SLAB_SIZE, .sc_id = SC_128B, .block_size = 128,  .num_objects_to_restore = 400 },
+        { .slab_base_offset = 8 * NVM_SLAB_SIZE, .sc_id = SC_4K,   .block_size = 4096, .num_objects_to_restore = 255 }
     };
     const int num_scenarios = sizeof(test_scenario) / sizeof(test_scenario[0]);
 
@@ -201,23 +223,693 @@ void test_restore_multiple_slabs_and_stress(void) {
     }
 
     // [Updated for Parallel Heap]: 访问 central_heap
-    TEST_ASSERT_EQUAL_UINT32(num_scenarios, global_nvm_allocator->central_heap.slab_lookup_table->count);
+    TEST_ASSERT_EQUAL_UINT32(num_scenarios, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
     // [Updated for Parallel Heap]: 访问 cpu_heaps[0]
-    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0].slab_lists[SC_16B]);
+    TEST_ASSERT_NOT_NULL(global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_16B][SLAB_LIST_PARTIAL]);
 
     for (int i = 0; i < num_scenarios; ++i) {
         verify_restored_slab(&test_scenario[i]);
     }
 
     // [Updated for Parallel Heap]: 访问 central_heap
-    FreeSegmentNode* current = global_nvm_allocator->central_heap.space_manager->head;
+    // 空闲空间按地址依次为恢复的 Slab 之间的空隙
+    FreeSpaceManager* manager = global_nvm_allocator->central_heaps[0].space_manager;
+    uint64_t offset, size, from = DATA_START;
+    for (int i = 0; i < num_scenarios; ++i) {
+        TEST_ASSERT_EQUAL_INT(0, space_manager_next_free_range(manager, from, &offset, &size));
+        TEST_ASSERT_EQUAL_UINT64(from, offset);
+        TEST_ASSERT_EQUAL_UINT64(test_scenario[i].slab_base_offset - from, size);
+        from = test_scenario[i].slab_base_offset + nvm_slab_class_span_size(test_scenario[i].sc_id);
+    }
+    TEST_ASSERT_EQUAL_INT(0, space_manager_next_free_range(manager, from, &offset, &size));
+    TEST_ASSERT_EQUAL_UINT64(from, offset);
+    TEST_ASSERT_EQUAL_UINT64(TOTAL_NVM_SIZE - from, size);
+}
 
-    TEST_ASSERT_NOT_NULL(current);
-    TEST_ASSERT_EQUAL_UINT64(0 * NVM_SLAB_SIZE, current->nvm_offset);
-    TEST_ASSERT_EQUAL_UINT64(1 * NVM_SLAB_SIZE, current->size);
-    current = current->next;
-    
-    // ...
+// ============================================================================
+//                          持久布局挂载测试
+// ============================================================================
+
+/**
+ * @brief 销毁后在同一块 NVM 上再次创建：由持久布局自动重建 Slab 与区块，
+ *        只在缓存中的块视为空闲，没有应用持有块的 Slab 直接作废。
+ */
+void test_attach_rebuilds_from_persistent_layout(void) {
+    char* base = (char*)mock_nvm_base;
+    const uint64_t usable = TOTAL_NVM_SIZE - DATA_START;
+
+    // 64B Slab 中保留偶数块 (奇数块释放后留在线程缓存中)
+    void* small[64];
+    for (int i = 0; i < 64; ++i) {
+        small[i] = nvm_malloc(64);
+        TEST_ASSERT_NOT_NULL(small[i]);
+    }
+    for (int i = 1; i < 64; i += 2) nvm_free(small[i]);
+
+    // 32B Slab 的块交给应用后又归还，Slab 只剩缓存中的块
+    nvm_free(nvm_malloc(32));
+
+    // 页粒度区块中的两个相邻对象 (150 页 + 175 页) 与一个 3 x 2MB + 1 的巨型对象 (取整到跨度单元)
+    char* page_a = nvm_malloc(600 * 1024);
+    char* page_b = nvm_malloc(700 * 1024);
+    char* huge   = nvm_malloc(3 * NVM_SLAB_SIZE + 1);
+    TEST_ASSERT_NOT_NULL(page_a);
+    TEST_ASSERT_EQUAL_PTR(page_a + 600 * 1024, page_b);
+    TEST_ASSERT_NOT_NULL(huge);
+
+    nvm_allocator_destroy();
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE));
+    NvmAllocator* allocator = global_nvm_allocator;
+    NvmCentralHeap* central = &allocator->central_heaps[0];
+
+    // 1. 64B Slab 挂载到区域所在节点的第一个 CPU 堆，位图与应用视角一致；32B Slab 已作废
+    NvmCpuHeap* owner = allocator->cpu_heaps[0];
+    for (uint32_t i = 0; i < allocator->cpu_count; ++i) {
+        if (allocator->cpu_heaps[i]->node == central->node) {
+            owner = allocator->cpu_heaps[i];
+            break;
+        }
+    }
+    NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, (uint64_t)((char*)small[0] - base));
+    TEST_ASSERT_NOT_NULL(slab);
+    TEST_ASSERT_EQUAL_UINT8(SC_64B, slab->size_type_id);
+    TEST_ASSERT_EQUAL_PTR(owner, slab->owner_heap);
+    TEST_ASSERT_EQUAL_PTR(slab, owner->slab_lists[SC_64B][SLAB_LIST_PARTIAL]);
+    TEST_ASSERT_EQUAL_UINT32(32, slab->allocated_block_count);
+    for (int i = 0; i < 64; ++i) {
+        uint32_t idx = nvm_slab_block_index(slab, (uint64_t)((char*)small[i] - base) - slab->nvm_base_offset);
+        TEST_ASSERT_EQUAL_INT(i % 2 == 0, (int)IS_BIT_SET(slab->bitmap, idx));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, central->slab_lookup_table->count);
+
+    // 2. 区块：两个页粒度对象的边界由起始页区分，巨型对象整体恢复
+    NvmExtent* chunk = slab_pagemap_lookup_extent(central->slab_page_map, (uint64_t)(page_b - base));
+    TEST_ASSERT_NOT_NULL(chunk);
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_PAGES - 150 - 175, chunk->free_pages);
+    TEST_ASSERT_NOT_NULL(central->extent_spans);
+    TEST_ASSERT_EQUAL_UINT32(3 * NVM_EXTENT_CHUNK_UNITS + 1, central->extent_spans->span_units);
+    TEST_ASSERT_EQUAL_UINT64(usable - slab->span_size - NVM_SLAB_SIZE - (3 * NVM_SLAB_SIZE + NVM_SPAN_UNIT),
+                             space_manager_free_bytes(central->space_manager));
+
+    // 3. 重建的对象可以正常释放，空间全部归还
+    for (int i = 0; i < 64; i += 2) nvm_free(small[i]);
+    nvm_free(page_a);
+    nvm_free(page_b);
+    nvm_free(huge);
+    nvm_thread_cache_flush();
+    nvm_malloc_trim();
+    TEST_ASSERT_EQUAL_UINT64(usable, space_manager_free_bytes(central->space_manager));
+
+    // 4. 全部归还后再次挂载，区域为空
+    nvm_allocator_destroy();
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE));
+    TEST_ASSERT_EQUAL_UINT64(usable, space_manager_free_bytes(global_nvm_allocator->central_heaps[0].space_manager));
+    TEST_ASSERT_EQUAL_UINT32(0, global_nvm_allocator->central_heaps[0].slab_lookup_table->count);
+}
+
+/**
+ * @brief 持久布局与区域不符、或跨度头部损坏时拒绝挂载。
+ */
+void test_attach_rejects_inconsistent_layout(void) {
+    nvm_allocator_destroy();
+
+    // 1. 区域大小与超级块记录的不同
+    TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE / 2));
+
+    // 2. 跨度头部记录了不存在的尺寸类别
+    NvmLayout layout;
+    TEST_ASSERT_EQUAL_INT(1, nvm_layout_open(&layout, mock_nvm_base, TOTAL_NVM_SIZE));
+    nvm_layout_set_span(&layout, DATA_START, NVM_SPAN_SLAB, SC_COUNT, NVM_SPAN_UNIT);
+    TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE));
+
+    // 恢复正常环境，以便 tearDown 能正常工作
+    nvm_layout_clear_span(&layout, DATA_START);
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE));
+}
+
+// ============================================================================
+//         测试 nvm_reserve / nvm_publish 两阶段分配
+// ============================================================================
+
+// 块在持久位图中是否已标记
+static bool persisted(const NvmAction* action) {
+    NvmLayout* layout = &global_nvm_allocator->central_heaps[action->region_id].layout;
+    uint64_t word = nvm_layout_bitmap(layout, action->slab_offset)[action->block_idx / 64];
+    return (word >> (action->block_idx % 64)) & 1;
+}
+
+/**
+ * @brief 预留不改写持久状态；发布一次性置位并写入应用位置，重新挂载后
+ *        只有已发布的块被恢复，未发布的预留视为空闲。
+ */
+void test_publish_persists_reservations(void) {
+    char* base = (char*)mock_nvm_base;
+    uint64_t* root = nvm_malloc(16 * sizeof(uint64_t));
+    TEST_ASSERT_NOT_NULL(root);
+    memset(root, 0, 16 * sizeof(uint64_t));
+
+    NvmAction actions[9];
+    uint64_t* dests[8];
+    for (int i = 0; i < 9; ++i) {
+        char* ptr = nvm_reserve(64, &actions[i]);
+        TEST_ASSERT_NOT_NULL(ptr);
+        TEST_ASSERT_EQUAL_PTR(ptr, actions[i].ptr);
+        TEST_ASSERT_EQUAL_UINT64((uint64_t)(ptr - base), actions[i].offset);
+        TEST_ASSERT_FALSE(persisted(&actions[i]));
+        memset(ptr, 0xA0 + i, 64);
+        if (i < 8) dests[i] = &root[i];
+    }
+
+    // 前 8 个发布 (第 4 个不写入应用位置)，第 9 个只预留
+    dests[3] = NULL;
+    TEST_ASSERT_EQUAL_INT(0, nvm_publish(actions, 8, dests));
+    for (int i = 0; i < 8; ++i) {
+        TEST_ASSERT_TRUE(persisted(&actions[i]));
+        TEST_ASSERT_EQUAL_UINT64(i == 3 ? 0 : actions[i].offset, root[i]);
+    }
+    TEST_ASSERT_FALSE(persisted(&actions[8]));
+
+    // 日志槽已清空并归还
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    TEST_ASSERT_EQUAL_UINT64(0, central->log_busy);
+    for (uint32_t s = 0; s < NVM_LAYOUT_LOG_SLOTS; ++s) {
+        TEST_ASSERT_EQUAL_UINT32(0, nvm_layout_log(&central->layout, s)->count);
+    }
+
+    // 空批次什么也不做
+    TEST_ASSERT_EQUAL_INT(0, nvm_publish(actions, 0, NULL));
+
+    nvm_allocator_destroy();
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE));
+    central = &global_nvm_allocator->central_heaps[0];
+
+    NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, actions[0].offset);
+    TEST_ASSERT_NOT_NULL(slab);
+    for (int i = 0; i < 9; ++i) {
+        TEST_ASSERT_EQUAL_INT(i < 8, (int)IS_BIT_SET(slab->bitmap, actions[i].block_idx));
+    }
+    TEST_ASSERT_EQUAL_UINT8(0xA0, ((uint8_t*)(base + root[0]))[0]);
+    TEST_ASSERT_EQUAL_UINT8(0xA7, ((uint8_t*)(base + root[7]))[63]);
+}
+
+/**
+ * @brief 参数非法 (含与页映射不符的预留) 时一项都不发布；放弃的预留回到缓存
+ *        被再次使用，伪造的预留被跳过。
+ */
+void test_publish_rejects_invalid_and_cancel(void) {
+    uint64_t* root = nvm_malloc(2 * sizeof(uint64_t));
+    uint64_t  dram_slot = 0;
+    NvmAction actions[2];
+    TEST_ASSERT_NOT_NULL(nvm_reserve(128, &actions[0]));
+    TEST_ASSERT_NOT_NULL(nvm_reserve(128, &actions[1]));
+
+    // 目标不在 NVM 中 / 未对齐 / 超出单批上限 / 区域号非法
+    uint64_t* outside[2]   = { &root[0], &dram_slot };
+    uint64_t* unaligned[2] = { &root[0], (uint64_t*)((char*)&root[1] + 4) };
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(actions, 2, outside));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(actions, 2, unaligned));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(actions, NVM_PUBLISH_MAX_ACTIONS + 1, NULL));
+    NvmAction bad = actions[0];
+    bad.region_id = 1;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(&bad, 1, NULL));
+
+    // Slab 起点不符 / 块索引越界 / 偏移与索引不一致
+    bad = actions[0];
+    bad.slab_offset += 4096;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(&bad, 1, NULL));
+    bad = actions[0];
+    bad.block_idx = UINT32_MAX;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(&bad, 1, NULL));
+    bad = actions[0];
+    bad.offset += 128;
+    bad.ptr = (char*)bad.ptr + 128;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(&bad, 1, NULL));
+    NvmAction mixed[2] = { actions[0], bad };
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(mixed, 2, NULL));
+    TEST_ASSERT_FALSE(persisted(&actions[0]));
+    TEST_ASSERT_FALSE(persisted(&actions[1]));
+    TEST_ASSERT_EQUAL_UINT64(0, dram_slot);
+
+    // 超过 Slab 尺寸的对象不支持预留
+    NvmAction large;
+    TEST_ASSERT_NULL(nvm_reserve(NVM_MAX_SLAB_BLOCK_SIZE + 1, &large));
+
+    // 放弃后块回到线程缓存，下一次分配同类别时取回
+    nvm_cancel(&bad, 1);
+    nvm_cancel(actions, 2);
+    void* again = nvm_malloc(128);
+    TEST_ASSERT_EQUAL_PTR(actions[1].ptr, again);
+    TEST_ASSERT_TRUE(persisted(&actions[1]));
+    nvm_free(again);
+    nvm_free(root);
+}
+
+/**
+ * @brief 每个预留只能被发布或取消一次：重复发布、取消后发布、发布后取消、
+ *        批内重复与伪造 (块已由 nvm_malloc 交出) 的预留都被拒绝，块不会被两方持有。
+ */
+void test_publish_rejects_stale_reservations(void) {
+    NvmAction published, cancelled;
+    TEST_ASSERT_NOT_NULL(nvm_reserve(256, &published));
+    TEST_ASSERT_NOT_NULL(nvm_reserve(256, &cancelled));
+
+    // 重复发布
+    TEST_ASSERT_EQUAL_INT(0, nvm_publish(&published, 1, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(&published, 1, NULL));
+    TEST_ASSERT_TRUE(persisted(&published));
+
+    // 取消后发布：块已回到线程缓存，持久位保持未置位
+    nvm_cancel(&cancelled, 1);
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(&cancelled, 1, NULL));
+    TEST_ASSERT_FALSE(persisted(&cancelled));
+
+    // 发布后取消被跳过：已发布的块不回到缓存，下一次分配取回的是取消的块
+    nvm_cancel(&published, 1);
+    void* again = nvm_malloc(256);
+    TEST_ASSERT_EQUAL_PTR(cancelled.ptr, again);
+    TEST_ASSERT_NOT_EQUAL(published.ptr, nvm_malloc(256));
+
+    // 伪造：为已交给应用的块构造预留记录 (字段与页映射一致)
+    NvmAction forged = cancelled;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(&forged, 1, NULL));
+    nvm_cancel(&forged, 1);
+    TEST_ASSERT_NOT_EQUAL(cancelled.ptr, nvm_malloc(256));
+
+    // 批内重复：整批拒绝，此前清除的预留标记被恢复，之后仍可正常发布
+    NvmAction fresh;
+    TEST_ASSERT_NOT_NULL(nvm_reserve(256, &fresh));
+    NvmAction twice[2] = { fresh, fresh };
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(twice, 2, NULL));
+    TEST_ASSERT_FALSE(persisted(&fresh));
+    TEST_ASSERT_EQUAL_INT(0, nvm_publish(&fresh, 1, NULL));
+    TEST_ASSERT_TRUE(persisted(&fresh));
+}
+
+/**
+ * @brief 日志已提交但未应用时崩溃：挂载时重做；提交不完整的日志被丢弃。
+ */
+void test_attach_replays_committed_log(void) {
+    char* base = (char*)mock_nvm_base;
+    uint64_t* root = nvm_malloc(2 * sizeof(uint64_t));
+    memset(root, 0, 2 * sizeof(uint64_t));
+    NvmAction action;
+    TEST_ASSERT_NOT_NULL(nvm_reserve(256, &action));
+
+    // 按 nvm_publish 的方式写好日志并提交，然后 "崩溃"
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    uint64_t* word = &nvm_layout_bitmap(&central->layout, action.slab_offset)[action.block_idx / 64];
+    NvmRedoLog* log = nvm_layout_log(&central->layout, 5);
+    log->entries[0] = (NvmLogEntry){ nvm_log_target(NVM_LOG_OP_SET, 0, (uint64_t)((char*)word - base)),
+                                     1ULL << (action.block_idx % 64) };
+    log->entries[1] = (NvmLogEntry){ nvm_log_target(NVM_LOG_OP_STORE, 0, (uint64_t)((char*)&root[0] - base)),
+                                     action.offset };
+    TEST_ASSERT_EQUAL_INT(0, nvm_log_commit(log, 2));
+
+    // 另一个槽中的日志只落盘了一部分 (校验和不符)
+    NvmRedoLog* torn = nvm_layout_log(&central->layout, 9);
+    torn->entries[0] = (NvmLogEntry){ nvm_log_target(NVM_LOG_OP_STORE, 0, (uint64_t)((char*)&root[1] - base)), 77 };
+    torn->count = 1;
+    torn->checksum = 0;
+
+    nvm_allocator_destroy();
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE));
+    central = &global_nvm_allocator->central_heaps[0];
+
+    TEST_ASSERT_EQUAL_UINT64(action.offset, root[0]);
+    TEST_ASSERT_EQUAL_UINT64(0, root[1]);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_layout_log(&central->layout, 5)->count);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_layout_log(&central->layout, 9)->count);
+
+    NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, action.offset);
+    TEST_ASSERT_NOT_NULL(slab);
+    TEST_ASSERT_TRUE(IS_BIT_SET(slab->bitmap, action.block_idx));
+
+    // 日志项越界 (区域号与挂载的区域不符) 时拒绝挂载
+    nvm_allocator_destroy();
+    NvmLayout layout;
+    TEST_ASSERT_EQUAL_INT(1, nvm_layout_open(&layout, mock_nvm_base, TOTAL_NVM_SIZE));
+    log = nvm_layout_log(&layout, 0);
+    log->entries[0] = (NvmLogEntry){ nvm_log_target(NVM_LOG_OP_STORE, 3, 0), 1 };
+    TEST_ASSERT_EQUAL_INT(0, nvm_log_commit(log, 1));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE));
+
+    // 恢复正常环境，以便 tearDown 能正常工作
+    nvm_log_clear(log);
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE));
+}
+
+// ============================================================================
+//         测试 nvm_allocator_restore_batch 批量恢复
+// ============================================================================
+
+// 块在 DRAM 位图与持久位图中是否都已标记，且所在 Slab 属于给定类别
+static bool restored(uint64_t offset, SizeClassID sc_id) {
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, offset);
+    if (!slab || slab->size_type_id != sc_id) return false;
+    uint32_t idx = nvm_slab_block_index(slab, offset - slab->nvm_base_offset);
+    return IS_BIT_SET(slab->bitmap, idx) && IS_BIT_SET(nvm_layout_bitmap(&central->layout, slab->nvm_base_offset), idx);
+}
+
+/**
+ * @brief 乱序条目按 Slab 分组：新建的 Slab 整字载入位图，已有的 Slab 逐块置位，
+ *        重复条目无害；重新挂载后全部对象仍在。
+ */
+void test_restore_batch_groups_by_slab(void) {
+    char* base = (char*)mock_nvm_base;
+    const uint64_t small  = NVM_ALIGN_UP(DATA_START, NVM_SPAN_UNIT);
+    const uint64_t medium = 4 * NVM_SLAB_SIZE;
+    FreeSpaceManager* manager = global_nvm_allocator->central_heaps[0].space_manager;
+
+    // 第一个 32B Slab 已由逐个恢复建立
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_allocation(base + small, 32));
+    uint64_t free_before = space_manager_free_bytes(manager);
+
+    const NvmRestoreEntry entries[] = {
+        { base + medium + 3 * 8192, 8192 },
+        { base + small + 64 * 32, 32 },
+        { base + small + NVM_SPAN_UNIT + 32, 32 },      // 相邻的第二个 32B Slab
+        { base + medium, 8000 },
+        { base + small + 5 * 32, 30 },
+        { base + small + 64 * 32, 32 },                 // 重复条目
+    };
+    const size_t n = sizeof(entries) / sizeof(entries[0]);
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_batch(entries, n));
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_batch(entries, 0));
+
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    TEST_ASSERT_EQUAL_UINT32(3, slab_pagemap_lookup(central->slab_page_map, small)->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(1, slab_pagemap_lookup(central->slab_page_map, small + NVM_SPAN_UNIT)->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(2, slab_pagemap_lookup(central->slab_page_map, medium)->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT64(free_before - NVM_SPAN_UNIT - nvm_slab_class_span_size(SC_8K),
+                             space_manager_free_bytes(manager));
+    TEST_ASSERT_EQUAL_PTR(global_nvm_allocator->cpu_heaps[0],
+                          slab_pagemap_lookup(central->slab_page_map, medium)->owner_heap);
+
+    for (int round = 0; round < 2; ++round) {
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t offset = (uint64_t)((char*)entries[i].nvm_ptr - base);
+            TEST_ASSERT_TRUE(restored(offset, map_size_to_sc_id(entries[i].size)));
+        }
+        nvm_allocator_destroy();
+        TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE));
+    }
+}
+
+/**
+ * @brief 条目非法、类别冲突或空间已被占用时整批失败，不留下任何改动。
+ */
+void test_restore_batch_rejects_without_side_effects(void) {
+    char* base = (char*)mock_nvm_base;
+    const uint64_t data = NVM_ALIGN_UP(DATA_START, NVM_SPAN_UNIT);
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_allocation(base + data, 16));
+    uint64_t free_before = space_manager_free_bytes(central->space_manager);
+
+    const NvmRestoreEntry batches[][2] = {
+        // 尺寸超过最大类别 / 空指针
+        { { base + data + NVM_SPAN_UNIT, 16 }, { base + data + 2 * NVM_SPAN_UNIT, NVM_MAX_SLAB_BLOCK_SIZE + 1 } },
+        { { base + data + NVM_SPAN_UNIT, 16 }, { NULL, 16 } },
+        // 12K 类别 Slab 末尾不足一块的空间 / 指向块内部
+        { { base + data + NVM_SPAN_UNIT, 16 }, { base + 4 * NVM_SLAB_SIZE + NVM_MAX_SLAB_SPAN - 2048, 12 << 10 } },
+        { { base + data + NVM_SPAN_UNIT, 16 }, { base + 4 * NVM_SLAB_SIZE + 8, 16 } },
+        // 同一 Slab 被当作两个类别 / 跨度重叠
+        { { base + data + NVM_SPAN_UNIT, 16 }, { base + data + NVM_SPAN_UNIT + 64, 64 } },
+        { { base + 4 * NVM_SLAB_SIZE, 8192 }, { base + 4 * NVM_SLAB_SIZE + NVM_SPAN_UNIT, 16 } },
+        // 与已有 Slab 的类别冲突
+        { { base + data + NVM_SPAN_UNIT, 16 }, { base + data + 32, 32 } },
+        // 持久元数据区已被占用 (此前的新 Slab 占位被回滚)
+        { { base, 16 }, { base + data + NVM_SPAN_UNIT, 16 } },
+    };
+
+    for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); ++b) {
+        TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_restore_batch(batches[b], 2));
+        TEST_ASSERT_NULL(slab_pagemap_lookup(central->slab_page_map, data + NVM_SPAN_UNIT));
+        TEST_ASSERT_NULL(slab_pagemap_lookup(central->slab_page_map, 4 * NVM_SLAB_SIZE));
+        TEST_ASSERT_EQUAL_UINT64(free_before, space_manager_free_bytes(central->space_manager));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, slab_pagemap_lookup(central->slab_page_map, data)->allocated_block_count);
+}
+
+/**
+ * @brief 建立新 Slab 途中失败：已建立的新 Slab 被退役、其余占位被归还，
+ *        已有 Slab 不被置位，空间与 Slab 数都与调用前一致。
+ */
+void test_restore_batch_carve_failure_rolls_back(void) {
+    char* base = (char*)mock_nvm_base;
+    const uint64_t data = NVM_ALIGN_UP(DATA_START, NVM_SPAN_UNIT);
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_allocation(base + data, 16));
+    NvmSlab* existing = slab_pagemap_lookup(central->slab_page_map, data);
+    uint64_t free_before  = space_manager_free_bytes(central->space_manager);
+    uint32_t slabs_before = central->slab_lookup_table->count;
+
+    // 第二个新 Slab 的偏移预先占住哈希表，使其注册失败
+    TEST_ASSERT_EQUAL_INT(0, slab_hashtable_insert(central->slab_lookup_table, data + 2 * NVM_SPAN_UNIT, existing));
+    const NvmRestoreEntry entries[] = {
+        { base + data + 16, 16 },                       // 已有 Slab
+        { base + data + NVM_SPAN_UNIT, 16 },            // 第一个新 Slab (建立后被退役)
+        { base + data + 2 * NVM_SPAN_UNIT, 16 },        // 建立失败
+        { base + data + 3 * NVM_SPAN_UNIT, 16 },        // 仅占位，被归还
+    };
+    TEST_ASSERT_EQUAL_INT(-1, nvm_allocator_restore_batch(entries, 4));
+    slab_hashtable_remove(central->slab_lookup_table, data + 2 * NVM_SPAN_UNIT);
+
+    TEST_ASSERT_EQUAL_UINT64(free_before, space_manager_free_bytes(central->space_manager));
+    TEST_ASSERT_EQUAL_UINT32(slabs_before, central->slab_lookup_table->count);
+    TEST_ASSERT_EQUAL_UINT32(1, existing->allocated_block_count);
+    for (uint64_t u = 1; u <= 3; ++u) {
+        TEST_ASSERT_NULL(slab_pagemap_lookup(central->slab_page_map, data + u * NVM_SPAN_UNIT));
+        TEST_ASSERT_EQUAL_UINT8(NVM_SPAN_FREE, nvm_layout_span_at(&central->layout,
+            (data + u * NVM_SPAN_UNIT - NVM_START_OFFSET) / NVM_SPAN_UNIT).state);
+    }
+    // 被退役的新 Slab 没有挂到堆上
+    for (int list = 0; list < SLAB_LIST_COUNT; ++list) {
+        for (NvmSlab* s = global_nvm_allocator->cpu_heaps[0]->slab_lists[SC_16B][list]; s; s = s->next_in_chain) {
+            TEST_ASSERT_EQUAL_PTR(existing, s);
+        }
+    }
+
+    // 之后同一批可以完整恢复
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_batch(entries, 4));
+    TEST_ASSERT_EQUAL_UINT32(2, existing->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(slabs_before + 3, central->slab_lookup_table->count);
+}
+
+/**
+ * @brief 条目数达到并行阈值时分桶并行排序与置位，结果与串行一致。
+ */
+void test_restore_batch_parallel(void) {
+    char* base = (char*)mock_nvm_base;
+    const uint64_t start = NVM_ALIGN_UP(DATA_START, NVM_SPAN_UNIT);
+    const uint32_t per_slab = NVM_SPAN_UNIT / 8;
+    const size_t n = NVM_RESTORE_PARALLEL_MIN + per_slab / 2;
+
+    NvmRestoreEntry* entries = malloc(n * sizeof(NvmRestoreEntry));
+    TEST_ASSERT_NOT_NULL(entries);
+    for (size_t i = 0; i < n; ++i) {
+        entries[i] = (NvmRestoreEntry){ base + start + i * 8, 8 };
+    }
+    // 固定种子的 LCG 打乱顺序
+    uint64_t seed = 42;
+    for (size_t i = n - 1; i > 0; --i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t j = (size_t)((seed >> 33) % (i + 1));
+        NvmRestoreEntry tmp = entries[i];
+        entries[i] = entries[j];
+        entries[j] = tmp;
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_restore_batch(entries, n));
+    free(entries);
+
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    size_t slabs = (n + per_slab - 1) / per_slab;
+    for (size_t s = 0; s < slabs; ++s) {
+        uint64_t offset = start + s * NVM_SPAN_UNIT;
+        uint32_t expected = (s + 1 < slabs) ? per_slab : (uint32_t)(n - s * per_slab);
+        NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, offset);
+        TEST_ASSERT_NOT_NULL(slab);
+        TEST_ASSERT_EQUAL_UINT32(expected, slab->allocated_block_count);
+
+        const uint64_t* words = nvm_layout_bitmap(&central->layout, offset);
+        uint32_t persisted_bits = 0;
+        for (uint32_t w = 0; w < per_slab / 64; ++w) persisted_bits += (uint32_t)__builtin_popcountll(words[w]);
+        TEST_ASSERT_EQUAL_UINT32(expected, persisted_bits);
+    }
+    TEST_ASSERT_NULL(slab_pagemap_lookup(central->slab_page_map, start + slabs * NVM_SPAN_UNIT));
+}
+
+// ============================================================================
+//         测试 nvm_tx_* 分配事务
+// ============================================================================
+
+// 块在持久位图中是否已标记 (按块地址定位)
+static bool ptr_persisted(const void* ptr) {
+    uint64_t offset = (uint64_t)((const char*)ptr - (const char*)mock_nvm_base);
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, offset);
+    TEST_ASSERT_NOT_NULL(slab);
+    uint32_t idx = nvm_slab_block_index(slab, offset - slab->nvm_base_offset);
+    return (nvm_layout_bitmap(&central->layout, slab->nvm_base_offset)[idx / 64] >> (idx % 64)) & 1;
+}
+
+/**
+ * @brief 事务内的分配、释放与写入在提交时一同生效；释放推迟到提交之后，
+ *        提交前被释放的块不会被再次分配。
+ */
+void test_tx_commit_applies_allocs_frees_and_stores(void) {
+    char* base = (char*)mock_nvm_base;
+    uint64_t* root = nvm_malloc(2 * sizeof(uint64_t));
+    memset(root, 0, 2 * sizeof(uint64_t));
+    void* old_node = nvm_malloc(64);
+    TEST_ASSERT_TRUE(ptr_persisted(old_node));
+
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_begin());
+    TEST_ASSERT_EQUAL_INT(-1, nvm_tx_begin());
+    char* a = nvm_tx_alloc(64);
+    char* b = nvm_tx_alloc(64);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_free(old_node));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_tx_free(old_node));
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_set(&root[0], 1));
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_set(&root[0], (uint64_t)(a - base)));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_tx_set((uint64_t*)((char*)&root[1] + 4), 1));
+
+    // 提交前持久状态不变，被释放的块仍不可再分配
+    TEST_ASSERT_FALSE(ptr_persisted(a));
+    TEST_ASSERT_FALSE(ptr_persisted(b));
+    TEST_ASSERT_TRUE(ptr_persisted(old_node));
+    TEST_ASSERT_EQUAL_UINT64(0, root[0]);
+    void* other = nvm_malloc(64);
+    TEST_ASSERT_TRUE(other != old_node);
+    nvm_free(other);
+
+    // 同一 Slab 的两次置位合并为一项，释放与写入各一项
+    TEST_ASSERT_EQUAL_UINT32(3, thread_tx.entry_count);
+
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_commit());
+    TEST_ASSERT_EQUAL_INT(-1, nvm_tx_commit());
+    TEST_ASSERT_TRUE(ptr_persisted(a));
+    TEST_ASSERT_TRUE(ptr_persisted(b));
+    TEST_ASSERT_FALSE(ptr_persisted(old_node));
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)(a - base), root[0]);
+
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    TEST_ASSERT_EQUAL_UINT64(0, central->log_busy);
+    for (uint32_t s = 0; s < NVM_LAYOUT_LOG_SLOTS; ++s) {
+        TEST_ASSERT_EQUAL_UINT32(0, nvm_layout_log(&central->layout, s)->count);
+    }
+
+    // 提交后释放的块回到线程缓存，下一次分配即取回
+    TEST_ASSERT_EQUAL_PTR(old_node, nvm_malloc(64));
+
+    // 空事务直接结束
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_begin());
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_commit());
+    TEST_ASSERT_EQUAL_UINT64(0, central->log_busy);
+}
+
+/**
+ * @brief 中止与提交前崩溃都不改写持久状态；销毁实例后残留的事务作废。
+ */
+void test_tx_abort_and_crash_before_commit(void) {
+    uint64_t* root = nvm_malloc(sizeof(uint64_t));
+    *root = 0;
+    void* old_node = nvm_malloc(128);
+
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_begin());
+    void* a = nvm_tx_alloc(128);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NULL(nvm_tx_alloc(NVM_MAX_SLAB_BLOCK_SIZE + 1));
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_free(old_node));
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_set(root, 42));
+    nvm_tx_abort();
+
+    TEST_ASSERT_FALSE(ptr_persisted(a));
+    TEST_ASSERT_TRUE(ptr_persisted(old_node));
+    TEST_ASSERT_EQUAL_UINT64(0, *root);
+    TEST_ASSERT_EQUAL_UINT64(0, global_nvm_allocator->central_heaps[0].log_busy);
+    TEST_ASSERT_EQUAL_PTR(a, nvm_malloc(128));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_tx_commit());
+
+    // 写好日志项但未提交时 "崩溃"：重新挂载后什么也没发生
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_begin());
+    void* b = nvm_tx_alloc(128);
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_free(old_node));
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_set(root, 42));
+    uint64_t b_offset = (uint64_t)((char*)b - (char*)mock_nvm_base);
+
+    nvm_allocator_destroy();
+    TEST_ASSERT_EQUAL_INT(0, nvm_allocator_create(mock_nvm_base, TOTAL_NVM_SIZE));
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+
+    TEST_ASSERT_EQUAL_UINT64(0, *root);
+    TEST_ASSERT_TRUE(ptr_persisted(old_node));
+    NvmSlab* slab = slab_pagemap_lookup(central->slab_page_map, b_offset);
+    TEST_ASSERT_FALSE(IS_BIT_SET(slab->bitmap, nvm_slab_block_index(slab, b_offset - slab->nvm_base_offset)));
+
+    // 旧实例的事务不延续到新实例
+    TEST_ASSERT_EQUAL_INT(-1, nvm_tx_commit());
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_begin());
+    nvm_tx_abort();
+    TEST_ASSERT_EQUAL_UINT64(0, central->log_busy);
+}
+
+/**
+ * @brief 日志应用失败时提交返回 -1：推迟释放的块不回到缓存，日志槽照常归还。
+ */
+void test_tx_commit_apply_failure(void) {
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    void* old_node = nvm_malloc(128);
+
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_begin());
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_free(old_node));
+    // 篡改清除项的区域号，使应用前的校验失败
+    NvmRedoLog* log = nvm_layout_log(&central->layout, thread_tx.slot);
+    log->entries[0].target |= 7ULL << NVM_LOG_REGION_SHIFT;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_tx_commit());
+
+    TEST_ASSERT_TRUE(ptr_persisted(old_node));
+    TEST_ASSERT_EQUAL_UINT64(0, central->log_busy);
+    TEST_ASSERT_EQUAL_UINT32(0, log->count);
+    TEST_ASSERT_NOT_EQUAL(old_node, nvm_malloc(128));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_tx_commit());
+}
+
+// 开始事务并分配一块后直接退出，不提交也不中止
+static void* tx_abandon_thread(void* arg) {
+    (void)arg;
+    if (nvm_tx_begin() != 0) return NULL;
+    return nvm_tx_alloc(256);
+}
+
+/**
+ * @brief 线程在事务进行中退出时自动中止并归还日志槽；日志槽全部被占用时
+ *        开始事务与发布有限等待后失败，而不是无限自旋。
+ */
+void test_tx_thread_exit_and_busy_slots(void) {
+    NvmCentralHeap* central = &global_nvm_allocator->central_heaps[0];
+    pthread_t tid;
+    void* block = NULL;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&tid, NULL, tx_abandon_thread, NULL));
+    TEST_ASSERT_EQUAL_INT(0, pthread_join(tid, &block));
+    TEST_ASSERT_NOT_NULL(block);
+    TEST_ASSERT_EQUAL_UINT64(0, central->log_busy);
+    TEST_ASSERT_FALSE(ptr_persisted(block));
+
+    central->log_busy = ~0ULL;
+    NvmAction action;
+    TEST_ASSERT_NOT_NULL(nvm_reserve(64, &action));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_tx_begin());
+    TEST_ASSERT_EQUAL_INT(-1, nvm_publish(&action, 1, NULL));
+    TEST_ASSERT_FALSE(persisted(&action));
+    central->log_busy = 0;
+
+    TEST_ASSERT_EQUAL_INT(0, nvm_publish(&action, 1, NULL));
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_begin());
+    TEST_ASSERT_EQUAL_INT(0, nvm_tx_commit());
 }
 
 // ============================================================================
@@ -232,6 +924,20 @@ int main(void) {
     RUN_TEST(test_restore_object_at_tail_of_space);
     RUN_TEST(test_restore_error_handling);
     RUN_TEST(test_restore_multiple_slabs_and_stress); 
+    RUN_TEST(test_attach_rebuilds_from_persistent_layout);
+    RUN_TEST(test_attach_rejects_inconsistent_layout);
+    RUN_TEST(test_publish_persists_reservations);
+    RUN_TEST(test_publish_rejects_invalid_and_cancel);
+    RUN_TEST(test_publish_rejects_stale_reservations);
+    RUN_TEST(test_attach_replays_committed_log);
+    RUN_TEST(test_restore_batch_groups_by_slab);
+    RUN_TEST(test_restore_batch_rejects_without_side_effects);
+    RUN_TEST(test_restore_batch_carve_failure_rolls_back);
+    RUN_TEST(test_restore_batch_parallel);
+    RUN_TEST(test_tx_commit_applies_allocs_frees_and_stores);
+    RUN_TEST(test_tx_abort_and_crash_before_commit);
+    RUN_TEST(test_tx_commit_apply_failure);
+    RUN_TEST(test_tx_thread_exit_and_busy_slots);
 
     return UNITY_END();
 }
\ No newline at end of file
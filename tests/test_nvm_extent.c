@@ -0,0 +1,197 @@
+#include "unity.h"
+#include "NvmDefs.h"
+#include "NvmExtent.h"
+
+// 直接包含 .c 文件，进行白盒测试
+#include "NvmExtent.c"
+
+#include <stdlib.h>
+
+#define TEST_BASE_OFFSET (4 * NVM_SLAB_SIZE)
+
+static NvmExtent* chunk = NULL;
+
+void setUp(void) {
+    chunk = nvm_extent_create(TEST_BASE_OFFSET, NVM_EXTENT_CHUNK_UNITS);
+    TEST_ASSERT_NOT_NULL(chunk);
+}
+
+void tearDown(void) {
+    nvm_extent_destroy(chunk);
+    chunk = NULL;
+}
+
+// ============================================================================
+//                          测试用例
+// ============================================================================
+
+/**
+ * @brief 测试区块的创建参数校验与初始状态。
+ */
+void test_extent_create(void) {
+    TEST_ASSERT_EQUAL_UINT64(TEST_BASE_OFFSET, chunk->nvm_base_offset);
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_CHUNK_UNITS, chunk->span_units);
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_PAGES, chunk->free_pages);
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_PAGES, chunk->max_free_run);
+    TEST_ASSERT_TRUE(nvm_extent_is_empty(chunk));
+
+    // 偏移未对齐或跨度小于页粒度区块均非法
+    TEST_ASSERT_NULL(nvm_extent_create(NVM_EXTENT_PAGE_SIZE, NVM_EXTENT_CHUNK_UNITS));
+    TEST_ASSERT_NULL(nvm_extent_create(0, 0));
+    TEST_ASSERT_NULL(nvm_extent_create(0, NVM_EXTENT_CHUNK_UNITS - 1));
+
+    // 巨型对象区块 (跨度不必是 2MB 的整数倍) 没有可分配的页
+    NvmExtent* span = nvm_extent_create(0, NVM_EXTENT_CHUNK_UNITS + 1);
+    TEST_ASSERT_NOT_NULL(span);
+    TEST_ASSERT_EQUAL_UINT32(0, span->free_pages);
+    TEST_ASSERT_EQUAL_UINT32(0, span->max_free_run);
+    uint32_t page;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_extent_alloc(span, 1, &page));
+    nvm_extent_destroy(span);
+}
+
+/**
+ * @brief 测试重置：页位图与对象长度表清空，可改绑为巨型对象或页粒度区块。
+ */
+void test_extent_reset(void) {
+    uint32_t page;
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, 8, &page));
+    TEST_ASSERT_EQUAL_UINT32(8, nvm_extent_object_pages(chunk, page));
+
+    nvm_extent_reset(chunk, 2 * NVM_SLAB_SIZE, 3 * NVM_EXTENT_CHUNK_UNITS);
+    TEST_ASSERT_EQUAL_UINT64(2 * NVM_SLAB_SIZE, chunk->nvm_base_offset);
+    TEST_ASSERT_EQUAL_UINT32(3 * NVM_EXTENT_CHUNK_UNITS, chunk->span_units);
+    TEST_ASSERT_EQUAL_UINT32(0, chunk->free_pages);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_extent_object_pages(chunk, page));
+
+    nvm_extent_reset(chunk, TEST_BASE_OFFSET, NVM_EXTENT_CHUNK_UNITS);
+    TEST_ASSERT_TRUE(nvm_extent_is_empty(chunk));
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_PAGES, chunk->max_free_run);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_extent_object_pages(chunk, page));
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, NVM_EXTENT_PAGES, &page));
+}
+
+/**
+ * @brief 测试 First-Fit 分配、非法参数与对象长度记录。
+ */
+void test_extent_alloc_first_fit(void) {
+    uint32_t a, b, c;
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, 4, &a));
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, 2, &b));
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, 1, &c));
+    TEST_ASSERT_EQUAL_UINT32(0, a);
+    TEST_ASSERT_EQUAL_UINT32(4, b);
+    TEST_ASSERT_EQUAL_UINT32(6, c);
+    TEST_ASSERT_EQUAL_UINT16(4, chunk->run_pages[a]);
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_PAGES - 7, chunk->free_pages);
+
+    uint32_t page;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_extent_alloc(chunk, 0, &page));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_extent_alloc(chunk, NVM_EXTENT_PAGES + 1, &page));
+
+    // 第一个空洞放不下时跳到后面的空闲区域
+    TEST_ASSERT_EQUAL_UINT32(2, nvm_extent_free(chunk, b));
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, 3, &page));
+    TEST_ASSERT_EQUAL_UINT32(7, page);
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, 2, &page));
+    TEST_ASSERT_EQUAL_UINT32(4, page);
+}
+
+/**
+ * @brief 测试释放后相邻空闲页合并，可再次满足跨位图字边界的大请求。
+ */
+void test_extent_free_coalesces(void) {
+    uint32_t pages[8];
+    for (int i = 0; i < 8; ++i) {
+        TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, 20, &pages[i]));
+        TEST_ASSERT_EQUAL_UINT32((uint32_t)i * 20, pages[i]);
+    }
+
+    // 非对象起点与重复释放均被忽略
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_extent_free(chunk, 1));
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_extent_free(chunk, NVM_EXTENT_PAGES));
+    TEST_ASSERT_EQUAL_UINT32(20, nvm_extent_free(chunk, pages[3]));
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_extent_free(chunk, pages[3]));
+
+    // 释放 2、4 后与 3 合并为 60 页的空洞 (页 40 ~ 99，跨越第一个位图字)
+    TEST_ASSERT_EQUAL_UINT32(20, nvm_extent_free(chunk, pages[2]));
+    TEST_ASSERT_EQUAL_UINT32(20, nvm_extent_free(chunk, pages[4]));
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_PAGES - 160, chunk->max_free_run);
+    uint32_t page;
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, 60, &page));
+    TEST_ASSERT_EQUAL_UINT32(40, page);
+
+    // 尾部空闲段也被占满后，最长空闲段即为剩余的空洞
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, NVM_EXTENT_PAGES - 160, &page));
+    TEST_ASSERT_EQUAL_UINT32(0, chunk->max_free_run);
+    TEST_ASSERT_EQUAL_INT(-1, nvm_extent_alloc(chunk, 1, &page));
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_PAGES - 160, nvm_extent_free(chunk, page));
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_PAGES - 160, chunk->max_free_run);
+    TEST_ASSERT_EQUAL_UINT32(60, nvm_extent_free(chunk, 40));
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, 60, &page));
+
+    TEST_ASSERT_EQUAL_UINT32(60, nvm_extent_free(chunk, page));
+    for (int i = 0; i < 8; ++i) {
+        if (i < 2 || i > 4) nvm_extent_free(chunk, pages[i]);
+    }
+    TEST_ASSERT_TRUE(nvm_extent_is_empty(chunk));
+}
+
+/**
+ * @brief 测试整块分配与耗尽。
+ */
+void test_extent_full_chunk(void) {
+    uint32_t page;
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, NVM_EXTENT_PAGES, &page));
+    TEST_ASSERT_EQUAL_UINT32(0, page);
+    TEST_ASSERT_EQUAL_UINT32(0, chunk->free_pages);
+    TEST_ASSERT_EQUAL_INT(-1, nvm_extent_alloc(chunk, 1, &page));
+
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_PAGES, nvm_extent_free(chunk, 0));
+    TEST_ASSERT_TRUE(nvm_extent_is_empty(chunk));
+
+    // 逐页填满
+    for (uint32_t i = 0; i < NVM_EXTENT_PAGES; ++i) {
+        TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, 1, &page));
+        TEST_ASSERT_EQUAL_UINT32(i, page);
+    }
+    TEST_ASSERT_EQUAL_INT(-1, nvm_extent_alloc(chunk, 1, &page));
+}
+
+/**
+ * @brief 测试按已知位置重新标记对象 (从持久记录重建)。
+ */
+void test_extent_restore(void) {
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_restore(chunk, 10, 5));
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_restore(chunk, 15, 1));
+    TEST_ASSERT_EQUAL_UINT32(NVM_EXTENT_PAGES - 6, chunk->free_pages);
+
+    // 越界与重叠
+    TEST_ASSERT_EQUAL_INT(-1, nvm_extent_restore(chunk, 14, 2));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_extent_restore(chunk, NVM_EXTENT_PAGES - 1, 2));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_extent_restore(chunk, 0, 0));
+
+    // 恢复的对象与正常分配的对象一样释放，空洞可再分配
+    uint32_t page;
+    TEST_ASSERT_EQUAL_INT(0, nvm_extent_alloc(chunk, 10, &page));
+    TEST_ASSERT_EQUAL_UINT32(0, page);
+    TEST_ASSERT_EQUAL_UINT32(5, nvm_extent_free(chunk, 10));
+    TEST_ASSERT_EQUAL_UINT32(1, nvm_extent_free(chunk, 15));
+    TEST_ASSERT_EQUAL_UINT32(10, nvm_extent_free(chunk, 0));
+    TEST_ASSERT_TRUE(nvm_extent_is_empty(chunk));
+}
+
+// ============================================================================
+//                          测试运行器
+// ============================================================================
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_extent_create);
+    RUN_TEST(test_extent_reset);
+    RUN_TEST(test_extent_alloc_first_fit);
+    RUN_TEST(test_extent_free_coalesces);
+    RUN_TEST(test_extent_full_chunk);
+    RUN_TEST(test_extent_restore);
+    return UNITY_END();
+}
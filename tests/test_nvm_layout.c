@@ -0,0 +1,168 @@
+#include "unity.h"
+#include "NvmDefs.h"
+#include "NvmLayout.h"
+
+// 直接包含 .c 文件，进行白盒测试
+#include "NvmLayout.c"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_REGION_SIZE (4 * NVM_SLAB_SIZE)
+
+static void* region = NULL;
+
+void setUp(void) {
+    region = calloc(1, TEST_REGION_SIZE);
+    TEST_ASSERT_NOT_NULL(region);
+}
+
+void tearDown(void) {
+    free(region);
+    region = NULL;
+}
+
+// ============================================================================
+//                          测试用例
+// ============================================================================
+
+/**
+ * @brief 元数据区按单元对齐，容纳超级块、头部表、每单元一个位图槽与日志槽。
+ */
+void test_meta_size(void) {
+    uint64_t units = TEST_REGION_SIZE / NVM_SPAN_UNIT;
+    uint64_t meta = nvm_layout_meta_size(TEST_REGION_SIZE);
+    uint64_t need = sizeof(NvmSuperblock) + units * (sizeof(NvmSpanHeader) + NVM_LAYOUT_BITMAP_BYTES) +
+                    (uint64_t)NVM_LAYOUT_LOG_SLOTS * NVM_LOG_SLOT_SIZE;
+
+    TEST_ASSERT_EQUAL_UINT64(0, meta % NVM_SPAN_UNIT);
+    TEST_ASSERT_TRUE(meta >= need);
+    TEST_ASSERT_TRUE(meta - NVM_SPAN_UNIT < need + 2 * CACHE_LINE_SIZE + NVM_LOG_SLOT_SIZE);
+
+    // 最小的块填满一个单元时，位图槽恰好每块一位
+    TEST_ASSERT_EQUAL_UINT32(NVM_SPAN_UNIT / 8, NVM_LAYOUT_BITMAP_BYTES * 8);
+    TEST_ASSERT_EQUAL_UINT32(8, sizeof(NvmSpanHeader));
+}
+
+/**
+ * @brief 未格式化的区域被格式化，再次打开时挂载同一布局。
+ */
+void test_format_then_attach(void) {
+    NvmLayout layout;
+    TEST_ASSERT_EQUAL_INT(0, nvm_layout_open(&layout, region, TEST_REGION_SIZE));
+
+    NvmSuperblock* sb = (NvmSuperblock*)((char*)region + NVM_START_OFFSET);
+    TEST_ASSERT_EQUAL_PTR(sb, layout.superblock);
+    TEST_ASSERT_EQUAL_UINT64(NVM_LAYOUT_MAGIC, sb->magic);
+    TEST_ASSERT_EQUAL_UINT32(NVM_LAYOUT_VERSION, sb->version);
+    TEST_ASSERT_EQUAL_UINT64(TEST_REGION_SIZE, sb->region_size);
+    TEST_ASSERT_EQUAL_UINT64(TEST_REGION_SIZE / NVM_SPAN_UNIT, layout.unit_count);
+    TEST_ASSERT_EQUAL_UINT64(nvm_layout_meta_size(TEST_REGION_SIZE), layout.meta_size);
+
+    // 头部表与位图槽位于元数据区内，互不重叠
+    TEST_ASSERT_TRUE((char*)layout.headers >= (char*)(sb + 1));
+    TEST_ASSERT_TRUE((char*)layout.bitmaps >= (char*)(layout.headers + layout.unit_count));
+    TEST_ASSERT_TRUE((char*)nvm_layout_bitmap(&layout, NVM_START_OFFSET + TEST_REGION_SIZE - NVM_SPAN_UNIT) +
+                     NVM_LAYOUT_BITMAP_BYTES <= (char*)layout.logs);
+    TEST_ASSERT_EQUAL_UINT64(0, ((char*)layout.logs - (char*)sb) % NVM_LOG_SLOT_SIZE);
+    TEST_ASSERT_TRUE((char*)nvm_layout_log(&layout, NVM_LAYOUT_LOG_SLOTS - 1) + NVM_LOG_SLOT_SIZE <=
+                     (char*)sb + layout.meta_size);
+    TEST_ASSERT_EQUAL_UINT64(NVM_LAYOUT_LOG_SLOTS, sb->log_count);
+
+    nvm_layout_set_span(&layout, 2 * NVM_SLAB_SIZE, NVM_SPAN_SLAB, SC_64B, NVM_SPAN_UNIT);
+
+    NvmLayout again;
+    TEST_ASSERT_EQUAL_INT(1, nvm_layout_open(&again, region, TEST_REGION_SIZE));
+    TEST_ASSERT_EQUAL_PTR(layout.bitmaps, again.bitmaps);
+    NvmSpanHeader header = nvm_layout_span_at(&again, 2 * NVM_SLAB_SIZE / NVM_SPAN_UNIT);
+    TEST_ASSERT_EQUAL_UINT8(NVM_SPAN_SLAB, header.state);
+    TEST_ASSERT_EQUAL_UINT8(SC_64B, header.size_class);
+    TEST_ASSERT_EQUAL_UINT32(1, header.span_units);
+}
+
+/**
+ * @brief 布局与区域不符时拒绝打开，区域过小时无法格式化。
+ */
+void test_open_rejects_mismatch(void) {
+    NvmLayout layout;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_layout_open(NULL, region, TEST_REGION_SIZE));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_layout_open(&layout, NULL, TEST_REGION_SIZE));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_layout_open(&layout, region, NVM_SPAN_UNIT));
+
+    TEST_ASSERT_EQUAL_INT(0, nvm_layout_open(&layout, region, TEST_REGION_SIZE));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_layout_open(&layout, region, TEST_REGION_SIZE / 2));
+
+    layout.superblock->log_count = NVM_LAYOUT_LOG_SLOTS + 1;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_layout_open(&layout, region, TEST_REGION_SIZE));
+    layout.superblock->log_count = NVM_LAYOUT_LOG_SLOTS;
+
+    layout.superblock->version = NVM_LAYOUT_VERSION + 1;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_layout_open(&layout, region, TEST_REGION_SIZE));
+
+    // 魔数缺失 (如格式化中途崩溃) 的区域重新格式化，日志头一并清空
+    nvm_layout_log(&layout, NVM_LAYOUT_LOG_SLOTS - 1)->count = 3;
+    layout.superblock->magic = 0;
+    TEST_ASSERT_EQUAL_INT(0, nvm_layout_open(&layout, region, TEST_REGION_SIZE));
+    TEST_ASSERT_EQUAL_UINT32(NVM_LAYOUT_VERSION, layout.superblock->version);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_layout_log(&layout, NVM_LAYOUT_LOG_SLOTS - 1)->count);
+}
+
+/**
+ * @brief 启用 Slab 与区块时清零位图槽，清除头部不影响相邻单元。
+ */
+void test_span_headers_and_bitmaps(void) {
+    NvmLayout layout;
+    TEST_ASSERT_EQUAL_INT(0, nvm_layout_open(&layout, region, TEST_REGION_SIZE));
+
+    uint64_t offset = NVM_SLAB_SIZE;
+    uint64_t* bitmap = nvm_layout_bitmap(&layout, offset);
+    memset(bitmap, 0xFF, NVM_LAYOUT_BITMAP_BYTES);
+
+    nvm_layout_set_span(&layout, offset, NVM_SPAN_SLAB, SC_8B, NVM_SPAN_UNIT);
+    for (uint32_t w = 0; w < NVM_LAYOUT_BITMAP_BYTES / sizeof(uint64_t); ++w) {
+        TEST_ASSERT_EQUAL_UINT64(0, bitmap[w]);
+    }
+
+    // 单个位与连续位的置位/清除
+    nvm_layout_mark(&layout, offset, 0);
+    nvm_layout_mark(&layout, offset, 8191);
+    TEST_ASSERT_EQUAL_UINT64(1, bitmap[0]);
+    TEST_ASSERT_EQUAL_UINT64(1ULL << 63, bitmap[127]);
+    nvm_layout_unmark(&layout, offset, 0);
+    TEST_ASSERT_EQUAL_UINT64(0, bitmap[0]);
+
+    nvm_layout_mark_range(&layout, offset, 60, 70, true);
+    TEST_ASSERT_EQUAL_UINT64(0xFULL << 60, bitmap[0]);
+    TEST_ASSERT_EQUAL_UINT64(~0ULL, bitmap[1]);
+    TEST_ASSERT_EQUAL_UINT64(0x3, bitmap[2]);
+    nvm_layout_mark_range(&layout, offset, 62, 67, false);
+    TEST_ASSERT_EQUAL_UINT64(0x3ULL << 60, bitmap[0]);
+    TEST_ASSERT_EQUAL_UINT64(0, bitmap[1]);
+    TEST_ASSERT_EQUAL_UINT64(0x2, bitmap[2]);
+
+    // 巨型对象不使用位图槽
+    nvm_layout_set_span(&layout, offset + NVM_SPAN_UNIT, NVM_SPAN_HUGE, 0, 2 * NVM_SLAB_SIZE);
+    nvm_layout_clear_span(&layout, offset);
+    TEST_ASSERT_EQUAL_UINT8(NVM_SPAN_FREE, nvm_layout_span_at(&layout, offset / NVM_SPAN_UNIT).state);
+    NvmSpanHeader huge = nvm_layout_span_at(&layout, offset / NVM_SPAN_UNIT + 1);
+    TEST_ASSERT_EQUAL_UINT8(NVM_SPAN_HUGE, huge.state);
+    TEST_ASSERT_EQUAL_UINT32(2 * NVM_SLAB_SIZE / NVM_SPAN_UNIT, huge.span_units);
+
+    // 越界的单元读出空头部
+    TEST_ASSERT_EQUAL_UINT8(NVM_SPAN_FREE, nvm_layout_span_at(&layout, layout.unit_count).state);
+}
+
+// ============================================================================
+//                          测试执行入口
+// ============================================================================
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_meta_size);
+    RUN_TEST(test_format_then_attach);
+    RUN_TEST(test_open_rejects_mismatch);
+    RUN_TEST(test_span_headers_and_bitmaps);
+
+    return UNITY_END();
+}
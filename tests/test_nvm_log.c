@@ -0,0 +1,140 @@
+#include "unity.h"
+#include "NvmDefs.h"
+#include "NvmLog.h"
+
+// 直接包含 .c 文件，进行白盒测试
+#include "NvmLog.c"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_REGION_SIZE (64 * 1024)
+
+static NvmRedoLog* log_slot = NULL;
+static void*       regions[2];
+static uint64_t    sizes[2] = { TEST_REGION_SIZE, TEST_REGION_SIZE };
+
+void setUp(void) {
+    log_slot = aligned_alloc(CACHE_LINE_SIZE, sizeof(NvmRedoLog));
+    TEST_ASSERT_NOT_NULL(log_slot);
+    memset(log_slot, 0, sizeof(NvmRedoLog));
+    for (int i = 0; i < 2; ++i) {
+        regions[i] = calloc(1, TEST_REGION_SIZE);
+        TEST_ASSERT_NOT_NULL(regions[i]);
+    }
+}
+
+void tearDown(void) {
+    free(log_slot);
+    for (int i = 0; i < 2; ++i) free(regions[i]);
+}
+
+static uint64_t* word_at(int region, uint64_t offset) {
+    return (uint64_t*)((char*)regions[region] + offset);
+}
+
+// ============================================================================
+//                          测试用例
+// ============================================================================
+
+/**
+ * @brief 日志槽恰好一页，日志项目标的编码可还原操作、区域与偏移。
+ */
+void test_slot_layout_and_target_encoding(void) {
+    TEST_ASSERT_EQUAL_UINT32(NVM_LOG_SLOT_SIZE, sizeof(NvmRedoLog));
+    TEST_ASSERT_EQUAL_UINT32(CACHE_LINE_SIZE, offsetof(NvmRedoLog, entries));
+
+    uint64_t target = nvm_log_target(NVM_LOG_OP_STORE, 513, 0x123456789A8ULL);
+    TEST_ASSERT_EQUAL_UINT32(NVM_LOG_OP_STORE, target >> NVM_LOG_OP_SHIFT);
+    TEST_ASSERT_EQUAL_UINT32(513, (target >> NVM_LOG_REGION_SHIFT) & 0xFFFF);
+    TEST_ASSERT_EQUAL_HEX64(0x123456789A8ULL, target & NVM_LOG_OFFSET_MASK);
+}
+
+/**
+ * @brief 提交后日志有效；任何一项或项数被改动 (部分落盘) 都使校验失败。
+ */
+void test_commit_and_validate(void) {
+    TEST_ASSERT_FALSE(nvm_log_valid(log_slot));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_log_commit(log_slot, 0));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_log_commit(log_slot, NVM_LOG_CAPACITY + 1));
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        log_slot->entries[i].target = nvm_log_target(NVM_LOG_OP_SET, 0, i * 8);
+        log_slot->entries[i].value  = 1ULL << i;
+    }
+    TEST_ASSERT_EQUAL_INT(0, nvm_log_commit(log_slot, 3));
+    TEST_ASSERT_TRUE(nvm_log_valid(log_slot));
+
+    log_slot->entries[2].value ^= 1;
+    TEST_ASSERT_FALSE(nvm_log_valid(log_slot));
+    log_slot->entries[2].value ^= 1;
+    TEST_ASSERT_TRUE(nvm_log_valid(log_slot));
+
+    log_slot->count = 2;
+    TEST_ASSERT_FALSE(nvm_log_valid(log_slot));
+    log_slot->count = 3;
+
+    nvm_log_clear(log_slot);
+    TEST_ASSERT_EQUAL_UINT32(0, log_slot->count);
+    TEST_ASSERT_FALSE(nvm_log_valid(log_slot));
+}
+
+/**
+ * @brief 三种操作按区域号定位目标字，重复应用结果不变。
+ */
+void test_apply_is_idempotent(void) {
+    *word_at(0, 64)  = 0xF0;
+    *word_at(1, 128) = 0xFF;
+
+    log_slot->entries[0] = (NvmLogEntry){ nvm_log_target(NVM_LOG_OP_SET, 0, 64), 0x0F };
+    log_slot->entries[1] = (NvmLogEntry){ nvm_log_target(NVM_LOG_OP_CLEAR, 1, 128), 0x3C };
+    log_slot->entries[2] = (NvmLogEntry){ nvm_log_target(NVM_LOG_OP_STORE, 1, TEST_REGION_SIZE - 8), 0xABCDEF };
+    TEST_ASSERT_EQUAL_INT(0, nvm_log_commit(log_slot, 3));
+
+    for (int round = 0; round < 2; ++round) {
+        TEST_ASSERT_EQUAL_INT(0, nvm_log_apply(log_slot, regions, sizes, 2));
+        TEST_ASSERT_EQUAL_HEX64(0xFF, *word_at(0, 64));
+        TEST_ASSERT_EQUAL_HEX64(0xC3, *word_at(1, 128));
+        TEST_ASSERT_EQUAL_HEX64(0xABCDEF, *word_at(1, TEST_REGION_SIZE - 8));
+    }
+    nvm_drain();
+}
+
+/**
+ * @brief 任何一项越界 (区域号、偏移或对齐) 时一项都不应用。
+ */
+void test_apply_rejects_out_of_range(void) {
+    const uint64_t bad_targets[] = {
+        nvm_log_target(NVM_LOG_OP_STORE, 2, 0),                     // 区域不存在
+        nvm_log_target(NVM_LOG_OP_STORE, 0, TEST_REGION_SIZE),      // 越过区域末尾
+        nvm_log_target(NVM_LOG_OP_STORE, 0, 12),                    // 未对齐
+        nvm_log_target(NVM_LOG_OP_STORE, 0, 0) & ~(3ULL << NVM_LOG_OP_SHIFT),  // 无操作
+    };
+
+    for (size_t i = 0; i < sizeof(bad_targets) / sizeof(bad_targets[0]); ++i) {
+        log_slot->entries[0] = (NvmLogEntry){ nvm_log_target(NVM_LOG_OP_STORE, 0, 0), 42 };
+        log_slot->entries[1] = (NvmLogEntry){ bad_targets[i], 7 };
+        TEST_ASSERT_EQUAL_INT(0, nvm_log_commit(log_slot, 2));
+        TEST_ASSERT_EQUAL_INT(-1, nvm_log_apply(log_slot, regions, sizes, 2));
+        TEST_ASSERT_EQUAL_UINT64(0, *word_at(0, 0));
+    }
+
+    // 未提交的日志不应用
+    nvm_log_clear(log_slot);
+    TEST_ASSERT_EQUAL_INT(-1, nvm_log_apply(log_slot, regions, sizes, 2));
+}
+
+// ============================================================================
+//                          测试执行入口
+// ============================================================================
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_slot_layout_and_target_encoding);
+    RUN_TEST(test_commit_and_validate);
+    RUN_TEST(test_apply_is_idempotent);
+    RUN_TEST(test_apply_rejects_out_of_range);
+
+    return UNITY_END();
+}
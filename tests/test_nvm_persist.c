@@ -0,0 +1,164 @@
+#include "unity.h"
+#include "NvmDefs.h"
+#include "NvmPersist.h"
+
+// 直接包含 .c 文件，进行白盒测试
+#include "NvmPersist.c"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_BUF_SIZE (16 * CACHE_LINE_SIZE)
+
+static char* buf = NULL;
+static NvmFlushMode hw_mode;
+
+void setUp(void) {
+    buf = aligned_alloc(CACHE_LINE_SIZE, TEST_BUF_SIZE);
+    TEST_ASSERT_NOT_NULL(buf);
+    memset(buf, 0, TEST_BUF_SIZE);
+    nvm_persist_set_mode(NVM_FLUSH_CLWB);
+    nvm_drain();
+}
+
+void tearDown(void) {
+    nvm_drain();
+    free(buf);
+    buf = NULL;
+}
+
+// ============================================================================
+//                          测试用例
+// ============================================================================
+
+/**
+ * @brief 写回方式按 CPU 能力探测，指定方式超出能力时降级。
+ */
+void test_mode_detect_and_clamp(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    TEST_ASSERT_TRUE(hw_mode >= NVM_FLUSH_CLFLUSH);
+#else
+    TEST_ASSERT_EQUAL_INT(NVM_FLUSH_NONE, hw_mode);
+#endif
+    TEST_ASSERT_EQUAL_INT(hw_mode, nvm_persist_mode());
+
+    TEST_ASSERT_EQUAL_INT(NVM_FLUSH_NONE, nvm_persist_set_mode(NVM_FLUSH_NONE));
+    TEST_ASSERT_EQUAL_INT(NVM_FLUSH_NONE, nvm_persist_mode());
+    TEST_ASSERT_EQUAL_INT(hw_mode, nvm_persist_set_mode(NVM_FLUSH_CLWB));
+}
+
+/**
+ * @brief 重叠或相邻的写回合并为一个待刷区间，不相邻时才发出旧区间。
+ */
+void test_flush_coalesces_adjacent_lines(void) {
+    if (hw_mode == NVM_FLUSH_NONE) TEST_IGNORE_MESSAGE("no cache line writeback on this CPU");
+    uintptr_t base = (uintptr_t)buf;
+
+    // 同一行的多次写回只记一次
+    nvm_flush(buf + 8, 8);
+    nvm_flush(buf + 16, 8);
+    TEST_ASSERT_EQUAL_HEX64(base, persist_lo);
+    TEST_ASSERT_EQUAL_HEX64(base + CACHE_LINE_SIZE, persist_hi);
+    TEST_ASSERT_FALSE(persist_unfenced);
+
+    // 跨行范围与相邻行向两侧扩展
+    nvm_flush(buf + CACHE_LINE_SIZE - 4, 8);
+    nvm_flush(buf + 2 * CACHE_LINE_SIZE, CACHE_LINE_SIZE);
+    TEST_ASSERT_EQUAL_HEX64(base + 3 * CACHE_LINE_SIZE, persist_hi);
+    nvm_flush(buf + 5 * CACHE_LINE_SIZE, 1);
+    TEST_ASSERT_EQUAL_HEX64(base + 5 * CACHE_LINE_SIZE, persist_lo);
+    TEST_ASSERT_EQUAL_HEX64(base + 6 * CACHE_LINE_SIZE, persist_hi);
+    nvm_flush(buf + 3 * CACHE_LINE_SIZE, 2 * CACHE_LINE_SIZE);
+    TEST_ASSERT_EQUAL_HEX64(base + 3 * CACHE_LINE_SIZE, persist_lo);
+
+    // 不相邻的区间发出了之前的写回
+    TEST_ASSERT_EQUAL(hw_mode != NVM_FLUSH_CLFLUSH, persist_unfenced);
+
+    // 空范围不改变待刷区间
+    nvm_flush(buf + 10 * CACHE_LINE_SIZE, 0);
+    TEST_ASSERT_EQUAL_HEX64(base + 3 * CACHE_LINE_SIZE, persist_lo);
+}
+
+/**
+ * @brief 屏障清空待刷区间；没有写回时不发出栅栏。
+ */
+void test_drain_only_fences_after_writeback(void) {
+    if (hw_mode == NVM_FLUSH_NONE) TEST_IGNORE_MESSAGE("no cache line writeback on this CPU");
+
+    nvm_drain();
+    TEST_ASSERT_FALSE(persist_unfenced);
+
+    nvm_flush(buf, TEST_BUF_SIZE);
+    TEST_ASSERT_FALSE(persist_unfenced);
+    nvm_drain();
+    TEST_ASSERT_EQUAL_UINT64(0, persist_lo);
+    TEST_ASSERT_EQUAL_UINT64(0, persist_hi);
+    TEST_ASSERT_FALSE(persist_unfenced);
+
+    buf[0] = 1;
+    nvm_persist(buf, 1);
+    TEST_ASSERT_EQUAL_UINT64(0, persist_hi);
+    TEST_ASSERT_EQUAL_INT8(1, buf[0]);
+
+    // CLFLUSH 自身有序，写回后同样无需栅栏
+    nvm_persist_set_mode(NVM_FLUSH_CLFLUSH);
+    nvm_flush(buf, 8);
+    nvm_flush(buf + 4 * CACHE_LINE_SIZE, 8);
+    TEST_ASSERT_FALSE(persist_unfenced);
+    nvm_drain();
+    TEST_ASSERT_EQUAL_UINT64(0, persist_hi);
+}
+
+/**
+ * @brief eADR 模式下写回与栅栏都被省去。
+ */
+void test_eadr_mode_skips_writeback(void) {
+    nvm_persist_set_mode(NVM_FLUSH_NONE);
+
+    nvm_flush(buf, TEST_BUF_SIZE);
+    TEST_ASSERT_EQUAL_UINT64(0, persist_hi);
+    nvm_persist(buf + CACHE_LINE_SIZE, 8);
+    TEST_ASSERT_EQUAL_UINT64(0, persist_hi);
+    TEST_ASSERT_FALSE(persist_unfenced);
+}
+
+/**
+ * @brief 作废后其他线程的过期待刷区间被丢弃，不对其发出写回。
+ */
+void test_invalidate_drops_stale_pending(void) {
+    if (hw_mode == NVM_FLUSH_NONE) TEST_IGNORE_MESSAGE("no cache line writeback on this CPU");
+
+    nvm_flush(buf, 8);
+    TEST_ASSERT_NOT_EQUAL(0, persist_hi);
+
+    // 模拟其他线程调用 nvm_persist_invalidate：只递增代数，本线程的区间原样留着
+    __atomic_fetch_add(&persist_generation, 1, __ATOMIC_RELAXED);
+    nvm_drain();
+    TEST_ASSERT_EQUAL_UINT64(0, persist_hi);
+    TEST_ASSERT_FALSE(persist_unfenced);
+
+    // 新区间属于新代数，照常合并与写回
+    nvm_flush(buf, 8);
+    nvm_flush(buf + CACHE_LINE_SIZE, 8);
+    TEST_ASSERT_EQUAL_HEX64((uintptr_t)buf + 2 * CACHE_LINE_SIZE, persist_hi);
+    nvm_persist_invalidate();
+    TEST_ASSERT_EQUAL_UINT64(0, persist_hi);
+}
+
+// ============================================================================
+//                          测试执行入口
+// ============================================================================
+
+int main(void) {
+    hw_mode = persist_detect();
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_mode_detect_and_clamp);
+    RUN_TEST(test_flush_coalesces_adjacent_lines);
+    RUN_TEST(test_drain_only_fences_after_writeback);
+    RUN_TEST(test_eadr_mode_skips_writeback);
+    RUN_TEST(test_invalidate_drops_stale_pending);
+
+    return UNITY_END();
+}
@@ -19,6 +19,11 @@ void tearDown(void) {
     g_simulated_nvm_pool = NULL;
 }
 
+// 单块分配 (批量接口取 1 块)，成功返回 0，Slab 已满返回 -1
+static int slab_alloc_one(NvmSlab* slab, uint32_t* out_block_idx) {
+    return nvm_slab_alloc_batch(slab, out_block_idx, 1) == 1 ? 0 : -1;
+}
+
 // ============================================================================
 // 测试用例
 // ============================================================================
@@ -53,8 +58,9 @@ void test_nvm_slab_creation_and_destruction(void) {
     TEST_ASSERT_EQUAL_UINT8_MESSAGE(valid_sc_id, slab->size_type_id, "Size class ID mismatch.");
     TEST_ASSERT_EQUAL_UINT64_MESSAGE(nvm_offset, slab->nvm_base_offset, "NVM base offset mismatch.");
     TEST_ASSERT_EQUAL_UINT32_MESSAGE(256, slab->block_size, "Block size should be 256 for SC_256B.");
-    // 理论计算: (2 * 1024 * 1024) / 256 = 8192
-    TEST_ASSERT_EQUAL_UINT32_MESSAGE(8192, slab->total_block_count, "Total block count mismatch.");
+    // 理论计算: 256B 类别的跨度为 64KB，64 * 1024 / 256 = 256
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(64 * 1024, slab->span_size, "Span size mismatch.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(256, slab->total_block_count, "Total block count mismatch.");
 
     // 检查初始动态状态 (calloc 应该已将它们清零)
     TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, slab->allocated_block_count, "Initial allocated_block_count should be 0.");
@@ -116,14 +122,14 @@ void test_slab_alloc_free_cache_behavior(void) {
     TEST_ASSERT_NOT_NULL(allocated_indices);
 
     // --- 子测试 1: 首次分配触发 refill_cache ---
-    ret = nvm_slab_alloc(slab, &allocated_indices[0]);
+    ret = slab_alloc_one(slab, &allocated_indices[0]);
     TEST_ASSERT_EQUAL_INT(0, ret);
     TEST_ASSERT_EQUAL_UINT32(1, slab->allocated_block_count);
     TEST_ASSERT_EQUAL_UINT32(batch_size - 1, slab->cache_count);
 
     // --- 子测试 2: 耗尽第一批缓存 (快速路径测试) ---
     for (int i = 1; i < batch_size; ++i) {
-        ret = nvm_slab_alloc(slab, &allocated_indices[i]);
+        ret = slab_alloc_one(slab, &allocated_indices[i]);
         TEST_ASSERT_EQUAL_INT(0, ret);
     }
     TEST_ASSERT_EQUAL_UINT32(0, slab->cache_count);
@@ -132,14 +138,14 @@ void test_slab_alloc_free_cache_behavior(void) {
     // --- 子测试 3: 填满缓存并触发 drain_cache ---
     // 先分配足够的块，以便后续可以释放它们
     for (int i = batch_size; i < cache_size; ++i) {
-        ret = nvm_slab_alloc(slab, &allocated_indices[i]);
+        ret = slab_alloc_one(slab, &allocated_indices[i]);
         TEST_ASSERT_EQUAL_INT(0, ret);
     }
     TEST_ASSERT_EQUAL_UINT32(cache_size, slab->allocated_block_count);
     
     // Act: 释放我们刚刚分配的 64 个块，这将填满缓存
     for (uint32_t i = 0; i < cache_size; ++i) {
-        nvm_slab_free(slab, allocated_indices[i]);
+        nvm_slab_free_local(slab, allocated_indices[i]);
     }
 
     // Assert: 缓存现在应该是满的
@@ -149,11 +155,11 @@ void test_slab_alloc_free_cache_behavior(void) {
     // Act: 再释放一个我们拥有的块（例如，再次释放第0个块），这将触发 drain_cache
     // 注意：这在技术上是“双重释放”，但可以用来测试 drain 逻辑。
     // 一个更好的方法是分配第65个块，然后再释放它。
-    ret = nvm_slab_alloc(slab, &allocated_indices[cache_size]); // 分配第 65 个块
+    ret = slab_alloc_one(slab, &allocated_indices[cache_size]); // 分配第 65 个块
     TEST_ASSERT_EQUAL_INT(0, ret); // allocated: 1, cache: 63
     
-    nvm_slab_free(slab, allocated_indices[0]); // 释放一个已分配块，cache: 64, allocated: 0
-    nvm_slab_free(slab, allocated_indices[cache_size]); // 释放第 65 个块，触发 drain
+    nvm_slab_free_local(slab, allocated_indices[0]); // 释放一个已分配块，cache: 64, allocated: 0
+    nvm_slab_free_local(slab, allocated_indices[cache_size]); // 释放第 65 个块，触发 drain
 
     // Assert:
     // 调用 free(allocated_indices[cache_size]) 时:
@@ -173,7 +179,7 @@ void test_slab_alloc_free_cache_behavior(void) {
 
     // Act: 循环分配，直到分配失败，并记录分配的块数
     uint32_t alloc_count = 0;
-    while (nvm_slab_alloc(slab, &allocated_indices[alloc_count]) == 0) {
+    while (slab_alloc_one(slab, &allocated_indices[alloc_count]) == 0) {
         alloc_count++;
         // 增加一个保护，防止无限循环
         if (alloc_count >= total_blocks + 1) {
@@ -188,14 +194,14 @@ void test_slab_alloc_free_cache_behavior(void) {
     TEST_ASSERT_TRUE(nvm_slab_is_full(slab));
     
     // 在已满的 slab 上再次分配应该会失败
-    ret = nvm_slab_alloc(slab, &block_idx);
+    ret = slab_alloc_one(slab, &block_idx);
     TEST_ASSERT_EQUAL_INT_MESSAGE(-1, ret, "Allocation on a full slab should fail.");
 
 
     // --- 子测试 5: 完全耗尽后再全部释放，并重新进行分配 ---
     // Act: 释放所有刚刚分配的块
     for (uint32_t i = 0; i < total_blocks; ++i) {
-        nvm_slab_free(slab, allocated_indices[i]);
+        nvm_slab_free_local(slab, allocated_indices[i]);
     }
 
     // Assert: slab 应该变回空的状态
@@ -206,7 +212,7 @@ void test_slab_alloc_free_cache_behavior(void) {
 
     // Act: 再次尝试将 slab 完全耗尽
     alloc_count = 0;
-    while (nvm_slab_alloc(slab, &block_idx) == 0) {
+    while (slab_alloc_one(slab, &block_idx) == 0) {
         alloc_count++;
         if (alloc_count >= total_blocks + 1) {
             TEST_FAIL_MESSAGE("Re-allocation loop ran more times than total blocks.");
@@ -225,6 +231,293 @@ void test_slab_alloc_free_cache_behavior(void) {
 }
 
 
+/**
+ * @brief 测试 nvm_slab_reset：复用描述符前清空全部动态状态。
+ */
+void test_slab_reset_for_reuse(void) {
+    NvmSlab* slab = nvm_slab_create(SC_512B, 0);
+    TEST_ASSERT_NOT_NULL(slab);
+
+    uint32_t block_idx;
+    for (int i = 0; i < 10; ++i) {
+        TEST_ASSERT_EQUAL_INT(0, slab_alloc_one(slab, &block_idx));
+    }
+    nvm_slab_free_local(slab, block_idx);
+    TEST_ASSERT_EQUAL_UINT32(9, slab->allocated_block_count);
+
+    nvm_slab_reset(slab, 4 * NVM_SLAB_SIZE);
+
+    TEST_ASSERT_EQUAL_UINT64(4 * NVM_SLAB_SIZE, slab->nvm_base_offset);
+    TEST_ASSERT_EQUAL_UINT8(SC_512B, slab->size_type_id);
+    TEST_ASSERT_EQUAL_UINT8(SLAB_LIST_NONE, slab->list_id);
+    TEST_ASSERT_EQUAL_UINT32(0, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(0, slab->cache_count);
+    for (uint32_t i = 0; i < slab->total_block_count; ++i) {
+        TEST_ASSERT_FALSE(IS_BIT_SET(slab->bitmap, i));
+    }
+
+    // 重置后可从头分配
+    TEST_ASSERT_EQUAL_INT(0, slab_alloc_one(slab, &block_idx));
+    TEST_ASSERT_EQUAL_UINT32(0, block_idx);
+
+    nvm_slab_destroy(slab);
+}
+
+
+/**
+ * @brief 测试两级位图：摘要位跟踪满字，refill 能直接定位到深处的空闲块。
+ */
+void test_slab_bitmap_summary_search(void) {
+    NvmSlab* slab = nvm_slab_create(SC_8B, 0);
+    TEST_ASSERT_NOT_NULL(slab);
+    TEST_ASSERT_EQUAL_UINT32(slab->total_block_count / 64, slab->bitmap_words);
+    TEST_ASSERT_EQUAL_UINT32((slab->bitmap_words + 63) / 64, slab->summary_words);
+
+    // 分配满整个 slab
+    uint32_t block_idx;
+    for (uint32_t i = 0; i < slab->total_block_count; ++i) {
+        TEST_ASSERT_EQUAL_INT(0, slab_alloc_one(slab, &block_idx));
+    }
+    TEST_ASSERT_TRUE(nvm_slab_is_full(slab));
+    for (uint32_t s = 0; s < slab->summary_words; ++s) {
+        TEST_ASSERT_EQUAL_UINT64(0, slab->summary[s]);
+    }
+
+    // 释放位于末端的一批块 (超过缓存容量，迫使回写位图)
+    const uint32_t target = slab->total_block_count - 100;
+    for (uint32_t i = target; i < slab->total_block_count; ++i) {
+        nvm_slab_free_local(slab, i);
+    }
+    TEST_ASSERT_TRUE(slab->summary[(target / 64) / 64] != 0);
+
+    // 全部重新分配回来，且都落在释放的区间内
+    for (uint32_t i = target; i < slab->total_block_count; ++i) {
+        TEST_ASSERT_EQUAL_INT(0, slab_alloc_one(slab, &block_idx));
+        TEST_ASSERT_TRUE(block_idx >= target && block_idx < slab->total_block_count);
+    }
+    TEST_ASSERT_TRUE(nvm_slab_is_full(slab));
+    TEST_ASSERT_EQUAL_INT(-1, slab_alloc_one(slab, &block_idx));
+
+    nvm_slab_destroy(slab);
+}
+
+void test_slab_load_bitmap(void) {
+    // 256B 类：256 块，共 4 个位图字
+    NvmSlab* slab = nvm_slab_create(SC_256B, 0);
+    TEST_ASSERT_NOT_NULL(slab);
+
+    // 载入会丢弃缓存中的块
+    uint32_t block_idx;
+    TEST_ASSERT_EQUAL_INT(0, slab_alloc_one(slab, &block_idx));
+
+    uint64_t words[4] = { ~0ULL, 0x5ULL, 0, 1ULL << 63 };
+    TEST_ASSERT_EQUAL_UINT32(64 + 2 + 1, nvm_slab_load_bitmap(slab, words));
+    TEST_ASSERT_EQUAL_UINT32(67, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(0, slab->cache_count);
+    TEST_ASSERT_FALSE(IS_BIT_SET(slab->summary, 0));
+    TEST_ASSERT_TRUE(IS_BIT_SET(slab->summary, 1));
+
+    // 之后的分配只取到空闲块
+    for (uint32_t i = 0; i < 256 - 67; ++i) {
+        TEST_ASSERT_EQUAL_INT(0, slab_alloc_one(slab, &block_idx));
+        TEST_ASSERT_TRUE(block_idx >= 64 && block_idx != 64 && block_idx != 66 && block_idx != 255);
+    }
+    TEST_ASSERT_EQUAL_INT(-1, slab_alloc_one(slab, &block_idx));
+
+    nvm_slab_destroy(slab);
+}
+
+/**
+ * @brief 测试批量分配：一次取出多块，Slab 耗尽时返回实际块数。
+ */
+void test_slab_alloc_batch(void) {
+    NvmSlab* slab = nvm_slab_create(SC_4K, 0);
+    TEST_ASSERT_NOT_NULL(slab);
+
+    uint32_t idx[100];
+    TEST_ASSERT_EQUAL_UINT32(100, nvm_slab_alloc_batch(slab, idx, 100));
+    TEST_ASSERT_EQUAL_UINT32(100, slab->allocated_block_count);
+    for (uint32_t i = 0; i < 100; ++i) {
+        TEST_ASSERT_EQUAL_UINT32(i, idx[i]);
+    }
+
+    uint32_t rest[512];
+    TEST_ASSERT_EQUAL_UINT32(slab->total_block_count - 100, nvm_slab_alloc_batch(slab, rest, 512));
+    TEST_ASSERT_TRUE(nvm_slab_is_full(slab));
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_alloc_batch(slab, rest, 1));
+
+    nvm_slab_destroy(slab);
+}
+
+/**
+ * @brief 测试远程释放只压入无锁链表，所属方一次性回收；越界索引被拒绝，重置清空链表。
+ */
+void test_slab_remote_free_and_collect(void) {
+    NvmSlab* slab = nvm_slab_create(SC_4K, 0);
+    TEST_ASSERT_NOT_NULL(slab);
+    char* slab_mem = (char*)malloc(NVM_SLAB_SIZE);
+    TEST_ASSERT_NOT_NULL(slab_mem);
+
+    uint32_t idx[3];
+    TEST_ASSERT_EQUAL_UINT32(3, nvm_slab_alloc_batch(slab, idx, 3));
+
+    // 远程释放只压入链表：计数、缓存不变，后继索引写在块内
+    uint32_t cache_before = slab->cache_count;
+    TEST_ASSERT_EQUAL_UINT32(1, nvm_slab_remote_free(slab, slab_mem, idx[0]));
+    TEST_ASSERT_EQUAL_UINT32(2, nvm_slab_remote_free(slab, slab_mem, idx[2]));
+    TEST_ASSERT_EQUAL_UINT32(2, nvm_slab_remote_pending(slab));
+    TEST_ASSERT_EQUAL_UINT32(3, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(cache_before, slab->cache_count);
+    TEST_ASSERT_EQUAL_UINT32(idx[0], *(uint32_t*)(slab_mem + (uint64_t)idx[2] * slab->block_size));
+
+    // 所属方一次性回收整条链表
+    TEST_ASSERT_EQUAL_UINT32(2, nvm_slab_collect_remote(slab, slab_mem));
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_remote_pending(slab));
+    TEST_ASSERT_EQUAL_UINT32(1, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(cache_before + 2, slab->cache_count);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_collect_remote(slab, slab_mem));
+
+    // 越界索引被拒绝，重置清空链表
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_remote_free(slab, slab_mem, slab->total_block_count));
+    nvm_slab_remote_free(slab, slab_mem, idx[1]);
+    nvm_slab_reset(slab, NVM_SLAB_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_remote_pending(slab));
+
+    free(slab_mem);
+    nvm_slab_destroy(slab);
+}
+
+/**
+ * @brief 测试本地释放直接归还到缓存并减少计数，归还的块可再次分配；越界索引被忽略。
+ */
+void test_slab_free_local(void) {
+    NvmSlab* slab = nvm_slab_create(SC_4K, 0);
+    TEST_ASSERT_NOT_NULL(slab);
+
+    uint32_t idx[3];
+    TEST_ASSERT_EQUAL_UINT32(3, nvm_slab_alloc_batch(slab, idx, 3));
+    uint32_t cache_before = slab->cache_count;
+
+    nvm_slab_free_local(slab, idx[1]);
+    TEST_ASSERT_EQUAL_UINT32(2, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(cache_before + 1, slab->cache_count);
+
+    nvm_slab_free_local(slab, slab->total_block_count);
+    TEST_ASSERT_EQUAL_UINT32(2, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(cache_before + 1, slab->cache_count);
+
+    // 与普通释放一样进入缓存，最终都能被再次分配出去
+    nvm_slab_free_local(slab, idx[0]);
+    nvm_slab_free_local(slab, idx[2]);
+    TEST_ASSERT_TRUE(nvm_slab_is_empty(slab));
+
+    uint32_t total = slab->total_block_count;
+    uint32_t got = 0, block_idx;
+    while (slab_alloc_one(slab, &block_idx) == 0) ++got;
+    TEST_ASSERT_EQUAL_UINT32(total, got);
+
+    nvm_slab_destroy(slab);
+}
+
+/**
+ * @brief 测试本地释放链表：同一 CPU 上压入、回收，闸门关闭或不在该 CPU 上时拒绝。
+ */
+void test_slab_local_free_list(void) {
+    if (nvm_rseq_cpu_id() < 0) TEST_IGNORE_MESSAGE("rseq is not registered for this thread.");
+
+    NvmSlab* slab = nvm_slab_create(SC_4K, 0);
+    TEST_ASSERT_NOT_NULL(slab);
+    char* slab_mem = (char*)malloc(NVM_SLAB_SIZE);
+    TEST_ASSERT_NOT_NULL(slab_mem);
+
+    uint32_t idx[3];
+    TEST_ASSERT_EQUAL_UINT32(3, nvm_slab_alloc_batch(slab, idx, 3));
+    uint32_t cache_before = slab->cache_count;
+
+    // 不在部分占用链表上：闸门关闭
+    TEST_ASSERT_EQUAL_INT(-1, nvm_slab_local_push(slab, slab_mem, idx[0], nvm_rseq_cpu_id()));
+
+    // 压入只改表头：计数、缓存不变 (序列被抢占时重试)
+    slab->list_id = SLAB_LIST_PARTIAL;
+    while (nvm_slab_local_push(slab, slab_mem, idx[0], nvm_rseq_cpu_id()) != 0) {}
+    while (nvm_slab_local_push(slab, slab_mem, idx[2], nvm_rseq_cpu_id()) != 0) {}
+    TEST_ASSERT_EQUAL_UINT32(2, nvm_slab_local_pending(slab));
+    TEST_ASSERT_EQUAL_UINT32(3, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(cache_before, slab->cache_count);
+    TEST_ASSERT_EQUAL_UINT32(idx[0], *(uint32_t*)(slab_mem + (uint64_t)idx[2] * slab->block_size));
+
+    // 不在给定 CPU 上时既不能压入也不能回收
+    int other = nvm_rseq_cpu_id() + 1;
+    TEST_ASSERT_EQUAL_INT(-1, nvm_slab_local_push(slab, slab_mem, idx[1], other));
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_collect_local(slab, slab_mem, other));
+    TEST_ASSERT_EQUAL_UINT32(2, nvm_slab_local_pending(slab));
+
+    uint32_t collected;
+    while ((collected = nvm_slab_collect_local(slab, slab_mem, nvm_rseq_cpu_id())) == 0) {}
+    TEST_ASSERT_EQUAL_UINT32(2, collected);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_local_pending(slab));
+    TEST_ASSERT_EQUAL_UINT32(1, slab->allocated_block_count);
+    TEST_ASSERT_EQUAL_UINT32(cache_before + 2, slab->cache_count);
+
+    // 重置清空链表
+    while (nvm_slab_local_push(slab, slab_mem, idx[1], nvm_rseq_cpu_id()) != 0) {}
+    nvm_slab_reset(slab, NVM_SLAB_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_local_pending(slab));
+
+    free(slab_mem);
+    nvm_slab_destroy(slab);
+}
+
+/**
+ * @brief 测试预留标记：同一块只能标记一次、清除一次，越界索引失败，重置后全部清除。
+ */
+void test_slab_reserve_block(void) {
+    NvmSlab* slab = nvm_slab_create(SC_64B, 0);
+    TEST_ASSERT_NOT_NULL(slab);
+    uint32_t last = slab->total_block_count - 1;
+
+    TEST_ASSERT_EQUAL_INT(0, nvm_slab_reserve_block(slab, 3));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_slab_reserve_block(slab, 3));
+    TEST_ASSERT_EQUAL_INT(0, nvm_slab_reserve_block(slab, last));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_slab_reserve_block(slab, slab->total_block_count));
+
+    TEST_ASSERT_EQUAL_INT(0, nvm_slab_unreserve_block(slab, 3));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_slab_unreserve_block(slab, 3));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_slab_unreserve_block(slab, 4));
+    TEST_ASSERT_EQUAL_INT(-1, nvm_slab_unreserve_block(slab, slab->total_block_count));
+
+    // 预留标记与位图互不影响
+    TEST_ASSERT_TRUE(nvm_slab_is_empty(slab));
+
+    nvm_slab_reset(slab, 65536);
+    TEST_ASSERT_EQUAL_INT(-1, nvm_slab_unreserve_block(slab, last));
+    nvm_slab_destroy(slab);
+}
+
+/**
+ * @brief 测试块数不是 64 整数倍时，末字尾部的无效位不会被分配出去。
+ */
+void test_slab_bitmap_tail_bits(void) {
+    // 直接构造一个非 64 对齐的块数：复用 4K 类的描述符并缩小块数
+    NvmSlab* slab = nvm_slab_create(SC_4K, 0);
+    TEST_ASSERT_NOT_NULL(slab);
+    slab->total_block_count = 70;
+    slab->bitmap_words      = 2;
+    slab->summary_words     = 1;
+    slab->summary           = &slab->bitmap[2];
+    nvm_slab_reset(slab, 0);
+
+    uint32_t block_idx;
+    for (uint32_t i = 0; i < 70; ++i) {
+        TEST_ASSERT_EQUAL_INT(0, slab_alloc_one(slab, &block_idx));
+        TEST_ASSERT_TRUE(block_idx < 70);
+    }
+    TEST_ASSERT_EQUAL_INT(-1, slab_alloc_one(slab, &block_idx));
+
+    nvm_slab_destroy(slab);
+}
+
+
 // 这是一个宏，用于简化调用辅助函数，并提供更好的失败信息
 // Unity 没有直接支持参数化测试，我们用这种方式模拟
 #define RUN_TEST_CASE(sc_id) \
@@ -258,15 +551,15 @@ static void perform_full_lifecycle_test_for_size(SizeClassID sc_id) {
     int ret;
 
     // 2. 验证总块数计算是否合理
-    // (2MB / block_size) 应该等于 total_blocks
+    // (span_size / block_size) 应该等于 total_blocks
     // 这是一个很好的交叉验证
     uint32_t expected_block_size = get_block_size_from_sc_id(sc_id);
-    TEST_ASSERT_EQUAL_UINT32( (SIMULATED_NVM_SIZE / expected_block_size), total_blocks );
+    TEST_ASSERT_EQUAL_UINT32( (get_span_size_from_sc_id(sc_id) / expected_block_size), total_blocks );
 
 
     // 3. 将 Slab 完全填满
     for (uint32_t i = 0; i < total_blocks; ++i) {
-        ret = nvm_slab_alloc(slab, &block_idx);
+        ret = slab_alloc_one(slab, &block_idx);
         if (ret != 0) {
             // 如果在填满前分配失败，立即报错并停止
             TEST_FAIL_MESSAGE("Allocation failed unexpectedly before slab was full.");
@@ -277,7 +570,7 @@ static void perform_full_lifecycle_test_for_size(SizeClassID sc_id) {
     TEST_ASSERT_TRUE_MESSAGE(nvm_slab_is_full(slab), "Slab should be full after allocating all blocks.");
     TEST_ASSERT_EQUAL_UINT32_MESSAGE(total_blocks, slab->allocated_block_count, "Allocated count should match total blocks when full.");
     // 尝试再次分配，应该会失败
-    ret = nvm_slab_alloc(slab, &block_idx);
+    ret = slab_alloc_one(slab, &block_idx);
     TEST_ASSERT_EQUAL_INT_MESSAGE(-1, ret, "Allocation should fail on a full slab.");
 
     // 5. 将 Slab 完全释放
@@ -291,11 +584,11 @@ static void perform_full_lifecycle_test_for_size(SizeClassID sc_id) {
     slab = nvm_slab_create(sc_id, 0); // 重新创建一个干净的
     
     for (uint32_t i = 0; i < total_blocks; ++i) {
-        nvm_slab_alloc(slab, &indices[i]);
+        slab_alloc_one(slab, &indices[i]);
     }
     // 现在我们有了所有真实的索引，再释放它们
     for (uint32_t i = 0; i < total_blocks; ++i) {
-        nvm_slab_free(slab, indices[i]);
+        nvm_slab_free_local(slab, indices[i]);
     }
     free(indices);
 
@@ -324,9 +617,66 @@ void test_slab_behavior_with_various_sizes(void) {
 
     // 测试一个较大的尺寸
     RUN_TEST_CASE(SC_4K);
+
+    // 测试中型类别 (块数少，末字尾部位较多)
+    RUN_TEST_CASE(SC_12K);
+    RUN_TEST_CASE(SC_192K);
+    RUN_TEST_CASE(SC_512K);
     
 }
 
+/**
+ * @brief 测试中型类别的块大小：1KB 对齐、单调递增，且 Slab 跨度的尾部浪费很小。
+ */
+void test_slab_medium_class_sizes(void) {
+    uint32_t prev = nvm_slab_class_block_size(SC_4K);
+    for (int sc = SC_5K; sc < SC_COUNT; ++sc) {
+        uint32_t size = nvm_slab_class_block_size((SizeClassID)sc);
+        TEST_ASSERT_GREATER_THAN_UINT32(prev, size);
+        TEST_ASSERT_EQUAL_UINT32(0, size % NVM_MEDIUM_QUANTUM);
+
+        uint32_t span  = nvm_slab_class_span_size((SizeClassID)sc);
+        uint32_t waste = span % size;
+        TEST_ASSERT_TRUE_MESSAGE(waste * 64 <= span, "Medium class wastes more than 1/64 of a slab.");
+        prev = size;
+    }
+    TEST_ASSERT_EQUAL_UINT32(NVM_MAX_SLAB_BLOCK_SIZE, prev);
+    TEST_ASSERT_EQUAL_UINT32(0, nvm_slab_class_block_size(SC_COUNT));
+
+    // 块数很少的 Slab：位图只有一个字，尾部无效位不会被分配出去
+    NvmSlab* slab = nvm_slab_create(SC_192K, 0);
+    TEST_ASSERT_NOT_NULL(slab);
+    TEST_ASSERT_EQUAL_UINT32(21, slab->total_block_count);
+    TEST_ASSERT_EQUAL_UINT32(1, slab->bitmap_words);
+    uint32_t idx[32];
+    TEST_ASSERT_EQUAL_UINT32(21, nvm_slab_alloc_batch(slab, idx, 32));
+    for (int i = 0; i < 21; ++i) {
+        TEST_ASSERT_LESS_THAN_UINT32(21, idx[i]);
+    }
+    TEST_ASSERT_TRUE(nvm_slab_is_full(slab));
+    nvm_slab_destroy(slab);
+}
+
+/**
+ * @brief 测试乘法-移位块索引：每个类别在每个块的首尾字节处均与除法一致。
+ */
+void test_slab_block_index_reciprocal(void) {
+    for (int sc = 0; sc < SC_COUNT; ++sc) {
+        NvmSlab* slab = nvm_slab_create((SizeClassID)sc, 0);
+        TEST_ASSERT_NOT_NULL(slab);
+        uint32_t size = slab->block_size;
+
+        // 乘法-移位是单调的，区间两端正确即整个区间正确
+        for (uint64_t off = 0; off < slab->span_size; off += size) {
+            TEST_ASSERT_EQUAL_UINT32(off / size, nvm_slab_block_index(slab, off));
+            uint64_t last = off + size - 1;
+            if (last >= slab->span_size) last = slab->span_size - 1;
+            TEST_ASSERT_EQUAL_UINT32(last / size, nvm_slab_block_index(slab, last));
+        }
+        nvm_slab_destroy(slab);
+    }
+}
+
 
 
 
@@ -340,6 +690,17 @@ int main(void) {
     RUN_TEST(test_nvm_slab_creation_and_destruction);
     RUN_TEST(test_slab_alloc_free_cache_behavior);
     RUN_TEST(test_slab_behavior_with_various_sizes);
+    RUN_TEST(test_slab_medium_class_sizes);
+    RUN_TEST(test_slab_block_index_reciprocal);
+    RUN_TEST(test_slab_reset_for_reuse);
+    RUN_TEST(test_slab_bitmap_summary_search);
+    RUN_TEST(test_slab_bitmap_tail_bits);
+    RUN_TEST(test_slab_load_bitmap);
+    RUN_TEST(test_slab_alloc_batch);
+    RUN_TEST(test_slab_remote_free_and_collect);
+    RUN_TEST(test_slab_free_local);
+    RUN_TEST(test_slab_local_free_list);
+    RUN_TEST(test_slab_reserve_block);
 
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "unity.h"
+#include "NvmDefs.h"       // For NVM_SPAN_UNIT
+#include "NvmSlab.h"       // For NvmSlab* type
+#include "SlabPageMap.h"
+
+// We directly include the .c file for white-box testing.
+#include "SlabPageMap.c"
+
+#include <stdlib.h>
+
+// 3 个叶子多一点，覆盖跨叶子的情况
+#define TEST_PAGE_COUNT  (3 * PAGEMAP_LEAF_ENTRIES + 5)
+#define TEST_NVM_SIZE    ((uint64_t)TEST_PAGE_COUNT * NVM_SPAN_UNIT)
+#define PAGE             NVM_SPAN_UNIT
+
+// 页映射表只存储指针，不解引用，使用伪造的指针值即可
+#define MOCK_SLAB_1 ((NvmSlab*)0x1000)
+#define MOCK_SLAB_2 ((NvmSlab*)0x2000)
+#define MOCK_SLAB_3 ((NvmSlab*)0x3000)
+#define MOCK_EXTENT ((NvmExtent*)0x4000)
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+//                          测试用例
+// ============================================================================
+
+/**
+ * @brief 测试页映射表的创建和销毁。
+ */
+void test_pagemap_creation_and_destruction(void) {
+    // --- 子测试 1: 正常创建，根数组按页数向上取整 ---
+    SlabPageMap* map = slab_pagemap_create(TEST_NVM_SIZE, 0);
+    TEST_ASSERT_NOT_NULL(map);
+    TEST_ASSERT_EQUAL_UINT64(TEST_PAGE_COUNT, map->page_count);
+    TEST_ASSERT_EQUAL_UINT32(4, map->root_count);
+    TEST_ASSERT_EQUAL_UINT32(0, slab_pagemap_count(map));
+
+    // 白盒测试: 叶子按需分配，创建时全部为空
+    for (uint32_t i = 0; i < map->root_count; ++i) {
+        TEST_ASSERT_NULL(map->root[i]);
+    }
+    slab_pagemap_destroy(map);
+
+    // --- 子测试 2: 空间不足一个单元 ---
+    TEST_ASSERT_NULL(slab_pagemap_create(NVM_SPAN_UNIT - 1, 0));
+
+    // --- 子测试 3: 销毁 NULL 指针 ---
+    slab_pagemap_destroy(NULL);
+}
+
+/**
+ * @brief 测试插入与查找：Slab 内任意偏移都应解析到同一个 Slab。
+ */
+void test_pagemap_insert_and_lookup(void) {
+    SlabPageMap* map = slab_pagemap_create(TEST_NVM_SIZE, 0);
+    uint64_t key1 = 0;
+    uint64_t key2 = 5 * PAGE;
+
+    TEST_ASSERT_EQUAL_INT(0, slab_pagemap_insert(map, key1, PAGE, MOCK_SLAB_1));
+    TEST_ASSERT_EQUAL_INT(0, slab_pagemap_insert(map, key2, PAGE, MOCK_SLAB_2));
+    TEST_ASSERT_EQUAL_UINT32(2, slab_pagemap_count(map));
+
+    // 页首、页内、页尾
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_1, slab_pagemap_lookup(map, key1));
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_1, slab_pagemap_lookup(map, key1 + 4096));
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_1, slab_pagemap_lookup(map, key1 + PAGE - 1));
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_2, slab_pagemap_lookup(map, key2 + 123));
+
+    // 未映射的页
+    TEST_ASSERT_NULL(slab_pagemap_lookup(map, PAGE));
+
+    // 重复插入失败，旧值不被覆盖
+    TEST_ASSERT_EQUAL_INT(-1, slab_pagemap_insert(map, key1, PAGE, MOCK_SLAB_3));
+    TEST_ASSERT_EQUAL_UINT32(2, slab_pagemap_count(map));
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_1, slab_pagemap_lookup(map, key1));
+
+    // 白盒测试: 两个页位于同一叶子，只分配了一个叶子
+    TEST_ASSERT_NOT_NULL(map->root[0]);
+    TEST_ASSERT_NULL(map->root[1]);
+
+    slab_pagemap_destroy(map);
+}
+
+/**
+ * @brief 测试越界与跨叶子的映射。
+ */
+void test_pagemap_bounds_and_leaves(void) {
+    const uint64_t start = 4 * PAGE;
+    SlabPageMap* map = slab_pagemap_create(TEST_NVM_SIZE, start);
+
+    uint64_t last_page  = start + (uint64_t)(TEST_PAGE_COUNT - 1) * PAGE;
+    uint64_t second_leaf = start + (uint64_t)PAGEMAP_LEAF_ENTRIES * PAGE;
+
+    TEST_ASSERT_EQUAL_INT(0, slab_pagemap_insert(map, last_page, PAGE, MOCK_SLAB_1));
+    TEST_ASSERT_EQUAL_INT(0, slab_pagemap_insert(map, second_leaf, PAGE, MOCK_SLAB_2));
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_1, slab_pagemap_lookup(map, last_page + 8));
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_2, slab_pagemap_lookup(map, second_leaf));
+    TEST_ASSERT_NOT_NULL(map->root[1]);
+    TEST_ASSERT_NOT_NULL(map->root[3]);
+
+    // 低于起始偏移或超过末尾的偏移均不可映射
+    TEST_ASSERT_NULL(slab_pagemap_lookup(map, 0));
+    TEST_ASSERT_NULL(slab_pagemap_lookup(map, last_page + PAGE));
+    TEST_ASSERT_EQUAL_INT(-1, slab_pagemap_insert(map, 0, PAGE, MOCK_SLAB_3));
+    TEST_ASSERT_EQUAL_INT(-1, slab_pagemap_insert(map, last_page + PAGE, PAGE, MOCK_SLAB_3));
+    TEST_ASSERT_EQUAL_UINT32(2, slab_pagemap_count(map));
+
+    slab_pagemap_destroy(map);
+}
+
+/**
+ * @brief 测试移除：移除后查找返回 NULL，且可重新发布。
+ */
+void test_pagemap_remove(void) {
+    SlabPageMap* map = slab_pagemap_create(TEST_NVM_SIZE, 0);
+    uint64_t key = 7 * PAGE;
+
+    // 移除未映射的页 (叶子未分配 / 叶子已分配)
+    TEST_ASSERT_NULL(slab_pagemap_remove(map, key, PAGE));
+    slab_pagemap_insert(map, key, PAGE, MOCK_SLAB_1);
+    TEST_ASSERT_NULL(slab_pagemap_remove(map, 0, PAGE));
+    TEST_ASSERT_EQUAL_UINT32(1, slab_pagemap_count(map));
+
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_1, slab_pagemap_remove(map, key + 64, PAGE));
+    TEST_ASSERT_EQUAL_UINT32(0, slab_pagemap_count(map));
+    TEST_ASSERT_NULL(slab_pagemap_lookup(map, key));
+
+    // 同一页重新发布新的 Slab
+    TEST_ASSERT_EQUAL_INT(0, slab_pagemap_insert(map, key, PAGE, MOCK_SLAB_2));
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_2, slab_pagemap_lookup(map, key));
+
+    slab_pagemap_destroy(map);
+}
+
+/**
+ * @brief 测试区块映射：与 Slab 映射共用表项，按类型标记互不混淆。
+ */
+void test_pagemap_extent_entries(void) {
+    SlabPageMap* map = slab_pagemap_create(TEST_NVM_SIZE, 0);
+    uint64_t slab_key   = 2 * PAGE;
+    uint64_t extent_key = 3 * PAGE;
+
+    TEST_ASSERT_EQUAL_INT(0, slab_pagemap_insert(map, slab_key, PAGE, MOCK_SLAB_1));
+    TEST_ASSERT_EQUAL_INT(0, slab_pagemap_insert_extent(map, extent_key, PAGE, MOCK_EXTENT));
+    TEST_ASSERT_EQUAL_UINT32(2, slab_pagemap_count(map));
+
+    // 按类型查找：另一种类型的查找返回 NULL
+    TEST_ASSERT_EQUAL_PTR(MOCK_EXTENT, slab_pagemap_lookup_extent(map, extent_key + 4096));
+    TEST_ASSERT_NULL(slab_pagemap_lookup(map, extent_key));
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_1, slab_pagemap_lookup(map, slab_key));
+    TEST_ASSERT_NULL(slab_pagemap_lookup_extent(map, slab_key));
+
+    // 已映射的页不能再发布另一种元数据
+    TEST_ASSERT_EQUAL_INT(-1, slab_pagemap_insert(map, extent_key, PAGE, MOCK_SLAB_2));
+
+    // 按类型撤销：类型不符时不改动表项
+    TEST_ASSERT_NULL(slab_pagemap_remove(map, extent_key, PAGE));
+    TEST_ASSERT_NULL(slab_pagemap_remove_extent(map, slab_key, PAGE));
+    TEST_ASSERT_EQUAL_UINT32(2, slab_pagemap_count(map));
+    TEST_ASSERT_EQUAL_PTR(MOCK_EXTENT, slab_pagemap_remove_extent(map, extent_key, PAGE));
+    TEST_ASSERT_NULL(slab_pagemap_lookup_extent(map, extent_key));
+    TEST_ASSERT_EQUAL_UINT32(1, slab_pagemap_count(map));
+
+    slab_pagemap_destroy(map);
+}
+
+/**
+ * @brief 测试跨多个单元的 Slab：每个单元都指向同一 Slab，冲突时整体回滚。
+ */
+void test_pagemap_multi_unit_span(void) {
+    SlabPageMap* map = slab_pagemap_create(TEST_NVM_SIZE, 0);
+
+    // 跨越第一、二个叶子边界的 8 单元跨度
+    uint64_t key  = (uint64_t)(PAGEMAP_LEAF_ENTRIES - 4) * PAGE;
+    uint64_t span = 8 * PAGE;
+
+    TEST_ASSERT_EQUAL_INT(0, slab_pagemap_insert(map, key, span, MOCK_SLAB_1));
+    TEST_ASSERT_EQUAL_UINT32(8, slab_pagemap_count(map));
+    for (uint64_t off = 0; off < span; off += PAGE / 2) {
+        TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_1, slab_pagemap_lookup(map, key + off));
+    }
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_1, slab_pagemap_lookup(map, key + span - 1));
+    TEST_ASSERT_NULL(slab_pagemap_lookup(map, key + span));
+    TEST_ASSERT_NULL(slab_pagemap_lookup(map, key - 1));
+
+    // 与已有跨度头部重叠：前两个单元发布后冲突，失败且不留下部分映射
+    TEST_ASSERT_EQUAL_INT(-1, slab_pagemap_insert(map, key - 2 * PAGE, 4 * PAGE, MOCK_SLAB_2));
+    TEST_ASSERT_EQUAL_UINT32(8, slab_pagemap_count(map));
+    TEST_ASSERT_NULL(slab_pagemap_lookup(map, key - 2 * PAGE));
+
+    // 越过末尾、大小非单元整数倍均失败
+    TEST_ASSERT_EQUAL_INT(-1, slab_pagemap_insert(map, (uint64_t)(TEST_PAGE_COUNT - 1) * PAGE, span, MOCK_SLAB_2));
+    TEST_ASSERT_EQUAL_INT(-1, slab_pagemap_insert(map, 0, PAGE + 1, MOCK_SLAB_2));
+    TEST_ASSERT_EQUAL_UINT32(8, slab_pagemap_count(map));
+
+    // 整体撤销
+    TEST_ASSERT_EQUAL_PTR(MOCK_SLAB_1, slab_pagemap_remove(map, key, span));
+    TEST_ASSERT_EQUAL_UINT32(0, slab_pagemap_count(map));
+    TEST_ASSERT_NULL(slab_pagemap_lookup(map, key + span - 1));
+
+    slab_pagemap_destroy(map);
+}
+
+
+// ============================================================================
+//                          测试执行入口
+// ============================================================================
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_pagemap_creation_and_destruction);
+    RUN_TEST(test_pagemap_insert_and_lookup);
+    RUN_TEST(test_pagemap_bounds_and_leaves);
+    RUN_TEST(test_pagemap_remove);
+    RUN_TEST(test_pagemap_extent_entries);
+    RUN_TEST(test_pagemap_multi_unit_span);
+
+    return UNITY_END();
+}
\ No newline at end of file
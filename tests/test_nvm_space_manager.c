@@ -7,11 +7,14 @@
 #include "NvmSpaceManager.c" 
 
 #include <stdlib.h>
+#include <pthread.h>
 
 // 为测试环境定义常量
 // **修正: 将 NVM_CHUNK_SIZE 改为 SLAB_SIZE，与 NvmDefs.h 中的定义保持一致**
 #define TOTAL_TEST_SIZE (10 * NVM_SLAB_SIZE) 
 #define NUM_CHUNKS (10)
+#define CHURN_SLOTS (64)
+#define WILD_THREADS (4)
 
 // setUp 和 tearDown 在本测试文件中可以是空的，因为每个测试
 // 都会创建和销毁自己的 Manager 实例，以保证测试的完全隔离。
@@ -22,14 +25,21 @@ void tearDown(void) {}
 //                          辅助函数
 // =================================A===========================================
 
-// 辅助函数，用于验证链表中只有一个节点，并且其属性正确
+// 辅助函数，验证 from 之后的下一个连续空闲段
+static void verify_free_range(FreeSpaceManager* manager, uint64_t from, uint64_t expected_offset, uint64_t expected_size) {
+    uint64_t offset, size;
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, space_manager_next_free_range(manager, from, &offset, &size), "Free range expected.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(expected_offset, offset, "Free range offset mismatch.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(expected_size, size, "Free range size mismatch.");
+}
+
+// 辅助函数，用于验证空闲空间只有一个连续段，并且其属性正确
 static void verify_single_node_state(FreeSpaceManager* manager, uint64_t expected_offset, uint64_t expected_size) {
-    TEST_ASSERT_NOT_NULL_MESSAGE(manager->head, "Manager head should not be NULL.");
-    TEST_ASSERT_EQUAL_PTR_MESSAGE(manager->head, manager->tail, "Head and tail should be the same for a single node list.");
-    TEST_ASSERT_NULL_MESSAGE(manager->head->prev, "Single node's prev should be NULL.");
-    TEST_ASSERT_NULL_MESSAGE(manager->head->next, "Single node's next should be NULL.");
-    TEST_ASSERT_EQUAL_UINT64_MESSAGE(expected_offset, manager->head->nvm_offset, "Node offset mismatch.");
-    TEST_ASSERT_EQUAL_UINT64_MESSAGE(expected_size, manager->head->size, "Node size mismatch.");
+    uint64_t offset, size;
+    verify_free_range(manager, 0, expected_offset, expected_size);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(-1, space_manager_next_free_range(manager, expected_offset + expected_size, &offset, &size),
+                                  "There should be a single free range.");
+    TEST_ASSERT_EQUAL_UINT64(expected_size, space_manager_free_bytes(manager));
 }
 
 
@@ -78,11 +88,9 @@ void test_alloc_and_free_with_merging(void) {
     // 释放 c1。它被 c0 和 c2 包围，无法合并。
     space_manager_free_slab(manager, c1);
     
-    // 链表应为: [c1] -> [c3-c9]
-    TEST_ASSERT_EQUAL_UINT64(c1, manager->head->nvm_offset);
-    TEST_ASSERT_EQUAL_UINT64(NVM_SLAB_SIZE, manager->head->size);
-    TEST_ASSERT_NOT_NULL(manager->head->next);
-    TEST_ASSERT_EQUAL_UINT64(offset_after_c2, manager->head->next->nvm_offset);
+    // 空闲段应为: [c1] -> [c3-c9]
+    verify_free_range(manager, 0, c1, NVM_SLAB_SIZE);
+    verify_free_range(manager, c1 + NVM_SLAB_SIZE, offset_after_c2, TOTAL_TEST_SIZE - offset_after_c2);
     space_manager_destroy(manager);
 
     // ========================================================================
@@ -95,9 +103,8 @@ void test_alloc_and_free_with_merging(void) {
     space_manager_free_slab(manager, c1); // 先释放 c1
     space_manager_free_slab(manager, c0); // 再释放 c0，应与 c1 向前合并
     
-    // 链表应为: [c0-c1] -> [c2-c9]
-    TEST_ASSERT_EQUAL_UINT64(c0, manager->head->nvm_offset);
-    TEST_ASSERT_EQUAL_UINT64(10 * NVM_SLAB_SIZE, manager->head->size);
+    // 空闲段应为: [c0-c9]
+    verify_single_node_state(manager, c0, 10 * NVM_SLAB_SIZE);
     space_manager_destroy(manager);
 
     // ========================================================================
@@ -126,9 +133,8 @@ void test_alloc_and_free_with_merging(void) {
     // 链表: [c2] -> [c4-c9]
     space_manager_free_slab(manager, c1); // 释放 c1, 它应该和 [c2] 向后合并
     
-    // 链表应为: [c1-c2] -> [c4-c9]
-    TEST_ASSERT_EQUAL_UINT64(c1, manager->head->nvm_offset);
-    TEST_ASSERT_EQUAL_UINT64(2 * NVM_SLAB_SIZE, manager->head->size);
+    // 空闲段应为: [c1-c2] -> [c4-c9]
+    verify_free_range(manager, 0, c1, 2 * NVM_SLAB_SIZE);
     space_manager_destroy(manager);
 
     // ========================================================================
@@ -147,10 +153,9 @@ void test_alloc_and_free_with_merging(void) {
     
     space_manager_free_slab(manager, c2); // 释放 c2, 连接 [c1] 和 [c3]
     
-    // 链表应为: [c1-c3] -> [c5-c9]
-    TEST_ASSERT_EQUAL_UINT64(c1, manager->head->nvm_offset);
-    TEST_ASSERT_EQUAL_UINT64(3 * NVM_SLAB_SIZE, manager->head->size);
-    TEST_ASSERT_NOT_NULL(manager->head->next);
+    // 空闲段应为: [c1-c3] -> [c5-c9]
+    verify_free_range(manager, 0, c1, 3 * NVM_SLAB_SIZE);
+    verify_free_range(manager, c4, c4 + NVM_SLAB_SIZE, TOTAL_TEST_SIZE - c4 - NVM_SLAB_SIZE);
     space_manager_destroy(manager);
 }
 
@@ -174,7 +179,7 @@ void test_full_allocation_and_deallocation_cycle(void) {
     }
     
     // --- 2. 验证空间已耗尽 ---
-    TEST_ASSERT_NULL_MESSAGE(manager->head, "Manager should be empty after full allocation.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, space_manager_free_bytes(manager), "Manager should be empty after full allocation.");
     uint64_t extra_alloc = space_manager_alloc_slab(manager);
     TEST_ASSERT_EQUAL_UINT64_MESSAGE((uint64_t)-1, extra_alloc, "Allocation should fail when space is exhausted.");
 
@@ -191,7 +196,7 @@ void test_full_allocation_and_deallocation_cycle(void) {
         uint64_t offset = space_manager_alloc_slab(manager);
         TEST_ASSERT_NOT_EQUAL((uint64_t)-1, offset);
     }
-    TEST_ASSERT_NULL_MESSAGE(manager->head, "Re-allocation should also exhaust the manager.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, space_manager_free_bytes(manager), "Re-allocation should also exhaust the manager.");
 
     // 清理
     free(offsets);
@@ -199,6 +204,375 @@ void test_full_allocation_and_deallocation_cycle(void) {
 }
 
 
+/**
+ * @brief 测试多 Slab 连续空间的分配与合并释放。
+ */
+void test_multi_slab_alloc_and_free(void) {
+    FreeSpaceManager* manager = space_manager_create(TOTAL_TEST_SIZE, 0);
+    TEST_ASSERT_NOT_NULL(manager);
+
+    // --- 1. 非跨度单元整数倍的大小被拒绝 ---
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)-1, space_manager_alloc(manager, NVM_SLAB_SIZE + 4096));
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)-1, space_manager_alloc(manager, 0));
+
+    // --- 2. 分配 3 + 1 + 4 个 Slab ---
+    uint64_t a = space_manager_alloc(manager, 3 * NVM_SLAB_SIZE);
+    uint64_t b = space_manager_alloc_slab(manager);
+    uint64_t c = space_manager_alloc(manager, 4 * NVM_SLAB_SIZE);
+    TEST_ASSERT_EQUAL_UINT64(0, a);
+    TEST_ASSERT_EQUAL_UINT64(3 * NVM_SLAB_SIZE, b);
+    TEST_ASSERT_EQUAL_UINT64(4 * NVM_SLAB_SIZE, c);
+    verify_single_node_state(manager, 8 * NVM_SLAB_SIZE, 2 * NVM_SLAB_SIZE);
+
+    // --- 3. 剩余空间不足时失败 ---
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)-1, space_manager_alloc(manager, 3 * NVM_SLAB_SIZE));
+
+    // --- 4. 释放 a 与 c 后，b 的两侧为空洞，跳过放不下的空洞 ---
+    // (5 个 Slab 没有对应的单个伙伴块，按地址查找跨越块边界的连续空闲段)
+    space_manager_free(manager, a, 3 * NVM_SLAB_SIZE);
+    space_manager_free(manager, c, 4 * NVM_SLAB_SIZE);
+    verify_free_range(manager, 0, 0, 3 * NVM_SLAB_SIZE);
+    verify_free_range(manager, 3 * NVM_SLAB_SIZE, 4 * NVM_SLAB_SIZE, 6 * NVM_SLAB_SIZE);
+
+    uint64_t d = space_manager_alloc(manager, 5 * NVM_SLAB_SIZE);
+    TEST_ASSERT_EQUAL_UINT64(4 * NVM_SLAB_SIZE, d);
+
+    // --- 5. 全部释放后合并为一个节点 ---
+    space_manager_free(manager, d, 5 * NVM_SLAB_SIZE);
+    space_manager_free_slab(manager, b);
+    verify_single_node_state(manager, 0, TOTAL_TEST_SIZE);
+
+    space_manager_destroy(manager);
+}
+
+/**
+ * @brief 测试按跨度对齐的分配与指定偏移占位：对齐产生的空隙保留为空闲段。
+ */
+void test_aligned_alloc_and_alloc_at_offset(void) {
+    FreeSpaceManager* manager = space_manager_create(TOTAL_TEST_SIZE, 0);
+    TEST_ASSERT_NOT_NULL(manager);
+
+    // --- 1. 非法对齐被拒绝 ---
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)-1, space_manager_alloc_aligned(manager, NVM_SPAN_UNIT, 4096));
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)-1, space_manager_alloc_aligned(manager, NVM_SPAN_UNIT, 3 * NVM_SPAN_UNIT));
+
+    // --- 2. 一个单元之后的 4MB 对齐分配跳到 4MB 处，头部空隙仍可分配 ---
+    uint64_t unit = space_manager_alloc(manager, NVM_SPAN_UNIT);
+    uint64_t big  = space_manager_alloc_aligned(manager, 2 * NVM_SLAB_SIZE, 2 * NVM_SLAB_SIZE);
+    TEST_ASSERT_EQUAL_UINT64(0, unit);
+    TEST_ASSERT_EQUAL_UINT64(2 * NVM_SLAB_SIZE, big);
+    verify_free_range(manager, 0, NVM_SPAN_UNIT, 2 * NVM_SLAB_SIZE - NVM_SPAN_UNIT);
+    // 伙伴块按自身大小对齐：4 个单元落在第一个 4 单元对齐的空闲块上
+    TEST_ASSERT_EQUAL_UINT64(4 * NVM_SPAN_UNIT, space_manager_alloc(manager, 4 * NVM_SPAN_UNIT));
+
+    // --- 3. 在空闲段中间占位会分裂节点；已占用的区域失败 ---
+    TEST_ASSERT_EQUAL_INT(0, space_manager_alloc_at_offset(manager, 6 * NVM_SLAB_SIZE, 2 * NVM_SPAN_UNIT));
+    TEST_ASSERT_EQUAL_INT(-1, space_manager_alloc_at_offset(manager, 6 * NVM_SLAB_SIZE + NVM_SPAN_UNIT, NVM_SPAN_UNIT));
+    TEST_ASSERT_EQUAL_INT(-1, space_manager_alloc_at_offset(manager, 2 * NVM_SLAB_SIZE, NVM_SPAN_UNIT));
+
+    // --- 4. 全部释放后合并为一个节点 ---
+    space_manager_free(manager, 6 * NVM_SLAB_SIZE, 2 * NVM_SPAN_UNIT);
+    space_manager_free(manager, 4 * NVM_SPAN_UNIT, 4 * NVM_SPAN_UNIT);
+    space_manager_free(manager, big, 2 * NVM_SLAB_SIZE);
+    space_manager_free(manager, unit, NVM_SPAN_UNIT);
+    verify_single_node_state(manager, 0, TOTAL_TEST_SIZE);
+
+    space_manager_destroy(manager);
+}
+
+/**
+ * @brief 测试批量指定偏移占位：相邻区间合并占位，任何一段失败时全部回滚。
+ */
+void test_alloc_at_offsets_batch(void) {
+    FreeSpaceManager* manager = space_manager_create(TOTAL_TEST_SIZE, 0);
+    TEST_ASSERT_NOT_NULL(manager);
+    const uint64_t U = NVM_SPAN_UNIT;
+    TEST_ASSERT_EQUAL_UINT64(0, space_manager_alloc(manager, U));
+
+    // --- 1. 跨越回收空间与荒野的一批区间 ---
+    const uint64_t offsets[] = { 2 * U, 3 * U, 8 * U, 2 * NVM_SLAB_SIZE };
+    const uint64_t sizes[]   = { U, U, 2 * U, NVM_SLAB_SIZE };
+    TEST_ASSERT_EQUAL_INT(0, space_manager_alloc_at_offsets(manager, offsets, sizes, 4));
+    TEST_ASSERT_EQUAL_UINT64(TOTAL_TEST_SIZE - 5 * U - NVM_SLAB_SIZE, space_manager_free_bytes(manager));
+    TEST_ASSERT_EQUAL_INT(-1, space_manager_alloc_at_offset(manager, 3 * U, U));
+    verify_free_range(manager, 0, U, U);
+    verify_free_range(manager, 4 * U, 4 * U, 4 * U);
+    TEST_ASSERT_EQUAL_INT(0, space_manager_alloc_at_offsets(manager, offsets, sizes, 0));
+
+    // --- 2. 未排序、重叠或未对齐的区间被拒绝 ---
+    const uint64_t unsorted[] = { 5 * U, 4 * U };
+    const uint64_t overlap[]  = { 4 * U, 5 * U };
+    const uint64_t ones[]     = { U, U };
+    const uint64_t twos[]     = { 2 * U, U };
+    const uint64_t odd[]      = { 4 * U + 4096 };
+    TEST_ASSERT_EQUAL_INT(-1, space_manager_alloc_at_offsets(manager, unsorted, ones, 2));
+    TEST_ASSERT_EQUAL_INT(-1, space_manager_alloc_at_offsets(manager, overlap, twos, 2));
+    TEST_ASSERT_EQUAL_INT(-1, space_manager_alloc_at_offsets(manager, odd, ones, 1));
+
+    // --- 3. 其中一段已被占用：之前占位的各段全部归还 ---
+    const uint64_t partial[] = { 4 * U, 5 * U, 9 * U, 12 * U };
+    const uint64_t partial_sizes[] = { U, U, U, U };
+    uint64_t free_before = space_manager_free_bytes(manager);
+    TEST_ASSERT_EQUAL_INT(-1, space_manager_alloc_at_offsets(manager, partial, partial_sizes, 4));
+    TEST_ASSERT_EQUAL_UINT64(free_before, space_manager_free_bytes(manager));
+    verify_free_range(manager, 4 * U, 4 * U, 4 * U);
+
+    // --- 4. 全部释放后合并为一个节点 ---
+    space_manager_free(manager, 2 * NVM_SLAB_SIZE, NVM_SLAB_SIZE);
+    space_manager_free(manager, 8 * U, 2 * U);
+    space_manager_free(manager, 2 * U, 2 * U);
+    space_manager_free(manager, 0, U);
+    verify_single_node_state(manager, 0, TOTAL_TEST_SIZE);
+
+    space_manager_destroy(manager);
+}
+
+/**
+ * @brief 随机分配/释放对齐跨度，与逐单元的参考模型对照：互不重叠、按大小对齐、
+ * 空闲字节数一致，全部释放后合并回一个空闲段。单元数不是 2 的幂。
+ */
+void test_buddy_random_churn(void) {
+    const uint64_t total = TOTAL_TEST_SIZE + 3 * NVM_SPAN_UNIT;
+    const uint64_t units = total / NVM_SPAN_UNIT;
+    FreeSpaceManager* manager = space_manager_create(total, 0);
+    TEST_ASSERT_NOT_NULL(manager);
+    verify_single_node_state(manager, 0, total);
+
+    uint64_t offsets[CHURN_SLOTS], sizes[CHURN_SLOTS];
+    uint8_t* used = (uint8_t*)calloc(units, 1);
+    TEST_ASSERT_NOT_NULL(used);
+    for (int i = 0; i < CHURN_SLOTS; ++i) sizes[i] = 0;
+
+    srand(12345);
+    uint64_t free_units = units;
+    for (int iter = 0; iter < 20000; ++iter) {
+        int slot = rand() % CHURN_SLOTS;
+        if (sizes[slot] == 0) {
+            uint64_t span = (uint64_t)NVM_SPAN_UNIT << (rand() % 7);   // 64KB ~ 4MB
+            uint64_t off = space_manager_alloc_aligned(manager, span, span);
+            if (off == (uint64_t)-1) continue;
+            TEST_ASSERT_EQUAL_UINT64(0, off % span);
+            for (uint64_t u = off / NVM_SPAN_UNIT; u < (off + span) / NVM_SPAN_UNIT; ++u) {
+                TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, used[u], "Allocated span overlaps a live span.");
+                used[u] = 1;
+            }
+            offsets[slot] = off;
+            sizes[slot]   = span;
+            free_units   -= span / NVM_SPAN_UNIT;
+        } else {
+            space_manager_free(manager, offsets[slot], sizes[slot]);
+            for (uint64_t u = offsets[slot] / NVM_SPAN_UNIT; u < (offsets[slot] + sizes[slot]) / NVM_SPAN_UNIT; ++u) {
+                used[u] = 0;
+            }
+            free_units  += sizes[slot] / NVM_SPAN_UNIT;
+            sizes[slot]  = 0;
+        }
+        TEST_ASSERT_EQUAL_UINT64(free_units * NVM_SPAN_UNIT, space_manager_free_bytes(manager));
+    }
+
+    // 重复释放与非单元对齐的区间被拒绝，状态不变
+    for (int i = 0; i < CHURN_SLOTS; ++i) {
+        if (sizes[i] == 0) continue;
+        space_manager_free(manager, offsets[i], sizes[i]);
+        space_manager_free(manager, offsets[i], sizes[i]);
+        sizes[i] = 0;
+    }
+    TEST_ASSERT_EQUAL_INT(-1, space_manager_alloc_at_offset(manager, 4096, NVM_SPAN_UNIT));
+    TEST_ASSERT_EQUAL_INT(-1, space_manager_alloc_at_offset(manager, total, NVM_SPAN_UNIT));
+    verify_single_node_state(manager, 0, total);
+
+    // 占满后的整片区域 (非 2 的幂) 只能走连续段查找
+    TEST_ASSERT_EQUAL_UINT64(0, space_manager_alloc(manager, total));
+    TEST_ASSERT_EQUAL_UINT64(0, space_manager_free_bytes(manager));
+    space_manager_free(manager, 0, total);
+    verify_single_node_state(manager, 0, total);
+
+    free(used);
+    space_manager_destroy(manager);
+}
+
+/**
+ * @brief 测试非 2 的幂大小的 Best-Fit：取最小的足够大的空闲段 (而非地址最低者)，
+ * 最大空闲段放不下时立即失败；随机分配/释放下区段索引与逐单元参考模型一致。
+ */
+void test_best_fit_extents(void) {
+    const uint64_t units = TOTAL_TEST_SIZE / NVM_SPAN_UNIT;
+    FreeSpaceManager* manager = space_manager_create(TOTAL_TEST_SIZE, 0);
+    TEST_ASSERT_NOT_NULL(manager);
+    TEST_ASSERT_EQUAL_UINT64(TOTAL_TEST_SIZE, space_manager_largest_free(manager));
+
+    // --- 1. 占满后挖出 8 / 3 / 5 个单元的三个空洞 ---
+    TEST_ASSERT_EQUAL_UINT64(0, space_manager_alloc(manager, TOTAL_TEST_SIZE));
+    TEST_ASSERT_EQUAL_UINT64(0, space_manager_largest_free(manager));
+    space_manager_free(manager, 10 * NVM_SPAN_UNIT, 8 * NVM_SPAN_UNIT);
+    space_manager_free(manager, 40 * NVM_SPAN_UNIT, 3 * NVM_SPAN_UNIT);
+    space_manager_free(manager, 100 * NVM_SPAN_UNIT, 5 * NVM_SPAN_UNIT);
+    TEST_ASSERT_EQUAL_UINT64(8 * NVM_SPAN_UNIT, space_manager_largest_free(manager));
+
+    // --- 2. 恰好放得下的空洞优先于地址更低的大空洞 ---
+    TEST_ASSERT_EQUAL_UINT64(40 * NVM_SPAN_UNIT, space_manager_alloc(manager, 3 * NVM_SPAN_UNIT));
+    TEST_ASSERT_EQUAL_UINT64(100 * NVM_SPAN_UNIT, space_manager_alloc(manager, 5 * NVM_SPAN_UNIT));
+
+    // --- 3. 总空闲量足够但没有单个空闲段放得下：立即失败 ---
+    space_manager_free(manager, 30 * NVM_SPAN_UNIT, 2 * NVM_SPAN_UNIT);
+    TEST_ASSERT_EQUAL_UINT64(10 * NVM_SPAN_UNIT, space_manager_free_bytes(manager));
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)-1, space_manager_alloc(manager, 9 * NVM_SPAN_UNIT));
+    TEST_ASSERT_EQUAL_UINT64(10 * NVM_SPAN_UNIT, space_manager_alloc(manager, 6 * NVM_SPAN_UNIT));
+    TEST_ASSERT_EQUAL_UINT64(2 * NVM_SPAN_UNIT, space_manager_largest_free(manager));
+    space_manager_free(manager, 0, 10 * NVM_SPAN_UNIT);
+    space_manager_free(manager, 18 * NVM_SPAN_UNIT, 12 * NVM_SPAN_UNIT);
+    TEST_ASSERT_EQUAL_UINT64(16 * NVM_SPAN_UNIT, space_manager_largest_free(manager));
+    verify_free_range(manager, 0, 0, 10 * NVM_SPAN_UNIT);
+    verify_free_range(manager, 10 * NVM_SPAN_UNIT, 16 * NVM_SPAN_UNIT, 16 * NVM_SPAN_UNIT);
+    space_manager_destroy(manager);
+
+    // --- 4. 随机大小的分配/释放，与参考模型逐段对照 ---
+    manager = space_manager_create(TOTAL_TEST_SIZE, 0);
+    TEST_ASSERT_NOT_NULL(manager);
+    uint64_t offsets[CHURN_SLOTS], sizes[CHURN_SLOTS] = {0};
+    uint8_t* used = (uint8_t*)calloc(units, 1);
+    TEST_ASSERT_NOT_NULL(used);
+
+    srand(54321);
+    for (int iter = 0; iter < 5000; ++iter) {
+        int slot = rand() % CHURN_SLOTS;
+        if (sizes[slot] == 0) {
+            uint64_t size = (uint64_t)(1 + rand() % 40) * NVM_SPAN_UNIT;
+            uint64_t off  = space_manager_alloc(manager, size);
+            if (off == (uint64_t)-1) {
+                TEST_ASSERT_TRUE(size > space_manager_largest_free(manager));
+                continue;
+            }
+            for (uint64_t u = off / NVM_SPAN_UNIT; u < (off + size) / NVM_SPAN_UNIT; ++u) {
+                TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, used[u], "Allocated range overlaps a live range.");
+                used[u] = 1;
+            }
+            offsets[slot] = off;
+            sizes[slot]   = size;
+        } else {
+            space_manager_free(manager, offsets[slot], sizes[slot]);
+            for (uint64_t u = offsets[slot] / NVM_SPAN_UNIT; u < (offsets[slot] + sizes[slot]) / NVM_SPAN_UNIT; ++u) {
+                used[u] = 0;
+            }
+            sizes[slot] = 0;
+        }
+
+        // 每个极大空闲段都能按地址找到，且最大者与 largest_free 一致
+        uint64_t largest = 0;
+        for (uint64_t u = 0; u < units; ) {
+            if (used[u]) { u++; continue; }
+            uint64_t end = u;
+            while (end < units && !used[end]) end++;
+            verify_free_range(manager, u * NVM_SPAN_UNIT, u * NVM_SPAN_UNIT, (end - u) * NVM_SPAN_UNIT);
+            if (end - u > largest) largest = end - u;
+            u = end;
+        }
+        TEST_ASSERT_EQUAL_UINT64(largest * NVM_SPAN_UNIT, space_manager_largest_free(manager));
+    }
+
+    for (int i = 0; i < CHURN_SLOTS; ++i) {
+        if (sizes[i] != 0) space_manager_free(manager, offsets[i], sizes[i]);
+    }
+    verify_single_node_state(manager, 0, TOTAL_TEST_SIZE);
+
+    free(used);
+    space_manager_destroy(manager);
+}
+
+typedef struct WildWorkerArgs {
+    FreeSpaceManager* manager;
+    uint64_t          offsets[TOTAL_TEST_SIZE / NVM_SPAN_UNIT];
+    uint32_t          count;
+} WildWorkerArgs;
+
+static void* wild_bump_worker(void* arg) {
+    WildWorkerArgs* args = (WildWorkerArgs*)arg;
+    for (;;) {
+        uint64_t off = space_manager_alloc_aligned(args->manager, 2 * NVM_SPAN_UNIT, 2 * NVM_SPAN_UNIT);
+        if (off == (uint64_t)-1) break;
+        args->offsets[args->count++] = off;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 测试荒野：全新空间无锁顺序切分，紧邻荒野的释放退回荒野，回收空间优先复用；
+ * 多线程并发切分互不重叠且恰好分完。
+ */
+void test_wilderness_bump_and_retreat(void) {
+    FreeSpaceManager* manager = space_manager_create(TOTAL_TEST_SIZE, 0);
+    TEST_ASSERT_NOT_NULL(manager);
+
+    // --- 1. 全新空间按地址顺序切分，不进入回收结构 ---
+    uint64_t a = space_manager_alloc(manager, NVM_SPAN_UNIT);
+    uint64_t b = space_manager_alloc_slab(manager);
+    uint64_t c = space_manager_alloc_slab(manager);
+    TEST_ASSERT_EQUAL_UINT64(0, a);
+    TEST_ASSERT_EQUAL_UINT64(NVM_SLAB_SIZE, b);
+    TEST_ASSERT_EQUAL_UINT64(2 * NVM_SLAB_SIZE, c);
+    TEST_ASSERT_EQUAL_UINT64(3 * NVM_SLAB_SIZE / NVM_SPAN_UNIT, manager->wild);
+    // 对齐空隙转入回收空间
+    verify_free_range(manager, 0, NVM_SPAN_UNIT, NVM_SLAB_SIZE - NVM_SPAN_UNIT);
+    TEST_ASSERT_EQUAL_UINT64(NVM_SLAB_SIZE / NVM_SPAN_UNIT - 1, manager->free_units);
+
+    // --- 2. 回收空间放得下时优先复用 ---
+    TEST_ASSERT_EQUAL_UINT64(2 * NVM_SPAN_UNIT, space_manager_alloc(manager, 2 * NVM_SPAN_UNIT));
+
+    // --- 3. 紧邻荒野的释放退回荒野，连同其下相邻的空闲区段 ---
+    space_manager_free_slab(manager, b);
+    TEST_ASSERT_EQUAL_UINT64(3 * NVM_SLAB_SIZE / NVM_SPAN_UNIT, manager->wild);
+    // c 与其下 b 合并出的空闲段 (单元 [4, 64)) 一起退回
+    space_manager_free_slab(manager, c);
+    TEST_ASSERT_EQUAL_UINT64(4, manager->wild);
+    TEST_ASSERT_EQUAL_UINT64(TOTAL_TEST_SIZE - 3 * NVM_SPAN_UNIT, space_manager_free_bytes(manager));
+
+    // 荒野中的区间不能被释放
+    space_manager_free_slab(manager, c);
+    TEST_ASSERT_EQUAL_UINT64(4, manager->wild);
+
+    // --- 4. 在荒野中指定偏移占位：越过的空隙转入回收空间 ---
+    TEST_ASSERT_EQUAL_INT(0, space_manager_alloc_at_offset(manager, 4 * NVM_SLAB_SIZE, NVM_SPAN_UNIT));
+    verify_free_range(manager, 4 * NVM_SPAN_UNIT, 4 * NVM_SPAN_UNIT, 4 * NVM_SLAB_SIZE - 4 * NVM_SPAN_UNIT);
+    TEST_ASSERT_EQUAL_INT(-1, space_manager_alloc_at_offset(manager, 4 * NVM_SLAB_SIZE, NVM_SPAN_UNIT));
+
+    space_manager_free(manager, 4 * NVM_SLAB_SIZE, NVM_SPAN_UNIT);
+    space_manager_free(manager, 2 * NVM_SPAN_UNIT, 2 * NVM_SPAN_UNIT);
+    space_manager_free(manager, a, NVM_SPAN_UNIT);
+    verify_single_node_state(manager, 0, TOTAL_TEST_SIZE);
+    TEST_ASSERT_EQUAL_UINT64(0, manager->wild);
+
+    // --- 5. 多线程并发切分 ---
+    static WildWorkerArgs args[WILD_THREADS];
+    pthread_t threads[WILD_THREADS];
+    for (int i = 0; i < WILD_THREADS; ++i) {
+        args[i].manager = manager;
+        args[i].count   = 0;
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, wild_bump_worker, &args[i]));
+    }
+    uint8_t used[TOTAL_TEST_SIZE / NVM_SPAN_UNIT] = {0};
+    uint32_t total = 0;
+    for (int i = 0; i < WILD_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+        for (uint32_t k = 0; k < args[i].count; ++k) {
+            uint64_t u = args[i].offsets[k] / NVM_SPAN_UNIT;
+            TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, used[u], "Concurrent bumps overlap.");
+            used[u] = used[u + 1] = 1;
+        }
+        total += args[i].count;
+    }
+    TEST_ASSERT_EQUAL_UINT32(TOTAL_TEST_SIZE / (2 * NVM_SPAN_UNIT), total);
+    TEST_ASSERT_EQUAL_UINT64(0, space_manager_free_bytes(manager));
+
+    for (int i = 0; i < WILD_THREADS; ++i) {
+        for (uint32_t k = 0; k < args[i].count; ++k) {
+            space_manager_free(manager, args[i].offsets[k], 2 * NVM_SPAN_UNIT);
+        }
+    }
+    verify_single_node_state(manager, 0, TOTAL_TEST_SIZE);
+
+    space_manager_destroy(manager);
+}
+
 // ============================================================================
 //                          测试执行入口
 // ============================================================================
@@ -208,6 +582,12 @@ int main(void) {
     RUN_TEST(test_space_manager_creation_and_destruction);
     RUN_TEST(test_alloc_and_free_with_merging);
     RUN_TEST(test_full_allocation_and_deallocation_cycle);
+    RUN_TEST(test_multi_slab_alloc_and_free);
+    RUN_TEST(test_aligned_alloc_and_alloc_at_offset);
+    RUN_TEST(test_alloc_at_offsets_batch);
+    RUN_TEST(test_buddy_random_churn);
+    RUN_TEST(test_best_fit_extents);
+    RUN_TEST(test_wilderness_bump_and_retreat);
 
     return UNITY_END();
 }
\ No newline at end of file